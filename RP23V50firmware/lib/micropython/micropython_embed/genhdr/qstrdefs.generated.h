@@ -204,6 +204,9 @@ QDEF1(MP_QSTR_ADC4, 33527, 4, "ADC4")
 QDEF1(MP_QSTR_ADC7, 33524, 4, "ADC7")
 QDEF1(MP_QSTR_ADC_PAD, 37225, 7, "ADC_PAD")
 QDEF1(MP_QSTR_ALT, 46972, 3, "ALT")
+QDEF1(MP_QSTR_ANIM_LOOP, 52461, 9, "ANIM_LOOP")
+QDEF1(MP_QSTR_ANIM_ONESHOT, 30517, 12, "ANIM_ONESHOT")
+QDEF1(MP_QSTR_ANIM_PINGPONG, 37207, 13, "ANIM_PINGPONG")
 QDEF1(MP_QSTR_ARBITRARY, 5137, 9, "ARBITRARY")
 QDEF1(MP_QSTR_AREF_PAD, 32095, 8, "AREF_PAD")
 QDEF1(MP_QSTR_ARRAY, 31324, 5, "ARRAY")
@@ -238,6 +241,7 @@ QDEF1(MP_QSTR_BUTTON_CONNECT, 24658, 14, "BUTTON_CONNECT")
 QDEF1(MP_QSTR_BUTTON_NONE, 45382, 11, "BUTTON_NONE")
 QDEF1(MP_QSTR_BUTTON_REMOVE, 10986, 13, "BUTTON_REMOVE")
 QDEF1(MP_QSTR_B_RAIL, 34158, 6, "B_RAIL")
+QDEF1(MP_QSTR_Batch, 53049, 5, "Batch")
 QDEF1(MP_QSTR_BytesIO, 46874, 7, "BytesIO")
 QDEF1(MP_QSTR_CONNECT_BUTTON, 58162, 14, "CONNECT_BUTTON")
 QDEF1(MP_QSTR_CURRENT_SENSE_MINUS, 52430, 19, "CURRENT_SENSE_MINUS")
@@ -279,6 +283,16 @@ QDEF1(MP_QSTR_DAC1, 64082, 4, "DAC1")
 QDEF1(MP_QSTR_DAC_0, 16780, 5, "DAC_0")
 QDEF1(MP_QSTR_DAC_1, 16781, 5, "DAC_1")
 QDEF1(MP_QSTR_DAC_PAD, 25737, 7, "DAC_PAD")
+QDEF1(MP_QSTR_DECODE_ADDRESS, 40992, 14, "DECODE_ADDRESS")
+QDEF1(MP_QSTR_DECODE_DATA, 11846, 11, "DECODE_DATA")
+QDEF1(MP_QSTR_DECODE_ERROR, 5358, 12, "DECODE_ERROR")
+QDEF1(MP_QSTR_DECODE_I2C, 16942, 10, "DECODE_I2C")
+QDEF1(MP_QSTR_DECODE_ONEWIRE, 24251, 14, "DECODE_ONEWIRE")
+QDEF1(MP_QSTR_DECODE_PRESENCE, 55599, 15, "DECODE_PRESENCE")
+QDEF1(MP_QSTR_DECODE_SPI, 58588, 10, "DECODE_SPI")
+QDEF1(MP_QSTR_DECODE_START, 11798, 12, "DECODE_START")
+QDEF1(MP_QSTR_DECODE_STOP, 28750, 11, "DECODE_STOP")
+QDEF1(MP_QSTR_DECODE_UART, 61284, 11, "DECODE_UART")
 QDEF1(MP_QSTR_DEEPSLEEP, 62334, 9, "DEEPSLEEP")
 QDEF1(MP_QSTR_EACCES, 49719, 6, "EACCES")
 QDEF1(MP_QSTR_EADDRINUSE, 4375, 10, "EADDRINUSE")
@@ -302,6 +316,7 @@ QDEF1(MP_QSTR_ENOTCONN, 55161, 8, "ENOTCONN")
 QDEF1(MP_QSTR_EOPNOTSUPP, 38828, 10, "EOPNOTSUPP")
 QDEF1(MP_QSTR_EPERM, 32746, 5, "EPERM")
 QDEF1(MP_QSTR_ETIMEDOUT, 63743, 9, "ETIMEDOUT")
+QDEF1(MP_QSTR_Event, 35561, 5, "Event")
 QDEF1(MP_QSTR_FLOAT32, 34740, 7, "FLOAT32")
 QDEF1(MP_QSTR_FLOAT64, 34583, 7, "FLOAT64")
 QDEF1(MP_QSTR_FLOATING, 21749, 8, "FLOATING")
@@ -422,6 +437,14 @@ QDEF1(MP_QSTR_SQUARE, 27012, 6, "SQUARE")
 QDEF1(MP_QSTR_Signal, 58523, 6, "Signal")
 QDEF1(MP_QSTR_StopAsyncIteration, 61676, 18, "StopAsyncIteration")
 QDEF1(MP_QSTR_StringIO, 30326, 8, "StringIO")
+QDEF1(MP_QSTR_TELEMETRY_ADC, 6451, 13, "TELEMETRY_ADC")
+QDEF1(MP_QSTR_TELEMETRY_GPIO, 54340, 14, "TELEMETRY_GPIO")
+QDEF1(MP_QSTR_TELEMETRY_INA0_CURRENT, 21685, 22, "TELEMETRY_INA0_CURRENT")
+QDEF1(MP_QSTR_TELEMETRY_INA0_POWER, 30659, 20, "TELEMETRY_INA0_POWER")
+QDEF1(MP_QSTR_TELEMETRY_INA0_VOLTAGE, 19166, 22, "TELEMETRY_INA0_VOLTAGE")
+QDEF1(MP_QSTR_TELEMETRY_INA1_CURRENT, 7732, 22, "TELEMETRY_INA1_CURRENT")
+QDEF1(MP_QSTR_TELEMETRY_INA1_POWER, 48066, 20, "TELEMETRY_INA1_POWER")
+QDEF1(MP_QSTR_TELEMETRY_INA1_VOLTAGE, 47775, 22, "TELEMETRY_INA1_VOLTAGE")
 QDEF1(MP_QSTR_TOP_GND_PAD, 24310, 11, "TOP_GND_PAD")
 QDEF1(MP_QSTR_TOP_RAIL, 6887, 8, "TOP_RAIL")
 QDEF1(MP_QSTR_TOP_RAIL_GND, 42325, 12, "TOP_RAIL_GND")
@@ -486,6 +509,14 @@ QDEF0(MP_QSTR___mul__, 16945, 7, "__mul__")
 QDEF0(MP_QSTR___ne__, 2830, 6, "__ne__")
 QDEF0(MP_QSTR___neg__, 54633, 7, "__neg__")
 QDEF0(MP_QSTR___or__, 47928, 6, "__or__")
+QDEF1(MP_QSTR___jl0, 29875, 5, "__jl0")
+QDEF1(MP_QSTR___jl1, 29874, 5, "__jl1")
+QDEF1(MP_QSTR___jl2, 29873, 5, "__jl2")
+QDEF1(MP_QSTR___jl3, 29872, 5, "__jl3")
+QDEF1(MP_QSTR___jl4, 29879, 5, "__jl4")
+QDEF1(MP_QSTR___jl5, 29878, 5, "__jl5")
+QDEF1(MP_QSTR___jl6, 29877, 5, "__jl6")
+QDEF1(MP_QSTR___jl7, 29876, 5, "__jl7")
 QDEF1(MP_QSTR___path__, 9160, 8, "__path__")
 QDEF0(MP_QSTR___pos__, 61481, 7, "__pos__")
 QDEF0(MP_QSTR___pow__, 45, 7, "__pow__")
@@ -512,15 +543,25 @@ QDEF1(MP_QSTR___traceback__, 53071, 13, "__traceback__")
 QDEF0(MP_QSTR___truediv__, 61320, 11, "__truediv__")
 QDEF0(MP_QSTR___xor__, 60448, 7, "__xor__")
 QDEF1(MP_QSTR__machine, 19391, 8, "_machine")
+QDEF1(MP_QSTR_abort, 65359, 5, "abort")
 QDEF1(MP_QSTR_abs_tol, 28029, 7, "abs_tol")
 QDEF1(MP_QSTR_acos, 40987, 4, "acos")
 QDEF1(MP_QSTR_acosh, 41747, 5, "acosh")
+QDEF1(MP_QSTR_adc_capture, 65528, 11, "adc_capture")
 QDEF1(MP_QSTR_adc_get, 49322, 7, "adc_get")
+QDEF1(MP_QSTR_adc_stats, 38685, 9, "adc_stats")
 QDEF1(MP_QSTR_add, 12868, 3, "add")
 QDEF1(MP_QSTR_addr, 31414, 4, "addr")
 QDEF1(MP_QSTR_addressof, 63834, 9, "addressof")
 QDEF1(MP_QSTR_addrsize, 37267, 8, "addrsize")
 QDEF1(MP_QSTR_alt, 13148, 3, "alt")
+QDEF1(MP_QSTR_animation_create, 30760, 16, "animation_create")
+QDEF1(MP_QSTR_animation_delete, 17909, 16, "animation_delete")
+QDEF1(MP_QSTR_animation_play, 32584, 14, "animation_play")
+QDEF1(MP_QSTR_animation_play_file, 20049, 19, "animation_play_file")
+QDEF1(MP_QSTR_animation_set_period, 5972, 20, "animation_set_period")
+QDEF1(MP_QSTR_animation_stats, 63629, 15, "animation_stats")
+QDEF1(MP_QSTR_animation_stop, 53492, 14, "animation_stop")
 QDEF1(MP_QSTR_appendleft, 7856, 10, "appendleft")
 QDEF1(MP_QSTR_arduino_reset, 18277, 13, "arduino_reset")
 QDEF1(MP_QSTR_arg, 13457, 3, "arg")
@@ -528,13 +569,16 @@ QDEF1(MP_QSTR_argv, 50887, 4, "argv")
 QDEF1(MP_QSTR_array, 29308, 5, "array")
 QDEF1(MP_QSTR_asin, 58704, 4, "asin")
 QDEF1(MP_QSTR_asinh, 36664, 5, "asinh")
+QDEF1(MP_QSTR_asyncio, 44357, 7, "asyncio")
 QDEF1(MP_QSTR_atan, 48671, 4, "atan")
 QDEF1(MP_QSTR_atan2, 33229, 5, "atan2")
 QDEF1(MP_QSTR_atanh, 33175, 5, "atanh")
 QDEF1(MP_QSTR_atten, 20655, 5, "atten")
 QDEF1(MP_QSTR_available, 28572, 9, "available")
+QDEF1(MP_QSTR_batch, 4121, 5, "batch")
 QDEF1(MP_QSTR_bin, 18656, 3, "bin")
 QDEF1(MP_QSTR_bound_method, 41623, 12, "bound_method")
+QDEF1(MP_QSTR_buffer, 41189, 6, "buffer")
 QDEF1(MP_QSTR_buffering, 56101, 9, "buffering")
 QDEF1(MP_QSTR_button_check, 55306, 12, "button_check")
 QDEF1(MP_QSTR_button_read, 10238, 11, "button_read")
@@ -542,9 +586,11 @@ QDEF1(MP_QSTR_bytearray_at, 23708, 12, "bytearray_at")
 QDEF1(MP_QSTR_byteorder, 39265, 9, "byteorder")
 QDEF1(MP_QSTR_bytes_at, 23990, 8, "bytes_at")
 QDEF1(MP_QSTR_calcsize, 14413, 8, "calcsize")
+QDEF1(MP_QSTR_capture_stats, 19711, 13, "capture_stats")
 QDEF1(MP_QSTR_ceil, 45062, 4, "ceil")
 QDEF1(MP_QSTR_center, 48974, 6, "center")
 QDEF1(MP_QSTR_change_terminal_color, 62554, 21, "change_terminal_color")
+QDEF1(MP_QSTR_channels, 46485, 8, "channels")
 QDEF1(MP_QSTR_chdir, 45745, 5, "chdir")
 QDEF1(MP_QSTR_check_button, 40170, 12, "check_button")
 QDEF1(MP_QSTR_clickwheel_down, 26357, 15, "clickwheel_down")
@@ -555,9 +601,11 @@ QDEF1(MP_QSTR_cmath, 62646, 5, "cmath")
 QDEF1(MP_QSTR_code, 55912, 4, "code")
 QDEF1(MP_QSTR_collect, 26011, 7, "collect")
 QDEF1(MP_QSTR_collections, 51424, 11, "collections")
+QDEF1(MP_QSTR_command_cache_stats, 52527, 19, "command_cache_stats")
 QDEF1(MP_QSTR_compile, 51700, 7, "compile")
 QDEF1(MP_QSTR_complex, 40389, 7, "complex")
 QDEF1(MP_QSTR_connect, 15835, 7, "connect")
+QDEF1(MP_QSTR_connect_many, 42015, 12, "connect_many")
 QDEF1(MP_QSTR_copysign, 5171, 8, "copysign")
 QDEF1(MP_QSTR_cos, 19578, 3, "cos")
 QDEF1(MP_QSTR_cosh, 56274, 4, "cosh")
@@ -565,6 +613,11 @@ QDEF1(MP_QSTR_cycle_term_color, 63110, 16, "cycle_term_color")
 QDEF1(MP_QSTR_dac_get, 33930, 7, "dac_get")
 QDEF1(MP_QSTR_dac_set, 20638, 7, "dac_set")
 QDEF1(MP_QSTR_decode, 22953, 6, "decode")
+QDEF1(MP_QSTR_decoder_add, 26405, 11, "decoder_add")
+QDEF1(MP_QSTR_decoder_feed, 45862, 12, "decoder_feed")
+QDEF1(MP_QSTR_decoder_read, 35126, 12, "decoder_read")
+QDEF1(MP_QSTR_decoder_remove, 62946, 14, "decoder_remove")
+QDEF1(MP_QSTR_decoder_stats, 51365, 13, "decoder_stats")
 QDEF1(MP_QSTR_deepsleep, 53918, 9, "deepsleep")
 QDEF1(MP_QSTR_default, 32206, 7, "default")
 QDEF1(MP_QSTR_degrees, 16642, 7, "degrees")
@@ -587,12 +640,16 @@ QDEF1(MP_QSTR_e, 46528, 1, "e")
 QDEF1(MP_QSTR_enable, 56836, 6, "enable")
 QDEF1(MP_QSTR_enable_irq, 24721, 10, "enable_irq")
 QDEF1(MP_QSTR_encode, 51779, 6, "encode")
+QDEF1(MP_QSTR_encoder, 4817, 7, "encoder")
+QDEF1(MP_QSTR_encoder_button, 32728, 14, "encoder_button")
 QDEF1(MP_QSTR_encoding, 39942, 8, "encoding")
 QDEF1(MP_QSTR_enumerate, 47729, 9, "enumerate")
 QDEF1(MP_QSTR_erf, 9108, 3, "erf")
 QDEF1(MP_QSTR_erfc, 38519, 4, "erfc")
 QDEF1(MP_QSTR_errno, 4545, 5, "errno")
 QDEF1(MP_QSTR_errorcode, 56592, 9, "errorcode")
+QDEF1(MP_QSTR_event, 27081, 5, "event")
+QDEF1(MP_QSTR_event_stats, 33303, 11, "event_stats")
 QDEF1(MP_QSTR_execfile, 10328, 8, "execfile")
 QDEF1(MP_QSTR_exists, 25861, 6, "exists")
 QDEF1(MP_QSTR_exit, 48773, 4, "exit")
@@ -642,12 +699,15 @@ QDEF1(MP_QSTR_get_wavegen_wave, 25055, 16, "get_wavegen_wave")
 QDEF1(MP_QSTR_getcwd, 53251, 6, "getcwd")
 QDEF1(MP_QSTR_getter, 45712, 6, "getter")
 QDEF1(MP_QSTR_getvalue, 44152, 8, "getvalue")
+QDEF1(MP_QSTR_gpio, 55380, 4, "gpio")
+QDEF1(MP_QSTR_gpio_capture, 40879, 12, "gpio_capture")
 QDEF1(MP_QSTR_gpio_get, 21245, 8, "gpio_get")
 QDEF1(MP_QSTR_gpio_get_dir, 33373, 12, "gpio_get_dir")
 QDEF1(MP_QSTR_gpio_get_pull, 3143, 13, "gpio_get_pull")
 QDEF1(MP_QSTR_gpio_set, 34537, 8, "gpio_set")
 QDEF1(MP_QSTR_gpio_set_dir, 39241, 12, "gpio_set_dir")
 QDEF1(MP_QSTR_gpio_set_pull, 17107, 13, "gpio_set_pull")
+QDEF1(MP_QSTR_handler, 24029, 7, "handler")
 QDEF1(MP_QSTR_heap_lock, 36013, 9, "heap_lock")
 QDEF1(MP_QSTR_heap_unlock, 11606, 11, "heap_unlock")
 QDEF1(MP_QSTR_help, 23700, 4, "help")
@@ -657,10 +717,13 @@ QDEF1(MP_QSTR_idle, 56481, 4, "idle")
 QDEF1(MP_QSTR_ilistdir, 27249, 8, "ilistdir")
 QDEF1(MP_QSTR_imag, 46919, 4, "imag")
 QDEF1(MP_QSTR_implementation, 11543, 14, "implementation")
+QDEF1(MP_QSTR_ina_capture, 41400, 11, "ina_capture")
 QDEF1(MP_QSTR_ina_get_bus_voltage, 40972, 19, "ina_get_bus_voltage")
 QDEF1(MP_QSTR_ina_get_current, 1500, 15, "ina_get_current")
 QDEF1(MP_QSTR_ina_get_power, 42986, 13, "ina_get_power")
 QDEF1(MP_QSTR_ina_get_voltage, 7095, 15, "ina_get_voltage")
+QDEF1(MP_QSTR_ina_stats, 39389, 9, "ina_stats")
+QDEF1(MP_QSTR_ina_window, 18480, 10, "ina_window")
 QDEF1(MP_QSTR_indices, 18522, 7, "indices")
 QDEF1(MP_QSTR_inf, 21252, 3, "inf")
 QDEF1(MP_QSTR_info, 46059, 4, "info")
@@ -686,8 +749,11 @@ QDEF1(MP_QSTR_jfs, 26778, 3, "jfs")
 QDEF1(MP_QSTR_jumperless, 59705, 10, "jumperless")
 QDEF1(MP_QSTR_kbd_intr, 5110, 8, "kbd_intr")
 QDEF1(MP_QSTR_keepends, 35682, 8, "keepends")
+QDEF1(MP_QSTR_la_capture_file, 46538, 15, "la_capture_file")
 QDEF1(MP_QSTR_la_capture_single_sample, 12015, 24, "la_capture_single_sample")
 QDEF1(MP_QSTR_la_enable_channel, 35562, 17, "la_enable_channel")
+QDEF1(MP_QSTR_la_file_bench, 34316, 13, "la_file_bench")
+QDEF1(MP_QSTR_la_file_stats, 49999, 13, "la_file_stats")
 QDEF1(MP_QSTR_la_get_control_analog, 32556, 21, "la_get_control_analog")
 QDEF1(MP_QSTR_la_get_control_digital, 29084, 22, "la_get_control_digital")
 QDEF1(MP_QSTR_la_is_capturing, 56979, 15, "la_is_capturing")
@@ -706,6 +772,7 @@ QDEF1(MP_QSTR_listdir, 58264, 7, "listdir")
 QDEF1(MP_QSTR_log, 16161, 3, "log")
 QDEF1(MP_QSTR_log10, 37184, 5, "log10")
 QDEF1(MP_QSTR_log2, 9075, 4, "log2")
+QDEF1(MP_QSTR_loops, 43818, 5, "loops")
 QDEF1(MP_QSTR_low, 16177, 3, "low")
 QDEF1(MP_QSTR_machine, 43872, 7, "machine")
 QDEF1(MP_QSTR_math, 47925, 4, "math")
@@ -732,6 +799,7 @@ QDEF1(MP_QSTR_mount, 3496, 5, "mount")
 QDEF1(MP_QSTR_name, 30114, 4, "name")
 QDEF1(MP_QSTR_namedtuple, 5662, 10, "namedtuple")
 QDEF1(MP_QSTR_nan, 22756, 3, "nan")
+QDEF1(MP_QSTR_nets, 35017, 4, "nets")
 QDEF1(MP_QSTR_node, 19397, 4, "node")
 QDEF1(MP_QSTR_nodename, 43874, 8, "nodename")
 QDEF1(MP_QSTR_nodes_clear, 57200, 11, "nodes_clear")
@@ -751,12 +819,16 @@ QDEF1(MP_QSTR_opt_level, 26503, 9, "opt_level")
 QDEF1(MP_QSTR_os, 28537, 2, "os")
 QDEF1(MP_QSTR_pack, 53692, 4, "pack")
 QDEF1(MP_QSTR_pack_into, 43295, 9, "pack_into")
+QDEF1(MP_QSTR_pairs, 12476, 5, "pairs")
 QDEF1(MP_QSTR_partition, 58759, 9, "partition")
 QDEF1(MP_QSTR_path, 52872, 4, "path")
 QDEF1(MP_QSTR_pause_core2, 53377, 11, "pause_core2")
 QDEF1(MP_QSTR_pend_throw, 29939, 10, "pend_throw")
+QDEF1(MP_QSTR_pending, 21434, 7, "pending")
+QDEF1(MP_QSTR_period_us, 59801, 9, "period_us")
 QDEF1(MP_QSTR_phase, 54634, 5, "phase")
 QDEF1(MP_QSTR_pi, 28700, 2, "pi")
+QDEF1(MP_QSTR_pin, 29682, 3, "pin")
 QDEF1(MP_QSTR_platform, 6458, 8, "platform")
 QDEF1(MP_QSTR_polar, 3077, 5, "polar")
 QDEF1(MP_QSTR_popleft, 39537, 7, "popleft")
@@ -784,10 +856,13 @@ QDEF1(MP_QSTR_pwm, 28719, 3, "pwm")
 QDEF1(MP_QSTR_pwm_set_duty_cycle, 63806, 18, "pwm_set_duty_cycle")
 QDEF1(MP_QSTR_pwm_set_frequency, 8553, 17, "pwm_set_frequency")
 QDEF1(MP_QSTR_pwm_stop, 23240, 8, "pwm_stop")
+QDEF1(MP_QSTR_pwm_sync, 28343, 8, "pwm_sync")
 QDEF1(MP_QSTR_python_compiler, 38285, 15, "python_compiler")
 QDEF1(MP_QSTR_qstr_info, 33200, 9, "qstr_info")
+QDEF1(MP_QSTR_quantity, 5470, 8, "quantity")
 QDEF1(MP_QSTR_r, 46551, 1, "r")
 QDEF1(MP_QSTR_radians, 16263, 7, "radians")
+QDEF1(MP_QSTR_rate, 2119, 4, "rate")
 QDEF1(MP_QSTR_read_button, 51454, 11, "read_button")
 QDEF1(MP_QSTR_read_probe, 54306, 10, "read_probe")
 QDEF1(MP_QSTR_read_u16, 44762, 8, "read_u16")
@@ -803,13 +878,27 @@ QDEF1(MP_QSTR_release, 36844, 7, "release")
 QDEF1(MP_QSTR_rename, 6197, 6, "rename")
 QDEF1(MP_QSTR_reset, 62480, 5, "reset")
 QDEF1(MP_QSTR_reversed, 28321, 8, "reversed")
+QDEF1(MP_QSTR_rising, 26669, 6, "rising")
 QDEF1(MP_QSTR_rmdir, 42821, 5, "rmdir")
 QDEF1(MP_QSTR_rpartition, 53269, 10, "rpartition")
 QDEF1(MP_QSTR_run_app, 46194, 7, "run_app")
+QDEF1(MP_QSTR_run_script, 43868, 10, "run_script")
+QDEF1(MP_QSTR_save, 33700, 4, "save")
 QDEF1(MP_QSTR_scan, 36378, 4, "scan")
 QDEF1(MP_QSTR_schedule, 44256, 8, "schedule")
+QDEF1(MP_QSTR_script_cache_stats, 58695, 18, "script_cache_stats")
+QDEF1(MP_QSTR_script_cache_warm, 13519, 17, "script_cache_warm")
 QDEF1(MP_QSTR_seek, 30109, 4, "seek")
 QDEF1(MP_QSTR_send_raw, 24322, 8, "send_raw")
+QDEF1(MP_QSTR_sensors, 22208, 7, "sensors")
+QDEF1(MP_QSTR_sequence_add, 35716, 12, "sequence_add")
+QDEF1(MP_QSTR_sequence_add_pwm, 44209, 16, "sequence_add_pwm")
+QDEF1(MP_QSTR_sequence_clear, 55228, 14, "sequence_clear")
+QDEF1(MP_QSTR_sequence_fired, 25241, 14, "sequence_fired")
+QDEF1(MP_QSTR_sequence_start, 10181, 14, "sequence_start")
+QDEF1(MP_QSTR_sequence_stats, 10244, 14, "sequence_stats")
+QDEF1(MP_QSTR_sequence_status, 10289, 15, "sequence_status")
+QDEF1(MP_QSTR_sequence_stop, 30557, 13, "sequence_stop")
 QDEF1(MP_QSTR_set_dac, 49694, 7, "set_dac")
 QDEF1(MP_QSTR_set_gpio, 31113, 8, "set_gpio")
 QDEF1(MP_QSTR_set_gpio_dir, 54185, 12, "set_gpio_dir")
@@ -834,6 +923,7 @@ QDEF1(MP_QSTR_sleep_ms, 25355, 8, "sleep_ms")
 QDEF1(MP_QSTR_sleep_us, 24595, 8, "sleep_us")
 QDEF1(MP_QSTR_slice, 62645, 5, "slice")
 QDEF1(MP_QSTR_soft_reset, 26081, 10, "soft_reset")
+QDEF1(MP_QSTR_source, 30904, 6, "source")
 QDEF1(MP_QSTR_splitlines, 54122, 10, "splitlines")
 QDEF1(MP_QSTR_sqrt, 17441, 4, "sqrt")
 QDEF1(MP_QSTR_stack_use, 63383, 9, "stack_use")
@@ -851,6 +941,10 @@ QDEF1(MP_QSTR_sysname, 13979, 7, "sysname")
 QDEF1(MP_QSTR_tan, 25086, 3, "tan")
 QDEF1(MP_QSTR_tanh, 41430, 4, "tanh")
 QDEF1(MP_QSTR_tau, 25061, 3, "tau")
+QDEF1(MP_QSTR_telemetry_info, 29787, 14, "telemetry_info")
+QDEF1(MP_QSTR_telemetry_read, 3335, 14, "telemetry_read")
+QDEF1(MP_QSTR_telemetry_start, 13877, 15, "telemetry_start")
+QDEF1(MP_QSTR_telemetry_stop, 62445, 14, "telemetry_stop")
 QDEF1(MP_QSTR_tell, 45332, 4, "tell")
 QDEF1(MP_QSTR_threshold, 12274, 9, "threshold")
 QDEF1(MP_QSTR_ticks_add, 44701, 9, "ticks_add")
@@ -859,7 +953,9 @@ QDEF1(MP_QSTR_ticks_diff, 57521, 10, "ticks_diff")
 QDEF1(MP_QSTR_ticks_ms, 12866, 8, "ticks_ms")
 QDEF1(MP_QSTR_ticks_us, 12634, 8, "ticks_us")
 QDEF1(MP_QSTR_time, 49648, 4, "time")
+QDEF1(MP_QSTR_times, 65411, 5, "times")
 QDEF1(MP_QSTR_toggle, 17335, 6, "toggle")
+QDEF1(MP_QSTR_trigger, 35997, 7, "trigger")
 QDEF1(MP_QSTR_trunc, 39259, 5, "trunc")
 QDEF1(MP_QSTR_uctypes, 29176, 7, "uctypes")
 QDEF1(MP_QSTR_umount, 40669, 6, "umount")
@@ -872,21 +968,31 @@ QDEF1(MP_QSTR_unpack_from, 27918, 11, "unpack_from")
 QDEF1(MP_QSTR_usys, 62409, 4, "usys")
 QDEF1(MP_QSTR_version, 54207, 7, "version")
 QDEF1(MP_QSTR_version_info, 2670, 12, "version_info")
+QDEF1(MP_QSTR_wait, 21902, 4, "wait")
 QDEF1(MP_QSTR_wait_probe, 30427, 10, "wait_probe")
 QDEF1(MP_QSTR_wait_touch, 64020, 10, "wait_touch")
+QDEF1(MP_QSTR_wavegen_add_output, 38514, 18, "wavegen_add_output")
 QDEF1(MP_QSTR_wavegen_get_amplitude, 20387, 21, "wavegen_get_amplitude")
 QDEF1(MP_QSTR_wavegen_get_freq, 22490, 16, "wavegen_get_freq")
 QDEF1(MP_QSTR_wavegen_get_offset, 47479, 18, "wavegen_get_offset")
 QDEF1(MP_QSTR_wavegen_get_output, 52261, 18, "wavegen_get_output")
 QDEF1(MP_QSTR_wavegen_get_wave, 16031, 16, "wavegen_get_wave")
 QDEF1(MP_QSTR_wavegen_is_running, 8945, 18, "wavegen_is_running")
+QDEF1(MP_QSTR_wavegen_load_cycle, 44666, 18, "wavegen_load_cycle")
+QDEF1(MP_QSTR_wavegen_play, 15703, 12, "wavegen_play")
+QDEF1(MP_QSTR_wavegen_play_status, 29596, 19, "wavegen_play_status")
+QDEF1(MP_QSTR_wavegen_play_stop, 51696, 17, "wavegen_play_stop")
+QDEF1(MP_QSTR_wavegen_remove_output, 41973, 21, "wavegen_remove_output")
 QDEF1(MP_QSTR_wavegen_set_amplitude, 53175, 21, "wavegen_set_amplitude")
 QDEF1(MP_QSTR_wavegen_set_freq, 17742, 16, "wavegen_set_freq")
+QDEF1(MP_QSTR_wavegen_set_harmonic, 2995, 20, "wavegen_set_harmonic")
 QDEF1(MP_QSTR_wavegen_set_offset, 53987, 18, "wavegen_set_offset")
 QDEF1(MP_QSTR_wavegen_set_output, 26033, 18, "wavegen_set_output")
+QDEF1(MP_QSTR_wavegen_set_phase, 21985, 17, "wavegen_set_phase")
 QDEF1(MP_QSTR_wavegen_set_sweep, 39066, 17, "wavegen_set_sweep")
 QDEF1(MP_QSTR_wavegen_set_wave, 11275, 16, "wavegen_set_wave")
 QDEF1(MP_QSTR_wavegen_start, 63283, 13, "wavegen_start")
+QDEF1(MP_QSTR_wavegen_stats, 63218, 13, "wavegen_stats")
 QDEF1(MP_QSTR_wavegen_stop, 43691, 12, "wavegen_stop")
 QDEF1(MP_QSTR_width, 29987, 5, "width")
 QDEF1(MP_QSTR_write_readinto, 33929, 14, "write_readinto")
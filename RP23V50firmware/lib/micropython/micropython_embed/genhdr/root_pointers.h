@@ -6,3 +6,9 @@ mp_obj_t sys_mutable[MP_SYS_MUTABLE_NUM];
 mp_sched_item_t sched_queue[(8)];
 struct _mp_vfs_mount_t *vfs_cur;
 struct _mp_vfs_mount_t *vfs_mount_table;
+mp_obj_t jl_wavegen_cycle_obj[4];
+mp_obj_t jl_wavegen_play_obj;
+mp_obj_t jl_command_cache[16];
+mp_obj_t jl_event_handlers[12];
+mp_obj_t jl_event_last[12];
+mp_obj_t jl_event_calls[64];
@@ -136,6 +136,10 @@ typedef uint32_t mp_hal_pin_obj_t;
 #define MICROPY_ENABLE_SOURCE_LINE  (1)
 
 #define MICROPY_ENABLE_EXTERNAL_IMPORT (1)  // Disable to avoid sys.path dependency
+
+// Scripts in /python_scripts are compiled once and kept as .mpy (ScriptCache.cpp)
+#define MICROPY_PERSISTENT_CODE_LOAD (1)
+#define MICROPY_PERSISTENT_CODE_SAVE (1)
 #define MICROPY_MALLOC_USES_ALLOCATED_SIZE (1)
 
 // Additional features for embedded use
@@ -143,6 +147,21 @@ typedef uint32_t mp_hal_pin_obj_t;
 #define MICROPY_ENABLE_SCHEDULER    (1)
 #define MICROPY_SCHEDULER_DEPTH     (8)
 
+// Every 64 branches the VM checks for events from EventDispatch.cpp and
+// schedules the script's handlers (jl_events_poll() in modjumperless.c)
+#ifdef __cplusplus
+extern "C"
+#endif
+void jl_events_poll(void);
+#define MICROPY_VM_HOOK_COUNT (64)
+#define MICROPY_VM_HOOK_INIT static unsigned int vm_hook_divisor = MICROPY_VM_HOOK_COUNT;
+#define MICROPY_VM_HOOK_POLL if (--vm_hook_divisor == 0) { \
+        vm_hook_divisor = MICROPY_VM_HOOK_COUNT; \
+        jl_events_poll(); \
+}
+#define MICROPY_VM_HOOK_LOOP MICROPY_VM_HOOK_POLL
+#define MICROPY_VM_HOOK_RETURN MICROPY_VM_HOOK_POLL
+
 // VFS support disabled - using jumperless filesystem bridge instead
 #define MICROPY_VFS                 (0)
 #define MICROPY_VFS_FAT             (0)  // Disable FAT to save memory
@@ -23,6 +23,8 @@
 #include "py/lexer.h"
 #include "py/mperrno.h"
 #include "py/builtin.h"
+#include "py/binary.h"
+#include "py/mphal.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -42,10 +44,20 @@ extern void jl_cycle_term_color(bool reset, float step, bool flush);
 void jl_dac_set(int channel, float voltage, int save);
 float jl_dac_get(int channel);
 float jl_adc_get(int channel);
+void jl_adc_stats(void);
 float jl_ina_get_current(int sensor);
 float jl_ina_get_voltage(int sensor);
 float jl_ina_get_bus_voltage(int sensor);
 float jl_ina_get_power(int sensor);
+int jl_ina_window(int sensor, float* out);
+void jl_ina_stats(void);
+int jl_bulk_start(int source, int mask, int quantity, int volts, void* out, uint32_t rows,
+                  float rate, uint32_t* times);
+void jl_bulk_wait(void);
+void jl_bulk_stop(void);
+void jl_bulk_finish(uint32_t* rows, uint32_t* start_us, float* interval_us, uint32_t* late);
+const char* jl_bulk_error_text(int error);
+void jl_bulk_stats(void);
 
 // Wavegen C wrappers (C linkage)
 void jl_wavegen_set_output(int channel);
@@ -53,7 +65,31 @@ void jl_wavegen_set_freq(float hz);
 void jl_wavegen_set_wave(int wave);
 void jl_wavegen_set_amplitude(float vpp);
 void jl_wavegen_set_offset(float v);
-void jl_wavegen_set_sweep(float start_hz, float end_hz, float seconds);
+void jl_wavegen_set_sweep(float start_hz, float end_hz, float seconds, int logarithmic, int repeat);
+void jl_wavegen_add_output(int channel);
+void jl_wavegen_remove_output(int channel);
+void jl_wavegen_set_phase(float degrees);
+void jl_wavegen_set_harmonic(int multiple);
+void jl_wavegen_stats(void);
+int jl_wavegen_load_cycle(const char *path);
+int jl_wavegen_set_cycle(const void *samples, uint32_t count, int format);
+int jl_wavegen_play_file(const char *path, float sample_rate, int loop);
+int jl_wavegen_play_buffer(const void *samples, uint32_t count, int format, float sample_rate, int loop);
+void jl_wavegen_play_stop(void);
+void jl_wavegen_play_status(uint32_t *out);
+void jl_sequence_clear(void);
+int jl_sequence_add(uint32_t at_us, int output, int value);
+int jl_sequence_add_volts(uint32_t at_us, int output, float volts);
+int jl_sequence_start(int loops, uint32_t period_us, int trigger, int rising);
+int jl_sequence_bad_event(void);
+const char *jl_sequence_error_text(int error);
+void jl_sequence_stop(void);
+void jl_sequence_status(int32_t *out);
+int jl_sequence_events(void);
+uint32_t jl_sequence_scheduled_at(int event);
+int32_t jl_sequence_fired_at(int event);
+void jl_sequence_stats(void);
+int jl_sequence_owns_dac(void);
 void jl_wavegen_start(int start);
 void jl_wavegen_stop(void);
 int jl_wavegen_get_output(void);
@@ -73,6 +109,13 @@ int jl_nodes_connect(int node1, int node2, int save);
 int jl_nodes_disconnect(int node1, int node2);
 int jl_nodes_is_connected(int node1, int node2);
 int jl_nodes_save(int slot);
+int jl_batch_begin(int save);
+int jl_batch_active(void);
+int jl_batch_count(void);
+int jl_batch_add(int node1, int node2, int remove, int save);
+void jl_batch_clear(void);
+void jl_batch_abort(void);
+int jl_batch_commit(int save);
 int jl_nodes_print_bridges(void);
 int jl_nodes_print_paths(void);
 int jl_nodes_print_crossbars(void);
@@ -106,6 +149,9 @@ void jl_la_set_control_analog(int channel, float value);
 void jl_la_set_control_digital(int channel, bool value);
 float jl_la_get_control_analog(int channel);
 bool jl_la_get_control_digital(int channel);
+int jl_la_capture_file(const char* path);
+int jl_la_file_bench(int kbytes);
+void jl_la_file_stats(void);
 
 void jl_logic_analyzer_enable_channel(int channel);
 void jl_logic_analyzer_enable_channel_mask(uint32_t channel_mask);
@@ -163,10 +209,43 @@ void jl_run_app(char* appName);
 void jl_help(void);
 void jl_help_section(const char* section);
 void jl_pause_core2(bool pause);
+void jl_command_cache_stats(void);
+int jl_run_script(const char* name);
+int jl_script_cache_warm(void);
+void jl_script_cache_stats(void);
+void jl_event_enable(int source, int on);
+int jl_event_gpio_watch(int pin, int on);
+int jl_event_pop(int* source, int* index, int* value, uint32_t* time_us);
+int jl_event_pending(void);
+void jl_event_clear(void);
+void jl_event_stats(void);
 int jl_pwm_setup(int gpio_pin, float frequency, float duty_cycle);
 int jl_pwm_set_duty_cycle(int gpio_pin, float duty_cycle);
 int jl_pwm_set_frequency(int gpio_pin, float frequency);
 int jl_pwm_stop(int gpio_pin);
+int jl_pwm_sync(int pins);
+
+// Keyframe animation engine (Animations.cpp)
+int jl_animation_create(const uint32_t* colors, int num_colors, int period_ms, int mode, int length);
+int jl_animation_play(int id, int node, int spread);
+void jl_animation_stop(int id);
+void jl_animation_delete(int id);
+void jl_animation_set_period(int id, int period_ms);
+void jl_animation_stats(void);
+int jl_animation_play_file(const char* path, int loops, int brightness);
+
+// Protocol decoders (ProtocolDecode.cpp)
+int jl_decoder_add(int protocol, const int* pins, int num_pins, int rate, int mode);
+void jl_decoder_remove(int slot);
+int jl_decoder_read(uint32_t* out, int max);
+int jl_decoder_feed(const uint8_t* samples, int count, int sample_rate);
+void jl_decoder_stats(uint32_t* out);
+
+// Telemetry (Telemetry.cpp)
+int jl_telemetry_start(uint32_t mask, int rate);
+void jl_telemetry_stop(void);
+int jl_telemetry_read(uint8_t* out, int max_bytes);
+void jl_telemetry_info(uint32_t* out);
 
 //=============================================================================
 // Custom Boolean-like Types for Jumperless
@@ -1101,6 +1180,9 @@ static int get_dac_channel(mp_obj_t obj) {
 // DAC Functions
 static mp_obj_t jl_dac_set_func(size_t n_args, const mp_obj_t *args) {
     int channel = get_dac_channel(args[0]);
+    if (jl_sequence_owns_dac()) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("the sequencer is using the DAC"));
+    }
     float voltage = mp_obj_get_float(args[1]);
     int save = (n_args > 2) ? mp_obj_is_true(args[2]) ? 1 : 0 : 1; // Default save=True
     
@@ -1173,26 +1255,143 @@ static MP_DEFINE_CONST_FUN_OBJ_1(jl_wavegen_set_freq_obj, jl_wavegen_set_freq_fu
 
 static mp_obj_t jl_wavegen_set_wave_func(mp_obj_t w_obj) {
     int w = get_wavegen_wave(w_obj);
-    if (w == 4) {
-        // ARBITRARY not implemented yet
-        mp_raise_NotImplementedError(MP_ERROR_TEXT("ARBITRARY waveform not implemented yet"));
-    }
+    // ARBITRARY plays the output's wavegen_load_cycle() cycle, sine until there is one
     jl_wavegen_set_wave(w);
     return mp_const_none;
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(jl_wavegen_set_wave_obj, jl_wavegen_set_wave_func);
 
 static mp_obj_t jl_wavegen_set_sweep_func(size_t n_args, const mp_obj_t *args) {
-    if (n_args != 3) {
-        mp_raise_TypeError(MP_ERROR_TEXT("wavegen_set_sweep(start_hz, end_hz, seconds)"));
-    }
+    // wavegen_set_sweep(start_hz, end_hz, seconds, [log=False], [repeat=False])
     float start_hz = mp_obj_get_float(args[0]);
     float end_hz = mp_obj_get_float(args[1]);
     float seconds = mp_obj_get_float(args[2]);
-    jl_wavegen_set_sweep(start_hz, end_hz, seconds);
+    int logarithmic = n_args > 3 && mp_obj_is_true(args[3]);
+    int repeat = n_args > 4 && mp_obj_is_true(args[4]);
+    jl_wavegen_set_sweep(start_hz, end_hz, seconds, logarithmic, repeat);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_wavegen_set_sweep_obj, 3, 5, jl_wavegen_set_sweep_func);
+
+static mp_obj_t jl_wavegen_add_output_func(mp_obj_t out_obj) {
+    jl_wavegen_add_output(get_wavegen_channel(out_obj));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_wavegen_add_output_obj, jl_wavegen_add_output_func);
+
+static mp_obj_t jl_wavegen_remove_output_func(mp_obj_t out_obj) {
+    jl_wavegen_remove_output(get_wavegen_channel(out_obj));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_wavegen_remove_output_obj, jl_wavegen_remove_output_func);
+
+static mp_obj_t jl_wavegen_set_phase_func(mp_obj_t deg_obj) {
+    jl_wavegen_set_phase(mp_obj_get_float(deg_obj));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_wavegen_set_phase_obj, jl_wavegen_set_phase_func);
+
+static mp_obj_t jl_wavegen_set_harmonic_func(mp_obj_t n_obj) {
+    int n = mp_obj_get_int(n_obj);
+    if (n < 1 || n > 255) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Harmonic must be 1-255"));
+    }
+    jl_wavegen_set_harmonic(n);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_wavegen_set_harmonic_obj, jl_wavegen_set_harmonic_func);
+
+static mp_obj_t jl_wavegen_stats_func(void) {
+    jl_wavegen_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_wavegen_stats_obj, jl_wavegen_stats_func);
+
+// The wavegen reads these buffers in place, so they're kept from the GC for as
+// long as it's using them. wavegen.dropExternal() lets go of them when the VM goes.
+MP_REGISTER_ROOT_POINTER(mp_obj_t jl_wavegen_cycle_obj[4]);
+MP_REGISTER_ROOT_POINTER(mp_obj_t jl_wavegen_play_obj);
+
+// Compiled '>' commands, see execCachedCommand() in Python_Proper.cpp
+MP_REGISTER_ROOT_POINTER(mp_obj_t jl_command_cache[16]);
+
+// samples in a buffer: array('h') is int16 at +-32767, anything else
+// (bytes, bytearray, array('H')) little-endian 12-bit DAC codes
+static const void *get_wavegen_samples(mp_obj_t obj, uint32_t *count, int *format) {
+    mp_buffer_info_t buf;
+    mp_get_buffer_raise(obj, &buf, MP_BUFFER_READ);
+    *format = buf.typecode == 'h' ? 0 : 1; // DDS_SAMPLES_S16 : DDS_SAMPLES_U12
+    *count = buf.len / 2;
+    return buf.buf;
+}
+
+static mp_obj_t jl_wavegen_load_cycle_func(mp_obj_t src_obj) {
+    // wavegen_load_cycle(path_or_buffer)
+    int ch = jl_wavegen_get_output();
+    if (mp_obj_is_str(src_obj)) {
+        if (!jl_wavegen_load_cycle(mp_obj_str_get_str(src_obj))) {
+            mp_raise_OSError(MP_ENOENT);
+        }
+        MP_STATE_VM(jl_wavegen_cycle_obj)[ch] = MP_OBJ_NULL;
+        return mp_const_none;
+    }
+    uint32_t count;
+    int format;
+    const void *samples = get_wavegen_samples(src_obj, &count, &format);
+    if (count < 2) {
+        mp_raise_ValueError(MP_ERROR_TEXT("A cycle needs at least 2 samples"));
+    }
+    jl_wavegen_set_cycle(samples, count, format);
+    MP_STATE_VM(jl_wavegen_cycle_obj)[ch] = src_obj;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_wavegen_load_cycle_obj, jl_wavegen_load_cycle_func);
+
+static mp_obj_t jl_wavegen_play_func(size_t n_args, const mp_obj_t *args) {
+    // wavegen_play(path_or_buffer, sample_rate, [loop=False])
+    float rate = mp_obj_get_float(args[1]);
+    int loop = n_args > 2 && mp_obj_is_true(args[2]);
+    if (rate <= 0.0f) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Sample rate must be positive"));
+    }
+    if (mp_obj_is_str(args[0])) {
+        if (!jl_wavegen_play_file(mp_obj_str_get_str(args[0]), rate, loop)) {
+            mp_raise_OSError(MP_ENOENT);
+        }
+        MP_STATE_VM(jl_wavegen_play_obj) = MP_OBJ_NULL;
+        return mp_const_none;
+    }
+    uint32_t count;
+    int format;
+    const void *samples = get_wavegen_samples(args[0], &count, &format);
+    if (count == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Nothing to play"));
+    }
+    jl_wavegen_play_buffer(samples, count, format, rate, loop);
+    MP_STATE_VM(jl_wavegen_play_obj) = args[0];
     return mp_const_none;
 }
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_wavegen_set_sweep_obj, 3, 3, jl_wavegen_set_sweep_func);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_wavegen_play_obj, 2, 3, jl_wavegen_play_func);
+
+static mp_obj_t jl_wavegen_play_stop_func(void) {
+    jl_wavegen_play_stop();
+    MP_STATE_VM(jl_wavegen_play_obj) = MP_OBJ_NULL;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_wavegen_play_stop_obj, jl_wavegen_play_stop_func);
+
+static mp_obj_t jl_wavegen_play_status_func(void) {
+    // (playing, position, starved)
+    uint32_t status[3];
+    jl_wavegen_play_status(status);
+    mp_obj_t items[3] = {
+        mp_obj_new_bool(status[0]),
+        mp_obj_new_int_from_uint(status[1]),
+        mp_obj_new_int_from_uint(status[2]),
+    };
+    return mp_obj_new_tuple(3, items);
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_wavegen_play_status_obj, jl_wavegen_play_status_func);
 
 static mp_obj_t jl_wavegen_set_amplitude_func(mp_obj_t vpp_obj) {
     float vpp = mp_obj_get_float(vpp_obj);
@@ -1255,6 +1454,12 @@ static mp_obj_t jl_adc_get_func(mp_obj_t channel_obj) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(jl_adc_get_obj, jl_adc_get_func);
 
+static mp_obj_t jl_adc_stats_func(void) {
+    jl_adc_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_adc_stats_obj, jl_adc_stats_func);
+
 // INA Functions
 static mp_obj_t jl_ina_get_current_func(mp_obj_t sensor_obj) {
     int sensor = mp_obj_get_int(sensor_obj);
@@ -1312,6 +1517,205 @@ static mp_obj_t jl_ina_get_power_func(mp_obj_t sensor_obj) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(jl_ina_get_power_obj, jl_ina_get_power_func);
 
+// ina_window(sensor) -> ((min, max, avg) current, bus voltage, power) over the
+// last 16 conversions, in the same units as ina_get_*
+static mp_obj_t jl_ina_window_func(mp_obj_t sensor_obj) {
+    int sensor = mp_obj_get_int(sensor_obj);
+    if (sensor < 0 || sensor > 1) {
+        mp_raise_ValueError(MP_ERROR_TEXT("INA sensor must be 0 or 1"));
+    }
+
+    float values[9];
+    if (jl_ina_window(sensor, values) == 0) {
+        return mp_const_none;
+    }
+    mp_obj_t quantities[3];
+    for (int q = 0; q < 3; q++) {
+        mp_obj_t items[3] = {
+            mp_obj_new_float(values[q * 3]),
+            mp_obj_new_float(values[q * 3 + 1]),
+            mp_obj_new_float(values[q * 3 + 2]),
+        };
+        quantities[q] = mp_obj_new_tuple(3, items);
+    }
+    return mp_obj_new_tuple(3, quantities);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_ina_window_obj, jl_ina_window_func);
+
+static mp_obj_t jl_ina_stats_func(void) {
+    jl_ina_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_ina_stats_obj, jl_ina_stats_func);
+
+// Bulk sampling - fills a caller's array in C at a set rate, no objects per sample
+#define BULK_ADC 0  // BulkSampler.h
+#define BULK_GPIO 1
+#define BULK_INA 2
+#define BULK_BAD_CHANNEL 2
+#define BULK_BAD_RATE 3
+
+// an int or a sequence of them -> bit mask
+static int get_channel_mask(mp_obj_t obj, int max) {
+    int mask = 0;
+    if (mp_obj_is_int(obj)) {
+        int ch = mp_obj_get_int(obj);
+        if (ch < 0 || ch > max) {
+            mp_raise_msg_varg(&mp_type_ValueError, MP_ERROR_TEXT("channel must be 0-%d"), max);
+        }
+        return 1 << ch;
+    }
+    size_t len;
+    mp_obj_t *items;
+    mp_obj_get_array(obj, &len, &items);
+    for (size_t i = 0; i < len; i++) {
+        mask |= get_channel_mask(items[i], max);
+    }
+    if (mask == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("no channels"));
+    }
+    return mask;
+}
+
+// runs one capture to the end and returns (start_us, interval_us). Ctrl-C
+// stops it on the way out
+static mp_obj_t bulk_capture(int source, int mask, int quantity, mp_obj_t buf_obj,
+                             mp_obj_t rate_obj, mp_obj_t times_obj) {
+    mp_buffer_info_t buf;
+    mp_get_buffer_raise(buf_obj, &buf, MP_BUFFER_WRITE);
+    int volts = 0;
+    size_t item;
+    if (source == BULK_GPIO) {
+        if (buf.typecode != 'B' && buf.typecode != 'b' && buf.typecode != BYTEARRAY_TYPECODE) {
+            mp_raise_TypeError(MP_ERROR_TEXT("GPIO samples go in a bytearray or array('B')"));
+        }
+        item = 1;
+    } else if (buf.typecode == 'f') {
+        volts = 1;
+        item = 4;
+    } else if (source == BULK_ADC && (buf.typecode == 'H' || buf.typecode == 'h')) {
+        item = 2;
+    } else {
+        mp_raise_TypeError(source == BULK_ADC
+            ? MP_ERROR_TEXT("ADC samples go in array('H') for codes or array('f') for volts")
+            : MP_ERROR_TEXT("INA samples go in array('f')"));
+    }
+    size_t columns = source == BULK_GPIO ? 1 : __builtin_popcount(mask);
+    uint32_t rows = buf.len / (item * columns);
+    if (rows == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffer too small for one row"));
+    }
+
+    uint32_t *times = NULL;
+    if (times_obj != mp_const_none) {
+        mp_buffer_info_t tbuf;
+        mp_get_buffer_raise(times_obj, &tbuf, MP_BUFFER_WRITE);
+        // unsigned 32-bit only, 'f' or 'i' would take the raw µs as something else
+        if ((tbuf.typecode != 'I' && tbuf.typecode != 'L') ||
+            mp_binary_get_size('@', tbuf.typecode, NULL) != 4 || tbuf.len / 4 < rows) {
+            mp_raise_ValueError(MP_ERROR_TEXT("times must be array('I') with a slot per row"));
+        }
+        times = (uint32_t *)tbuf.buf;
+    }
+
+    int error = jl_bulk_start(source, mask, quantity, volts, buf.buf, rows,
+                              mp_obj_get_float(rate_obj), times);
+    if (error != 0) {
+        mp_raise_msg_varg(error == BULK_BAD_CHANNEL || error == BULK_BAD_RATE
+                              ? &mp_type_ValueError : &mp_type_RuntimeError,
+                          MP_ERROR_TEXT("capture: %s"), jl_bulk_error_text(error));
+    }
+
+    uint32_t done, start_us, late;
+    float interval_us;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        jl_bulk_wait();
+        nlr_pop();
+    } else {
+        jl_bulk_stop();
+        jl_bulk_finish(&done, &start_us, &interval_us, &late);
+        nlr_jump(nlr.ret_val);
+    }
+    jl_bulk_finish(&done, &start_us, &interval_us, &late);
+
+    mp_obj_t result[2] = {
+        mp_obj_new_int_from_uint(start_us),
+        mp_obj_new_float(interval_us),
+    };
+    return mp_obj_new_tuple(2, result);
+}
+
+// adc_capture(channels, buffer, rate, times=None)
+static mp_obj_t jl_adc_capture_func(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_channels, ARG_buffer, ARG_rate, ARG_times };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_channels, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_rate, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_times, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    int mask = get_channel_mask(args[ARG_channels].u_obj, 7);
+    return bulk_capture(BULK_ADC, mask, 0, args[ARG_buffer].u_obj, args[ARG_rate].u_obj,
+                        args[ARG_times].u_obj);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(jl_adc_capture_obj, 3, jl_adc_capture_func);
+
+// gpio_capture(buffer, rate, times=None), a byte a row, bit n is GPIO_(n+1)
+static mp_obj_t jl_gpio_capture_func(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_buffer, ARG_rate, ARG_times };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_rate, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_times, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    return bulk_capture(BULK_GPIO, 1, 0, args[ARG_buffer].u_obj, args[ARG_rate].u_obj,
+                        args[ARG_times].u_obj);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(jl_gpio_capture_obj, 2, jl_gpio_capture_func);
+
+// ina_capture(sensors, buffer, rate, quantity="current", times=None)
+static mp_obj_t jl_ina_capture_func(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_sensors, ARG_buffer, ARG_rate, ARG_quantity, ARG_times };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_sensors, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_buffer, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_rate, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_quantity, MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_times, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    int quantity = 0; // INA_CURRENT, INA_BUS_VOLTAGE, INA_POWER
+    if (args[ARG_quantity].u_obj != MP_OBJ_NULL) {
+        const char *name = mp_obj_str_get_str(args[ARG_quantity].u_obj);
+        if (strcmp(name, "current") == 0) {
+            quantity = 0;
+        } else if (strcmp(name, "voltage") == 0) {
+            quantity = 1;
+        } else if (strcmp(name, "power") == 0) {
+            quantity = 2;
+        } else {
+            mp_raise_ValueError(MP_ERROR_TEXT("quantity must be 'current', 'voltage' or 'power'"));
+        }
+    }
+    int mask = get_channel_mask(args[ARG_sensors].u_obj, 1);
+    return bulk_capture(BULK_INA, mask, quantity, args[ARG_buffer].u_obj, args[ARG_rate].u_obj,
+                        args[ARG_times].u_obj);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(jl_ina_capture_obj, 3, jl_ina_capture_func);
+
+static mp_obj_t jl_capture_stats_func(void) {
+    jl_bulk_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_capture_stats_obj, jl_capture_stats_func);
+
 // GPIO Functions
 // Helper: map an incoming pin object (int or node) to a physical GPIO that
 // jl_gpio_* backends understand. Supports:
@@ -1551,12 +1955,202 @@ static mp_obj_t jl_pwm_stop_func(mp_obj_t pin_obj) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(jl_pwm_stop_obj, jl_pwm_stop_func);
 
+static mp_obj_t jl_pwm_sync_func(size_t n_args, const mp_obj_t *args) {
+    // pwm_sync(pin, ...) restarts them together
+    int pins = 0;
+    for (size_t i = 0; i < n_args; i++) {
+        int gpio_pin = mp_obj_get_int(args[i]);
+        
+        // Convert GPIO node constants (131-138) to pin numbers (1-8)
+        if (gpio_pin >= 131 && gpio_pin <= 138) {
+            gpio_pin = gpio_pin - 131 + 1;
+        }
+        
+        if (gpio_pin < 1 || gpio_pin > 8) {
+            mp_raise_ValueError(MP_ERROR_TEXT("GPIO pin must be 1-8 or GPIO_1-GPIO_8"));
+        }
+        pins |= 1 << (gpio_pin - 1);
+    }
+    
+    if (jl_pwm_sync(pins) != 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("None of those pins have PWM running"));
+    }
+    
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR(jl_pwm_sync_obj, 1, jl_pwm_sync_func);
+
+// Sequencer Functions
+// GPIO_1-8, 1-8 or 20-27 to 1-8
+static int get_sequence_pin(mp_obj_t obj) {
+    int pin = get_node_value(obj);
+    if (pin >= 131 && pin <= 138) {
+        pin = pin - 131 + 1;
+    } else if (pin >= 20 && pin <= 27) {
+        pin = pin - 20 + 1;
+    }
+    if (pin < 1 || pin > 8) {
+        mp_raise_ValueError(MP_ERROR_TEXT("GPIO pin must be 1-8 or GPIO_1-GPIO_8"));
+    }
+    return pin;
+}
+
+static uint32_t get_sequence_time(mp_obj_t obj) {
+    mp_int_t us = mp_obj_get_int(obj);
+    if (us < 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Event time must be 0 or more microseconds"));
+    }
+    return (uint32_t)us;
+}
+
+static mp_obj_t jl_sequence_clear_func(void) {
+    jl_sequence_clear();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_sequence_clear_obj, jl_sequence_clear_func);
+
+static mp_obj_t jl_sequence_add_func(mp_obj_t time_obj, mp_obj_t output_obj, mp_obj_t value_obj) {
+    // sequence_add(time_us, output, value): volts for DAC0/DAC1/rails, a level for GPIO
+    uint32_t at = get_sequence_time(time_obj);
+    int node = get_node_value(output_obj);
+    int ok;
+    switch (node) {
+        case 106: // DAC0
+        case 107: // DAC1
+        case 101: // TOP_RAIL
+        case 102: // BOTTOM_RAIL
+            ok = jl_sequence_add_volts(at, map_node_to_dac_channel(node), mp_obj_get_float(value_obj));
+            break;
+        default: {
+            int pin = get_sequence_pin(output_obj);
+            int level = get_gpio_state_value(value_obj);
+            if (level != 0 && level != 1) {
+                mp_raise_ValueError(MP_ERROR_TEXT("A sequenced GPIO is HIGH or LOW"));
+            }
+            ok = jl_sequence_add(at, 4 + pin - 1, level); // SEQ_GPIO1
+            break;
+        }
+    }
+    if (!ok) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("sequence is full or running"));
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(jl_sequence_add_obj, jl_sequence_add_func);
+
+static mp_obj_t jl_sequence_add_pwm_func(mp_obj_t time_obj, mp_obj_t pin_obj, mp_obj_t duty_obj) {
+    uint32_t at = get_sequence_time(time_obj);
+    int pin = get_sequence_pin(pin_obj);
+    float duty = mp_obj_get_float(duty_obj);
+    if (duty < 0.0 || duty > 1.0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("PWM duty cycle must be 0.0 to 1.0"));
+    }
+    if (!jl_sequence_add(at, 12 + pin - 1, (int)(duty * 65535.0f + 0.5f))) { // SEQ_PWM1
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("sequence is full or running"));
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(jl_sequence_add_pwm_obj, jl_sequence_add_pwm_func);
+
+static mp_obj_t jl_sequence_start_func(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_loops, ARG_period_us, ARG_trigger, ARG_rising };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_loops, MP_ARG_INT, {.u_int = 1} },
+        { MP_QSTR_period_us, MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_trigger, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_rising, MP_ARG_BOOL, {.u_bool = true} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_loops].u_int < 0 || args[ARG_period_us].u_int < 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("loops and period_us can't be negative"));
+    }
+    int trigger = args[ARG_trigger].u_obj == mp_const_none ? 0 : get_sequence_pin(args[ARG_trigger].u_obj);
+    int error = jl_sequence_start(args[ARG_loops].u_int, args[ARG_period_us].u_int, trigger,
+                                  args[ARG_rising].u_bool);
+    if (error != 0) {
+        int event = jl_sequence_bad_event();
+        if (event >= 0) {
+            mp_raise_msg_varg(&mp_type_ValueError, MP_ERROR_TEXT("%s (event %d)"),
+                              jl_sequence_error_text(error), event);
+        }
+        mp_raise_msg_varg(&mp_type_ValueError, MP_ERROR_TEXT("%s"), jl_sequence_error_text(error));
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(jl_sequence_start_obj, 0, jl_sequence_start_func);
+
+static mp_obj_t jl_sequence_stop_func(void) {
+    jl_sequence_stop();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_sequence_stop_obj, jl_sequence_stop_func);
+
+static mp_obj_t jl_sequence_status_func(void) {
+    // (running, waiting, passes, worst_late_us)
+    int32_t status[4];
+    jl_sequence_status(status);
+    mp_obj_t items[4] = {
+        mp_obj_new_bool(status[0]),
+        mp_obj_new_bool(status[1]),
+        mp_obj_new_int(status[2]),
+        mp_obj_new_int(status[3]),
+    };
+    return mp_obj_new_tuple(4, items);
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_sequence_status_obj, jl_sequence_status_func);
+
+static mp_obj_t jl_sequence_fired_func(void) {
+    // [(scheduled_us, fired_us or None), ...] in the order the events were added
+    int count = jl_sequence_events();
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < count; i++) {
+        int32_t fired = jl_sequence_fired_at(i);
+        mp_obj_t pair[2] = {
+            mp_obj_new_int_from_uint(jl_sequence_scheduled_at(i)),
+            fired < 0 ? mp_const_none : mp_obj_new_int(fired),
+        };
+        mp_obj_list_append(list, mp_obj_new_tuple(2, pair));
+    }
+    return list;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_sequence_fired_obj, jl_sequence_fired_func);
+
+static mp_obj_t jl_sequence_stats_func(void) {
+    jl_sequence_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_sequence_stats_obj, jl_sequence_stats_func);
+
 // Node Functions
+
+// Inside a batch connect/disconnect are only recorded, see jl_batch_begin()
+static void batch_add_or_raise(int node1, int node2, int remove, int save) {
+    int result = jl_batch_add(node1, node2, remove, save);
+    if (result < 0) {
+        mp_raise_msg_varg(&mp_type_ValueError, MP_ERROR_TEXT("can't %s %d and %d"),
+                          remove ? "disconnect" : "connect", node1, node2);
+    } else if (result == 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("too many changes in one batch"));
+    }
+}
+
+static void batch_commit_or_raise(int save) {
+    if (jl_batch_commit(save) < 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("batch doesn't fit in the node file, nothing changed"));
+    }
+}
+
 static mp_obj_t jl_nodes_connect_func(size_t n_args, const mp_obj_t *args) {
     int node1 = get_node_value(args[0]);
     int node2 = get_node_value(args[1]);
     int save = (n_args > 2) ? mp_obj_is_true(args[2]) ? 1 : 0 : 0; // Default save=False (use local copy)
     
+    if (jl_batch_active()) {
+        batch_add_or_raise(node1, node2, 0, save);
+        return mp_const_none;
+    }
     jl_nodes_connect(node1, node2, save);
     return mp_const_none;
 }
@@ -1566,12 +2160,133 @@ static mp_obj_t jl_nodes_disconnect_func(mp_obj_t node1_obj, mp_obj_t node2_obj)
     int node1 = get_node_value(node1_obj);
     int node2 = get_node_value(node2_obj);
     
+    if (jl_batch_active()) {
+        batch_add_or_raise(node1, node2, 1, 1);
+        return mp_const_none;
+    }
     jl_nodes_disconnect(node1, node2);
     return mp_const_none;
 }
 static MP_DEFINE_CONST_FUN_OBJ_2(jl_nodes_disconnect_obj, jl_nodes_disconnect_func);
 
+// connect_many([(a, b), ...], save=False) - one route and one crossbar update for the lot
+static mp_obj_t jl_nodes_connect_many_func(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_pairs, ARG_save };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_pairs, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_save, MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    int save = args[ARG_save].u_bool ? 1 : 0;
+
+    // in a batch already, these just join it
+    bool own = !jl_batch_active();
+    if (own && jl_batch_begin(save) < 0) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("no memory for the batch"));
+    }
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_iter_buf_t iter_buf;
+        mp_obj_t iterable = mp_getiter(args[ARG_pairs].u_obj, &iter_buf);
+        mp_obj_t item;
+        while ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION) {
+            mp_obj_t *pair;
+            mp_obj_get_array_fixed_n(item, 2, &pair);
+            batch_add_or_raise(get_node_value(pair[0]), get_node_value(pair[1]), 0, save);
+        }
+        nlr_pop();
+    } else {
+        if (own) {
+            jl_batch_abort();
+        }
+        nlr_jump(nlr.ret_val);
+    }
+    if (own) {
+        batch_commit_or_raise(save);
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(jl_nodes_connect_many_obj, 1, jl_nodes_connect_many_func);
+
+// with jumperless.batch(save=False): ... - commits when the block ends, drops
+// everything if it raises
+typedef struct _batch_obj_t {
+    mp_obj_base_t base;
+    bool save;
+} batch_obj_t;
+
+static mp_obj_t batch_enter(mp_obj_t self_in) {
+    batch_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    int result = jl_batch_begin(self->save ? 1 : 0);
+    if (result == 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("already in a batch"));
+    } else if (result < 0) {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("no memory for the batch"));
+    }
+    return self_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(batch_enter_obj, batch_enter);
+
+static mp_obj_t batch_exit(size_t n_args, const mp_obj_t *args) {
+    batch_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (args[1] == mp_const_none) {
+        batch_commit_or_raise(self->save ? 1 : 0);
+    } else {
+        jl_batch_abort();
+    }
+    return mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(batch_exit_obj, 4, 4, batch_exit);
+
+static mp_obj_t batch_abort(mp_obj_t self_in) {
+    (void)self_in;
+    jl_batch_abort();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(batch_abort_obj, batch_abort);
+
+static mp_obj_t batch_pending(mp_obj_t self_in) {
+    (void)self_in;
+    return mp_obj_new_int(jl_batch_count());
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(batch_pending_obj, batch_pending);
+
+static const mp_rom_map_elem_t batch_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&batch_enter_obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&batch_exit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_abort), MP_ROM_PTR(&batch_abort_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pending), MP_ROM_PTR(&batch_pending_obj) },
+};
+static MP_DEFINE_CONST_DICT(batch_locals_dict, batch_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    batch_type,
+    MP_QSTR_Batch,
+    MP_TYPE_FLAG_NONE,
+    locals_dict, &batch_locals_dict
+);
+
+static mp_obj_t jl_batch_func(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_save };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_save, MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    batch_obj_t *o = m_new_obj(batch_obj_t);
+    o->base.type = &batch_type;
+    o->save = args[ARG_save].u_bool;
+    return MP_OBJ_FROM_PTR(o);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(jl_batch_obj, 0, jl_batch_func);
+
 static mp_obj_t jl_nodes_clear_func(void) {
+    if (jl_batch_active()) {
+        jl_batch_clear();
+        return mp_const_none;
+    }
     jl_nodes_clear();
     return mp_const_none;
 }
@@ -1787,6 +2502,295 @@ static mp_obj_t jl_pause_core2_func(mp_obj_t pause_obj) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(jl_pause_core2_obj, jl_pause_core2_func);
 
+static mp_obj_t jl_command_cache_stats_func(void) {
+    jl_command_cache_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_command_cache_stats_obj, jl_command_cache_stats_func);
+
+// Script cache Functions
+static mp_obj_t jl_run_script_func(mp_obj_t name_obj) {
+    const char* name = mp_obj_str_get_str(name_obj);
+    if (!jl_run_script(name)) {
+        mp_raise_OSError(MP_ENOENT);
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_run_script_obj, jl_run_script_func);
+
+static mp_obj_t jl_script_cache_warm_func(void) {
+    return mp_obj_new_int(jl_script_cache_warm());
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_script_cache_warm_obj, jl_script_cache_warm_func);
+
+static mp_obj_t jl_script_cache_stats_func(void) {
+    jl_script_cache_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_script_cache_stats_obj, jl_script_cache_stats_func);
+
+// Event Functions
+//
+// Handlers and awaited events are kept per slot: probe_button, encoder,
+// encoder_button and nets are slots 0-3 (their eventSource), GPIO_1-8 are 4-11.
+// Producers push into the ring in EventDispatch.cpp; jl_events_poll(), from
+// the VM hook and mp_hal_delay_ms(), schedules jl_events_dispatch() to empty it.
+#define EVENT_SOURCE_GPIO 4
+#define EVENT_SLOTS 12
+
+MP_REGISTER_ROOT_POINTER(mp_obj_t jl_event_handlers[12]);
+MP_REGISTER_ROOT_POINTER(mp_obj_t jl_event_last[12]);
+// handler calls waiting their turn, (handler, event) pairs in a ring
+#define EVENT_CALLS 32
+MP_REGISTER_ROOT_POINTER(mp_obj_t jl_event_calls[64]);
+
+static const qstr event_source_names[EVENT_SOURCE_GPIO + 1] = {
+    MP_QSTR_probe_button, MP_QSTR_encoder, MP_QSTR_encoder_button, MP_QSTR_nets, MP_QSTR_gpio,
+};
+
+static uint32_t event_counts[EVENT_SLOTS]; // events seen per slot, for Event objects
+static uint32_t event_awaited = 0;        // slots an event() has asked for
+static bool event_scheduled = false;
+static bool event_dispatching = false;
+static uint8_t event_call_head = 0;
+static uint8_t event_call_count = 0;
+
+static int event_slot(mp_obj_t source_obj, mp_obj_t pin_obj) {
+    qstr source = mp_obj_str_get_qstr(source_obj);
+    for (int s = 0; s < EVENT_SOURCE_GPIO; s++) {
+        if (source == event_source_names[s]) {
+            return s;
+        }
+    }
+    if (source != MP_QSTR_gpio) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Event source must be probe_button, encoder, encoder_button, nets or gpio"));
+    }
+    int pin = pin_obj == mp_const_none ? -1 : map_pin_obj_to_physical_gpio(pin_obj);
+    if (pin >= 20 && pin <= 27) {
+        pin -= 19;
+    }
+    if (pin < 1 || pin > 8) {
+        mp_raise_ValueError(MP_ERROR_TEXT("gpio events need a pin, 1-8 or GPIO_1-GPIO_8"));
+    }
+    return EVENT_SOURCE_GPIO + pin - 1;
+}
+
+// turns the producers for a slot on or off to match its handler and waiters
+static void event_update_slot(int slot) {
+    bool wanted = MP_STATE_VM(jl_event_handlers)[slot] != MP_OBJ_NULL || (event_awaited & (1u << slot));
+    if (slot < EVENT_SOURCE_GPIO) {
+        jl_event_enable(slot, wanted);
+        return;
+    }
+    jl_event_gpio_watch(slot - EVENT_SOURCE_GPIO + 1, wanted);
+    bool any = false;
+    for (int s = EVENT_SOURCE_GPIO; s < EVENT_SLOTS; s++) {
+        any |= MP_STATE_VM(jl_event_handlers)[s] != MP_OBJ_NULL || (event_awaited & (1u << s));
+    }
+    jl_event_enable(EVENT_SOURCE_GPIO, any);
+}
+
+// empties the ring into jl_event_last/event_counts and queues the handler
+// calls. Safe inside a handler, so one that waits on an event still sees it
+static void event_record_all(void) {
+    int source, index, value;
+    uint32_t time_us;
+    while (jl_event_pop(&source, &index, &value, &time_us)) {
+        int slot = source < EVENT_SOURCE_GPIO ? source : EVENT_SOURCE_GPIO + index - 1;
+        if (slot < 0 || slot >= EVENT_SLOTS) {
+            continue;
+        }
+        mp_obj_t items[4] = {
+            MP_OBJ_NEW_QSTR(event_source_names[source < EVENT_SOURCE_GPIO ? source : EVENT_SOURCE_GPIO]),
+            MP_OBJ_NEW_SMALL_INT(index),
+            MP_OBJ_NEW_SMALL_INT(value),
+            mp_obj_new_int_from_uint(time_us),
+        };
+        mp_obj_t event = mp_obj_new_tuple(4, items);
+        MP_STATE_VM(jl_event_last)[slot] = event;
+        event_counts[slot]++;
+        mp_obj_t handler = MP_STATE_VM(jl_event_handlers)[slot];
+        if (handler != MP_OBJ_NULL && event_call_count < EVENT_CALLS) {
+            // a full queue means a handler has been stuck for a while, the
+            // event is still in jl_event_last for anything waiting on it
+            int at = (event_call_head + event_call_count) % EVENT_CALLS;
+            MP_STATE_VM(jl_event_calls)[2 * at] = handler;
+            MP_STATE_VM(jl_event_calls)[2 * at + 1] = event;
+            event_call_count++;
+        }
+    }
+}
+
+static void event_dispatch_all(void) {
+    event_record_all();
+    if (event_dispatching) {
+        return; // a handler is running, its caller gets to the queue after it
+    }
+    event_dispatching = true;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        while (event_call_count > 0) {
+            mp_obj_t *call = &MP_STATE_VM(jl_event_calls)[2 * event_call_head];
+            mp_obj_t handler = call[0];
+            mp_obj_t event = call[1];
+            call[0] = call[1] = MP_OBJ_NULL;
+            event_call_head = (event_call_head + 1) % EVENT_CALLS;
+            event_call_count--;
+            // one handler raising doesn't lose the events behind it
+            mp_call_function_1_protected(handler, event);
+            event_record_all();
+        }
+        nlr_pop();
+        event_dispatching = false;
+    } else {
+        // out of memory making a tuple, or something the handler let through
+        event_dispatching = false;
+        nlr_jump(nlr.ret_val);
+    }
+}
+
+static mp_obj_t jl_events_dispatch_func(mp_obj_t arg) {
+    (void)arg;
+    event_scheduled = false;
+    event_dispatch_all();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_events_dispatch_obj, jl_events_dispatch_func);
+
+void jl_events_poll(void) {
+    if (!event_scheduled && jl_event_pending() > 0) {
+        event_scheduled = mp_sched_schedule(MP_OBJ_FROM_PTR(&jl_events_dispatch_obj), mp_const_none);
+    }
+}
+
+// the VM is going away, forget the handlers and stop the producers
+void jl_events_reset(void) {
+    for (int s = 0; s < EVENT_SLOTS; s++) {
+        MP_STATE_VM(jl_event_handlers)[s] = MP_OBJ_NULL;
+        MP_STATE_VM(jl_event_last)[s] = MP_OBJ_NULL;
+        event_counts[s] = 0;
+    }
+    for (int i = 0; i < 2 * EVENT_CALLS; i++) {
+        MP_STATE_VM(jl_event_calls)[i] = MP_OBJ_NULL;
+    }
+    event_call_head = 0;
+    event_call_count = 0;
+    event_awaited = 0;
+    event_scheduled = false;
+    event_dispatching = false;
+    jl_event_clear();
+}
+
+static mp_obj_t jl_on_func(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    // on(source, handler, pin=None), handler(event) or None to stop
+    enum { ARG_source, ARG_handler, ARG_pin };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_source, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_handler, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_pin, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    int slot = event_slot(args[ARG_source].u_obj, args[ARG_pin].u_obj);
+    mp_obj_t handler = args[ARG_handler].u_obj;
+    if (handler != mp_const_none && !mp_obj_is_callable(handler)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("Handler must be callable or None"));
+    }
+    MP_STATE_VM(jl_event_handlers)[slot] = handler == mp_const_none ? MP_OBJ_NULL : handler;
+    event_update_slot(slot);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(jl_on_obj, 2, jl_on_func);
+
+// event(source, pin=None): `await` it, iterate it, or .wait() for the next event
+typedef struct _event_obj_t {
+    mp_obj_base_t base;
+    uint8_t slot;
+    uint32_t seen;
+} event_obj_t;
+
+static bool event_arrived(event_obj_t *self) {
+    event_dispatch_all();
+    if (event_counts[self->slot] == self->seen) {
+        return false;
+    }
+    self->seen = event_counts[self->slot];
+    return true;
+}
+
+static mp_obj_t event_iternext(mp_obj_t self_in) {
+    event_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (event_arrived(self)) {
+        return mp_make_stop_iteration(MP_STATE_VM(jl_event_last)[self->slot]);
+    }
+    // asyncio only runs a task again if it put itself back on the queue before
+    // yielding, which is what asyncio.sleep_ms(0) does on its first step
+    mp_map_elem_t *asyncio = mp_map_lookup(&MP_STATE_VM(mp_loaded_modules_dict).map,
+        MP_OBJ_NEW_QSTR(MP_QSTR_asyncio), MP_MAP_LOOKUP);
+    if (asyncio != NULL) {
+        mp_obj_t sleep = mp_load_attr(asyncio->value, MP_QSTR_sleep_ms);
+        mp_iternext(mp_call_function_1(sleep, MP_OBJ_NEW_SMALL_INT(0)));
+    }
+    return mp_const_none;
+}
+
+static mp_obj_t event_wait(size_t n_args, const mp_obj_t *args) {
+    // wait([timeout_ms]) - the event, or None if it timed out
+    event_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t timeout = n_args > 1 && args[1] != mp_const_none ? mp_obj_get_int(args[1]) : -1;
+    mp_uint_t start = mp_hal_ticks_ms();
+    while (!event_arrived(self)) {
+        if (timeout >= 0 && (mp_int_t)(mp_hal_ticks_ms() - start) >= timeout) {
+            return mp_const_none;
+        }
+        mp_hal_delay_ms(1);
+    }
+    return MP_STATE_VM(jl_event_last)[self->slot];
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(event_wait_obj, 1, 2, event_wait);
+
+static void event_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    event_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->slot < EVENT_SOURCE_GPIO) {
+        mp_printf(print, "Event(%q)", event_source_names[self->slot]);
+    } else {
+        mp_printf(print, "Event(gpio, pin=%d)", self->slot - EVENT_SOURCE_GPIO + 1);
+    }
+}
+
+static const mp_rom_map_elem_t event_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_wait), MP_ROM_PTR(&event_wait_obj) },
+};
+static MP_DEFINE_CONST_DICT(event_locals_dict, event_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    event_type,
+    MP_QSTR_Event,
+    MP_TYPE_FLAG_ITER_IS_ITERNEXT,
+    iter, event_iternext,
+    print, event_print,
+    locals_dict, &event_locals_dict
+);
+
+static mp_obj_t jl_event_func(size_t n_args, const mp_obj_t *args) {
+    int slot = event_slot(args[0], n_args > 1 ? args[1] : mp_const_none);
+    event_awaited |= 1u << slot; // stays on until the VM goes
+    event_update_slot(slot);
+    event_obj_t *o = m_new_obj(event_obj_t);
+    o->base.type = &event_type;
+    o->slot = slot;
+    o->seen = event_counts[slot];
+    return MP_OBJ_FROM_PTR(o);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_event_obj, 1, 2, jl_event_func);
+
+static mp_obj_t jl_event_stats_func(void) {
+    jl_event_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_event_stats_obj, jl_event_stats_func);
+
 // Terminal Color Functions
 static mp_obj_t jl_change_terminal_color_func(size_t n_args, const mp_obj_t *args) {
     int color = -1;
@@ -2510,7 +3514,9 @@ void jl_help_section(const char* section) {
         mp_printf(&mp_plat_print, "   ina_get_current(sensor)          - Read current in amps\n");
         mp_printf(&mp_plat_print, "   ina_get_voltage(sensor)          - Read shunt voltage\n");
         mp_printf(&mp_plat_print, "   ina_get_bus_voltage(sensor)      - Read bus voltage\n");
-        mp_printf(&mp_plat_print, "   ina_get_power(sensor)            - Read power in watts\n\n");
+        mp_printf(&mp_plat_print, "   ina_get_power(sensor)            - Read power in watts\n");
+        mp_printf(&mp_plat_print, "   ina_window(sensor)               - Min/max/avg of recent readings\n");
+        mp_printf(&mp_plat_print, "   ina_stats()                      - Print sampler statistics\n\n");
         mp_printf(&mp_plat_print, "  Aliases: get_current, get_voltage, get_bus_voltage, get_power\n\n");
         mp_printf(&mp_plat_print, "             sensor: 0 or 1\n\n");
     }
@@ -2586,6 +3592,14 @@ void jl_help_section(const char* section) {
         mp_printf(&mp_plat_print, "Misc:\n\n");
         mp_printf(&mp_plat_print, "   arduino_reset()                  - Reset Arduino\n");
         mp_printf(&mp_plat_print, "   pause_core2(bool/int/str)        - Pause/unpause Core2\n");
+        mp_printf(&mp_plat_print, "   command_cache_stats()            - '>' command cache hits and latency\n");
+        mp_printf(&mp_plat_print, "   run_script(name)                 - Run a script, from its .mpy if current\n");
+        mp_printf(&mp_plat_print, "   script_cache_warm()              - Compile all scripts in the background\n");
+        mp_printf(&mp_plat_print, "   script_cache_stats()             - Script .mpy cache hits and timing\n");
+        mp_printf(&mp_plat_print, "   on(source, handler, [pin])       - Call handler(event) on probe_button, encoder,\n");
+        mp_printf(&mp_plat_print, "                                      encoder_button, nets or gpio events\n");
+        mp_printf(&mp_plat_print, "   event(source, [pin])             - Awaitable for the next event, or .wait([ms])\n");
+        mp_printf(&mp_plat_print, "   event_stats()                    - Event queue counters\n");
         mp_printf(&mp_plat_print, "   probe_tap(node)                  - Tap probe on node (unimplemented)\n");
         mp_printf(&mp_plat_print, "   run_app(appName)                 - Run app\n");
         mp_printf(&mp_plat_print, "   format_output(True/False)        - Enable/disable formatted output\n\n");
@@ -3210,6 +4224,12 @@ static MP_DEFINE_CONST_FUN_OBJ_0(jl_get_current_slot_obj, jl_get_current_slot);
 
 // Import stat function for module importing
 mp_import_stat_t mp_import_stat(const char *path) {
+    // there's no file reader to load a .mpy with, the lexer would get its
+    // bytes as source. The script cache's .mpy files are only for running
+    size_t len = strlen(path);
+    if (len > 4 && strcmp(path + len - 4, ".mpy") == 0) {
+        return MP_IMPORT_STAT_NO_EXIST;
+    }
     if (jl_fs_exists(path)) {
         return MP_IMPORT_STAT_FILE;
     }
@@ -3346,6 +4366,294 @@ static mp_obj_t jl_la_get_control_digital_func(mp_obj_t channel_obj) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(jl_la_get_control_digital_obj, jl_la_get_control_digital_func);
 
+// la_capture_file(path) -> bytes written, one capture with the current settings
+static mp_obj_t jl_la_capture_file_func(mp_obj_t path_obj) {
+    const char *path = mp_obj_str_get_str(path_obj);
+    int written = jl_la_capture_file(path);
+    if (written == -2) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("logic analyzer is busy"));
+    }
+    if (written < 0) {
+        mp_raise_OSError(5); // EIO
+    }
+    return mp_obj_new_int(written);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_la_capture_file_obj, jl_la_capture_file_func);
+
+// la_file_bench(kbytes=256) -> bytes per second the FatFS partition takes
+static mp_obj_t jl_la_file_bench_func(size_t n_args, const mp_obj_t *args) {
+    int kbytes = (n_args > 0) ? mp_obj_get_int(args[0]) : 256;
+    if (kbytes < 4 || kbytes > 4096) {
+        mp_raise_ValueError(MP_ERROR_TEXT("kbytes must be 4-4096"));
+    }
+    return mp_obj_new_int(jl_la_file_bench(kbytes));
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_la_file_bench_obj, 0, 1, jl_la_file_bench_func);
+
+static mp_obj_t jl_la_file_stats_func(void) {
+    jl_la_file_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_la_file_stats_obj, jl_la_file_stats_func);
+
+//=============================================================================
+// Animation Functions
+//=============================================================================
+
+// animation_create([0x100000, 0x001000, ...], period_ms, mode=ANIM_LOOP, length=0)
+// Colors are keyframes, length > number of keyframes interpolates between them
+static mp_obj_t jl_animation_create_func(size_t n_args, const mp_obj_t *args) {
+    size_t num_colors;
+    mp_obj_t *items;
+    mp_obj_get_array(args[0], &num_colors, &items);
+
+    if (num_colors == 0 || num_colors > 16) {
+        mp_raise_ValueError(MP_ERROR_TEXT("animation needs 1-16 keyframe colors"));
+    }
+
+    uint32_t colors[16];
+    for (size_t i = 0; i < num_colors; i++) {
+        colors[i] = (uint32_t)mp_obj_get_int_truncated(items[i]) & 0xFFFFFF;
+    }
+
+    int period_ms = mp_obj_get_int(args[1]);
+    int mode = (n_args > 2) ? mp_obj_get_int(args[2]) : 0;
+    int length = (n_args > 3) ? mp_obj_get_int(args[3]) : 0;
+
+    if (mode < 0 || mode > 2) {
+        mp_raise_ValueError(MP_ERROR_TEXT("mode must be ANIM_LOOP, ANIM_PINGPONG or ANIM_ONESHOT"));
+    }
+
+    int id = jl_animation_create(colors, (int)num_colors, period_ms, mode, length);
+    if (id < 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("no free animation slots"));
+    }
+    return mp_obj_new_int(id);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_animation_create_obj, 2, 4, jl_animation_create_func);
+
+// animation_play(id, node, spread=1)
+static mp_obj_t jl_animation_play_func(size_t n_args, const mp_obj_t *args) {
+    int id = mp_obj_get_int(args[0]);
+    int node = get_node_value(args[1]);
+    int spread = (n_args > 2) ? mp_obj_get_int(args[2]) : 1;
+
+    if (!jl_animation_play(id, node, spread)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid animation id"));
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_animation_play_obj, 2, 3, jl_animation_play_func);
+
+static mp_obj_t jl_animation_stop_func(mp_obj_t id_obj) {
+    jl_animation_stop(mp_obj_get_int(id_obj));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_animation_stop_obj, jl_animation_stop_func);
+
+static mp_obj_t jl_animation_delete_func(mp_obj_t id_obj) {
+    jl_animation_delete(mp_obj_get_int(id_obj));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(jl_animation_delete_obj, jl_animation_delete_func);
+
+static mp_obj_t jl_animation_set_period_func(mp_obj_t id_obj, mp_obj_t period_obj) {
+    jl_animation_set_period(mp_obj_get_int(id_obj), mp_obj_get_int(period_obj));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(jl_animation_set_period_obj, jl_animation_set_period_func);
+
+static mp_obj_t jl_animation_stats_func(void) {
+    jl_animation_stats();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_animation_stats_obj, jl_animation_stats_func);
+
+// animation_play_file(path, loops=1, brightness=0) - plays a .jla asset, blocks until done
+static mp_obj_t jl_animation_play_file_func(size_t n_args, const mp_obj_t *args) {
+    const char *path = mp_obj_str_get_str(args[0]);
+    int loops = (n_args > 1) ? mp_obj_get_int(args[1]) : 1;
+    int brightness = (n_args > 2) ? mp_obj_get_int(args[2]) : 0;
+
+    int frames = jl_animation_play_file(path, loops, brightness);
+    if (frames < 0) {
+        mp_raise_OSError(MP_ENOENT);
+    }
+    return mp_obj_new_int(frames);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_animation_play_file_obj, 1, 3, jl_animation_play_file_func);
+
+//=============================================================================
+// Protocol Decoder Functions
+//=============================================================================
+
+// decoder_add(DECODE_UART, rx, baud) / (DECODE_I2C, (scl, sda)) /
+// (DECODE_SPI, (clk, mosi, miso, cs), 0, mode) / (DECODE_ONEWIRE, dq)
+// Pins are logic analyzer channels 0-7 (GP20-GP27), -1 for unused SPI pins
+static mp_obj_t jl_decoder_add_func(size_t n_args, const mp_obj_t *args) {
+    int protocol = mp_obj_get_int(args[0]);
+    int pins[4] = {-1, -1, -1, -1};
+    size_t num_pins = 1;
+
+    if (mp_obj_is_int(args[1])) {
+        pins[0] = mp_obj_get_int(args[1]);
+    } else {
+        mp_obj_t *items;
+        mp_obj_get_array(args[1], &num_pins, &items);
+        if (num_pins == 0 || num_pins > 4) {
+            mp_raise_ValueError(MP_ERROR_TEXT("decoders take 1-4 pins"));
+        }
+        for (size_t i = 0; i < num_pins; i++) {
+            pins[i] = mp_obj_get_int(items[i]);
+        }
+    }
+    int rate = (n_args > 2) ? mp_obj_get_int(args[2]) : 0;
+    int mode = (n_args > 3) ? mp_obj_get_int(args[3]) : 0;
+
+    if (protocol < 1 || protocol > 4) {
+        mp_raise_ValueError(MP_ERROR_TEXT("protocol must be DECODE_UART, DECODE_I2C, DECODE_SPI or DECODE_ONEWIRE"));
+    }
+    int slot = jl_decoder_add(protocol, pins, (int)num_pins, rate, mode);
+    if (slot == -2) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("no free decoder slots"));
+    }
+    if (slot < 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("bad pins or rate for this protocol"));
+    }
+    return mp_obj_new_int(slot);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_decoder_add_obj, 2, 4, jl_decoder_add_func);
+
+// decoder_remove(slot=-1) - -1 removes them all
+static mp_obj_t jl_decoder_remove_func(size_t n_args, const mp_obj_t *args) {
+    jl_decoder_remove((n_args > 0) ? mp_obj_get_int(args[0]) : -1);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_decoder_remove_obj, 0, 1, jl_decoder_remove_func);
+
+// decoder_read(max=64) -> [(sample, slot, type, data), ...] oldest first
+static mp_obj_t jl_decoder_read_func(size_t n_args, const mp_obj_t *args) {
+    int max = (n_args > 0) ? mp_obj_get_int(args[0]) : 64;
+    if (max < 1 || max > 128) {
+        mp_raise_ValueError(MP_ERROR_TEXT("max must be 1-128"));
+    }
+
+    uint32_t raw[2 * 128];
+    int n = jl_decoder_read(raw, max);
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < n; i++) {
+        uint32_t packed = raw[2 * i + 1];
+        mp_obj_t event[4] = {
+            mp_obj_new_int_from_uint(raw[2 * i]),
+            MP_OBJ_NEW_SMALL_INT(packed & 0xFF),
+            MP_OBJ_NEW_SMALL_INT((packed >> 8) & 0xFF),
+            MP_OBJ_NEW_SMALL_INT(packed >> 16),
+        };
+        mp_obj_list_append(list, mp_obj_new_tuple(4, event));
+    }
+    return list;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_decoder_read_obj, 0, 1, jl_decoder_read_func);
+
+// decoder_feed(samples, sample_rate) - decodes a buffer captured some other
+// way from scratch, returns how many events it queued
+static mp_obj_t jl_decoder_feed_func(mp_obj_t buf_obj, mp_obj_t rate_obj) {
+    mp_buffer_info_t buf;
+    mp_get_buffer_raise(buf_obj, &buf, MP_BUFFER_READ);
+    int rate = mp_obj_get_int(rate_obj);
+    if (rate <= 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("sample_rate must be positive"));
+    }
+    return mp_obj_new_int(jl_decoder_feed((const uint8_t *)buf.buf, (int)buf.len, rate));
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(jl_decoder_feed_obj, jl_decoder_feed_func);
+
+// decoder_stats() -> (sample_rate, samples, events, dropped)
+static mp_obj_t jl_decoder_stats_func(void) {
+    uint32_t stats[4];
+    jl_decoder_stats(stats);
+    mp_obj_t items[4];
+    for (int i = 0; i < 4; i++) {
+        items[i] = mp_obj_new_int_from_uint(stats[i]);
+    }
+    return mp_obj_new_tuple(4, items);
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_decoder_stats_obj, jl_decoder_stats_func);
+
+//=============================================================================
+// Telemetry Functions
+//=============================================================================
+
+// telemetry_start(channels, rate=100) - channels is a TELEMETRY_* constant or
+// a list of them, returns the record size in bytes
+static mp_obj_t jl_telemetry_start_func(size_t n_args, const mp_obj_t *args) {
+    uint32_t mask = 0;
+    if (mp_obj_is_int(args[0])) {
+        int channel = mp_obj_get_int(args[0]);
+        if (channel < 0 || channel > 14) {
+            mp_raise_ValueError(MP_ERROR_TEXT("telemetry channels are 0-14"));
+        }
+        mask = 1UL << channel;
+    } else {
+        size_t count;
+        mp_obj_t *items;
+        mp_obj_get_array(args[0], &count, &items);
+        for (size_t i = 0; i < count; i++) {
+            int channel = mp_obj_get_int(items[i]);
+            if (channel < 0 || channel > 14) {
+                mp_raise_ValueError(MP_ERROR_TEXT("telemetry channels are 0-14"));
+            }
+            mask |= 1UL << channel;
+        }
+    }
+    int rate = (n_args > 1) ? mp_obj_get_int(args[1]) : 100;
+
+    if (mask == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("no channels"));
+    }
+    if (rate < 1 || rate > 5000) {
+        mp_raise_ValueError(MP_ERROR_TEXT("rate must be 1-5000 Hz"));
+    }
+    int size = jl_telemetry_start(mask, rate);
+    if (size < 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("no timer for telemetry"));
+    }
+    return mp_obj_new_int(size);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_telemetry_start_obj, 1, 2, jl_telemetry_start_func);
+
+static mp_obj_t jl_telemetry_stop_func(void) {
+    jl_telemetry_stop();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_telemetry_stop_obj, jl_telemetry_stop_func);
+
+// telemetry_read(max_bytes=4096) -> bytes, whole records only, oldest first
+static mp_obj_t jl_telemetry_read_func(size_t n_args, const mp_obj_t *args) {
+    int max_bytes = (n_args > 0) ? mp_obj_get_int(args[0]) : 4096;
+    if (max_bytes < 1 || max_bytes > 16384) {
+        mp_raise_ValueError(MP_ERROR_TEXT("max_bytes must be 1-16384"));
+    }
+
+    vstr_t vstr;
+    vstr_init_len(&vstr, max_bytes);
+    vstr.len = jl_telemetry_read((uint8_t *)vstr.buf, max_bytes);
+    return mp_obj_new_bytes_from_vstr(&vstr);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(jl_telemetry_read_obj, 0, 1, jl_telemetry_read_func);
+
+// telemetry_info() -> (mask, rate, record_size, buffered, records, dropped)
+static mp_obj_t jl_telemetry_info_func(void) {
+    uint32_t info[6];
+    jl_telemetry_info(info);
+    mp_obj_t items[6];
+    for (int i = 0; i < 6; i++) {
+        items[i] = mp_obj_new_int_from_uint(info[i]);
+    }
+    return mp_obj_new_tuple(6, items);
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(jl_telemetry_info_obj, jl_telemetry_info_func);
+
 //=============================================================================
 // Module Definition
 //=============================================================================
@@ -3578,6 +4886,7 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     
     // ADC functions
     { MP_ROM_QSTR(MP_QSTR_adc_get), MP_ROM_PTR(&jl_adc_get_obj) },
+    { MP_ROM_QSTR(MP_QSTR_adc_stats), MP_ROM_PTR(&jl_adc_stats_obj) },
     
     // ADC function aliases
     { MP_ROM_QSTR(MP_QSTR_get_adc), MP_ROM_PTR(&jl_adc_get_obj) },
@@ -3587,6 +4896,12 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_ina_get_voltage), MP_ROM_PTR(&jl_ina_get_voltage_obj) },
     { MP_ROM_QSTR(MP_QSTR_ina_get_bus_voltage), MP_ROM_PTR(&jl_ina_get_bus_voltage_obj) },
     { MP_ROM_QSTR(MP_QSTR_ina_get_power), MP_ROM_PTR(&jl_ina_get_power_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ina_window), MP_ROM_PTR(&jl_ina_window_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ina_stats), MP_ROM_PTR(&jl_ina_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_adc_capture), MP_ROM_PTR(&jl_adc_capture_obj) },
+    { MP_ROM_QSTR(MP_QSTR_gpio_capture), MP_ROM_PTR(&jl_gpio_capture_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ina_capture), MP_ROM_PTR(&jl_ina_capture_obj) },
+    { MP_ROM_QSTR(MP_QSTR_capture_stats), MP_ROM_PTR(&jl_capture_stats_obj) },
     
     // INA function aliases
     { MP_ROM_QSTR(MP_QSTR_get_ina_current), MP_ROM_PTR(&jl_ina_get_current_obj) },
@@ -3619,6 +4934,7 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_pwm_set_duty_cycle), MP_ROM_PTR(&jl_pwm_set_duty_cycle_obj) },
     { MP_ROM_QSTR(MP_QSTR_pwm_set_frequency), MP_ROM_PTR(&jl_pwm_set_frequency_obj) },
     { MP_ROM_QSTR(MP_QSTR_pwm_stop), MP_ROM_PTR(&jl_pwm_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pwm_sync), MP_ROM_PTR(&jl_pwm_sync_obj) },
     
     // PWM function aliases
     { MP_ROM_QSTR(MP_QSTR_set_pwm), MP_ROM_PTR(&jl_pwm_obj) },
@@ -3642,6 +4958,25 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_wavegen_start), MP_ROM_PTR(&jl_wavegen_start_obj) },
     { MP_ROM_QSTR(MP_QSTR_start_wavegen), MP_ROM_PTR(&jl_wavegen_start_obj) },
     { MP_ROM_QSTR(MP_QSTR_wavegen_stop), MP_ROM_PTR(&jl_wavegen_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wavegen_add_output), MP_ROM_PTR(&jl_wavegen_add_output_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wavegen_remove_output), MP_ROM_PTR(&jl_wavegen_remove_output_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wavegen_set_phase), MP_ROM_PTR(&jl_wavegen_set_phase_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wavegen_set_harmonic), MP_ROM_PTR(&jl_wavegen_set_harmonic_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wavegen_stats), MP_ROM_PTR(&jl_wavegen_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wavegen_load_cycle), MP_ROM_PTR(&jl_wavegen_load_cycle_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wavegen_play), MP_ROM_PTR(&jl_wavegen_play_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wavegen_play_stop), MP_ROM_PTR(&jl_wavegen_play_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wavegen_play_status), MP_ROM_PTR(&jl_wavegen_play_status_obj) },
+
+    // Sequencer
+    { MP_ROM_QSTR(MP_QSTR_sequence_clear), MP_ROM_PTR(&jl_sequence_clear_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sequence_add), MP_ROM_PTR(&jl_sequence_add_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sequence_add_pwm), MP_ROM_PTR(&jl_sequence_add_pwm_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sequence_start), MP_ROM_PTR(&jl_sequence_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sequence_stop), MP_ROM_PTR(&jl_sequence_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sequence_status), MP_ROM_PTR(&jl_sequence_status_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sequence_fired), MP_ROM_PTR(&jl_sequence_fired_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sequence_stats), MP_ROM_PTR(&jl_sequence_stats_obj) },
     { MP_ROM_QSTR(MP_QSTR_stop_wavegen), MP_ROM_PTR(&jl_wavegen_stop_obj) },
     // Getters
     { MP_ROM_QSTR(MP_QSTR_wavegen_get_output), MP_ROM_PTR(&jl_wavegen_get_output_obj) },
@@ -3659,6 +4994,8 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     // Node functions
     { MP_ROM_QSTR(MP_QSTR_connect), MP_ROM_PTR(&jl_nodes_connect_obj) },
     { MP_ROM_QSTR(MP_QSTR_disconnect), MP_ROM_PTR(&jl_nodes_disconnect_obj) },
+    { MP_ROM_QSTR(MP_QSTR_connect_many), MP_ROM_PTR(&jl_nodes_connect_many_obj) },
+    { MP_ROM_QSTR(MP_QSTR_batch), MP_ROM_PTR(&jl_batch_obj) },
     { MP_ROM_QSTR(MP_QSTR_nodes_clear), MP_ROM_PTR(&jl_nodes_clear_obj) },
     { MP_ROM_QSTR(MP_QSTR_is_connected), MP_ROM_PTR(&jl_nodes_is_connected_obj) },
     { MP_ROM_QSTR(MP_QSTR_nodes_save), MP_ROM_PTR(&jl_nodes_save_obj) },
@@ -3682,6 +5019,13 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     // Misc functions
     { MP_ROM_QSTR(MP_QSTR_arduino_reset), MP_ROM_PTR(&jl_arduino_reset_obj) },
     { MP_ROM_QSTR(MP_QSTR_pause_core2), MP_ROM_PTR(&jl_pause_core2_obj) },
+    { MP_ROM_QSTR(MP_QSTR_command_cache_stats), MP_ROM_PTR(&jl_command_cache_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run_script), MP_ROM_PTR(&jl_run_script_obj) },
+    { MP_ROM_QSTR(MP_QSTR_script_cache_warm), MP_ROM_PTR(&jl_script_cache_warm_obj) },
+    { MP_ROM_QSTR(MP_QSTR_script_cache_stats), MP_ROM_PTR(&jl_script_cache_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_on), MP_ROM_PTR(&jl_on_obj) },
+    { MP_ROM_QSTR(MP_QSTR_event), MP_ROM_PTR(&jl_event_obj) },
+    { MP_ROM_QSTR(MP_QSTR_event_stats), MP_ROM_PTR(&jl_event_stats_obj) },
     { MP_ROM_QSTR(MP_QSTR_run_app), MP_ROM_PTR(&jl_run_app_obj) },
     { MP_ROM_QSTR(MP_QSTR_change_terminal_color), MP_ROM_PTR(&jl_change_terminal_color_obj) },
     { MP_ROM_QSTR(MP_QSTR_cycle_term_color), MP_ROM_PTR(&jl_cycle_term_color_obj) },
@@ -3761,6 +5105,52 @@ static const mp_rom_map_elem_t jumperless_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_la_set_control_digital), MP_ROM_PTR(&jl_la_set_control_digital_obj) },
     { MP_ROM_QSTR(MP_QSTR_la_get_control_analog), MP_ROM_PTR(&jl_la_get_control_analog_obj) },
     { MP_ROM_QSTR(MP_QSTR_la_get_control_digital), MP_ROM_PTR(&jl_la_get_control_digital_obj) },
+    { MP_ROM_QSTR(MP_QSTR_la_capture_file), MP_ROM_PTR(&jl_la_capture_file_obj) },
+    { MP_ROM_QSTR(MP_QSTR_la_file_bench), MP_ROM_PTR(&jl_la_file_bench_obj) },
+    { MP_ROM_QSTR(MP_QSTR_la_file_stats), MP_ROM_PTR(&jl_la_file_stats_obj) },
+
+    // Keyframe animations
+    { MP_ROM_QSTR(MP_QSTR_animation_create), MP_ROM_PTR(&jl_animation_create_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animation_play), MP_ROM_PTR(&jl_animation_play_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animation_stop), MP_ROM_PTR(&jl_animation_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animation_delete), MP_ROM_PTR(&jl_animation_delete_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animation_set_period), MP_ROM_PTR(&jl_animation_set_period_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animation_stats), MP_ROM_PTR(&jl_animation_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_animation_play_file), MP_ROM_PTR(&jl_animation_play_file_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ANIM_LOOP), MP_ROM_INT(0) },
+    { MP_ROM_QSTR(MP_QSTR_ANIM_PINGPONG), MP_ROM_INT(1) },
+    { MP_ROM_QSTR(MP_QSTR_ANIM_ONESHOT), MP_ROM_INT(2) },
+
+    // Protocol decoders
+    { MP_ROM_QSTR(MP_QSTR_decoder_add), MP_ROM_PTR(&jl_decoder_add_obj) },
+    { MP_ROM_QSTR(MP_QSTR_decoder_remove), MP_ROM_PTR(&jl_decoder_remove_obj) },
+    { MP_ROM_QSTR(MP_QSTR_decoder_read), MP_ROM_PTR(&jl_decoder_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_decoder_feed), MP_ROM_PTR(&jl_decoder_feed_obj) },
+    { MP_ROM_QSTR(MP_QSTR_decoder_stats), MP_ROM_PTR(&jl_decoder_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_UART), MP_ROM_INT(1) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_I2C), MP_ROM_INT(2) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_SPI), MP_ROM_INT(3) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_ONEWIRE), MP_ROM_INT(4) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_DATA), MP_ROM_INT(0) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_START), MP_ROM_INT(1) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_STOP), MP_ROM_INT(2) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_ADDRESS), MP_ROM_INT(3) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_PRESENCE), MP_ROM_INT(4) },
+    { MP_ROM_QSTR(MP_QSTR_DECODE_ERROR), MP_ROM_INT(5) },
+
+    // Telemetry
+    { MP_ROM_QSTR(MP_QSTR_telemetry_start), MP_ROM_PTR(&jl_telemetry_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_telemetry_stop), MP_ROM_PTR(&jl_telemetry_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_telemetry_read), MP_ROM_PTR(&jl_telemetry_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_telemetry_info), MP_ROM_PTR(&jl_telemetry_info_obj) },
+    { MP_ROM_QSTR(MP_QSTR_TELEMETRY_ADC), MP_ROM_INT(0) },
+    { MP_ROM_QSTR(MP_QSTR_TELEMETRY_INA0_CURRENT), MP_ROM_INT(8) },
+    { MP_ROM_QSTR(MP_QSTR_TELEMETRY_INA0_VOLTAGE), MP_ROM_INT(9) },
+    { MP_ROM_QSTR(MP_QSTR_TELEMETRY_INA0_POWER), MP_ROM_INT(10) },
+    { MP_ROM_QSTR(MP_QSTR_TELEMETRY_INA1_CURRENT), MP_ROM_INT(11) },
+    { MP_ROM_QSTR(MP_QSTR_TELEMETRY_INA1_VOLTAGE), MP_ROM_INT(12) },
+    { MP_ROM_QSTR(MP_QSTR_TELEMETRY_INA1_POWER), MP_ROM_INT(13) },
+    { MP_ROM_QSTR(MP_QSTR_TELEMETRY_GPIO), MP_ROM_INT(14) },
 };
 
 static MP_DEFINE_CONST_DICT(jumperless_module_globals, jumperless_module_globals_table);
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Checks the '>' command cache's keys (src/CommandTemplate.cpp) on the host.
+
+Builds CommandTemplate.cpp with a small harness that reads commands on stdin
+and prints the key and the numbers taken out of each. This script then checks:
+
+  - commands that differ only in their numbers get the same key
+  - ints, floats and exponents come out with the right values
+  - numbers in names, strings, triple-quoted strings and comments stay put
+  - hex, complex, underscored and leading-dot numbers stay in the key
+  - only the first eight numbers are taken out
+  - a command too long for the key is refused
+  - commands that leave code to run later (def, lambda, class, for) keep
+    their numbers, and a function defined that way still sees them after
+    another command has bound __jl0
+  - the assignments, run from their keys in Python, give what the commands did
+
+    command_template_test.py
+    command_template_test.py --cxx clang++ -v
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, "..", "src")
+
+HARNESS = r"""
+#include <cstdio>
+#include <cstring>
+#include "CommandTemplate.h"
+
+// a command a line, "key\t<key>" then a "lit" line per number, or "refused"
+int main() {
+    char line[1024];
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\n")] = '\0';
+        // \n in the input stands for a newline in the command
+        for (char *p = line; (p = strstr(p, "\\n")) != nullptr;) {
+            *p = '\n';
+            memmove(p + 1, p + 2, strlen(p + 2) + 1);
+        }
+        char key[COMMAND_TEMPLATE_KEY_MAX];
+        commandLiteral lits[COMMAND_TEMPLATE_MAX_LITERALS];
+        int n = commandTemplate(line, key, sizeof(key), lits);
+        if (n < 0) {
+            printf("refused\n");
+            continue;
+        }
+        for (char *p = key; *p; p++) {
+            if (*p == '\n') *p = '\x1f';
+        }
+        printf("key\t%s\t%d\n", key, n);
+        for (int i = 0; i < n; i++) {
+            if (lits[i].isFloat) {
+                printf("lit f %.17g\n", lits[i].f);
+            } else {
+                printf("lit i %d\n", lits[i].i);
+            }
+        }
+    }
+    return 0;
+}
+"""
+
+
+def build(cxx):
+    tmp = tempfile.mkdtemp()
+    src = os.path.join(tmp, "template_test.cpp")
+    exe = os.path.join(tmp, "template_test")
+    with open(src, "w") as f:
+        f.write(HARNESS)
+    subprocess.check_call([cxx, "-O2", "-std=c++17", "-Wall", "-I", SRC, src,
+                           os.path.join(SRC, "CommandTemplate.cpp"), "-o", exe])
+    return exe
+
+
+def run(exe, commands):
+    text = "\n".join(c.replace("\n", "\\n") for c in commands) + "\n"
+    out = subprocess.check_output([exe], input=text, text=True)
+    results = []
+    for line in out.splitlines():
+        if line == "refused":
+            results.append(None)
+        elif line.startswith("key\t"):
+            _, key, _ = line.split("\t")
+            results.append([key.replace("\x1f", "\n"), []])
+        else:
+            _, kind, value = line.split()
+            results[-1][1].append(float(value) if kind == "f" else int(value))
+    return results
+
+
+CASES = [
+    "gpio_get(2)",
+    "gpio_get(7)",
+    "dac_set(0, 2.5)",
+    "dac_set(1, -3.25)",
+    "x = 1e3 + 2.5E-1 + 7.",
+    "connect(D13, GPIO_1)",
+    "print('row 12', \"5\", x)",
+    "s = '''a 1\n2 b'''",
+    "y = 4 # set 5",
+    "z = 0x10 + 1j.imag + 1_000 + .5",
+    "t = (1, 2, 3, 4, 5, 6, 7, 8, 9, 10)",
+    "u = 'it\\'s 3' + str(4)",
+    "v = 1234567890 + 123456789",
+    "w = [1, 2][0:1]",
+    "connect(%s)" % ", ".join(["1"] * 60),
+    "def f(): return 5",
+    "g = lambda: 3",
+    "h = (i + 1 for i in range(2))",
+    "class C: n = 4",
+    "before = 7",
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cxx", default="c++")
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    results = dict(zip(CASES, run(build(args.cxx), CASES)))
+    failures = 0
+
+    def check(ok, what):
+        nonlocal failures
+        if not ok:
+            failures += 1
+            print("FAIL " + what)
+        elif args.verbose:
+            print("ok   " + what)
+
+    def expect(command, key, lits):
+        got = results[command]
+        check(got is not None and got[0] == key and got[1] == lits,
+              "%r -> %r" % (command, got))
+
+    expect("gpio_get(2)", "gpio_get(__jl0)", [2])
+    check(results["gpio_get(2)"][0] == results["gpio_get(7)"][0], "same key for gpio_get(2) and (7)")
+    expect("dac_set(0, 2.5)", "dac_set(__jl0, __jl1)", [0, 2.5])
+    expect("dac_set(1, -3.25)", "dac_set(__jl0, -__jl1)", [1, 3.25])
+    expect("x = 1e3 + 2.5E-1 + 7.", "x = __jl0 + __jl1 + __jl2", [1000.0, 0.25, 7.0])
+    expect("connect(D13, GPIO_1)", "connect(D13, GPIO_1)", [])
+    expect("print('row 12', \"5\", x)", "print('row 12', \"5\", x)", [])
+    expect("s = '''a 1\n2 b'''", "s = '''a 1\n2 b'''", [])
+    expect("y = 4 # set 5", "y = __jl0 # set 5", [4])
+    expect("z = 0x10 + 1j.imag + 1_000 + .5", "z = 0x10 + 1j.imag + 1_000 + .5", [])
+    expect("t = (1, 2, 3, 4, 5, 6, 7, 8, 9, 10)",
+           "t = (__jl0, __jl1, __jl2, __jl3, __jl4, __jl5, __jl6, __jl7, 9, 10)",
+           [1, 2, 3, 4, 5, 6, 7, 8])
+    expect("u = 'it\\'s 3' + str(4)", "u = 'it\\'s 3' + str(__jl0)", [4])
+    expect("v = 1234567890 + 123456789", "v = 1234567890 + __jl0", [123456789])
+    expect("w = [1, 2][0:1]", "w = [__jl0, __jl1][__jl2:__jl3]", [1, 2, 0, 1])
+    check(results["connect(%s)" % ", ".join(["1"] * 60)] is None, "too long for the key")
+    for deferred in ("def f(): return 5", "g = lambda: 3", "h = (i + 1 for i in range(2))",
+                     "class C: n = 4"):
+        expect(deferred, deferred, [])
+    expect("before = 7", "before = __jl0", [7])
+
+    # a function from the '>' path, then another cached command rebinding __jl0
+    scope = {}
+    for command in ("def f(): return 5", "gpio_get(2)"):
+        key, lits = results[command]
+        scope.update({"__jl%d" % i: v for i, v in enumerate(lits)})
+        if command.startswith("def"):
+            exec(key, scope)
+    check(scope["f"]() == 5, "f() still returns 5 after gpio_get(2) ran from the cache")
+
+    # the key with the numbers bound runs the same as the command
+    for command in CASES:
+        got = results[command]
+        if got is None or not got[1] or not command[0].isalpha() or "(" in command.split("=")[0]:
+            continue
+        plain, templated = {}, {"__jl%d" % i: v for i, v in enumerate(got[1])}
+        exec(command, plain)
+        exec(got[0], templated)
+        name = command.split("=")[0].strip()
+        check(plain[name] == templated[name], "%r runs the same from its key" % command)
+
+    print("command_template_test %s" % ("passed" if failures == 0 else "FAILED (%d)" % failures))
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
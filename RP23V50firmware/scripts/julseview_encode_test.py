@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Golden-output test and benchmark for the JulseView block encoder.
+
+Builds src/JulseViewEncode.h on the host next to a copy of the per-sample
+encoding from JulseView.cpp (encode_digital_data() / process_analog_sample()),
+checks that they produce the same bytes for every analog channel count and
+odd block length, then times both.
+
+    julseview_encode_test.py               test + benchmark
+    julseview_encode_test.py --cxx clang++
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, "..", "src")
+
+HARNESS = r"""
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "JulseViewEncode.h"
+
+// per-sample encoding, as in julseview::encode_digital_data() and
+// julseview::process_analog_sample()
+static uint32_t reference(const uint8_t* dbuf, const uint8_t* abuf, uint32_t count,
+                          uint8_t a_cnt, uint8_t* txbuf) {
+    uint32_t txbufidx = 0;
+    for (uint32_t s = 0; s < count; s++) {
+        uint32_t cval = dbuf[s] & 0xFF;
+        for (char b = 0; b < 2; b++) {
+            uint8_t data_byte = (cval & 0x7F) + 0x30;
+            if (data_byte < 0x80) data_byte |= 0x80;
+            txbuf[txbufidx++] = data_byte;
+            cval >>= 7;
+        }
+        uint32_t off = s * a_cnt * 2;
+        for (uint8_t i = 0; i < a_cnt; i++) {
+            uint16_t adc_value = abuf[off] | (abuf[off + 1] << 8);
+            uint16_t adc_12bit = adc_value & 0x0FFF;
+            txbuf[txbufidx] = (adc_12bit & 0x7F) + 0x30;
+            txbuf[txbufidx + 1] = ((adc_12bit >> 7) & 0x7F) + 0x30;
+            txbufidx += 2;
+            off += 2;
+        }
+    }
+    return txbufidx;
+}
+
+int main(int argc, char** argv) {
+    const uint32_t samples = 1 << 16;
+    std::vector<uint8_t> dbuf(samples + 8), abuf(samples * 9 * 2 + 8);
+    std::vector<uint8_t> want(samples * 20 + 64), got(samples * 20 + 64);
+    srand(1);
+    for (auto& b : dbuf) b = rand();
+    for (auto& b : abuf) b = rand(); // top nibble set on purpose, it has to be masked
+    int failures = 0;
+
+    // every analog count, every block length, odd offsets into the buffers
+    for (uint8_t a_cnt = 0; a_cnt <= 9; a_cnt++) {
+        for (uint32_t count = 0; count <= 70; count++) {
+            for (uint32_t skew = 0; skew < 4; skew++) {
+                const uint8_t* d = dbuf.data() + skew;
+                const uint8_t* a = abuf.data() + skew;
+                uint32_t n1 = reference(d, a, count, a_cnt, want.data());
+                uint32_t n2 = jv_encode_block(d, a, count, a_cnt, got.data());
+                if (n1 != n2 || memcmp(want.data(), got.data(), n1) != 0) {
+                    if (failures++ < 10)
+                        printf("FAIL a_cnt=%u count=%u skew=%u\n", a_cnt, count, skew);
+                }
+            }
+        }
+        // and the whole buffer in JULSEVIEW_BLOCK_SAMPLES batches like send_slices_analog
+        uint32_t n1 = reference(dbuf.data(), abuf.data(), samples, a_cnt, want.data());
+        uint32_t n2 = 0;
+        for (uint32_t s = 0; s < samples; s += JULSEVIEW_BLOCK_SAMPLES)
+            n2 += jv_encode_block(dbuf.data() + s, abuf.data() + s * a_cnt * 2,
+                                  JULSEVIEW_BLOCK_SAMPLES, a_cnt, got.data() + n2);
+        if (n1 != n2 || memcmp(want.data(), got.data(), n1) != 0) {
+            failures++;
+            printf("FAIL batched a_cnt=%u\n", a_cnt);
+        }
+    }
+    printf("golden: %s\n", failures ? "FAILED" : "identical");
+    if (failures) return 1;
+
+    printf("%-8s %14s %14s %8s\n", "analog", "per-sample/s", "block/s", "speedup");
+    for (uint8_t a_cnt : {0, 1, 4, 8}) {
+        double rates[2];
+        for (int which = 0; which < 2; which++) {
+            volatile uint32_t sink = 0;
+            auto start = std::chrono::steady_clock::now();
+            int rounds = 0;
+            double elapsed = 0;
+            do {
+                for (uint32_t s = 0; s < samples; s += JULSEVIEW_BLOCK_SAMPLES) {
+                    const uint8_t* d = dbuf.data() + s;
+                    const uint8_t* a = abuf.data() + s * a_cnt * 2;
+                    sink += which ? jv_encode_block(d, a, JULSEVIEW_BLOCK_SAMPLES, a_cnt, got.data())
+                                  : reference(d, a, JULSEVIEW_BLOCK_SAMPLES, a_cnt, got.data());
+                }
+                rounds++;
+                elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            } while (elapsed < 0.2);
+            rates[which] = (double)samples * rounds / elapsed;
+        }
+        printf("%-8u %14.0f %14.0f %7.2fx\n", a_cnt, rates[0], rates[1], rates[1] / rates[0]);
+    }
+    return 0;
+}
+"""
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "c++"))
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        source = os.path.join(tmp, "harness.cpp")
+        binary = os.path.join(tmp, "harness")
+        with open(source, "w") as f:
+            f.write(HARNESS)
+        subprocess.check_call([args.cxx, "-O2", "-std=gnu++17", "-Wall", "-I", SRC,
+                               source, "-o", binary])
+        sys.exit(subprocess.call([binary]))
+
+
+if __name__ == "__main__":
+    main()
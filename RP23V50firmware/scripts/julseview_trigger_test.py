@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Checks the JulseView PIO trigger compiler against its software evaluator.
+
+Builds src/JulseViewTrigger.h on the host. The harness makes random AND/OR,
+edge and multi-stage triggers and random pin traces. For each one it prints
+the compiled program and the sample where jv_trigger_feed() fires. This script
+then runs every program on a small PIO simulator, with each sample held on the
+pins for --hold cycles, and checks that irq JV_TRIGGER_IRQ_CAPTURE goes up on
+the same sample. It runs them again with each sample held for only the pass
+length the compiler reports. Then the irq may come up to one sample late per
+stage after the first, but never early and never missed.
+
+    julseview_trigger_test.py
+    julseview_trigger_test.py --cases 20000 --hold 48 --cxx clang++
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, "..", "src")
+
+# Room left on pio1 next to the 11 word capture program
+PROGRAM_ROOM = 21
+IRQ_CAPTURE = 7
+
+HARNESS = r"""
+#include <cstdio>
+#include <cstdlib>
+#include "JulseViewTrigger.h"
+
+static uint8_t bits(int max_set) {
+    uint8_t v = 0;
+    int n = 1 + rand() % max_set;
+    for (int i = 0; i < n; i++) v |= 1u << (rand() % 8);
+    return v;
+}
+
+// as julseview::check_analog_level_trigger(), one sample at a time
+static bool analog_reference(uint16_t v, uint16_t level, int edge, uint16_t* last) {
+    bool up = *last < level && v >= level;
+    bool down = *last > level && v <= level;
+    *last = v;
+    return edge == 0 ? up : edge == 1 ? down : (up || down);
+}
+
+int main(int argc, char** argv) {
+    int cases = argc > 1 ? atoi(argv[1]) : 5000;
+    srand(argc > 2 ? atoi(argv[2]) : 1);
+
+    for (int c = 0; c < cases; c++) {
+        jv_trigger_spec spec;
+        spec.stages = 1 + rand() % 3;
+        for (int i = 0; i < spec.stages; i++) {
+            uint8_t op = (rand() % 4 == 0) ? JV_TRIGGER_OR : JV_TRIGGER_AND;
+            uint8_t mask = bits(3);
+            uint8_t rising = 0, falling = 0;
+            int e = rand() % 8;
+            switch (rand() % (op == JV_TRIGGER_OR ? 8 : 4)) {
+            case 0: rising = 1u << e; break;
+            case 1: falling = 1u << e; break;
+            case 2: rising = falling = 1u << e; break;
+            }
+            if (rand() % 16 == 0) rising |= 1u << ((e + 1) % 8); // two edges: software only
+            spec.stage[i] = jv_trigger_make_stage(op, mask, rand() & 0xFF, rising, falling);
+        }
+
+        uint16_t code[JV_TRIGGER_MAX_PROGRAM];
+        int pass = 0;
+        int len = jv_trigger_compile(&spec, code, JV_TRIGGER_MAX_PROGRAM, &pass);
+
+        // every level held for at least two samples, the PIO needs a few
+        // cycles to get from one stage to the next
+        uint8_t trace[400];
+        int n = 0;
+        uint8_t v = rand() & 0xFF;
+        while (n < (int)sizeof(trace)) {
+            int run = 2 + rand() % 4;
+            for (int r = 0; r < run && n < (int)sizeof(trace); r++) trace[n++] = v;
+            v ^= bits(2);
+        }
+
+        jv_trigger_state st;
+        jv_trigger_reset(&st);
+        int fired = -1;
+        for (int i = 0; i < n; i++) {
+            if (jv_trigger_feed(&spec, &st, trace[i])) { fired = i; break; }
+        }
+
+        printf("%d %d %d", len, pass, spec.stages);
+        for (int i = 0; i < len; i++) printf(" %04x", code[i]);
+        printf(" ;");
+        for (int i = 0; i < n; i++) printf("%02x", trace[i]);
+        printf(" ; %d\n", fired);
+    }
+
+    // analog scan against the one-sample-at-a-time rule, across ring wraps
+    int analog_bad = 0;
+    uint16_t ring[256];
+    for (int c = 0; c < 2000; c++) {
+        uint16_t level = rand() & 0xFFF;
+        int edge = rand() % 3;
+        uint16_t last_ref = 0, last_scan = 0;
+        uint32_t pos = rand() & 0xFF;
+        int left = 1000;
+        while (left > 0) {
+            uint32_t count = 1 + rand() % 100;
+            uint32_t from = pos;
+            int want = -1;
+            for (uint32_t k = 0; k < count; k++) {
+                uint16_t s = (rand() & 0xFFF);
+                ring[pos] = s;
+                if (want < 0 && analog_reference(s, level, edge, &last_ref)) want = pos;
+                pos = (pos + 1) & 0xFF;
+            }
+            int got = jv_analog_level_scan(ring, 0xFF, from, pos, level, edge, &last_scan);
+            if (got != want) { analog_bad++; break; }
+            if (got >= 0) {
+                // pick up after the crossing, like the firmware does
+                last_ref = last_scan = ring[got] & 0xFFF;
+                break;
+            }
+            left -= count;
+        }
+    }
+    printf("analog %d\n", analog_bad);
+    return 0;
+}
+"""
+
+
+def build(cxx):
+    tmp = tempfile.mkdtemp()
+    src = os.path.join(tmp, "trigger_test.cpp")
+    exe = os.path.join(tmp, "trigger_test")
+    with open(src, "w") as f:
+        f.write(HARNESS)
+    subprocess.check_call([cxx, "-O2", "-std=c++17", "-Wall", "-I", SRC, src, "-o", exe])
+    return exe
+
+
+class Pio:
+    """Just enough of an RP2350 state machine for the trigger programs:
+    in base 0, OUT shifting right, one cycle per instruction, no delays."""
+
+    def __init__(self, program):
+        self.program = program
+        self.pc = 0
+        self.x = self.y = self.osr = self.isr = 0
+        self.irq = 0
+        self.snapshot = -1  # sample the last `mov osr, pins` saw
+
+    def step(self, pins, sample):
+        instr = self.program[self.pc]
+        major = instr >> 13
+        nxt = (self.pc + 1) % len(self.program)
+
+        if major == 0:  # jmp
+            cond, addr = (instr >> 5) & 7, instr & 0x1F
+            if cond == 0:
+                take = True
+            elif cond == 1:
+                take = self.x == 0
+            elif cond == 2:
+                take = self.x != 0
+                self.x = (self.x - 1) & 0xFFFFFFFF
+            elif cond == 5:
+                take = self.x != self.y
+            else:
+                raise ValueError("jmp condition %d" % cond)
+            self.pc = addr if take else nxt
+        elif major == 1:  # wait
+            level, src, index = (instr >> 7) & 1, (instr >> 5) & 3, instr & 0x1F
+            if src != 1:
+                raise ValueError("wait source %d" % src)
+            if ((pins >> index) & 1) == level:
+                self.pc = nxt
+        elif major == 3:  # out, shifting right
+            dest, count = (instr >> 5) & 7, (instr & 0x1F) or 32
+            value = self.osr & ((1 << count) - 1)
+            self.osr >>= count
+            if dest == 1:
+                self.x = value
+            elif dest == 2:
+                self.y = value
+            elif dest != 3:
+                raise ValueError("out destination %d" % dest)
+            self.pc = nxt
+        elif major == 5:  # mov
+            dest, src = (instr >> 5) & 7, instr & 7
+            if src == 0:
+                value = pins
+                self.snapshot = sample
+            else:
+                value = {1: self.x, 2: self.y, 6: self.isr, 7: self.osr}[src]
+            if dest == 1:
+                self.x = value
+            elif dest == 2:
+                self.y = value
+            elif dest == 6:
+                self.isr = value
+            elif dest == 7:
+                self.osr = value
+            else:
+                raise ValueError("mov destination %d" % dest)
+            self.pc = nxt
+        elif major == 6 and not instr & 0x60:  # irq set
+            self.irq |= 1 << (instr & 7)
+            self.pc = nxt
+        else:
+            raise ValueError("instruction %04x" % instr)
+
+
+def simulate(program, trace, hold):
+    sm = Pio(program)
+    for cycle in range(len(trace) * hold):
+        sample = cycle // hold
+        sm.step(trace[sample], sample)
+        if sm.irq & (1 << IRQ_CAPTURE):
+            return sm.snapshot
+    return -1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cxx", default="c++")
+    parser.add_argument("--cases", type=int, default=5000)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--hold", type=int, default=64,
+                        help="PIO cycles per sample (default 64)")
+    args = parser.parse_args()
+
+    exe = build(args.cxx)
+    out = subprocess.check_output([exe, str(args.cases), str(args.seed)], text=True)
+
+    compiled = fits = software = fired = tight_late = 0
+    failures = []
+    longest = 0
+    for line in out.splitlines():
+        if line.startswith("analog"):
+            analog_bad = int(line.split()[1])
+            continue
+        words, trace_hex, want = line.split(";")
+        words = words.split()
+        length = int(words[0])
+        want = int(want)
+        if length < 0:
+            software += 1
+            continue
+        pass_cycles, stages = int(words[1]), int(words[2])
+        program = [int(w, 16) for w in words[3:]]
+        trace = bytes.fromhex(trace_hex.strip())
+        compiled += 1
+        fits += length <= PROGRAM_ROOM
+        longest = max(longest, length)
+        fired += want >= 0
+
+        got = simulate(program, trace, args.hold)
+        if got != want:
+            failures.append((program, trace_hex.strip()[:64], want, got))
+        # as fast as the compiler says the program keeps up with: no sample
+        # is skipped, but a stage that already holds on the sample the one
+        # before it matched gets seen on the next snapshot, a sample later
+        got = simulate(program, trace, pass_cycles)
+        if got < 0 and want >= len(trace) - stages:
+            got = want  # the trace ran out before the program got to the irq
+        if (got < 0) != (want < 0) or not 0 <= got - want < stages:
+            failures.append((program, trace_hex.strip()[:64], want, got))
+        tight_late += got - want if want >= 0 else 0
+
+    print("%d triggers: %d compiled (%d fit in %d words, longest %d), %d software only" % (
+        compiled + software, compiled, fits, PROGRAM_ROOM, longest, software))
+    print("%d of the compiled ones fired on their trace" % fired)
+    print("at one pass per sample, %d samples late in all" % tight_late)
+    for program, trace, want, got in failures[:10]:
+        print("MISMATCH want sample %d got %d: %s  trace %s..." % (
+            want, got, " ".join("%04x" % w for w in program), trace))
+    print("analog scan: %s" % ("ok" if analog_bad == 0 else "%d mismatches" % analog_bad))
+
+    if failures or analog_bad:
+        print("%d mismatches" % len(failures))
+        sys.exit(1)
+    print("identical")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,356 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Reference codec, self test and benchmark for the logic analyzer binary transport.
+
+The logic analyzer on the second CDC port speaks 7-bit ASCII (two bytes per
+digital or analog value) unless the client asks for binary frames with "B1"
+after reset. See src/LogicAnalyzer.h for the frame types and
+src/BinaryStream.h for the framing.
+
+    la_binary.py --selftest                    encoder/decoder round trips
+    la_binary.py --compare                     bytes per sample, synthetic data
+    la_binary.py /dev/ttyACM1 --bench          capture with both transports
+    la_binary.py /dev/ttyACM1 --bench --samples 200000 --rate 1000000 --analog 0
+"""
+
+import argparse
+import random
+import struct
+import sys
+import time
+
+MAGIC = b"\xa5\x5a"
+STREAM_CAPTURE = ord("A")
+
+FRAME_INFO = 0
+FRAME_DIGITAL_RAW = 1
+FRAME_DIGITAL_RLE = 2
+FRAME_ANALOG = 3
+FRAME_END = 4
+
+BLOCK_SAMPLES = 512
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def frame(ftype, seq, payload):
+    body = struct.pack("<BBHH", STREAM_CAPTURE, ftype, seq & 0xFFFF, len(payload)) + payload
+    return MAGIC + body + struct.pack("<H", crc16_ccitt(body))
+
+
+# --- encoder, same choices the firmware makes --------------------------------
+
+def encode_rle(samples):
+    out = bytearray()
+    i = 0
+    while i < len(samples):
+        value = samples[i]
+        run = 1
+        while i + run < len(samples) and samples[i + run] == value:
+            run += 1
+        i += run
+        if len(out) + 6 >= len(samples):
+            return None
+        out.append(value)
+        while run >= 0x80:
+            out.append((run & 0x7F) | 0x80)
+            run >>= 7
+        out.append(run)
+    return bytes(out)
+
+
+def pack_analog(values):
+    out = bytearray()
+    for i in range(0, len(values) - 1, 2):
+        pair = (values[i] & 0xFFF) | ((values[i + 1] & 0xFFF) << 12)
+        out += struct.pack("<I", pair)[:3]
+    if len(values) % 2:
+        out += struct.pack("<H", values[-1] & 0xFFF)
+    return bytes(out)
+
+
+def encode_binary(digital, analog, a_mask, rate=1000000):
+    """digital: list of bytes, analog: per sample list of enabled channel values."""
+    a_cnt = bin(a_mask).count("1")
+    seq = 0
+    out = bytearray(frame(FRAME_INFO, seq, struct.pack(
+        "<BBBBIIH", 1, 1, 8, a_mask, rate, len(digital), BLOCK_SAMPLES)))
+    seq += 1
+    for first in range(0, len(digital), BLOCK_SAMPLES):
+        block = digital[first:first + BLOCK_SAMPLES]
+        rle = encode_rle(block)
+        if rle is not None:
+            out += frame(FRAME_DIGITAL_RLE, seq, struct.pack("<I", first) + rle)
+        else:
+            out += frame(FRAME_DIGITAL_RAW, seq, struct.pack("<I", first) + bytes(block))
+        seq += 1
+        if a_cnt:
+            flat = [v for sample in analog[first:first + BLOCK_SAMPLES] for v in sample]
+            out += frame(FRAME_ANALOG, seq, struct.pack("<IB", first, a_mask) + pack_analog(flat))
+            seq += 1
+    ascii_bytes = len(digital) * (2 + 2 * a_cnt)
+    end = struct.pack("<III", len(digital), len(out) + 22, ascii_bytes)
+    out += frame(FRAME_END, seq, end)
+    return bytes(out)
+
+
+def encode_ascii(digital, analog):
+    """What the firmware sends without "B1"."""
+    out = bytearray()
+    for i, d in enumerate(digital):
+        out += bytes(((d & 0x7F) + 0x30 | 0x80, ((d >> 7) & 1) + 0x30 | 0x80))
+        for v in analog[i] if analog else ():
+            out += bytes(((v & 0x7F) + 0x30, ((v >> 7) & 0x7F) + 0x30))
+    out += b"$%d+" % len(out)
+    return bytes(out)
+
+
+# --- decoder -----------------------------------------------------------------
+
+class CaptureDecoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.info = None
+        self.end = None
+        self.digital = []
+        self.analog = []
+        self.frames = 0
+        self.crc_errors = 0
+        self.seq_gaps = 0
+        self.expected_seq = None
+
+    def feed(self, data):
+        self.buffer += data
+        while True:
+            start = self.buffer.find(MAGIC)
+            if start < 0:
+                del self.buffer[:-1]
+                return
+            del self.buffer[:start]
+            if len(self.buffer) < 8:
+                return
+            stream, ftype, seq, length = struct.unpack_from("<BBHH", self.buffer, 2)
+            if len(self.buffer) < 10 + length:
+                return
+            body = bytes(self.buffer[2:8 + length])
+            (crc,) = struct.unpack_from("<H", self.buffer, 8 + length)
+            if stream != STREAM_CAPTURE or crc16_ccitt(body) != crc:
+                self.crc_errors += stream == STREAM_CAPTURE
+                del self.buffer[:2]
+                continue
+            del self.buffer[:10 + length]
+            if self.expected_seq is not None and seq != self.expected_seq:
+                self.seq_gaps += 1
+            self.expected_seq = (seq + 1) & 0xFFFF
+            self.frames += 1
+            self._frame(ftype, body[6:])
+
+    def _frame(self, ftype, payload):
+        if ftype == FRAME_INFO:
+            names = ("version", "digital_bytes", "digital_channels", "a_mask",
+                     "rate", "samples", "block_samples")
+            self.info = dict(zip(names, struct.unpack_from("<BBBBIIH", payload)))
+        elif ftype == FRAME_DIGITAL_RAW:
+            self.digital += payload[4:]
+        elif ftype == FRAME_DIGITAL_RLE:
+            pos = 4
+            while pos < len(payload):
+                value = payload[pos]
+                pos += 1
+                run = shift = 0
+                while True:
+                    byte = payload[pos]
+                    pos += 1
+                    run |= (byte & 0x7F) << shift
+                    shift += 7
+                    if byte < 0x80:
+                        break
+                self.digital += [value] * run
+        elif ftype == FRAME_ANALOG:
+            a_cnt = bin(payload[4]).count("1")
+            data = payload[5:]
+            values = []
+            pos = 0
+            while pos + 3 <= len(data):
+                pair = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16)
+                values += [pair & 0xFFF, pair >> 12]
+                pos += 3
+            if pos + 2 == len(data):
+                values.append((data[pos] | (data[pos + 1] << 8)) & 0xFFF)
+            for i in range(0, len(values), a_cnt):
+                self.analog.append(values[i:i + a_cnt])
+        elif ftype == FRAME_END:
+            self.end = dict(zip(("samples", "bytes", "ascii_bytes"),
+                                struct.unpack_from("<III", payload)))
+
+
+# --- synthetic data ----------------------------------------------------------
+
+def synthetic(kind, samples, a_cnt, seed=1):
+    rng = random.Random(seed)
+    digital = []
+    if kind == "idle":
+        digital = [0xFF] * samples
+    elif kind == "clock":  # bit 0 toggles every 4 samples, a slow counter above it
+        digital = [((i // 4) & 1) | (((i // 64) & 0x7F) << 1) for i in range(samples)]
+    elif kind == "uart":   # mostly idle high with the odd byte
+        level = 0xFF
+        for i in range(samples):
+            if rng.random() < 0.01:
+                level ^= 1 << rng.randrange(8)
+            digital.append(level)
+    else:                  # noise, the worst case for run lengths
+        digital = [rng.randrange(256) for _ in range(samples)]
+    analog = [[rng.randrange(4096) for _ in range(a_cnt)] for _ in range(samples)] if a_cnt else []
+    return digital, analog
+
+
+def selftest():
+    failures = 0
+    for kind in ("idle", "clock", "uart", "noise"):
+        for samples in (1, 7, BLOCK_SAMPLES, BLOCK_SAMPLES + 1, 5000):
+            for a_mask in (0, 0x01, 0x0F, 0x07, 0xFF):
+                a_cnt = bin(a_mask).count("1")
+                digital, analog = synthetic(kind, samples, a_cnt, seed=samples)
+                data = encode_binary(digital, analog, a_mask)
+
+                decoder = CaptureDecoder()
+                # feed in awkward pieces like USB would
+                for i in range(0, len(data), 61):
+                    decoder.feed(data[i:i + 61])
+                ok = (decoder.digital == digital and decoder.analog == analog and
+                      decoder.end is not None and decoder.end["samples"] == samples and
+                      decoder.end["bytes"] == len(data) and
+                      decoder.crc_errors == 0 and decoder.seq_gaps == 0)
+                if not ok:
+                    failures += 1
+                    print("FAIL %s samples=%d a_mask=0x%02x" % (kind, samples, a_mask))
+
+    # a corrupted byte loses that frame and nothing else
+    digital, analog = synthetic("noise", 2000, 0)
+    data = bytearray(encode_binary(digital, analog, 0))
+    data[200] ^= 0x40
+    decoder = CaptureDecoder()
+    decoder.feed(bytes(data))
+    if decoder.crc_errors != 1 or len(decoder.digital) != 2000 - BLOCK_SAMPLES:
+        failures += 1
+        print("FAIL corruption: %d crc errors, %d samples" % (decoder.crc_errors, len(decoder.digital)))
+
+    print("selftest %s" % ("passed" if failures == 0 else "FAILED (%d)" % failures))
+    return failures == 0
+
+
+def compare(samples):
+    print("%-6s %-7s %10s %10s %8s %12s" % ("data", "analog", "ascii", "binary", "ratio", "decode/s"))
+    for kind in ("idle", "clock", "uart", "noise"):
+        for a_cnt in (0, 1, 4, 8):
+            a_mask = (1 << a_cnt) - 1
+            digital, analog = synthetic(kind, samples, a_cnt)
+            ascii_data = encode_ascii(digital, analog)
+            binary = encode_binary(digital, analog, a_mask)
+            start = time.perf_counter()
+            CaptureDecoder().feed(binary)
+            rate = samples / (time.perf_counter() - start)
+            print("%-6s %-7d %10d %10d %7.1f%% %12.0f" % (
+                kind, a_cnt, len(ascii_data), len(binary),
+                100.0 * len(binary) / len(ascii_data), rate))
+
+
+# --- live capture ------------------------------------------------------------
+
+def capture(port, transport, rate, samples, analog, timeout=30.0):
+    port.reset_input_buffer()
+    port.write(b"*")
+    time.sleep(0.05)
+    commands = [b"R%d" % rate, b"L%d" % samples]
+    commands += [b"A%d%d" % (1 if ch < analog else 0, ch) for ch in range(8)]
+    if transport == "binary":
+        commands.append(b"B1")
+    for command in commands:
+        port.write(command + b"\n")
+        time.sleep(0.01)
+    time.sleep(0.1)
+    port.reset_input_buffer()
+
+    start = time.monotonic()
+    port.write(b"F\n")
+    received = bytearray()
+    decoder = CaptureDecoder()
+    while time.monotonic() - start < timeout:
+        chunk = port.read(65536)
+        if not chunk:
+            continue
+        if transport == "binary":
+            decoder.feed(chunk)
+            received += chunk
+            if decoder.end is not None:
+                break
+        else:
+            received += chunk
+            if received.endswith(b"+") and b"$" in received[-16:]:
+                break
+    elapsed = time.monotonic() - start
+    return elapsed, len(received), decoder
+
+
+def bench(port_name, rate, samples, analog):
+    import serial
+
+    port = serial.Serial(port_name, timeout=0.05)
+    port.write(b"B\n")
+    time.sleep(0.1)
+    reply = port.read(64)
+    if b"B1" not in reply:
+        print("firmware doesn't offer the binary transport (got %r)" % reply)
+        return
+
+    results = {}
+    for transport in ("ascii", "binary"):
+        elapsed, size, decoder = capture(port, transport, rate, samples, analog)
+        results[transport] = (elapsed, size)
+        print("%-6s %8d samples in %6.3f s, %8d bytes (%.2f bytes/sample), %.0f samples/s" % (
+            transport, samples, elapsed, size, size / samples, samples / elapsed))
+        if transport == "binary":
+            if decoder.end is None:
+                print("       no end frame, capture incomplete")
+            else:
+                print("       %d frames, %d crc errors, %d gaps, decoded %d samples" % (
+                    decoder.frames, decoder.crc_errors, decoder.seq_gaps, len(decoder.digital)))
+    port.write(b"*")
+    port.close()
+
+    a, b = results["ascii"], results["binary"]
+    print("binary is %.1f%% of the bytes, %.2fx the speed" % (100.0 * b[1] / a[1], a[0] / b[0]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", nargs="?")
+    parser.add_argument("--selftest", action="store_true")
+    parser.add_argument("--compare", action="store_true")
+    parser.add_argument("--bench", action="store_true")
+    parser.add_argument("--rate", type=int, default=100000)
+    parser.add_argument("--samples", type=int, default=50000)
+    parser.add_argument("--analog", type=int, default=0, help="number of analog channels (0-8)")
+    args = parser.parse_args()
+
+    if args.selftest:
+        sys.exit(0 if selftest() else 1)
+    if args.compare:
+        compare(args.samples)
+        return
+    if args.bench and args.port:
+        bench(args.port, args.rate, args.samples, args.analog)
+        return
+    parser.print_help()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Checks logic analyzer capture files and converts them for sigrok/PulseView.
+
+A capture sent to a file ("W<file>" on the logic analyzer port, or
+la_capture_file() from MicroPython) holds the same binary frames a "B1" client
+gets over USB, see src/LogicAnalyzer.h and src/CaptureSink.h. Copy it off the
+board's drive and:
+
+    la_capture_file.py capture.jla                  frames, samples, errors
+    la_capture_file.py capture.jla --sr capture.sr  sigrok session for PulseView
+    la_capture_file.py capture.jla --csv out.csv    one row per sample
+    la_capture_file.py --selftest
+
+Analog channels go into the .sr and .csv as raw 12-bit ADC counts.
+"""
+
+import argparse
+import io
+import os
+import struct
+import sys
+import zipfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from la_binary import CaptureDecoder, encode_binary, synthetic  # noqa: E402
+
+SR_CHUNK = 4 * 1024 * 1024  # bytes per logic-1-n member, what sigrok writes
+
+
+def read_capture(path):
+    decoder = CaptureDecoder()
+    with open(path, "rb") as f:
+        while True:
+            data = f.read(65536)
+            if not data:
+                break
+            decoder.feed(data)
+    return decoder, os.path.getsize(path)
+
+
+def problems(decoder, size):
+    found = []
+    if decoder.info is None:
+        found.append("no info frame")
+    if decoder.end is None:
+        found.append("no end frame, the capture was cut short")
+    else:
+        if decoder.end["samples"] != len(decoder.digital) and decoder.digital:
+            found.append("end frame says %d samples, decoded %d" % (
+                decoder.end["samples"], len(decoder.digital)))
+        if decoder.end["bytes"] != size:
+            found.append("end frame says %d bytes, file has %d" % (decoder.end["bytes"], size))
+    if decoder.crc_errors:
+        found.append("%d frames failed their CRC" % decoder.crc_errors)
+    if decoder.seq_gaps:
+        found.append("%d gaps in the frame sequence" % decoder.seq_gaps)
+    if decoder.analog and len(decoder.analog) != len(decoder.digital):
+        found.append("%d analog samples for %d digital" % (len(decoder.analog), len(decoder.digital)))
+    return found
+
+
+def analog_channels(decoder):
+    a_mask = decoder.info["a_mask"] if decoder.info else 0
+    return [ch for ch in range(8) if a_mask >> ch & 1]
+
+
+def samplerate_string(rate):
+    for divisor, unit in ((1000000000, "GHz"), (1000000, "MHz"), (1000, "kHz")):
+        if rate >= divisor and rate % divisor == 0:
+            return "%d %s" % (rate // divisor, unit)
+    return "%d Hz" % rate
+
+
+def write_sr(decoder, out):
+    """sigrok session v2: a zip with metadata, logic-1-n and analog-1-ch-1."""
+    channels = analog_channels(decoder) if decoder.analog else []
+    meta = ["[global]", "sigrok version=0.5.2", "", "[device 1]",
+            "capturefile=logic-1", "total probes=8",
+            "samplerate=%s" % samplerate_string(decoder.info["rate"]),
+            "total analog=%d" % len(channels)]
+    meta += ["probe%d=D%d" % (i + 1, i) for i in range(8)]
+    meta += ["analog%d=A%d" % (9 + i, ch) for i, ch in enumerate(channels)]
+    meta.append("unitsize=1")
+
+    with zipfile.ZipFile(out, "w", zipfile.ZIP_DEFLATED) as z:
+        z.writestr("version", "2")
+        z.writestr("metadata", "\n".join(meta) + "\n")
+        digital = bytes(decoder.digital)
+        for n, first in enumerate(range(0, len(digital), SR_CHUNK)):
+            z.writestr("logic-1-%d" % (n + 1), digital[first:first + SR_CHUNK])
+        for i in range(len(channels)):
+            values = [sample[i] for sample in decoder.analog]
+            z.writestr("analog-1-%d-1" % (9 + i), struct.pack("<%df" % len(values), *values))
+
+
+def write_csv(decoder, out):
+    channels = analog_channels(decoder) if decoder.analog else []
+    out.write("sample,%s%s\n" % (",".join("D%d" % i for i in range(8)),
+                                 "".join(",A%d" % ch for ch in channels)))
+    for n, value in enumerate(decoder.digital):
+        row = [str(n)] + [str(value >> i & 1) for i in range(8)]
+        if channels:
+            row += [str(v) for v in decoder.analog[n]]
+        out.write(",".join(row) + "\n")
+
+
+def summary(path):
+    decoder, size = read_capture(path)
+    info = decoder.info or {}
+    print("%s: %d bytes, %d frames" % (path, size, decoder.frames))
+    if info:
+        print("  %d Hz, %d samples asked for, analog %s" % (
+            info["rate"], info["samples"],
+            ",".join("A%d" % ch for ch in analog_channels(decoder)) or "none"))
+    print("  decoded %d samples" % len(decoder.digital))
+    if decoder.end is not None and decoder.end["bytes"]:
+        print("  %.1f%% of what the ASCII transport would have taken" % (
+            100.0 * decoder.end["bytes"] / max(1, decoder.end["ascii_bytes"])))
+    found = problems(decoder, size)
+    for problem in found:
+        print("  PROBLEM: " + problem)
+    if not found:
+        print("  ok")
+    return decoder, found
+
+
+def selftest():
+    failures = 0
+    for kind in ("idle", "uart", "noise"):
+        for samples, a_mask in ((1, 0), (5000, 0), (5000, 0x05), (70000, 0x01)):
+            a_cnt = bin(a_mask).count("1")
+            digital, analog = synthetic(kind, samples, a_cnt, seed=samples)
+            data = encode_binary(digital, analog, a_mask, rate=250000)
+            decoder = CaptureDecoder()
+            decoder.feed(data)
+            if problems(decoder, len(data)) or decoder.digital != digital:
+                failures += 1
+                print("FAIL decode %s samples=%d a_mask=0x%02x" % (kind, samples, a_mask))
+                continue
+
+            sr = io.BytesIO()
+            write_sr(decoder, sr)
+            with zipfile.ZipFile(io.BytesIO(sr.getvalue())) as z:
+                names = z.namelist()
+                logic = b"".join(z.read(n) for n in sorted(
+                    (n for n in names if n.startswith("logic-1-")),
+                    key=lambda n: int(n.rsplit("-", 1)[1])))
+                meta = z.read("metadata").decode()
+                ok = logic == bytes(digital) and "samplerate=250 kHz" in meta
+                for i in range(a_cnt):
+                    raw = z.read("analog-1-%d-1" % (9 + i))
+                    values = struct.unpack("<%df" % (len(raw) // 4), raw)
+                    ok = ok and list(values) == [float(s[i]) for s in analog]
+            if not ok:
+                failures += 1
+                print("FAIL sr %s samples=%d a_mask=0x%02x" % (kind, samples, a_mask))
+
+    # a file cut off mid-capture is reported, not silently short
+    digital, analog = synthetic("noise", 3000, 0)
+    data = encode_binary(digital, analog, 0)[:-100]
+    decoder = CaptureDecoder()
+    decoder.feed(data)
+    if not any("cut short" in p for p in problems(decoder, len(data))):
+        failures += 1
+        print("FAIL truncated file not reported")
+
+    print("selftest %s" % ("passed" if failures == 0 else "FAILED (%d)" % failures))
+    return failures == 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("file", nargs="?")
+    parser.add_argument("--sr", help="write a sigrok session file")
+    parser.add_argument("--csv", help="write a CSV file")
+    parser.add_argument("--selftest", action="store_true")
+    args = parser.parse_args()
+
+    if args.selftest:
+        sys.exit(0 if selftest() else 1)
+    if not args.file:
+        parser.print_help()
+        return
+
+    decoder, found = summary(args.file)
+    if decoder.info is None:
+        sys.exit(1)
+    if args.sr:
+        write_sr(decoder, args.sr)
+        print("wrote " + args.sr)
+    if args.csv:
+        with open(args.csv, "w") as out:
+            write_csv(decoder, out)
+        print("wrote " + args.csv)
+    sys.exit(1 if found else 0)
+
+
+if __name__ == "__main__":
+    main()
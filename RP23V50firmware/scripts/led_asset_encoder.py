@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Encoder for compressed LED images and animations (.jla).
+
+Copy the output to the Jumperless filesystem (e.g. /images/startup.jla) and
+play it with animation_play_file() from MicroPython.
+
+    led_asset_encoder.py --images-h src/Images.h --reverse -o startup.jla
+    led_asset_encoder.py frame*.png -o wave.jla --frame-ms 30
+    led_asset_encoder.py frames.json -o wave.jla
+
+PNGs (needs Pillow) and JSON frames are 30x14 grids laid out like the board
+seen from above, the same way drawImage() maps Images.h. JSON is a list of
+frames, each a list of 445 0xRRGGBB LED colors, or {"grid": [[...], ...]}.
+
+File layout (little endian), see src/LEDAssets.h:
+
+    "JLA1" pixels:u16 frames:u16 frameMs:u16 flags:u16 reserved:u32
+    per frame: length:u16 durationMs:u16 type:u8 ops
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+PIXELS = 445
+GRID_WIDTH = 30
+GRID_HEIGHT = 14
+
+KEYFRAME = 0
+DELTA = 1
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+GRAPHICS_CPP = os.path.join(HERE, "..", "src", "Graphics.cpp")
+
+# drawImage() uses 14 of the 21 lines of the 32x21 startup frames
+IMAGE_SKIP_LINES = (1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 1, 1, 0, 0)
+
+
+def load_screen_map(path=GRAPHICS_CPP):
+    source = open(path).read()
+    body = re.search(r"const int screenMap\[445\]\s*=\s*\{(.*?)\};", source, re.S)
+    return [int(x) for x in re.findall(r"\d+", body.group(1))][:GRID_WIDTH * GRID_HEIGHT]
+
+
+def grid_to_leds(grid, screen_map):
+    """grid[y][x] -> LED colors, later cells win like setPixelColor() would."""
+    leds = [0] * PIXELS
+    for y in range(GRID_HEIGHT):
+        for x in range(GRID_WIDTH):
+            leds[screen_map[y * GRID_WIDTH + x]] = grid[y][x]
+    return leds
+
+
+def scale(color, factor):
+    r = int(((color >> 16) & 0xFF) * factor)
+    g = int(((color >> 8) & 0xFF) * factor)
+    b = int((color & 0xFF) * factor)
+    return (r << 16) | (g << 8) | b
+
+
+def load_images_h(path, screen_map, brightness):
+    source = open(path).read()
+    arrays = {}
+    for name, body in re.findall(r"startupFrame(\d+)\s*\[\]\s*(?:PROGMEM\s*)?=\s*\{(.*?)\};", source, re.S):
+        arrays[int(name)] = [int(x, 16) for x in re.findall(r"0x[0-9a-fA-F]+", body)]
+
+    frames = []
+    for index in sorted(arrays):
+        image = arrays[index]
+        grid = []
+        for line in range(1, 21):
+            if IMAGE_SKIP_LINES[line]:
+                continue
+            grid.append([scale(image[line * 32 + x + 1] & 0xFFFFFF, brightness)
+                         for x in range(GRID_WIDTH)])
+        frames.append(grid_to_leds(grid, screen_map))
+    return frames
+
+
+def load_png(path, screen_map):
+    from PIL import Image
+
+    image = Image.open(path).convert("RGB")
+    if image.size != (GRID_WIDTH, GRID_HEIGHT):
+        image = image.resize((GRID_WIDTH, GRID_HEIGHT), Image.NEAREST)
+    grid = [[(r << 16) | (g << 8) | b for r, g, b in
+             (image.getpixel((x, y)) for x in range(GRID_WIDTH))]
+            for y in range(GRID_HEIGHT)]
+    return grid_to_leds(grid, screen_map)
+
+
+def load_json(path, screen_map):
+    frames = []
+    for frame in json.load(open(path)):
+        if isinstance(frame, dict):
+            frames.append(grid_to_leds(frame["grid"], screen_map))
+        else:
+            frames.append((list(frame) + [0] * PIXELS)[:PIXELS])
+    return frames
+
+
+def encode_ops(target, previous):
+    """previous None makes a keyframe, otherwise unchanged pixels are skipped."""
+    ops = bytearray()
+    skip_value = 0 if previous is None else None
+    pixel = 0
+    end = PIXELS
+    # a keyframe doesn't need its trailing black, the decoder fills it in
+    while end > 0 and (target[end - 1] == 0 if previous is None
+                       else target[end - 1] == previous[end - 1]):
+        end -= 1
+
+    def skippable(i):
+        return target[i] == skip_value if previous is None else target[i] == previous[i]
+
+    while pixel < end:
+        if skippable(pixel):
+            count = 1
+            while pixel + count < end and count < 128 and skippable(pixel + count):
+                count += 1
+            ops.append(count - 1)
+            pixel += count
+            continue
+
+        color = target[pixel]
+        run = 1
+        while pixel + run < end and run < 64 and target[pixel + run] == color:
+            run += 1
+        if run >= 2:
+            ops.append(0x80 | (run - 1))
+            ops += bytes(((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF))
+            pixel += run
+            continue
+
+        # literals until the next skip or a run worth breaking for
+        literals = []
+        while pixel < end and len(literals) < 64 and not skippable(pixel):
+            if pixel + 1 < end and target[pixel + 1] == target[pixel]:
+                break
+            literals.append(target[pixel])
+            pixel += 1
+        ops.append(0xC0 | (len(literals) - 1))
+        for c in literals:
+            ops += bytes(((c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF))
+    return bytes(ops)
+
+
+def encode(frames, frame_ms, keyframe_interval):
+    out = bytearray(b"JLA1" + struct.pack("<HHHHI", PIXELS, len(frames), frame_ms, 0, 0))
+    previous = None
+    for number, frame in enumerate(frames):
+        key = previous is None or (keyframe_interval and number % keyframe_interval == 0)
+        ops = encode_ops(frame, None if key else previous)
+        if not key:
+            # a delta that's no smaller than a keyframe isn't worth it
+            key_ops = encode_ops(frame, None)
+            if len(key_ops) <= len(ops):
+                key, ops = True, key_ops
+        out += struct.pack("<HHB", len(ops), 0, KEYFRAME if key else DELTA) + ops
+        previous = frame
+    return bytes(out)
+
+
+def decode(data):
+    """Same thing the firmware does, for checking the encoder."""
+    if data[:4] != b"JLA1":
+        raise ValueError("not a .jla file")
+    pixels, count, _, _, _ = struct.unpack_from("<HHHHI", data, 4)
+    leds = [0] * pixels
+    frames = []
+    pos = 16
+    for _ in range(count):
+        length, _, ftype = struct.unpack_from("<HHB", data, pos)
+        pos += 5
+        end = pos + length
+        pixel = 0
+        while pos < end:
+            op = data[pos]
+            pos += 1
+            if op < 0x80:
+                if ftype == KEYFRAME:
+                    for i in range(pixel, min(pixel + op + 1, pixels)):
+                        leds[i] = 0
+                pixel += op + 1
+            elif op < 0xC0:
+                color = (data[pos] << 16) | (data[pos + 1] << 8) | data[pos + 2]
+                pos += 3
+                for _ in range((op & 0x3F) + 1):
+                    leds[pixel] = color
+                    pixel += 1
+            else:
+                for _ in range((op & 0x3F) + 1):
+                    leds[pixel] = (data[pos] << 16) | (data[pos + 1] << 8) | data[pos + 2]
+                    pos += 3
+                    pixel += 1
+        if ftype == KEYFRAME:
+            for i in range(pixel, pixels):
+                leds[i] = 0
+        frames.append(list(leds))
+    return frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("inputs", nargs="*", help="PNG or JSON files, in order")
+    parser.add_argument("--images-h", metavar="PATH",
+                        help="encode the startup frames from Images.h")
+    parser.add_argument("--brightness", type=float, default=None,
+                        help="scale colors by this (default 0.07 for --images-h "
+                             "to match drawImage(), 1.0 otherwise)")
+    parser.add_argument("--reverse", action="store_true",
+                        help="play the frames last to first (like the startup animation)")
+    parser.add_argument("--frame-ms", type=int, default=20)
+    parser.add_argument("--keyframe-interval", type=int, default=0,
+                        help="force a keyframe every N frames (0 = only when smaller)")
+    parser.add_argument("-o", "--output", required=True)
+    args = parser.parse_args()
+
+    screen_map = load_screen_map()
+    frames = []
+    if args.images_h:
+        brightness = 0.07 if args.brightness is None else args.brightness
+        frames += load_images_h(args.images_h, screen_map, brightness)
+    for path in args.inputs:
+        if path.lower().endswith(".json"):
+            frames += load_json(path, screen_map)
+        else:
+            frames += [load_png(path, screen_map)]
+        if args.brightness is not None and not args.images_h:
+            frames = [[scale(c, args.brightness) for c in f] for f in frames]
+    if not frames:
+        parser.error("nothing to encode")
+    if args.reverse:
+        frames.reverse()
+
+    data = encode(frames, args.frame_ms, args.keyframe_interval)
+    if decode(data) != frames:
+        sys.exit("round trip failed, not writing %s" % args.output)
+
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+    raw = len(frames) * PIXELS * 3
+    print("%s: %d frames, %d bytes (%.1f%% of %d raw, %d bytes/frame)" % (
+        args.output, len(frames), len(data), 100.0 * len(data) / raw, raw,
+        len(data) // len(frames)))
+
+
+if __name__ == "__main__":
+    main()
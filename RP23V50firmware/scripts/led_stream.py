@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Reference decoder and throughput benchmark for the binary LED stream.
+
+Set `dump_format = binary;` in the [display] config section and point
+serial_1 or serial_2 at `leds`, then:
+
+    led_stream.py /dev/ttyACM2                 live view in the terminal
+    led_stream.py /dev/ttyACM2 --interval 10   at most one frame per 10 ms
+    led_stream.py /dev/ttyACM2 --bench 10      stream flat out for 10 s
+
+Frame layout (little endian), see src/BinaryStream.h and src/LEDStream.h:
+
+    A5 5A  stream('L')  type  seq:u16  length:u16  payload  crc:u16
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+MAGIC = b"\xa5\x5a"
+STREAM_LEDS = ord("L")
+
+KEYFRAME = 0
+DELTA = 1
+INFO = 2
+
+PIXELS = 445
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+class LedStreamDecoder:
+    """Feed it bytes, it keeps the LED state and counts what went wrong."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.pixels = bytearray(PIXELS * 3)
+        self.synced = False  # no keyframe yet, deltas can't be applied
+        self.expected_seq = None
+        self.frames = 0
+        self.keyframes = 0
+        self.bytes = 0
+        self.crc_errors = 0
+        self.seq_gaps = 0
+        self.info = None
+
+    def feed(self, data):
+        """Returns True if the caller should ask for a keyframe."""
+        self.buffer += data
+        want_keyframe = False
+
+        while True:
+            start = self.buffer.find(MAGIC)
+            if start < 0:
+                del self.buffer[:-1]
+                break
+            del self.buffer[:start]
+            if len(self.buffer) < 8:
+                break
+
+            stream, ftype, seq, length = struct.unpack_from("<BBHH", self.buffer, 2)
+            if length > PIXELS * 3 + 2:
+                del self.buffer[:2]  # not a real header
+                continue
+            if len(self.buffer) < 8 + length + 2:
+                break
+
+            body = bytes(self.buffer[2:8 + length])
+            (crc,) = struct.unpack_from("<H", self.buffer, 8 + length)
+            if crc16_ccitt(body) != crc:
+                self.crc_errors += 1
+                del self.buffer[:2]
+                want_keyframe = True
+                continue
+            del self.buffer[:8 + length + 2]
+
+            if stream != STREAM_LEDS:
+                continue
+            want_keyframe |= self._frame(ftype, seq, body[6:])
+
+        return want_keyframe
+
+    def _frame(self, ftype, seq, payload):
+        if ftype == INFO:
+            fields = struct.unpack_from("<BHHHIIIII", payload)
+            names = ("version", "pixels", "keyframe_interval", "interval_ms",
+                     "frames", "keyframes", "bytes", "dropped", "encode_us")
+            self.info = dict(zip(names, fields))
+            return False
+
+        lost = self.expected_seq is not None and seq != self.expected_seq
+        self.expected_seq = (seq + 1) & 0xFFFF
+        self.frames += 1
+        self.bytes += len(payload) + 10
+
+        if ftype == KEYFRAME:
+            (count,) = struct.unpack_from("<H", payload)
+            self.pixels[:count * 3] = payload[2:2 + count * 3]
+            self.keyframes += 1
+            self.synced = True
+            return False
+
+        if lost:
+            self.seq_gaps += 1
+            self.synced = False
+        if not self.synced:
+            return True
+
+        pos = 0
+        while pos < len(payload):
+            first, count = struct.unpack_from("<HB", payload, pos)
+            pos += 3
+            self.pixels[first * 3:(first + count) * 3] = payload[pos:pos + count * 3]
+            pos += count * 3
+        return False
+
+    def rgb(self, pixel):
+        return tuple(self.pixels[pixel * 3:pixel * 3 + 3])
+
+
+def render(decoder):
+    """Breadboard rows as columns, 5 LEDs tall, top half then bottom half."""
+    out = ["\033[H"]
+    for half in (0, 30):
+        for led in range(5):
+            for row in range(half, half + 30):
+                r, g, b = decoder.rgb(row * 5 + led)
+                out.append("\033[48;2;%d;%d;%dm  " % (r, g, b))
+            out.append("\033[0m\n")
+        out.append("\n")
+    for pixel in range(300, PIXELS):
+        r, g, b = decoder.rgb(pixel)
+        out.append("\033[48;2;%d;%d;%dm " % (r, g, b))
+        if (pixel - 299) % 60 == 0:
+            out.append("\033[0m\n")
+    out.append("\033[0m\n%d frames  %d keyframes  %d crc errors  %d gaps\033[K\n" % (
+        decoder.frames, decoder.keyframes, decoder.crc_errors, decoder.seq_gaps))
+    sys.stdout.write("".join(out))
+    sys.stdout.flush()
+
+
+def request_info(port, decoder, timeout=1.0):
+    decoder.info = None
+    port.write(b"I")
+    deadline = time.monotonic() + timeout
+    while decoder.info is None and time.monotonic() < deadline:
+        decoder.feed(port.read(4096))
+    return decoder.info
+
+
+def bench(port, decoder, seconds):
+    port.write(b"S\x00\x00")
+    start = time.monotonic()
+    while time.monotonic() - start < seconds:
+        if decoder.feed(port.read(4096)):
+            port.write(b"K")
+    elapsed = time.monotonic() - start
+    port.write(b"X")
+    time.sleep(0.05)
+    port.reset_input_buffer()
+
+    print("%.1f s: %d frames (%d keyframes)" % (elapsed, decoder.frames, decoder.keyframes))
+    print("%.1f frames/s, %.1f kB/s, %.0f bytes/frame" % (
+        decoder.frames / elapsed, decoder.bytes / elapsed / 1024,
+        decoder.bytes / max(decoder.frames, 1)))
+    print("%d crc errors, %d sequence gaps" % (decoder.crc_errors, decoder.seq_gaps))
+
+    info = request_info(port, decoder)
+    if info:
+        print("device: %d frames, %d dropped, last encode %d us" % (
+            info["frames"], info["dropped"], info["encode_us"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port")
+    parser.add_argument("--interval", type=int, default=20,
+                        help="minimum ms between frames (default 20)")
+    parser.add_argument("--pull", action="store_true",
+                        help="ask for each frame instead of streaming")
+    parser.add_argument("--bench", type=float, metavar="SECONDS",
+                        help="stream as fast as possible and report throughput")
+    args = parser.parse_args()
+
+    port = serial.Serial(args.port, timeout=0.02)
+    decoder = LedStreamDecoder()
+
+    try:
+        if args.bench:
+            bench(port, decoder, args.bench)
+            return
+
+        sys.stdout.write("\033[2J\033[?25l")
+        if args.pull:
+            port.write(b"C\x01")
+        else:
+            port.write(b"S" + struct.pack("<H", args.interval))
+
+        last_frames = 0
+        while True:
+            if decoder.feed(port.read(4096)):
+                port.write(b"K")
+            if decoder.frames != last_frames:
+                last_frames = decoder.frames
+                render(decoder)
+                if args.pull:
+                    time.sleep(args.interval / 1000)
+                    port.write(b"C\x01")
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.write(b"X")
+        sys.stdout.write("\033[?25h\033[0m\n")
+        port.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,281 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Checks the on-device protocol decoders against synthetic captures.
+
+Builds src/ProtocolDecode.cpp on the host. This script draws UART, I2C, SPI
+and 1-Wire traffic on separate capture channels of one trace and writes down
+the events it expects. The harness feeds the trace to all four decoders at once,
+in randomly sized blocks like the DMA halves. The events it gets back have to
+match, down to the sample each one starts on.
+
+    protocol_decode_test.py
+    protocol_decode_test.py --cases 500 --cxx clang++
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, "..", "src")
+
+UART, I2C, SPI, ONEWIRE = 1, 2, 3, 4
+DATA, START, STOP, ADDRESS, PRESENCE, ERROR = 0, 1, 2, 3, 4, 5
+
+RATE = 1000000  # one sample per microsecond keeps the 1-Wire numbers readable
+
+HARNESS = r"""
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "ProtocolDecode.h"
+
+// argv: seed trace-file then per decoder: protocol rate mode pin pin pin pin
+int main(int argc, char** argv) {
+    srand(atoi(argv[1]));
+    FILE* f = fopen(argv[2], "rb");
+    std::vector<uint8_t> trace;
+    int c;
+    while ((c = fgetc(f)) != EOF) trace.push_back((uint8_t)c);
+    fclose(f);
+
+    protocolDecoderClear(-1);
+    for (int a = 3; a + 6 < argc; a += 7) {
+        uint8_t pins[4];
+        for (int i = 0; i < 4; i++) pins[i] = (uint8_t)atoi(argv[a + 3 + i]);
+        protocolDecoderSet(-1, atoi(argv[a]), pins, atoi(argv[a + 1]), atoi(argv[a + 2]));
+    }
+    protocolDecodeBegin(RATE);
+
+    size_t pos = 0;
+    protocolEvent ev[64];
+    while (pos < trace.size()) {
+        size_t n = 1 + rand() % 700;
+        if (n > trace.size() - pos) n = trace.size() - pos;
+        protocolDecodeFeed(&trace[pos], n);
+        pos += n;
+        int got;
+        while ((got = protocolDecodeRead(ev, 64)) > 0) {
+            for (int i = 0; i < got; i++)
+                printf("%u %u %u %u\n", ev[i].sample, ev[i].decoder, ev[i].type, ev[i].data);
+        }
+    }
+    printf("dropped %u\n", protocolDecodeStats.dropped);
+    return 0;
+}
+""".replace("RATE", str(RATE))
+
+
+def build(cxx):
+    tmp = tempfile.mkdtemp()
+    src = os.path.join(tmp, "decode_test.cpp")
+    exe = os.path.join(tmp, "decode_test")
+    with open(src, "w") as f:
+        f.write(HARNESS)
+    subprocess.check_call([cxx, "-O2", "-std=c++17", "-Wall", "-I", SRC, src,
+                           os.path.join(SRC, "ProtocolDecode.cpp"), "-o", exe])
+    return exe, tmp
+
+
+class Lines:
+    """Levels for a few channels, appended a run at a time."""
+
+    def __init__(self, idle):
+        self.levels = [[] for _ in idle]
+        self.idle = idle
+
+    def hold(self, samples, *levels):
+        for ch, level in enumerate(levels):
+            self.levels[ch].extend([level] * samples)
+
+    def now(self):
+        return len(self.levels[0])
+
+
+def uart(rng, baud):
+    line = Lines([1])
+    events = []
+    period = RATE / baud
+    t = 20.0
+    line.hold(20, 1)
+    for _ in range(rng.randint(1, 12)):
+        byte = rng.randrange(256)
+        bad = rng.random() < 0.1
+        bits = [0] + [(byte >> i) & 1 for i in range(8)] + [0 if bad else 1]
+        start = line.now()
+        for b in bits:
+            t += period
+            line.hold(int(round(t)) - line.now(), b)
+        if bad:
+            # framing error, then idle long enough to see a clean edge
+            t += period * 2
+            line.hold(int(round(t)) - line.now(), 0)
+        events.append((start, ERROR if bad else DATA, byte))
+        gap = rng.choice([0, 0, period * rng.uniform(0.5, 5)])
+        if bad:
+            gap += period  # the line has to come back up before a new start bit
+        t += gap
+        line.hold(int(round(t)) - line.now(), 1)
+    return line, events
+
+
+def i2c(rng):
+    q = 4  # samples per quarter bit
+    line = Lines([1, 1])
+    events = []
+    line.hold(10, 1, 1)
+    for _ in range(rng.randint(1, 3)):
+        # start: SDA falls while SCL is high
+        line.hold(q, 1, 1)
+        events.append((line.now(), START, 0))
+        line.hold(q, 1, 0)
+        line.hold(q, 0, 0)
+        first = True
+        for _ in range(rng.randint(1, 5)):
+            byte = rng.randrange(256)
+            nack = rng.randrange(2)
+            bits = [(byte >> (7 - i)) & 1 for i in range(8)] + [nack]
+            start = None
+            for b in bits:
+                line.hold(q, 0, b)
+                if start is None:
+                    start = line.now()
+                line.hold(2 * q, 1, b)
+                line.hold(q, 0, b)
+            events.append((start, ADDRESS if first else DATA, byte | nack << 8))
+            first = False
+        # stop: SDA rises while SCL is high
+        line.hold(q, 0, 0)
+        line.hold(q, 1, 0)
+        events.append((line.now(), STOP, 0))
+        line.hold(3 * q, 1, 1)
+    return line, events
+
+
+def spi(rng, mode, lsb_first):
+    cpol, cpha = (mode >> 1) & 1, mode & 1
+    half = rng.randint(1, 4)
+    line = Lines([cpol, 0, 0, 1])  # clk mosi miso cs
+    events = []
+    line.hold(8, cpol, 0, 0, 1)
+    for _ in range(rng.randint(1, 3)):
+        events.append((line.now(), START, 0))
+        line.hold(half, cpol, 0, 0, 0)
+        for _ in range(rng.randint(1, 4)):
+            o, i = rng.randrange(256), rng.randrange(256)
+            order = range(8) if lsb_first else range(7, -1, -1)
+            start = None
+            for bit in order:
+                bo, bi = (o >> bit) & 1, (i >> bit) & 1
+                # data changes half a clock before the sampling edge
+                if cpha == 0:
+                    line.hold(half, cpol, bo, bi, 0)
+                    if start is None:
+                        start = line.now()
+                    line.hold(half, 1 - cpol, bo, bi, 0)
+                else:
+                    line.hold(half, 1 - cpol, bo, bi, 0)
+                    if start is None:
+                        start = line.now()
+                    line.hold(half, cpol, bo, bi, 0)
+            events.append((start, DATA, o | i << 8))
+        line.hold(half, cpol, 0, 0, 0)
+        events.append((line.now(), STOP, 0))
+        line.hold(half * 3, cpol, 0, 0, 1)
+    return line, events
+
+
+def onewire(rng):
+    line = Lines([1])
+    events = []
+    line.hold(30, 1)
+    for _ in range(rng.randint(1, 3)):
+        events.append((line.now(), START, 0))
+        line.hold(rng.randint(480, 520), 0)
+        line.hold(rng.randint(15, 60), 1)
+        if rng.random() < 0.8:
+            events.append((line.now(), PRESENCE, 0))
+            line.hold(rng.randint(60, 240), 0)
+        line.hold(480 - 60, 1)
+        for _ in range(rng.randint(1, 4)):
+            byte = rng.randrange(256)
+            events.append((line.now(), DATA, byte))
+            for i in range(8):
+                low = rng.randint(1, 12) if (byte >> i) & 1 else rng.randint(30, 100)
+                line.hold(low, 0)
+                line.hold(max(2, 70 - low), 1)
+        line.hold(100, 1)
+    return line, events
+
+
+def make_case(rng):
+    """Returns (trace bytes, decoder args, expected events)."""
+    baud = rng.choice([9600, 57600, 115200, 250000])
+    spi_mode = rng.randrange(4)
+    lsb = rng.randrange(2)
+    parts = [
+        (UART, baud, 0, [0], uart(rng, baud)),
+        (I2C, 0, 0, [1, 2], i2c(rng)),
+        (SPI, 0, spi_mode | (4 if lsb else 0), [3, 4, 5, 6], spi(rng, spi_mode, lsb)),
+        (ONEWIRE, 0, 0, [7], onewire(rng)),
+    ]
+    length = max(p[4][0].now() for p in parts) + 50
+    trace = bytearray(length)
+    args = []
+    expected = []
+    for slot, (proto, rate, mode, pins, (line, events)) in enumerate(parts):
+        for ch, pin in enumerate(pins):
+            levels = line.levels[ch] + [line.idle[ch]] * (length - line.now())
+            for s, level in enumerate(levels):
+                if level:
+                    trace[s] |= 1 << pin
+        args += [proto, rate, mode] + (pins + [255] * 4)[:4]
+        expected += [(s, slot, t, d) for s, t, d in events]
+    return bytes(trace), [str(a) for a in args], expected
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cxx", default="c++")
+    parser.add_argument("--cases", type=int, default=200)
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    exe, tmp = build(args.cxx)
+    rng = random.Random(args.seed)
+    trace_path = os.path.join(tmp, "trace.bin")
+    total = 0
+    failures = []
+    for case in range(args.cases):
+        trace, dargs, expected = make_case(rng)
+        with open(trace_path, "wb") as f:
+            f.write(trace)
+        out = subprocess.check_output([exe, str(case + 1), trace_path] + dargs, text=True)
+        got = []
+        for line in out.splitlines():
+            if line.startswith("dropped"):
+                continue
+            got.append(tuple(int(v) for v in line.split()))
+        # decoders are fed one after another per block, so order by decoder
+        want = sorted(expected, key=lambda e: (e[1], e[0]))
+        got = sorted(got, key=lambda e: (e[1], e[0]))
+        total += len(want)
+        if got != want:
+            failures.append((case, want, got))
+
+    print("%d captures, %d events" % (args.cases, total))
+    for case, want, got in failures[:5]:
+        missing = [e for e in want if e not in got]
+        extra = [e for e in got if e not in want]
+        print("case %d: missing %s extra %s" % (case, missing[:4], extra[:4]))
+    if failures:
+        print("%d mismatches" % len(failures))
+        sys.exit(1)
+    print("identical")
+
+
+if __name__ == "__main__":
+    main()
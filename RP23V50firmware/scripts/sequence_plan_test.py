@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Checks the sequencer's timeline compiler (src/SequencePlan.cpp) on the host.
+
+Builds SequencePlan.cpp with a small harness that reads timelines on stdin,
+compiles them and prints the steps. This script then checks:
+
+  - events out of order are sorted, and equal times merge into one step
+  - the last event added for an output at the same time wins
+  - which step each event went into
+  - PWM changes on one pin in a step merge into one op
+  - bad outputs and values, pins used twice, the trigger pin
+  - DAC steps too close together, looping round included, and which event
+  - a period shorter than the timeline
+  - repeating with no period needs a trigger
+  - the DAC preload time at 100 kHz and 1 MHz
+
+    sequence_plan_test.py
+    sequence_plan_test.py --cxx clang++ -v
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, "..", "src")
+
+# SequencePlan.h
+DAC0, DAC1, TOP_RAIL, BOTTOM_RAIL = 0, 1, 2, 3
+GPIO1 = 4
+PWM1 = 12
+(SEQ_OK, SEQ_EMPTY, SEQ_BAD_OUTPUT, SEQ_PIN_CONFLICT, SEQ_DAC_TOO_CLOSE,
+ SEQ_PERIOD_TOO_SHORT, SEQ_NEEDS_TRIGGER) = range(7)
+
+HARNESS = r"""
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "SequencePlan.h"
+
+// "case name period loops busHz trigger count" then count "at output value" lines,
+// or "preload channels busHz"
+int main() {
+    char word[32], name[64];
+    while (scanf("%31s", word) == 1) {
+        if (strcmp(word, "preload") == 0) {
+            int channels;
+            unsigned bus;
+            scanf("%d %u", &channels, &bus);
+            printf("preload %d %u %u\n", channels, bus, seqPreloadUs(channels, bus));
+            continue;
+        }
+        unsigned period, bus;
+        int loops, trigger, count;
+        scanf("%63s %u %d %u %d %d", name, &period, &loops, &bus, &trigger, &count);
+        std::vector<seqEvent> events(count);
+        for (auto &e : events) {
+            unsigned at, output, value;
+            scanf("%u %u %u", &at, &output, &value);
+            e.at = at;
+            e.output = (uint8_t)output;
+            e.value = (uint16_t)value;
+        }
+        std::vector<seqStep> steps(count + 1);
+        std::vector<seqPwmOp> pwm(count + 1);
+        std::vector<uint16_t> eventStep(count + 1);
+        seqPlan plan = {};
+        plan.steps = steps.data();
+        plan.pwm = pwm.data();
+        plan.eventStep = eventStep.data();
+        int error = seqCompile(&plan, events.data(), count, period, loops, bus, trigger);
+        printf("case %s %d %d %d %u %u %u\n", name, error, plan.badEvent, plan.stepCount,
+               plan.gpioUsed, plan.pwmUsed, plan.dacUsed);
+        if (error != SEQ_OK) {
+            continue;
+        }
+        for (int s = 0; s < plan.stepCount; s++) {
+            const seqStep &st = steps[s];
+            printf("step %u %u %u %u %u %u %u %u", st.at, st.gpioSet, st.gpioClear, st.dacMask,
+                   st.dac[0], st.dac[1], st.dac[2], st.dac[3]);
+            for (int n = 0; n < st.pwmCount; n++) {
+                printf(" %u:%u", pwm[st.pwmFirst + n].pin, pwm[st.pwmFirst + n].value);
+            }
+            printf("\n");
+        }
+        printf("events");
+        for (int i = 0; i < count; i++) {
+            printf(" %u", eventStep[i]);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+"""
+
+
+def build(cxx):
+    tmp = tempfile.mkdtemp()
+    src = os.path.join(tmp, "plan_test.cpp")
+    exe = os.path.join(tmp, "plan_test")
+    with open(src, "w") as f:
+        f.write(HARNESS)
+    subprocess.check_call([cxx, "-O2", "-std=c++17", "-Wall", "-I", SRC, src,
+                           os.path.join(SRC, "SequencePlan.cpp"), "-o", exe])
+    return exe
+
+
+class Plan:
+    def __init__(self, fields):
+        (self.error, self.bad, self.count, self.gpio_used, self.pwm_used,
+         self.dac_used) = [int(v) for v in fields]
+        self.steps = []
+        self.event_step = []
+
+
+def parse(out):
+    plans = {}
+    preload = {}
+    plan = None
+    for line in out.splitlines():
+        f = line.split()
+        if f[0] == "preload":
+            preload[(int(f[1]), int(f[2]))] = int(f[3])
+        elif f[0] == "case":
+            plan = plans[f[1]] = Plan(f[2:])
+        elif f[0] == "step":
+            nums = [int(v) for v in f[1:9]]
+            pwm = [tuple(int(v) for v in op.split(":")) for op in f[9:]]
+            plan.steps.append({"at": nums[0], "set": nums[1], "clear": nums[2],
+                               "dac_mask": nums[3], "dac": nums[4:8], "pwm": pwm})
+        elif f[0] == "events":
+            plan.event_step = [int(v) for v in f[1:]]
+    return plans, preload
+
+
+def timeline(name, events, period=0, loops=1, bus=1000000, trigger=-1):
+    lines = ["case %s %d %d %d %d %d" % (name, period, loops, bus, trigger, len(events))]
+    lines += ["%d %d %d" % e for e in events]
+    return "\n".join(lines)
+
+
+CASES = [
+    # added out of order, two steps share a time
+    timeline("merge", [(300, GPIO1, 1), (0, DAC0, 100), (300, DAC1, 200), (0, GPIO1 + 2, 1),
+                       (1000, GPIO1, 0)]),
+    # the later of two events on one output at one time wins
+    timeline("last_wins", [(0, GPIO1, 1), (0, GPIO1, 0), (0, DAC0, 5), (0, DAC0, 6),
+                           (0, GPIO1 + 1, 0), (0, GPIO1 + 1, 1)]),
+    timeline("pwm", [(10, PWM1 + 3, 1000), (10, PWM1, 50), (10, PWM1 + 3, 2000), (20, PWM1, 60)]),
+    timeline("bad_output", [(0, GPIO1, 1), (5, 20, 0)]),
+    timeline("bad_code", [(0, DAC0, 4096)]),
+    timeline("bad_level", [(0, GPIO1, 2)]),
+    timeline("gpio_and_pwm", [(0, GPIO1 + 4, 1), (10, PWM1 + 4, 100)]),
+    timeline("trigger_pin", [(0, GPIO1 + 1, 1)], trigger=1),
+    timeline("trigger_other", [(0, GPIO1 + 1, 1)], trigger=2),
+    # one channel takes 52 us at 1 MHz
+    timeline("dac_close", [(0, DAC0, 1), (40, GPIO1, 1), (51, DAC1, 2), (200, DAC0, 3)]),
+    timeline("dac_spaced", [(0, DAC0, 1), (52, DAC1, 2), (60, GPIO1, 1)]),
+    # round the loop, 960 to 1000 + 10 is 50
+    timeline("dac_wrap", [(10, DAC0, 1), (500, GPIO1, 1), (960, TOP_RAIL, 2)], period=1000),
+    timeline("dac_wrap_ok", [(10, DAC0, 1), (958, TOP_RAIL, 2)], period=1000),
+    timeline("period_short", [(0, GPIO1, 1), (1000, GPIO1, 0)], period=1000),
+    timeline("period_ok", [(0, GPIO1, 1), (999, GPIO1, 0)], period=1000),
+    timeline("empty", []),
+    timeline("repeat_untriggered", [(0, GPIO1, 1)], loops=3),
+    timeline("forever_untriggered", [(0, GPIO1, 1)], loops=0),
+    timeline("repeat_triggered", [(0, GPIO1, 1)], loops=3, trigger=2),
+    timeline("repeat_period", [(0, GPIO1, 1)], period=100, loops=0),
+    "preload 1 1000000",
+    "preload 4 1000000",
+    "preload 1 100000",
+    "preload 0 1000000",
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cxx", default="c++")
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    out = subprocess.check_output([build(args.cxx)], input="\n".join(CASES) + "\n", text=True)
+    plans, preload = parse(out)
+    failures = 0
+
+    def check(ok, what):
+        nonlocal failures
+        if not ok:
+            failures += 1
+            print("FAIL " + what)
+        elif args.verbose:
+            print("ok   " + what)
+
+    p = plans["merge"]
+    check(p.error == SEQ_OK and [s["at"] for s in p.steps] == [0, 300, 1000],
+          "merge: steps at %s" % [s["at"] for s in p.steps])
+    check(p.steps[0]["set"] == 0b100 and p.steps[0]["dac_mask"] == 1 and
+          p.steps[0]["dac"][0] == 100 and p.steps[1]["set"] == 1 and
+          p.steps[1]["dac_mask"] == 2 and p.steps[1]["dac"][1] == 200 and
+          p.steps[2]["clear"] == 1, "merge: each step has its outputs")
+    check(p.event_step == [1, 0, 1, 0, 2], "merge: events went to steps %s" % p.event_step)
+    check(p.gpio_used == 0b101 and p.dac_used == 0b11, "merge: used GPIO and DAC masks")
+
+    p = plans["last_wins"]
+    s = p.steps[0] if p.steps else {}
+    check(p.count == 1 and s["set"] == 0b10 and s["clear"] == 0b01 and s["dac"][0] == 6,
+          "last wins: set %s clear %s dac %s" % (s.get("set"), s.get("clear"), s.get("dac")))
+
+    p = plans["pwm"]
+    check(p.count == 2 and sorted(p.steps[0]["pwm"]) == [(0, 50), (3, 2000)] and
+          p.steps[1]["pwm"] == [(0, 60)] and p.pwm_used == 0b1001,
+          "pwm: ops %s" % [s["pwm"] for s in p.steps])
+
+    for name, bad in (("bad_output", 1), ("bad_code", 0), ("bad_level", 0)):
+        p = plans[name]
+        check(p.error == SEQ_BAD_OUTPUT and p.bad == bad, "%s: error %d event %d" % (
+            name, p.error, p.bad))
+    check(plans["gpio_and_pwm"].error == SEQ_PIN_CONFLICT, "a pin as GPIO and PWM")
+    check(plans["trigger_pin"].error == SEQ_PIN_CONFLICT, "an output on the trigger pin")
+    check(plans["trigger_other"].error == SEQ_OK, "the trigger on another pin")
+
+    p = plans["dac_close"]
+    check(p.error == SEQ_DAC_TOO_CLOSE and p.bad == 2,
+          "DAC too close: error %d event %d" % (p.error, p.bad))
+    check(plans["dac_spaced"].error == SEQ_OK, "DAC steps just far enough apart")
+    p = plans["dac_wrap"]
+    check(p.error == SEQ_DAC_TOO_CLOSE and p.bad == 0,
+          "DAC too close round the loop: error %d event %d" % (p.error, p.bad))
+    check(plans["dac_wrap_ok"].error == SEQ_OK, "DAC far enough round the loop")
+    check(plans["period_short"].error == SEQ_PERIOD_TOO_SHORT, "period as long as the timeline")
+    check(plans["period_ok"].error == SEQ_OK, "period just longer than the timeline")
+    check(plans["empty"].error == SEQ_EMPTY, "no events")
+    check(plans["repeat_untriggered"].error == SEQ_NEEDS_TRIGGER, "3 passes, no period or trigger")
+    check(plans["forever_untriggered"].error == SEQ_NEEDS_TRIGGER, "for ever, no period or trigger")
+    check(plans["repeat_triggered"].error == SEQ_OK, "3 passes on a trigger")
+    check(plans["repeat_period"].error == SEQ_OK, "for ever with a period")
+
+    # 38 clocks for one channel, 119 for four, plus a quarter and 5 us
+    expect = {(1, 1000000): 52, (4, 1000000): 153, (1, 100000): 480, (0, 1000000): 0}
+    for key, us in expect.items():
+        check(preload[key] == us, "preload %d channels at %d Hz: %d us (%d)" % (
+            key[0], key[1], preload[key], us))
+
+    print("sequence_plan_test %s" % ("passed" if failures == 0 else "FAILED (%d)" % failures))
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Reference decoder and logger for the binary telemetry stream.
+
+Point serial_1 or serial_2 at `telemetry` in the config, then:
+
+    telemetry_stream.py /dev/ttyACM2 adc0 adc1 ina0_current          print
+    telemetry_stream.py /dev/ttyACM2 adc0 gpio --rate 2000 --csv log.csv
+    telemetry_stream.py /dev/ttyACM2 adc0 --rate 5000 --bench 10
+
+Frame layout (little endian), see src/BinaryStream.h and src/Telemetry.h:
+
+    A5 5A  stream('T')  type  seq:u16  length:u16  payload  crc:u16
+
+A records frame carries whole records back to back, each one a u32
+microsecond timestamp and an i16 per subscribed channel, lowest first.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+MAGIC = b"\xa5\x5a"
+STREAM_TELEMETRY = ord("T")
+
+RECORDS = 0
+INFO = 1
+
+# name, scale to the printed unit
+CHANNELS = [
+    ("adc0", 0.001), ("adc1", 0.001), ("adc2", 0.001), ("adc3", 0.001),
+    ("adc4", 0.001), ("adc5", 0.001), ("adc6", 0.001), ("adc7", 0.001),
+    ("ina0_current", 0.1), ("ina0_voltage", 0.001), ("ina0_power", 1.0),
+    ("ina1_current", 0.1), ("ina1_voltage", 0.001), ("ina1_power", 1.0),
+    ("gpio", 1),
+]
+UNITS = ["V"] * 8 + ["mA", "V", "mW"] * 2 + [""]
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def channels_in(mask):
+    return [c for c in range(len(CHANNELS)) if mask >> c & 1]
+
+
+class TelemetryDecoder:
+    """Feed it bytes, get back (time_us, [values]) records in engineering units."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.expected_seq = None
+        self.info = None
+        self.channels = []
+        self.frames = 0
+        self.records = 0
+        self.bytes = 0
+        self.crc_errors = 0
+        self.seq_gaps = 0
+
+    def feed(self, data):
+        self.buffer += data
+        out = []
+
+        while True:
+            start = self.buffer.find(MAGIC)
+            if start < 0:
+                del self.buffer[:-1]
+                break
+            del self.buffer[:start]
+            if len(self.buffer) < 8:
+                break
+
+            stream, ftype, seq, length = struct.unpack_from("<BBHH", self.buffer, 2)
+            if stream != STREAM_TELEMETRY or length > 1024:
+                del self.buffer[:2]  # not a real header
+                continue
+            if len(self.buffer) < 8 + length + 2:
+                break
+
+            body = bytes(self.buffer[2:8 + length])
+            (crc,) = struct.unpack_from("<H", self.buffer, 8 + length)
+            if crc16_ccitt(body) != crc:
+                self.crc_errors += 1
+                del self.buffer[:2]
+                continue
+            del self.buffer[:8 + length + 2]
+
+            if self.expected_seq is not None and seq != self.expected_seq:
+                self.seq_gaps += 1
+            self.expected_seq = (seq + 1) & 0xFFFF
+            self.frames += 1
+            self.bytes += 10 + length
+            out.extend(self.handle(ftype, body[6:]))
+        return out
+
+    def handle(self, ftype, payload):
+        if ftype == INFO:
+            (version, owner, mask, rate, size, records, dropped,
+             capacity) = struct.unpack_from("<BBIHHIIH", payload)
+            self.info = dict(version=version, owner=owner, mask=mask, rate=rate,
+                             record_size=size, records=records,
+                             dropped=dropped, capacity=capacity)
+            self.channels = channels_in(mask)
+            return []
+        if ftype != RECORDS or self.info is None:
+            return []
+
+        size = self.info["record_size"]
+        layout = "<I" + "h" * len(self.channels)
+        records = []
+        for offset in range(0, len(payload) - size + 1, size):
+            stamp, *raw = struct.unpack_from(layout, payload, offset)
+            values = [raw[i] * CHANNELS[c][1] for i, c in enumerate(self.channels)]
+            records.append((stamp, values))
+        self.records += len(records)
+        return records
+
+
+def subscribe(port, mask, rate):
+    port.write(b"S" + struct.pack("<IH", mask, rate))
+
+
+def main():
+    names = [name for name, _ in CHANNELS]
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("port")
+    parser.add_argument("channels", nargs="+", choices=names)
+    parser.add_argument("--rate", type=int, default=100, help="Hz, 1-5000")
+    parser.add_argument("--csv", help="write records here instead of printing")
+    parser.add_argument("--bench", type=float, metavar="SECONDS",
+                        help="count records for this long and report the rate")
+    args = parser.parse_args()
+
+    mask = 0
+    for name in args.channels:
+        mask |= 1 << names.index(name)
+
+    port = serial.Serial(args.port, timeout=0.05)
+    port.dtr = True
+    port.reset_input_buffer()
+    decoder = TelemetryDecoder()
+    subscribe(port, mask, args.rate)
+
+    out = open(args.csv, "w") if args.csv else None
+    if out:
+        out.write("time_us," + ",".join(names[c] for c in channels_in(mask)) + "\n")
+
+    start = time.monotonic()
+    first_stamp = None
+    try:
+        while args.bench is None or time.monotonic() - start < args.bench:
+            for stamp, values in decoder.feed(port.read(4096)):
+                if first_stamp is None:
+                    first_stamp = stamp
+                if out:
+                    out.write("%d,%s\n" % (stamp, ",".join("%g" % v for v in values)))
+                elif args.bench is None:
+                    print("%10.3f ms  " % (((stamp - first_stamp) & 0xFFFFFFFF) / 1000)
+                          + "  ".join("%s %.4g%s" % (names[c], v, UNITS[c])
+                                      for c, v in zip(decoder.channels, values)))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.write(b"I")
+        time.sleep(0.1)
+        decoder.feed(port.read(4096))
+        port.write(b"X")
+        if out:
+            out.close()
+
+    elapsed = time.monotonic() - start
+    info = decoder.info or {}
+    print("%d records in %.1f s (%.0f/s), %d frames, %d bytes, %d crc errors, "
+          "%d seq gaps, %d dropped on the device"
+          % (decoder.records, elapsed, decoder.records / elapsed, decoder.frames,
+             decoder.bytes, decoder.crc_errors, decoder.seq_gaps,
+             info.get("dropped", 0)), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
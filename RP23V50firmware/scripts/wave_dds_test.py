@@ -0,0 +1,415 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+"""Checks the wavegen's DDS core (src/WaveDds.cpp) on the host.
+
+Builds WaveDds.cpp with a small harness that renders a set of cases and prints
+the codes. This script then checks:
+
+  - spectral purity of the sine at 12 and 16 bits (SFDR and SINAD from an FFT
+    of a coherent record)
+  - the triangle's third harmonic
+  - phase relationships between outputs and harmonic outputs
+  - that frequency and amplitude changes between blocks don't glitch
+  - linear and log sweep frequencies, one-shot and repeating
+  - that a half-finished edit isn't picked up
+  - a user table of any length, 12-bit codes read in place
+  - playback of a sequence from memory, once and looped, and through a ring
+    that runs dry
+
+    wave_dds_test.py
+    wave_dds_test.py --cxx clang++ -v
+"""
+
+import argparse
+import cmath
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, "..", "src")
+
+N = 8192
+RATE = 30000.0
+
+HARNESS = r"""
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "WaveDds.h"
+
+static const int N = NFRAMES;
+static const float RATE = FRAMERATE;
+
+static void dump(const char *name, ddsState *dds, int frames) {
+    std::vector<uint16_t> codes(frames * ddsChannels(dds));
+    ddsRender(dds, codes.data(), frames);
+    printf("case %s %d %d\n", name, ddsChannels(dds), frames);
+    for (size_t i = 0; i < codes.size(); i++) printf("%u ", codes[i]);
+    printf("\n");
+}
+
+static ddsParams *setup(ddsState *dds, int bits, float hz) {
+    ddsInit(dds, RATE);
+    ddsParams *p = ddsEdit(dds);
+    p->codeMax = (1 << bits) - 1;
+    p->frequency = hz;
+    p->enabled = 1;
+    p->out[0].gain = (1 << (bits - 1)) - 1;
+    p->out[0].offset = 1 << (bits - 1);
+    return p;
+}
+
+int main() {
+    ddsState dds;
+    static const struct { const char *name; int bits; int cycles; int wave; } tones[] = {
+        {"sine12", 12, 127, DDS_SINE},
+        {"sine12_high", 12, 3001, DDS_SINE},
+        {"sine16", 16, 1021, DDS_SINE},
+        {"triangle", 12, 64, DDS_TRIANGLE},
+    };
+    for (auto &t : tones) {
+        ddsParams *p = setup(&dds, t.bits, RATE * t.cycles / N);
+        p->out[0].waveform = t.wave;
+        ddsCommit(&dds);
+        ddsApply(&dds);
+        dump(t.name, &dds, N);
+    }
+
+    // quadrature on all four, 16 bits
+    ddsParams *p = setup(&dds, 16, RATE * 37 / N);
+    p->enabled = 0x0f;
+    for (int i = 0; i < 4; i++) {
+        p->out[i] = p->out[0];
+        p->out[i].phase = (uint32_t)i << 30;
+    }
+    ddsCommit(&dds);
+    ddsApply(&dds);
+    dump("quadrature", &dds, N);
+
+    // fundamental and third harmonic
+    p = setup(&dds, 16, RATE * 37 / N);
+    p->enabled = 0x05;
+    p->out[2] = p->out[0];
+    p->out[2].harmonic = 3;
+    ddsCommit(&dds);
+    ddsApply(&dds);
+    dump("harmonic", &dds, N);
+
+    // retune and rescale between blocks, frequencies that aren't bin centred
+    p = setup(&dds, 16, 311.7f);
+    ddsCommit(&dds);
+    ddsApply(&dds);
+    printf("increment %u\n", dds.increment);
+    dump("before", &dds, 1000);
+    p = ddsEdit(&dds);
+    p->frequency = 1234.5f;
+    p->out[0].gain = 16000;
+    ddsCommit(&dds);
+    ddsApply(&dds);
+    printf("increment %u\n", dds.increment);
+    dump("after", &dds, 1000);
+
+    // an edit that hasn't been committed stays out
+    p = ddsEdit(&dds);
+    p->frequency = 5000.0f;
+    printf("mid_edit_applied %d\n", ddsApply(&dds) ? 1 : 0);
+    ddsCommit(&dds);
+    printf("committed_applied %d\n", ddsApply(&dds) ? 1 : 0);
+
+    // sweeps, 100 Hz to 1 kHz in a second
+    std::vector<uint16_t> scratch(RATE);
+    const char *modes[] = {"linear", "log"};
+    for (int m = 0; m < 2; m++) {
+        for (int repeat = 0; repeat < 2; repeat++) {
+            p = setup(&dds, 12, 50.0f);
+            p->sweepMode = m == 0 ? DDS_SWEEP_LINEAR : DDS_SWEEP_LOG;
+            p->sweepRepeat = repeat;
+            p->sweepStart = 100.0f;
+            p->sweepEnd = 1000.0f;
+            p->sweepSeconds = 1.0f;
+            p->sweepId = 1;
+            ddsCommit(&dds);
+            ddsApply(&dds);
+            float start = ddsCurrentFrequency(&dds);
+            ddsRender(&dds, scratch.data(), (int)RATE / 2);
+            float half = ddsCurrentFrequency(&dds);
+            ddsRender(&dds, scratch.data(), (int)RATE / 2 + 64);
+            float after = ddsCurrentFrequency(&dds);
+            // an amplitude change mid sweep doesn't restart it
+            ddsRender(&dds, scratch.data(), (int)RATE / 4);
+            float before_edit = ddsCurrentFrequency(&dds);
+            p = ddsEdit(&dds);
+            p->out[0].gain = 100;
+            ddsCommit(&dds);
+            ddsApply(&dds);
+            float after_edit = ddsCurrentFrequency(&dds);
+            printf("sweep %s %d %f %f %f %f %f\n", modes[m], repeat, start, half, after,
+                   before_edit, after_edit);
+        }
+    }
+
+    // a 1000 point cycle of 12-bit codes, as raw bytes off a file would be
+    static uint8_t cycle[2000];
+    for (int i = 0; i < 1000; i++) {
+        int code = (int)lround(2048 + 2047 * sin(2 * M_PI * i / 1000));
+        cycle[2 * i] = code & 0xff;
+        cycle[2 * i + 1] = code >> 8;
+    }
+    p = setup(&dds, 12, RATE * 127 / N);
+    p->out[0].waveform = DDS_TABLE;
+    p->out[0].table = cycle;
+    p->out[0].tableLength = 1000;
+    p->out[0].tableFormat = DDS_SAMPLES_U12;
+    ddsCommit(&dds);
+    ddsApply(&dds);
+    dump("table", &dds, N);
+
+    // a 100 sample ramp at a quarter of the frame rate, once then looped
+    static int16_t ramp[100];
+    for (int i = 0; i < 100; i++) ramp[i] = (int16_t)(i * 300);
+    for (int loop = 0; loop < 2; loop++) {
+        p = setup(&dds, 16, 100.0f);
+        p->out[0].waveform = DDS_PLAYBACK;
+        p->out[0].gain = 32767;
+        p->out[0].offset = 0;
+        p->play.data = ramp;
+        p->play.length = 100;
+        p->play.format = DDS_SAMPLES_S16;
+        p->play.loop = loop;
+        p->play.rate = RATE / 4;
+        p->play.id = 1;
+        ddsCommit(&dds);
+        ddsApply(&dds);
+        dump(loop ? "play_loop" : "play_once", &dds, 600);
+        printf("play_done %d %d\n", loop, ddsPlaying(&dds) ? 1 : 0);
+    }
+
+    // the same ramp through a 64 sample ring, 40 in it to start with
+    static int16_t slots[64];
+    ddsRing ring = {slots, 64, 0, 0, false};
+    p = setup(&dds, 16, 100.0f);
+    p->out[0].waveform = DDS_PLAYBACK;
+    p->out[0].gain = 32767;
+    p->out[0].offset = 0;
+    p->play.ring = &ring;
+    p->play.rate = RATE;
+    p->play.id = 1;
+    ddsCommit(&dds);
+    ddsApply(&dds);
+    printf("ring_pushed %u\n", ddsRingPush(&ring, ramp, 100));
+    dump("ring_dry", &dds, 80);
+    printf("ring_starved %u\n", dds.playStarved);
+    ddsRingPush(&ring, ramp + 63, 37);
+    ring.finished = true;
+    dump("ring_rest", &dds, 50);
+    printf("ring_done %d %u\n", ddsPlaying(&dds) ? 1 : 0, ddsPlayPosition(&dds));
+    return 0;
+}
+""".replace("NFRAMES", str(N)).replace("FRAMERATE", "%.1ff" % RATE)
+
+
+def build(cxx):
+    tmp = tempfile.mkdtemp()
+    src = os.path.join(tmp, "dds_test.cpp")
+    exe = os.path.join(tmp, "dds_test")
+    with open(src, "w") as f:
+        f.write(HARNESS)
+    subprocess.check_call([cxx, "-O2", "-std=c++17", "-Wall", "-I", SRC, src,
+                           os.path.join(SRC, "WaveDds.cpp"), "-o", exe])
+    return exe
+
+
+def fft(x):
+    """Iterative radix-2, len(x) a power of two."""
+    n = len(x)
+    a = [complex(v) for v in x]
+    j = 0
+    for i in range(1, n):
+        bit = n >> 1
+        while j & bit:
+            j ^= bit
+            bit >>= 1
+        j |= bit
+        if i < j:
+            a[i], a[j] = a[j], a[i]
+    size = 2
+    while size <= n:
+        w_step = cmath.exp(-2j * math.pi / size)
+        half = size // 2
+        for start in range(0, n, size):
+            w = 1.0
+            for k in range(start, start + half):
+                t = a[k + half] * w
+                a[k + half] = a[k] - t
+                a[k] += t
+                w *= w_step
+        size *= 2
+    return a
+
+
+def spectrum(x):
+    mean = sum(x) / len(x)
+    bins = fft([v - mean for v in x])[:len(x) // 2]
+    return [abs(b) ** 2 for b in bins], bins
+
+
+def purity(x, bin_):
+    power, _ = spectrum(x)
+    fundamental = power[bin_]
+    rest = [p for k, p in enumerate(power) if k not in (0, bin_)]
+    sfdr = 10 * math.log10(fundamental / max(rest))
+    sinad = 10 * math.log10(fundamental / sum(rest))
+    return sfdr, sinad
+
+
+def parse(out):
+    cases = {}
+    values = {}
+    lines = out.splitlines()
+    i = 0
+    while i < len(lines):
+        words = lines[i].split()
+        if words[0] == "case":
+            name, channels, frames = words[1], int(words[2]), int(words[3])
+            codes = [int(v) for v in lines[i + 1].split()]
+            cases[name] = [codes[c::channels] for c in range(channels)]
+            assert len(cases[name][0]) == frames
+            i += 2
+            continue
+        values.setdefault(words[0], []).append(words[1:])
+        i += 1
+    return cases, values
+
+
+class Checker:
+    def __init__(self, verbose):
+        self.failures = 0
+        self.verbose = verbose
+
+    def check(self, ok, what):
+        if not ok:
+            self.failures += 1
+            print("FAIL " + what)
+        elif self.verbose:
+            print("ok   " + what)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cxx", default="c++")
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    out = subprocess.check_output([build(args.cxx)], text=True)
+    cases, values = parse(out)
+    c = Checker(args.verbose)
+
+    # 12 bits is ~74 dB SINAD at best, 16 bits shows what the table does
+    for name, bin_, min_sfdr, min_sinad in (("sine12", 127, 75, 70),
+                                            ("sine12_high", 3001, 75, 70),
+                                            ("sine16", 1021, 95, 90)):
+        sfdr, sinad = purity(cases[name][0], bin_)
+        c.check(sfdr >= min_sfdr and sinad >= min_sinad,
+                "%s: SFDR %.1f dB (>= %d), SINAD %.1f dB (>= %d)" % (
+                    name, sfdr, min_sfdr, sinad, min_sinad))
+
+    power, _ = spectrum(cases["triangle"][0])
+    third = 10 * math.log10(power[192] / power[64])
+    c.check(abs(third - 20 * math.log10(1 / 9.0)) < 0.3,
+            "triangle: third harmonic %.2f dB (-19.08)" % third)
+
+    phases = []
+    for ch in cases["quadrature"]:
+        _, bins = spectrum(ch)
+        phases.append(cmath.phase(bins[37]))
+    for i in range(1, 4):
+        lag = math.degrees(phases[i] - phases[0]) % 360
+        c.check(abs(lag - 90 * i) < 0.1, "quadrature: output %d at %.3f degrees" % (i, lag))
+
+    power, _ = spectrum(cases["harmonic"][1])
+    peak = max(range(1, len(power)), key=lambda k: power[k])
+    c.check(peak == 111, "harmonic: third harmonic output peaks in bin %d (111)" % peak)
+
+    # across the retune: scaled to each side's amplitude, no step bigger than
+    # the new tone's steepest slope
+    before, after = cases["before"][0], cases["after"][0]
+    joined = before + after
+    steepest = 2 * math.pi * 1234.5 / RATE + 0.001
+    step = abs((after[0] - 32768) / 16000.0 - (before[-1] - 32768) / 32767.0)
+    c.check(step <= steepest, "retune: step at the change %.4f of full scale (<= %.4f)" % (
+        step, steepest))
+    for name, x, amp in (("before", before, 32767), ("after", after, 16000)):
+        top = max(x) - 32768
+        c.check(abs(top - amp) <= amp * 0.01 + 2, "retune: %s peaks at %d (%d)" % (name, top, amp))
+    # and the phase carries on: rebuild it from the increments
+    inc_a, inc_b = (int(v[0]) for v in values["increment"])
+    phase = 0
+    worst = 0
+    for n, v in enumerate(joined):
+        gain = 32767 if n < 1000 else 16000
+        ideal = 32768 + gain * math.sin(2 * math.pi * phase / 2 ** 32)
+        worst = max(worst, abs(v - ideal))
+        phase = (phase + (inc_a if n < 1000 else inc_b)) % 2 ** 32
+    c.check(worst < 3, "retune: within %.2f codes of a phase continuous sine" % worst)
+
+    c.check(values["mid_edit_applied"][0] == ["0"] and values["committed_applied"][0] == ["1"],
+            "edits: uncommitted edit ignored, committed one applied")
+
+    for mode, repeat, start, half, after, before_edit, after_edit in values["sweep"]:
+        start, half, after, before_edit, after_edit = map(
+            float, (start, half, after, before_edit, after_edit))
+        want_half = 550.0 if mode == "linear" else math.sqrt(100.0 * 1000.0)
+        want_after = 1000.0 if repeat == "0" else 100.0
+        c.check(abs(start - 100) < 0.01 and abs(half - want_half) < want_half * 0.01,
+                "sweep %s: %.1f Hz at the start, %.1f half way (%.1f)" % (mode, start, half, want_half))
+        c.check(abs(after - want_after) < want_after * 0.02,
+                "sweep %s repeat=%s: %.1f Hz after the end (%.1f)" % (mode, repeat, after, want_after))
+        c.check(before_edit == after_edit,
+                "sweep %s repeat=%s: amplitude change keeps it at %.1f Hz" % (mode, repeat, after_edit))
+
+    sfdr, sinad = purity(cases["table"][0], 127)
+    c.check(sfdr >= 70 and sinad >= 65,
+            "table: 1000 point 12-bit cycle, SFDR %.1f dB (>= 70), SINAD %.1f dB (>= 65)" % (
+                sfdr, sinad))
+
+    # the ramp is 300 a sample, 75 a frame at a quarter rate, 0.5 code slack
+    # for the gain rounding
+    for name, loop in (("play_once", "0"), ("play_loop", "1")):
+        x = cases[name][0]
+        for n, v in enumerate(x):
+            at = n / 4.0
+            if loop == "1":
+                at %= 100
+                want = 300 * at if at <= 99 else 29700 * (100 - at)
+            else:
+                want = 300 * min(at, 99)
+            if abs(v - want) > 1:
+                c.check(False, "%s: frame %d is %d (%.1f)" % (name, n, v, want))
+                break
+        else:
+            c.check(True, "%s: interpolated ramp" % name)
+        done = [v[1] for v in values["play_done"] if v[0] == loop][0]
+        c.check(done == ("1" if loop == "1" else "0"),
+                "%s: still playing after 600 frames %s" % (name, done))
+
+    pushed = int(values["ring_pushed"][0][0])
+    dry, rest = cases["ring_dry"][0], cases["ring_rest"][0]
+    starved = int(values["ring_starved"][0][0])
+    c.check(pushed == 63, "ring: 64 slots take %d samples (63)" % pushed)
+    near = lambda x, first: all(abs(v - 300 * (first + i)) <= 1 for i, v in enumerate(x))
+    c.check(near(dry[:62], 0) and starved == 80 - 62,
+            "ring: plays what it has, then holds %d for %d frames" % (dry[-1], starved))
+    c.check(len(set(dry[61:])) == 1, "ring: holds the last sample while it's dry")
+    playing, position = values["ring_done"][0]
+    c.check(near(rest[:38], 62) and playing == "0",
+            "ring: carries on where it stopped, ends at sample %s" % position)
+
+    print("wave_dds_test %s" % ("passed" if c.failures == 0 else "FAILED (%d)" % c.failures))
+    sys.exit(1 if c.failures else 0)
+
+
+if __name__ == "__main__":
+    main()
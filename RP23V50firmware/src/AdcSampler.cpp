@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: MIT
+#include "AdcSampler.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+adcSamplerStatistics adcSamplerStats = {0, 0, 0, 0};
+
+#define ADC_SAMPLER_BLOCK (ADC_SAMPLER_CHANNELS * ADC_SAMPLER_DECIMATE)
+
+static uint16_t blocks[2][ADC_SAMPLER_BLOCK];
+static int dmaChannel[2] = {-1, -1};
+static bool irqInstalled = false;
+
+static volatile bool running = false;
+static uint8_t sampledMask = 0;
+static uint8_t sampledCount = 0;
+static int8_t slotOf[ADC_SAMPLER_CHANNELS]; // channel -> position in the round-robin, -1 if not sampled
+
+static volatile uint16_t latest[ADC_SAMPLER_CHANNELS];
+static uint16_t history[ADC_SAMPLER_CHANNELS][ADC_SAMPLER_HISTORY];
+static volatile uint32_t sequence[ADC_SAMPLER_CHANNELS];
+
+static void __not_in_flash_func(averageBlock)(const uint16_t *block) {
+  uint32_t sums[ADC_SAMPLER_CHANNELS] = {0};
+  uint8_t n = sampledCount;
+
+  // round-robin goes up through the mask, every block starts on the lowest
+  for (int s = 0; s < ADC_SAMPLER_DECIMATE; s++) {
+    for (int k = 0; k < n; k++) {
+      sums[k] += *block++ & 0x0FFF;
+    }
+  }
+
+  for (int ch = 0; ch < ADC_SAMPLER_CHANNELS; ch++) {
+    int k = slotOf[ch];
+    if (k < 0) {
+      continue;
+    }
+    uint16_t avg = sums[k] >> ADC_SAMPLER_DECIMATE_SHIFT;
+    uint32_t seq = sequence[ch] + 1;
+    history[ch][seq & (ADC_SAMPLER_HISTORY - 1)] = avg;
+    latest[ch] = avg;
+    sequence[ch] = seq;
+  }
+}
+
+static void __not_in_flash_func(adcSamplerIrq)(void) {
+  for (int i = 0; i < 2; i++) {
+    int ch = dmaChannel[i];
+    if (ch < 0 || !dma_irqn_get_channel_status(1, ch)) {
+      continue;
+    }
+    dma_irqn_acknowledge_channel(1, ch);
+    if (!running) {
+      continue;
+    }
+
+    uint32_t start = time_us_32();
+    // the other block is filling now, this one is ours until it chains back
+    dma_channel_set_write_addr(ch, blocks[i], false);
+    averageBlock(blocks[i]);
+    adcSamplerStats.blocks++;
+
+    adcSamplerStats.lastIrqUs = time_us_32() - start;
+    if (adcSamplerStats.lastIrqUs > adcSamplerStats.maxIrqUs) {
+      adcSamplerStats.maxIrqUs = adcSamplerStats.lastIrqUs;
+    }
+  }
+}
+
+bool adcSamplerStart(uint8_t mask) {
+  adcSamplerStop();
+  if (mask == 0) {
+    return false;
+  }
+
+  for (int i = 0; i < 2; i++) {
+    if (dmaChannel[i] < 0) {
+      dmaChannel[i] = dma_claim_unused_channel(false);
+      if (dmaChannel[i] < 0) {
+        return false;
+      }
+    }
+  }
+  if (!irqInstalled) {
+    irq_add_shared_handler(DMA_IRQ_1, adcSamplerIrq,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+    irqInstalled = true;
+  }
+
+  // a restart after a polled read keeps what the channels already had, only
+  // the ones new to the mask start empty
+  uint8_t kept = mask & sampledMask;
+  sampledMask = mask;
+  sampledCount = 0;
+  for (int ch = 0; ch < ADC_SAMPLER_CHANNELS; ch++) {
+    slotOf[ch] = ((mask >> ch) & 1) ? sampledCount++ : -1;
+    if (!((kept >> ch) & 1)) {
+      sequence[ch] = 0;
+    }
+  }
+  uint32_t blockLength = sampledCount * ADC_SAMPLER_DECIMATE;
+
+  for (int i = 0; i < 2; i++) {
+    dma_channel_config cfg = dma_channel_get_default_config(dmaChannel[i]);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    channel_config_set_chain_to(&cfg, dmaChannel[i ^ 1]);
+    dma_channel_configure(dmaChannel[i], &cfg, blocks[i], &adc_hw->fifo,
+                          blockLength, false);
+    dma_irqn_acknowledge_channel(1, dmaChannel[i]);
+    dma_irqn_set_channel_enabled(1, dmaChannel[i], true);
+  }
+
+  adc_run(false);
+  adc_fifo_setup(true, true, 1, false, false);
+  adc_fifo_drain();
+  adc_set_clkdiv(ADC_SAMPLER_CLKDIV);
+  adc_select_input(__builtin_ctz(mask));
+  adc_set_round_robin(mask);
+
+  adcSamplerStats.blocks = 0;
+  adcSamplerStats.maxIrqUs = 0;
+  running = true;
+  dma_channel_start(dmaChannel[0]);
+  adc_run(true);
+  return true;
+}
+
+void adcSamplerStop(void) {
+  if (!running) {
+    return;
+  }
+  running = false;
+  adc_run(false);
+
+  uint32_t both = (1u << dmaChannel[0]) | (1u << dmaChannel[1]);
+  for (int i = 0; i < 2; i++) {
+    dma_irqn_set_channel_enabled(1, dmaChannel[i], false);
+  }
+  // both at once so neither can chain-trigger the other mid-abort
+  dma_hw->abort = both;
+  while (dma_hw->abort & both) {
+    tight_loop_contents();
+  }
+  for (int i = 0; i < 2; i++) {
+    dma_irqn_acknowledge_channel(1, dmaChannel[i]);
+  }
+
+  adc_set_round_robin(0);
+  adc_fifo_setup(false, false, 0, false, false);
+  adc_fifo_drain();
+  adc_set_clkdiv(1.0);
+  adc_select_input(0);
+}
+
+bool adcSamplerRunning(void) { return running; }
+
+uint8_t adcSamplerMask(void) { return sampledMask; }
+
+bool adcSamplerHas(int channel) {
+  return running && channel >= 0 && channel < ADC_SAMPLER_CHANNELS &&
+         slotOf[channel] >= 0;
+}
+
+// right after a start there's nothing yet, the first block is ~1.4 ms away
+static void waitForFirst(int channel) {
+  uint32_t start = micros();
+  while (running && sequence[channel] == 0 && micros() - start < 5000) {
+    tight_loop_contents();
+  }
+}
+
+uint16_t adcSamplerLatest(int channel) {
+  if (channel < 0 || channel >= ADC_SAMPLER_CHANNELS) {
+    return 0;
+  }
+  waitForFirst(channel);
+  return latest[channel];
+}
+
+uint16_t adcSamplerAverage(int channel, int count) {
+  uint16_t values[ADC_SAMPLER_HISTORY];
+  int n = adcSamplerHistory(channel, values, count);
+  if (n == 0) {
+    return 0;
+  }
+  uint32_t sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += values[i];
+  }
+  return sum / n;
+}
+
+uint16_t adcSamplerFresh(int channel, int count) {
+  if (channel < 0 || channel >= ADC_SAMPLER_CHANNELS || count <= 0) {
+    return 0;
+  }
+  if (count > ADC_SAMPLER_HISTORY - 1) {
+    count = ADC_SAMPLER_HISTORY - 1;
+  }
+  // the block filling right now started before the call, so it's skipped
+  // and the count after it are used
+  uint32_t wanted = sequence[channel] + count + 1;
+  uint32_t start = micros();
+  uint32_t timeout = (count + 2) * 2000;
+  while (running && (int32_t)(sequence[channel] - wanted) < 0 &&
+         micros() - start < timeout) {
+    tight_loop_contents();
+  }
+  return adcSamplerAverage(channel, count);
+}
+
+int adcSamplerHistory(int channel, uint16_t *out, int count) {
+  if (channel < 0 || channel >= ADC_SAMPLER_CHANNELS || count <= 0) {
+    return 0;
+  }
+  if (count > ADC_SAMPLER_HISTORY) {
+    count = ADC_SAMPLER_HISTORY;
+  }
+  waitForFirst(channel);
+  uint32_t seq = sequence[channel];
+  if (count > (int)seq) {
+    count = seq;
+  }
+  for (int i = 0; i < count; i++) {
+    out[i] = history[channel][(seq - i) & (ADC_SAMPLER_HISTORY - 1)];
+  }
+  return count;
+}
+
+uint32_t adcSamplerSequence(int channel) {
+  if (channel < 0 || channel >= ADC_SAMPLER_CHANNELS) {
+    return 0;
+  }
+  return sequence[channel];
+}
+
+void printAdcSamplerStats(Stream *stream) {
+  if (!running) {
+    stream->printf("adc sampler: stopped (%lu polled reads)\n\r",
+                   adcSamplerStats.fallbacks);
+    return;
+  }
+  uint32_t perChannel = 48000000UL / (ADC_SAMPLER_CLKDIV + 1) / sampledCount;
+  stream->printf("adc sampler: mask 0x%02X, %lu sps per channel, %lu averages/s\n\r",
+                 sampledMask, perChannel, perChannel / ADC_SAMPLER_DECIMATE);
+  stream->printf("blocks: %lu  irq: %lu us (max %lu us)  polled reads: %lu\n\r",
+                 adcSamplerStats.blocks, adcSamplerStats.lastIrqUs,
+                 adcSamplerStats.maxIrqUs, adcSamplerStats.fallbacks);
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+#ifndef ADCSAMPLER_H
+#define ADCSAMPLER_H
+
+#include <Arduino.h>
+
+// Background ADC acquisition
+//
+// The ADC free-runs in round-robin over the sampled channels and two chained
+// DMA channels ping-pong its FIFO into a pair of blocks. Each block holds
+// ADC_SAMPLER_DECIMATE conversions of every channel. The DMA completion IRQ
+// averages them into one value per channel and keeps the last
+// ADC_SAMPLER_HISTORY of those. readAdc(), telemetry and the probe sensing
+// read the history without waiting instead of running a blocking adc_read()
+// loop; settleAdc() waits for new averages when a read has to see a change.
+//
+// The LogicAnalyzer and JulseView reprogram the ADC. They call adcSamplerStop()
+// before they touch it, and sampling comes back on with initADC() (or
+// adcSamplerStart()) when they let go. While stopped, readAdc() falls back to
+// polling.
+
+#define ADC_SAMPLER_CHANNELS 8          // ADC0-7 on GP40-47
+#define ADC_SAMPLER_DEFAULT_MASK 0xFF
+#define ADC_SAMPLER_DECIMATE 16         // conversions per average, power of two
+#define ADC_SAMPLER_DECIMATE_SHIFT 4
+#define ADC_SAMPLER_HISTORY 16          // averages kept per channel, power of two
+#define ADC_SAMPLER_CLKDIV 499          // 48 MHz / (1 + div) = 96 ksps over all channels
+
+struct adcSamplerStatistics {
+  uint32_t blocks;     // completed DMA blocks since adcSamplerStart()
+  uint32_t lastIrqUs;  // time the last block took to average
+  uint32_t maxIrqUs;
+  uint32_t fallbacks;  // readAdc() calls that had to poll
+};
+
+extern adcSamplerStatistics adcSamplerStats;
+
+/// (re)starts sampling the channels in mask, false if there are no DMA
+/// channels to be had. Channels that were already sampled keep their history
+bool adcSamplerStart(uint8_t mask = ADC_SAMPLER_DEFAULT_MASK);
+/// stops the DMA and leaves the ADC idle with round-robin off
+void adcSamplerStop(void);
+bool adcSamplerRunning(void);
+uint8_t adcSamplerMask(void);
+/// running and sampling this channel
+bool adcSamplerHas(int channel);
+
+/// most recent average, raw 12 bit
+uint16_t adcSamplerLatest(int channel);
+/// mean of the last count averages (1 to ADC_SAMPLER_HISTORY)
+uint16_t adcSamplerAverage(int channel, int count);
+/// mean of count averages taken entirely after the call, waits for them
+/// (about count + 1 averages' time). settleAdc() uses it for reads that have
+/// to see a change the caller just made, like a dac_set() right before
+uint16_t adcSamplerFresh(int channel, int count);
+/// copies the last count averages, newest first, returns how many there were
+int adcSamplerHistory(int channel, uint16_t *out, int count);
+/// goes up by one every time the channel gets a new average
+uint32_t adcSamplerSequence(int channel);
+
+void printAdcSamplerStats(Stream *stream);
+
+#endif
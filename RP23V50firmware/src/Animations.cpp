@@ -0,0 +1,342 @@
+// SPDX-License-Identifier: MIT
+#include "Animations.h"
+#include "LEDs.h"
+#include "JumperlessDefines.h"
+
+keyframeAnimation keyframeAnimations[MAX_KEYFRAME_ANIMATIONS];
+animationSchedulerStats animationStats = {0, 0, 0, 0, 0};
+
+/// how long the scheduler may spend per frame before deferring the rest
+uint32_t animationBudgetUs = 1500;
+
+static int schedulerCursor = 0;
+
+static inline bool validAnimation(int id) {
+  return id >= 0 && id < MAX_KEYFRAME_ANIMATIONS &&
+         keyframeAnimations[id].allocated != 0;
+}
+
+static uint32_t lerpColor(uint32_t a, uint32_t b, uint32_t t, uint32_t steps) {
+  // t/steps of the way from a to b, per channel
+  int32_t ar = (a >> 16) & 0xff, ag = (a >> 8) & 0xff, ab = a & 0xff;
+  int32_t br = (b >> 16) & 0xff, bg = (b >> 8) & 0xff, bb = b & 0xff;
+
+  uint32_t r = ar + ((br - ar) * (int32_t)t) / (int32_t)steps;
+  uint32_t g = ag + ((bg - ag) * (int32_t)t) / (int32_t)steps;
+  uint32_t bl = ab + ((bb - ab) * (int32_t)t) / (int32_t)steps;
+
+  return (r << 16) | (g << 8) | bl;
+}
+
+static void buildTable(keyframeAnimation *anim, const uint32_t *keyframes,
+                       int numKeyframes, int tableLength) {
+  if (numKeyframes > ANIMATION_MAX_KEYFRAMES) {
+    numKeyframes = ANIMATION_MAX_KEYFRAMES;
+  }
+  if (tableLength <= 0) {
+    tableLength = numKeyframes;
+  }
+  if (tableLength > ANIMATION_TABLE_SIZE) {
+    tableLength = ANIMATION_TABLE_SIZE;
+  }
+
+  if (tableLength == numKeyframes || numKeyframes == 1 || tableLength == 1) {
+    // keyframes are the frames, nothing to interpolate
+    for (int i = 0; i < tableLength; i++) {
+      anim->table[i] = keyframes[i % numKeyframes];
+    }
+  } else {
+    // spread the keyframes evenly over the table and lerp between them,
+    // looping animations blend the last keyframe back into the first
+    int segments = (anim->mode == ANIM_LOOP) ? numKeyframes : numKeyframes - 1;
+
+    for (int i = 0; i < tableLength; i++) {
+      uint32_t pos = ((uint32_t)i * segments << 8) /
+                     (anim->mode == ANIM_LOOP ? tableLength : tableLength - 1);
+      int k = pos >> 8;
+      if (k >= numKeyframes) {
+        k = numKeyframes - 1;
+      }
+      int next = (k + 1) % numKeyframes;
+      anim->table[i] = lerpColor(keyframes[k], keyframes[next], pos & 0xff, 256);
+    }
+  }
+  anim->tableLength = tableLength;
+}
+
+/// returns the slot number or -1 if there's no room
+int animationCreate(const uint32_t *keyframes, int numKeyframes, int periodMs,
+                    int mode, int tableLength, int slot) {
+  if (keyframes == nullptr || numKeyframes <= 0) {
+    return -1;
+  }
+
+  if (slot < 0) {
+    for (int i = ANIMATION_ROW_SLOTS; i < MAX_KEYFRAME_ANIMATIONS; i++) {
+      if (keyframeAnimations[i].allocated == 0) {
+        slot = i;
+        break;
+      }
+    }
+  }
+  if (slot < 0 || slot >= MAX_KEYFRAME_ANIMATIONS) {
+    return -1;
+  }
+
+  keyframeAnimation *anim = &keyframeAnimations[slot];
+
+  anim->active = 0; // core 2 skips it while we rebuild
+  anim->mode = mode;
+  anim->direction = 1;
+  anim->phase = 0;
+  anim->target = -1;
+  anim->spread = 1;
+  anim->sourceColor = 0xffffffff;
+  buildTable(anim, keyframes, numKeyframes, tableLength);
+  anim->allocated = 1;
+
+  animationSetPeriod(slot, periodMs);
+
+  return slot;
+}
+
+int animationSetKeyframes(int id, const uint32_t *keyframes, int numKeyframes,
+                          int tableLength) {
+  if (!validAnimation(id) || keyframes == nullptr || numKeyframes <= 0) {
+    return -1;
+  }
+  keyframeAnimation *anim = &keyframeAnimations[id];
+
+  uint8_t wasActive = anim->active;
+  uint8_t oldLength = anim->tableLength;
+  anim->active = 0;
+  buildTable(anim, keyframes, numKeyframes, tableLength);
+
+  if (anim->tableLength != oldLength && oldLength > 0) {
+    // keep the period the same when the table changes size
+    anim->phaseStep = (uint32_t)(((uint64_t)anim->phaseStep * anim->tableLength) /
+                                 oldLength);
+    anim->phase %= ((uint32_t)anim->tableLength << ANIMATION_FIXED_SHIFT);
+  }
+  anim->active = wasActive;
+  return id;
+}
+
+/// periodMs is the time for one pass through the whole table
+void animationSetPeriod(int id, int periodMs) {
+  if (!validAnimation(id)) {
+    return;
+  }
+  if (periodMs < 1) {
+    periodMs = 1;
+  }
+  keyframeAnimations[id].phaseStep =
+      ((uint32_t)keyframeAnimations[id].tableLength << ANIMATION_FIXED_SHIFT) /
+      (uint32_t)periodMs;
+}
+
+/// node is a breadboard row (1-60) or a nano header node, -1 for none
+void animationSetTarget(int id, int node, int spread) {
+  if (!validAnimation(id)) {
+    return;
+  }
+  keyframeAnimations[id].target = node;
+  keyframeAnimations[id].spread = spread;
+}
+
+/// startFrame -1 resumes from wherever it was stopped
+void animationStart(int id, int startFrame) {
+  if (!validAnimation(id)) {
+    return;
+  }
+  keyframeAnimation *anim = &keyframeAnimations[id];
+
+  if (startFrame >= 0) {
+    anim->phase = ((uint32_t)(startFrame % anim->tableLength))
+                  << ANIMATION_FIXED_SHIFT;
+    anim->direction = 1;
+  }
+  anim->lastTick = millis();
+  anim->active = 1;
+}
+
+void animationStop(int id) {
+  if (!validAnimation(id)) {
+    return;
+  }
+  keyframeAnimations[id].active = 0;
+}
+
+void animationDelete(int id) {
+  if (!validAnimation(id)) {
+    return;
+  }
+  keyframeAnimations[id].active = 0;
+  keyframeAnimations[id].target = -1;
+  keyframeAnimations[id].allocated = 0;
+}
+
+bool animationIsActive(int id) {
+  return validAnimation(id) && keyframeAnimations[id].active != 0;
+}
+
+int animationFrame(int id) {
+  if (!validAnimation(id)) {
+    return 0;
+  }
+  return keyframeAnimations[id].phase >> ANIMATION_FIXED_SHIFT;
+}
+
+/// color at the current frame plus offset table entries
+uint32_t animationSample(int id, int offset) {
+  if (!validAnimation(id) || keyframeAnimations[id].tableLength == 0) {
+    return 0;
+  }
+  keyframeAnimation *anim = &keyframeAnimations[id];
+  int index = (int)(anim->phase >> ANIMATION_FIXED_SHIFT) + offset;
+
+  index %= anim->tableLength;
+  if (index < 0) {
+    index += anim->tableLength;
+  }
+  return anim->table[index];
+}
+
+static void advanceAnimation(keyframeAnimation *anim, uint32_t now) {
+  uint32_t elapsed = now - anim->lastTick;
+
+  if (elapsed == 0) {
+    return;
+  }
+  anim->lastTick = now;
+
+  if (elapsed > 1000) { // core 2 was paused, don't try to catch up
+    elapsed = 1000;
+  }
+
+  uint32_t end = (uint32_t)anim->tableLength << ANIMATION_FIXED_SHIFT;
+  uint64_t travel = (uint64_t)anim->phaseStep * elapsed;
+
+  switch (anim->mode) {
+  case ANIM_LOOP:
+    anim->phase = (anim->phase + (uint32_t)(travel % end)) % end;
+    break;
+
+  case ANIM_PINGPONG: {
+    // last valid position is the start of the last frame, a full
+    // there-and-back is 2 * last so anything beyond that is a no-op
+    uint32_t last = end - ANIMATION_FIXED_ONE;
+    if (last == 0) {
+      break;
+    }
+    uint32_t delta = (uint32_t)(travel % (2ULL * last));
+    while (delta > 0) {
+      if (anim->direction > 0) {
+        uint32_t room = last - anim->phase;
+        if (delta <= room) {
+          anim->phase += delta;
+          delta = 0;
+        } else {
+          anim->phase = last;
+          delta -= room;
+          anim->direction = -1;
+        }
+      } else {
+        if (delta <= anim->phase) {
+          anim->phase -= delta;
+          delta = 0;
+        } else {
+          delta -= anim->phase;
+          anim->phase = 0;
+          anim->direction = 1;
+        }
+      }
+    }
+    break;
+  }
+
+  case ANIM_ONESHOT:
+    if (anim->phase + travel >= end - ANIMATION_FIXED_ONE) {
+      anim->phase = end - ANIMATION_FIXED_ONE;
+      anim->active = 0; // holds the last frame
+    } else {
+      anim->phase += (uint32_t)travel;
+    }
+    break;
+  }
+}
+
+static void drawAnimation(int id) {
+  keyframeAnimation *anim = &keyframeAnimations[id];
+  int node = anim->target;
+
+  if (node >= 1 && node <= 60) {
+    for (int j = 0; j < 5; j++) {
+      leds.setPixelColor(((node - 1) * 5) + j,
+                         animationSample(id, j * anim->spread));
+    }
+  } else if (node >= NANO_D0 && node <= NANO_GND_1) {
+    for (int j = 0; j < 35; j++) {
+      if (bbPixelToNodesMapV5[j][0] == node) {
+        leds.setPixelColor(bbPixelToNodesMapV5[j][1], animationSample(id));
+        break;
+      }
+    }
+  }
+}
+
+/// called from core2stuff() right before leds.show()
+void animationScheduler(void) {
+  uint32_t startUs = micros();
+  uint32_t now = millis();
+
+  for (int visited = 0; visited < MAX_KEYFRAME_ANIMATIONS; visited++) {
+    int id = schedulerCursor;
+    schedulerCursor = (schedulerCursor + 1) % MAX_KEYFRAME_ANIMATIONS;
+
+    keyframeAnimation *anim = &keyframeAnimations[id];
+    if (anim->active == 0) {
+      continue;
+    }
+
+    if (micros() - startUs > animationBudgetUs) {
+      // out of time, this one goes first next frame
+      schedulerCursor = id;
+      animationStats.deferred++;
+      break;
+    }
+
+    advanceAnimation(anim, now);
+    animationStats.advanced++;
+
+    if (anim->target >= 0) {
+      drawAnimation(id);
+    }
+  }
+
+  animationStats.lastFrameUs = micros() - startUs;
+  if (animationStats.lastFrameUs > animationStats.maxFrameUs) {
+    animationStats.maxFrameUs = animationStats.lastFrameUs;
+  }
+  animationStats.frames++;
+}
+
+void printAnimationStats(Stream *stream) {
+  int active = 0;
+  int allocated = 0;
+  for (int i = 0; i < MAX_KEYFRAME_ANIMATIONS; i++) {
+    if (keyframeAnimations[i].allocated) {
+      allocated++;
+    }
+    if (keyframeAnimations[i].active) {
+      active++;
+    }
+  }
+  stream->printf("animations: %d allocated, %d active\n\r", allocated, active);
+  stream->printf("frame time: %lu us (max %lu us, budget %lu us)\n\r",
+                 animationStats.lastFrameUs, animationStats.maxFrameUs,
+                 animationBudgetUs);
+  stream->printf("frames: %lu  advanced: %lu  deferred: %lu\n\r",
+                 animationStats.frames, animationStats.advanced,
+                 animationStats.deferred);
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: MIT
+#ifndef ANIMATIONS_H
+#define ANIMATIONS_H
+
+#include <Arduino.h>
+
+// Keyframe animation engine for core 2
+//
+// Every animation owns a precomputed color table. Time is tracked as a 16.16
+// fixed-point position into that table, so advancing a frame is an add and a
+// shift instead of recomputing HSV colors. The scheduler only touches active
+// slots and gives up for this frame once animationBudgetUs is used, picking up
+// where it left off on the next call.
+
+#define MAX_KEYFRAME_ANIMATIONS 64
+#define ANIMATION_TABLE_SIZE 32
+#define ANIMATION_MAX_KEYFRAMES 16
+
+// slots below this are owned by initRowAnimations(), the rest are free for
+// scripts (see jl_animation_*)
+#define ANIMATION_ROW_SLOTS 48
+
+#define ANIMATION_FIXED_SHIFT 16
+#define ANIMATION_FIXED_ONE (1UL << ANIMATION_FIXED_SHIFT)
+
+typedef enum {
+  ANIM_LOOP = 0,
+  ANIM_PINGPONG = 1,
+  ANIM_ONESHOT = 2,
+} animationMode;
+
+struct keyframeAnimation {
+  uint32_t table[ANIMATION_TABLE_SIZE];
+  uint8_t tableLength = 0;
+  uint8_t mode = ANIM_LOOP;
+  volatile uint8_t active = 0;
+  volatile uint8_t allocated = 0;
+  int8_t direction = 1;
+
+  uint32_t phase = 0;     // 16.16 position in table
+  uint32_t phaseStep = 0; // 16.16 table entries per millisecond
+  uint32_t lastTick = 0;  // millis() of the last advance
+
+  int target = -1; // node to draw into, -1 = owner samples it itself
+  int spread = 1;  // table entries between the LEDs of a row
+
+  uint32_t sourceColor = 0xffffffff; // what the table was built from (for caching)
+};
+
+struct animationSchedulerStats {
+  uint32_t lastFrameUs;
+  uint32_t maxFrameUs;
+  uint32_t advanced;
+  uint32_t deferred;
+  uint32_t frames;
+};
+
+extern keyframeAnimation keyframeAnimations[MAX_KEYFRAME_ANIMATIONS];
+extern animationSchedulerStats animationStats;
+extern uint32_t animationBudgetUs;
+
+int animationCreate(const uint32_t *keyframes, int numKeyframes,
+                    int periodMs, int mode = ANIM_LOOP, int tableLength = 0,
+                    int slot = -1);
+int animationSetKeyframes(int id, const uint32_t *keyframes, int numKeyframes,
+                          int tableLength = 0);
+void animationSetPeriod(int id, int periodMs);
+void animationSetTarget(int id, int node, int spread = 1);
+void animationStart(int id, int startFrame = 0);
+void animationStop(int id);
+void animationDelete(int id);
+
+uint32_t animationSample(int id, int offset = 0);
+int animationFrame(int id);
+bool animationIsActive(int id);
+
+void animationScheduler(void);
+void printAnimationStats(Stream *stream = &Serial);
+
+#endif
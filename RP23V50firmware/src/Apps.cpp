@@ -14,6 +14,7 @@
 #include "Peripherals.h"
 #include "PersistentStuff.h"
 #include "Probing.h"
+#include "ProbeSense.h"
 #include "Python_Proper.h"
 #include "RotaryEncoder.h"
 #include "config.h"
@@ -144,6 +145,90 @@ void leaveApp(int lastNetSlot) {
 
 void fileManagerApp(void) { filesystemApp(true); }
 
+// Second pass of probeCalibApp: every pad in turn, keeping what it reads so
+// probing maps through measured thresholds instead of the linear fit
+static void probeCalibTable(void) {
+  int raw = 0;
+  if (probeSenseRead(&raw) < 0) {
+    Serial.println("ADC sampler isn't running, skipping the pad table");
+    return;
+  }
+
+  Serial.println("\n\n\rNow tap each pad that lights up and hold the probe there until the next one lights");
+  Serial.println("turn the clickwheel to skip back and forth, hold it when you're done\n\r");
+  while (encoderButtonState == HELD) {
+    delay(1); // the hold that ended the first pass
+  }
+
+  int index = 1;
+  int lastIndex = -1;
+  long lastEncoderPosition = encoderPosition;
+  int candidate = -1;
+  int agreeing = 0;
+  int lastRecorded = -1;
+  int recorded = 0;
+
+  while (index < PROBE_CALIBRATION_PADS) {
+    if (index != lastIndex) {
+      clearLEDsExceptRails();
+      b.lightUpNode(probeRowMapByPad[index], 0x201000);
+      Serial.printf("                                        \rpad %d %s (saved %d) ", index,
+                    definesToChar(probeRowMapByPad[index]), probeCalibrationMeasured(index));
+      Serial.flush();
+      lastIndex = index;
+      candidate = -1;
+      agreeing = 0;
+    }
+
+    if (encoderPosition != lastEncoderPosition) {
+      index += encoderPosition > lastEncoderPosition ? 1 : -1;
+      index = constrain(index, 1, PROBE_CALIBRATION_PADS - 1);
+      lastEncoderPosition = encoderPosition;
+      continue;
+    }
+    if (encoderButtonState == HELD || Serial.available() > 0) {
+      break;
+    }
+
+    delay(1);
+    if (probeSenseRead(&raw) != 1 || raw <= jumperlessConfig.calibration.probe_min ||
+        raw < MINIMUM_PROBE_READING) {
+      agreeing = 0;
+      continue;
+    }
+    // still sitting on the pad we just took doesn't count for this one
+    if (lastRecorded >= 0 && abs(raw - lastRecorded) <= PROBE_SENSE_SPREAD * 2) {
+      continue;
+    }
+    if (candidate >= 0 && abs(raw - candidate) <= PROBE_SENSE_SPREAD) {
+      agreeing++;
+    } else {
+      candidate = raw;
+      agreeing = 0;
+    }
+
+    if (agreeing >= 30) {
+      probeCalibrationSet(index, candidate);
+      Serial.printf("-> %d\n\r", candidate);
+      lastRecorded = candidate;
+      recorded++;
+      index++;
+    }
+  }
+  clearLEDsExceptRails();
+
+  if (recorded == 0) {
+    Serial.println("\n\rNo pads measured, keeping the old table");
+    return;
+  }
+  if (probeCalibrationSave()) {
+    Serial.printf("\n\rMeasured %d pads, %d in the table now\n\r", recorded,
+                  probeCalibrationCount());
+  } else {
+    Serial.println("\n\rCouldn't write " PROBE_CALIBRATION_FILE);
+  }
+}
+
 void probeCalibApp(void) {
   b.clear();
 
@@ -255,6 +340,8 @@ void probeCalibApp(void) {
     if (encoderButtonState == HELD) done = true;
   }
 
+  probeCalibTable();
+
   Serial.println("\n\n\r");
   Serial.println("Saving config...");
 
@@ -322,6 +409,7 @@ void customApp(void) {
   refreshConnections(-1, 0);
   waitCore2();
 
+  settleAdc(0, 8);
   float voltage = readAdcVoltage(0, 8);
   Serial.print("\n\rADC0: ");
   Serial.println(voltage);
@@ -368,6 +456,7 @@ void customApp(void) {
   removeBridgeFromNodeFile(TOP_RAIL, ISENSE_PLUS, netSlot, 0);
   refreshConnections(-1, 0);
 
+  settleAdc(7, 8);
   float probeVoltage = readAdcVoltage(7, 8);
   Serial.print("Probe voltage: ");
   Serial.print(probeVoltage, 4);
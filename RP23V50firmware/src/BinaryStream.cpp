@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MIT
+#include "BinaryStream.h"
+
+// nibble table, 32 bytes instead of 512 and still only two lookups per byte
+static const uint16_t crcNibbleTable[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+};
+
+uint16_t crc16Ccitt(const uint8_t *data, size_t length, uint16_t crc) {
+  for (size_t i = 0; i < length; i++) {
+    crc = (crc << 4) ^ crcNibbleTable[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (crc << 4) ^ crcNibbleTable[(crc >> 12) ^ (data[i] & 0x0f)];
+  }
+  return crc;
+}
+
+static bool writeAll(Stream *stream, const uint8_t *data, size_t length,
+                     unsigned long startTime, unsigned long timeoutMs) {
+  size_t sent = 0;
+  while (sent < length) {
+    int room = stream->availableForWrite();
+    if (room <= 0) {
+      if (millis() - startTime > timeoutMs) {
+        return false;
+      }
+      delayMicroseconds(10);
+      continue;
+    }
+    if ((size_t)room > length - sent) {
+      room = length - sent;
+    }
+    sent += stream->write(data + sent, room);
+  }
+  return true;
+}
+
+static void fillHeader(uint8_t *header, uint8_t streamId, uint8_t type,
+                       uint16_t seq, uint16_t length) {
+  header[0] = BINARY_FRAME_MAGIC_0;
+  header[1] = BINARY_FRAME_MAGIC_1;
+  header[2] = streamId;
+  header[3] = type;
+  header[4] = seq & 0xff;
+  header[5] = seq >> 8;
+  header[6] = length & 0xff;
+  header[7] = length >> 8;
+}
+
+bool writeBinaryFrame(Stream *stream, uint8_t streamId, uint8_t type,
+                      uint16_t seq, const uint8_t *payload, uint16_t length,
+                      unsigned long timeoutMs) {
+  uint8_t header[BINARY_FRAME_HEADER_SIZE];
+  fillHeader(header, streamId, type, seq, length);
+
+  uint16_t crc = crc16Ccitt(header + 2, BINARY_FRAME_HEADER_SIZE - 2);
+  crc = crc16Ccitt(payload, length, crc);
+  uint8_t trailer[2] = {(uint8_t)(crc & 0xff), (uint8_t)(crc >> 8)};
+
+  unsigned long startTime = millis();
+  return writeAll(stream, header, sizeof(header), startTime, timeoutMs) &&
+         writeAll(stream, payload, length, startTime, timeoutMs) &&
+         writeAll(stream, trailer, sizeof(trailer), startTime, timeoutMs);
+}
+
+size_t finishBinaryFrame(uint8_t *frame, uint8_t streamId, uint8_t type,
+                         uint16_t seq, uint16_t length) {
+  fillHeader(frame, streamId, type, seq, length);
+
+  uint16_t crc = crc16Ccitt(frame + 2, BINARY_FRAME_HEADER_SIZE - 2 + length);
+  frame[BINARY_FRAME_HEADER_SIZE + length] = crc & 0xff;
+  frame[BINARY_FRAME_HEADER_SIZE + length + 1] = crc >> 8;
+  return BINARY_FRAME_OVERHEAD + length;
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: MIT
+#ifndef BINARYSTREAM_H
+#define BINARYSTREAM_H
+
+#include <Arduino.h>
+
+// Framing shared by the binary streams on the CDC ports
+//
+//   0xA5 0x5A  stream  type  seq(u16)  length(u16)  payload...  crc(u16)
+//
+// Everything is little endian. The CRC is CRC-16/CCITT-FALSE over everything
+// from the stream byte through the end of the payload, so a host that loses
+// sync can hunt for the magic and throw away anything that doesn't check out.
+
+#define BINARY_FRAME_MAGIC_0 0xA5
+#define BINARY_FRAME_MAGIC_1 0x5A
+#define BINARY_FRAME_HEADER_SIZE 8
+#define BINARY_FRAME_OVERHEAD (BINARY_FRAME_HEADER_SIZE + 2)
+
+// stream ids, one per kind of data so a host can tell them apart
+#define BINARY_STREAM_LEDS 'L'
+#define BINARY_STREAM_CAPTURE 'A'
+#define BINARY_STREAM_TELEMETRY 'T'
+
+uint16_t crc16Ccitt(const uint8_t *data, size_t length, uint16_t crc = 0xffff);
+
+/// writes a whole frame, false if the port stopped taking data before
+/// timeoutMs ran out (the host will see a bad CRC and resync)
+bool writeBinaryFrame(Stream *stream, uint8_t streamId, uint8_t type,
+                      uint16_t seq, const uint8_t *payload, uint16_t length,
+                      unsigned long timeoutMs = 5);
+
+/// for payloads built in place at frame + BINARY_FRAME_HEADER_SIZE, fills in
+/// the header in front and the CRC behind, returns the whole frame size
+size_t finishBinaryFrame(uint8_t *frame, uint8_t streamId, uint8_t type,
+                         uint16_t seq, uint16_t length);
+
+#endif
@@ -0,0 +1,348 @@
+// SPDX-License-Identifier: MIT
+#include "BulkSampler.h"
+#include "AdcSampler.h"
+#include "InaSampler.h"
+#include "Peripherals.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/timer.h"
+
+bulkSamplerStatistics bulkSamplerStats = {0, 0, 0, 0, 0, 0};
+
+#define BULK_START_US 50 // from bulkSamplerStart() to the first timed row
+
+static bulkRequest job;
+static int channels = 0;
+static uint8_t channelOf[ADC_SAMPLER_CHANNELS]; // column -> ADC channel or INA sensor
+static uint16_t *codes = nullptr;               // where ADC codes go, the back half of a float buffer
+static bool useDma = false;
+static uint8_t resumeMask = 0;                  // the background sampler's, 0 if it wasn't running
+
+static volatile bool running = false;
+static bool started = false;                    // until bulkSamplerFinish()
+static volatile uint32_t row = 0;
+static int dmaChannel = -1;
+static int alarmNum = -1;
+
+static uint64_t startAt = 0;
+static uint64_t period256 = 0;                  // us per row, 24.8 fixed point
+static uint32_t firstUs = 0;
+static uint32_t lastUs = 0;
+static volatile uint32_t late = 0;
+static float adcIntervalUs = 0;
+
+// the divider in 1/256ths of a clock, the ADC takes (1 + div) clocks a conversion
+static uint32_t adcDivider256(float rateHz, int count) {
+  float conversions = rateHz * count;
+  float div = (float)BULK_ADC_CLOCK_HZ / conversions - 1.0f;
+  uint32_t div256 = (uint32_t)(div * 256.0f + 0.5f);
+  if (div256 < 95 * 256) {
+    div256 = 95 * 256; // anything under 96 clocks is 96 clocks anyway
+  }
+  return div256;
+}
+
+float bulkSamplerAdcRate(float rateHz, int count) {
+  if (count <= 0 || rateHz <= 0) {
+    return 0;
+  }
+  if (rateHz * count < BULK_ADC_DMA_MIN_HZ) {
+    return rateHz; // timed
+  }
+  float clocks = 1.0f + adcDivider256(rateHz, count) / 256.0f;
+  return (float)BULK_ADC_CLOCK_HZ / clocks / count;
+}
+
+const char *bulkErrorText(int error) {
+  switch (error) {
+  case BULK_OK:
+    return "ok";
+  case BULK_BUSY:
+    return "a capture is already running";
+  case BULK_BAD_CHANNEL:
+    return "no channels, or one that doesn't exist";
+  case BULK_BAD_RATE:
+    return "rate out of range";
+  case BULK_NO_TIMER:
+    return "no hardware alarm free";
+  case BULK_NO_DMA:
+    return "no DMA channel free";
+  }
+  return "unknown error";
+}
+
+static void __not_in_flash_func(takeRow)(uint32_t r) {
+  uint32_t base = r * channels;
+  if (job.source == BULK_GPIO) {
+    // GPIO_1-8 are GP20-27, one after the other
+    ((uint8_t *)job.out)[r] = (uint8_t)(gpio_get_all() >> gpioDef[0][0]);
+  } else if (job.source == BULK_INA) {
+    float *out = (float *)job.out;
+    float scale = job.quantity == INA_BUS_VOLTAGE ? 1.0f : 0.001f; // mA and mW to A and W
+    for (int k = 0; k < channels; k++) {
+      out[base + k] = inaSamplerCached(channelOf[k], job.quantity) * scale;
+    }
+  } else {
+    for (int k = 0; k < channels; k++) {
+      adc_select_input(channelOf[k]);
+      codes[base + k] = adc_read();
+    }
+  }
+}
+
+static void __not_in_flash_func(onAlarm)(uint alarm) {
+  (void)alarm;
+  uint32_t start = time_us_32();
+  while (running) {
+    uint64_t due = startAt + ((row * period256) >> 8);
+    uint64_t now = time_us_64();
+    if ((int64_t)(due - now) > 0) {
+      if (!hardware_alarm_set_target(alarmNum, from_us_since_boot(due))) {
+        break;
+      }
+      continue; // went by while it was being set
+    }
+    if (((now - due) << 8) >= period256) {
+      late = late + 1;
+    }
+    uint32_t r = row;
+    uint32_t at = (uint32_t)now;
+    takeRow(r);
+    if (job.times != nullptr) {
+      job.times[r] = at;
+    }
+    if (r == 0) {
+      firstUs = at;
+    }
+    lastUs = at;
+    row = r + 1;
+    if (r + 1 == job.rows) {
+      running = false;
+    }
+  }
+  uint32_t us = time_us_32() - start;
+  if (us > bulkSamplerStats.maxHandlerUs) {
+    bulkSamplerStats.maxHandlerUs = us;
+  }
+}
+
+static void releaseAdc(void) {
+  adc_run(false);
+  adc_set_round_robin(0);
+  adc_fifo_setup(false, false, 0, false, false);
+  adc_fifo_drain();
+  adc_set_clkdiv(1.0);
+  adc_select_input(0);
+  if (resumeMask != 0) {
+    adcSamplerStart(resumeMask);
+  }
+  resumeMask = 0;
+}
+
+static int startDma(void) {
+  dmaChannel = dma_claim_unused_channel(false);
+  if (dmaChannel < 0) {
+    return BULK_NO_DMA;
+  }
+  uint32_t div256 = adcDivider256(job.rateHz, channels);
+  adcIntervalUs = (1.0f + div256 / 256.0f) * channels * (1000000.0f / BULK_ADC_CLOCK_HZ);
+
+  adc_fifo_setup(true, true, 1, false, false);
+  adc_fifo_drain();
+  adc_set_clkdiv(div256 / 256.0f);
+  adc_select_input(channelOf[0]);
+  adc_set_round_robin(job.mask);
+
+  dma_channel_config cfg = dma_channel_get_default_config(dmaChannel);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, false);
+  channel_config_set_write_increment(&cfg, true);
+  channel_config_set_dreq(&cfg, DREQ_ADC);
+  dma_channel_configure(dmaChannel, &cfg, codes, &adc_hw->fifo, job.rows * channels, true);
+
+  firstUs = time_us_32();
+  adc_run(true);
+  return BULK_OK;
+}
+
+static int startTimer(void) {
+  if (alarmNum < 0) {
+    alarmNum = hardware_alarm_claim_unused(false);
+    if (alarmNum < 0) {
+      return BULK_NO_TIMER;
+    }
+  }
+  hardware_alarm_set_callback(alarmNum, onAlarm);
+
+  period256 = (uint64_t)(256000000.0 / job.rateHz + 0.5);
+  startAt = time_us_64() + BULK_START_US;
+  running = true;
+  if (hardware_alarm_set_target(alarmNum, from_us_since_boot(startAt))) {
+    hardware_alarm_force_irq(alarmNum);
+  }
+  return BULK_OK;
+}
+
+int bulkSamplerStart(const bulkRequest *request) {
+  if (started) {
+    return BULK_BUSY;
+  }
+  job = *request;
+  if (job.out == nullptr || job.rows == 0) {
+    return BULK_BAD_CHANNEL;
+  }
+
+  uint8_t valid = 0;
+  float maxHz = BULK_TIMER_MAX_HZ;
+  if (job.source == BULK_ADC) {
+    valid = (1 << ADC_SAMPLER_CHANNELS) - 1;
+  } else if (job.source == BULK_INA) {
+    valid = (1 << INA_SAMPLER_SENSORS) - 1;
+    maxHz = BULK_INA_MAX_HZ;
+  } else {
+    job.mask = 1;
+  }
+  if (job.source != BULK_GPIO && (job.mask == 0 || (job.mask & ~valid))) {
+    return BULK_BAD_CHANNEL;
+  }
+
+  channels = 0;
+  for (int ch = 0; ch < 8; ch++) {
+    if ((job.mask >> ch) & 1) {
+      channelOf[channels++] = ch;
+    }
+  }
+  if (job.source == BULK_ADC) {
+    float conversions = job.rateHz * channels;
+    useDma = conversions >= BULK_ADC_DMA_MIN_HZ;
+    maxHz = BULK_ADC_MAX_HZ / channels;
+  } else {
+    useDma = false;
+  }
+  if (!(job.rateHz >= BULK_MIN_HZ) || job.rateHz > maxHz) {
+    return BULK_BAD_RATE;
+  }
+
+  if (job.source == BULK_ADC) {
+    codes = job.volts ? (uint16_t *)job.out + job.rows * channels : (uint16_t *)job.out;
+    // round-robin and single reads would both scramble the sampler's blocks
+    resumeMask = adcSamplerRunning() ? adcSamplerMask() : 0;
+    adcSamplerStop();
+  }
+
+  row = 0;
+  late = 0;
+  firstUs = 0;
+  lastUs = 0;
+  int error = useDma ? startDma() : startTimer();
+  if (error != BULK_OK) {
+    if (job.source == BULK_ADC) {
+      releaseAdc();
+    }
+    return error;
+  }
+  started = true;
+  bulkSamplerStats.captures++;
+  if (useDma) {
+    bulkSamplerStats.dmaCaptures++;
+  }
+  return BULK_OK;
+}
+
+bool bulkSamplerBusy(void) {
+  if (!started) {
+    return false;
+  }
+  if (useDma) {
+    return dma_channel_is_busy(dmaChannel);
+  }
+  return running;
+}
+
+void bulkSamplerStop(void) {
+  if (!started) {
+    return;
+  }
+  if (useDma) {
+    if (dma_channel_is_busy(dmaChannel)) {
+      bulkSamplerStats.stopped++;
+    }
+    adc_run(false);
+    dma_channel_abort(dmaChannel);
+  } else {
+    if (running) {
+      bulkSamplerStats.stopped++;
+    }
+    running = false;
+    hardware_alarm_cancel(alarmNum);
+  }
+}
+
+void bulkSamplerFinish(bulkResult *result) {
+  result->rows = 0;
+  result->startUs = 0;
+  result->intervalUs = 0;
+  result->late = 0;
+  if (!started) {
+    return;
+  }
+  bulkSamplerStop();
+
+  uint32_t done;
+  if (useDma) {
+    uint32_t remaining = dma_hw->ch[dmaChannel].transfer_count & 0x0FFFFFFF; // above is the mode
+    done = (job.rows * channels - remaining) / channels;
+    dma_channel_unclaim(dmaChannel);
+    dmaChannel = -1;
+    result->startUs = firstUs;
+    result->intervalUs = adcIntervalUs;
+    if (job.times != nullptr) {
+      for (uint32_t r = 0; r < done; r++) {
+        job.times[r] = firstUs + (uint32_t)(r * adcIntervalUs + 0.5f);
+      }
+    }
+  } else {
+    done = row;
+    result->startUs = firstUs;
+    if (done > 1) {
+      result->intervalUs = (float)(lastUs - firstUs) / (done - 1);
+    } else {
+      result->intervalUs = (float)period256 / 256.0f;
+    }
+  }
+
+  if (job.source == BULK_ADC) {
+    releaseAdc();
+    if (job.volts) {
+      // forwards is safe: with n values in all, float i ends at byte 4i+4
+      // and code i+1 starts at byte 2n+2i+2, which is never before it
+      float *out = (float *)job.out;
+      uint32_t count = done * channels;
+      for (uint32_t i = 0; i < count; i++) {
+        int ch = channelOf[i % channels];
+        float volts = (codes[i] & 0x0FFF) * (adcSpread[ch] / 4095);
+        if (ch != 4 && ch != 5) {
+          volts -= adcZero[ch];
+        }
+        out[i] = volts;
+      }
+    }
+  }
+
+  result->rows = done;
+  result->late = late;
+  bulkSamplerStats.rows += done;
+  bulkSamplerStats.late += late;
+  started = false;
+}
+
+void printBulkSamplerStats(Stream *stream) {
+  stream->printf("bulk sampler: %s, %lu captures (%lu by DMA), %lu rows\n\r",
+                 bulkSamplerBusy() ? "running" : "idle", bulkSamplerStats.captures,
+                 bulkSamplerStats.dmaCaptures, bulkSamplerStats.rows);
+  stream->printf("late rows: %lu  stopped early: %lu  alarm handler max: %lu us\n\r",
+                 bulkSamplerStats.late, bulkSamplerStats.stopped,
+                 bulkSamplerStats.maxHandlerUs);
+}
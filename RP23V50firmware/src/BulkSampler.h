@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+#ifndef BULKSAMPLER_H
+#define BULKSAMPLER_H
+
+#include <Arduino.h>
+
+// Bulk acquisition into a caller's buffer
+//
+// A script that wants a few thousand readings shouldn't have to make a few
+// thousand calls. bulkSamplerStart() takes a buffer, a row count and a rate
+// and fills the buffer on its own, one row per tick with one value per
+// channel, lowest channel first. The caller waits for bulkSamplerBusy() to go
+// false and bulkSamplerFinish() tidies up and says when the rows were taken.
+//
+// ADC rows at BULK_ADC_DMA_MIN_HZ conversions a second and up come straight
+// from the ADC's FIFO by DMA. The ADC free-runs in round-robin over the
+// channels and its clock divider sets the rate, so the timing is exact and
+// the CPU does nothing per sample. The background sampler (AdcSampler.h) is
+// stopped for the capture and started again after it.
+//
+// Slower ADC rows, GPIO and the INA219s go off a hardware alarm on core 0.
+// Each row's due time is worked out from the start, so the rate doesn't
+// drift. GPIO rows are one read of SIO. INA rows copy InaSampler's cache, so
+// they're only as fresh as the last conversion (~17 ms).
+
+#define BULK_ADC_CLOCK_HZ 48000000
+#define BULK_ADC_MAX_HZ 500000     // conversions a second, all channels together
+#define BULK_ADC_DMA_MIN_HZ 750    // the divider tops out at 65535
+#define BULK_TIMER_MAX_HZ 100000   // rows a second off the alarm
+#define BULK_INA_MAX_HZ 1000
+#define BULK_MIN_HZ 0.01f
+
+enum bulkSource {
+  BULK_ADC = 0,
+  BULK_GPIO,
+  BULK_INA,
+};
+
+enum bulkError {
+  BULK_OK = 0,
+  BULK_BUSY,         // a capture's already running
+  BULK_BAD_CHANNEL,
+  BULK_BAD_RATE,
+  BULK_NO_TIMER,
+  BULK_NO_DMA,
+};
+
+struct bulkRequest {
+  uint8_t source;    // bulkSource
+  uint8_t mask;      // ADC0-7, or INA sensors 0-1. GPIO rows are always GPIO_1-8
+  uint8_t quantity;  // INA only, an inaQuantity
+  bool volts;        // ADC only, floats in volts instead of 12-bit codes
+  void *out;         // rows x channels of uint16_t codes or floats, or a
+                     // byte a row for GPIO with bit n = GPIO_(n+1)
+  uint32_t rows;
+  float rateHz;      // rows a second
+  uint32_t *times;   // when each row was taken in us (DMA rows: computed), or nullptr
+};
+
+struct bulkResult {
+  uint32_t rows;       // rows filled, fewer than asked if it was stopped
+  uint32_t startUs;    // the first row
+  float intervalUs;    // from one row to the next, on average if it's timer driven
+  uint32_t late;       // rows taken a whole interval or more after they were due
+};
+
+struct bulkSamplerStatistics {
+  uint32_t captures;
+  uint32_t dmaCaptures;
+  uint32_t rows;
+  uint32_t late;
+  uint32_t maxHandlerUs;
+  uint32_t stopped;    // captures cut short
+};
+
+extern bulkSamplerStatistics bulkSamplerStats;
+
+/// BULK_OK or a bulkError, nothing is started unless it's BULK_OK
+int bulkSamplerStart(const bulkRequest *request);
+bool bulkSamplerBusy(void);
+/// cuts a capture short, bulkSamplerFinish() still has to be called
+void bulkSamplerStop(void);
+/// once it isn't busy: converts ADC codes to volts if asked, fills in the
+/// times of DMA rows from the first one and the ADC interval (only the first
+/// is measured) and gives the ADC back to the background sampler
+void bulkSamplerFinish(bulkResult *result);
+/// the rate the ADC's divider will really give for rateHz over channels
+float bulkSamplerAdcRate(float rateHz, int channels);
+const char *bulkErrorText(int error);
+
+void printBulkSamplerStats(Stream *stream);
+
+#endif
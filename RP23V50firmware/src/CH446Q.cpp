@@ -537,6 +537,8 @@ void sendPath(int i, int setOrClear, int newOrLast) {
 void sendXYraw(int chip, int x, int y, int setOrClear) {
   uint32_t chAddress = 0;
   chipSelect = chip;
+  // whatever the ADCs see may have just changed, see settleAdc()
+  markAdcInputsChanged();
 
   // Serial.print("sendXYraw: chip = ");
   // Serial.print(chip);
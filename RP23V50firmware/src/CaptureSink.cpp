@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: MIT
+#include "CaptureSink.h"
+#include "BinaryStream.h"
+#include <new>
+
+#ifdef USE_TINYUSB
+#include "tusb.h"
+#endif
+
+captureFileStatistics captureFileStats = {0, 0, 0, 0, 0, 0};
+
+bool UsbCaptureSink::write(const uint8_t *data, int len) {
+#ifdef USE_TINYUSB
+  if (!tud_cdc_n_connected(cdc)) {
+    Serial.println("LA: USB not connected");
+    Serial.flush();
+    return false;
+  }
+  // push big chunks into the TinyUSB fifo, its flush threshold does the rest
+  int off = 0;
+  while (off < len) {
+    uint32_t space = tud_cdc_n_write_available(cdc);
+    if (space == 0) {
+      tud_task();
+      tud_cdc_n_write_flush(cdc);
+      delayMicroseconds(10);
+      continue;
+    }
+    uint32_t chunk = (uint32_t)(len - off);
+    if (chunk > space) {
+      chunk = space;
+    }
+    off += (int)tud_cdc_n_write(cdc, data + off, chunk);
+    tud_task();
+  }
+  // so a tail shorter than a packet goes out now
+  tud_cdc_n_write_flush(cdc);
+  return true;
+#else
+  return false;
+#endif
+}
+
+FileCaptureSink::FileCaptureSink() {
+  filePath[0] = 0;
+  blocks[0] = blocks[1] = nullptr;
+  failed = false;
+  release();
+}
+
+bool FileCaptureSink::setPath(const char *path) {
+  if (path == nullptr || strlen(path) >= sizeof(filePath)) {
+    return false;
+  }
+  strcpy(filePath, path);
+  return true;
+}
+
+void FileCaptureSink::release(void) {
+  for (int b = 0; b < 2; b++) {
+    delete[] blocks[b];
+    blocks[b] = nullptr;
+    filled[b] = 0;
+    written[b] = 0;
+    ready[b] = false;
+  }
+  filling = 0;
+}
+
+bool FileCaptureSink::begin(void) {
+  memset(&captureFileStats, 0, sizeof(captureFileStats));
+  release();
+  failed = false;
+  if (filePath[0] == 0) {
+    return false;
+  }
+  blocks[0] = new (std::nothrow) uint8_t[CAPTURE_FILE_BLOCK];
+  blocks[1] = new (std::nothrow) uint8_t[CAPTURE_FILE_BLOCK];
+  if (blocks[0] == nullptr || blocks[1] == nullptr) {
+    release();
+    return false;
+  }
+  file = FatFS.open(filePath, "w");
+  if (!file) {
+    release();
+    return false;
+  }
+  return true;
+}
+
+bool FileCaptureSink::writeChunk(int block) {
+  int n = filled[block] - written[block];
+  if (n > CAPTURE_FILE_CHUNK) {
+    n = CAPTURE_FILE_CHUNK;
+  }
+  uint32_t start = micros();
+  size_t out = file.write(blocks[block] + written[block], n);
+  uint32_t us = micros() - start;
+
+  captureFileStats.chunks++;
+  captureFileStats.totalWriteUs += us;
+  if (us > captureFileStats.maxWriteUs) {
+    captureFileStats.maxWriteUs = us;
+  }
+  if ((int)out != n) {
+    failed = true; // partition's full, most likely
+    return false;
+  }
+  captureFileStats.bytes += n;
+  written[block] += n;
+  if (written[block] == filled[block]) {
+    filled[block] = 0;
+    written[block] = 0;
+    ready[block] = false;
+  }
+  return true;
+}
+
+bool FileCaptureSink::write(const uint8_t *data, int len) {
+  if (failed || !file) {
+    return false;
+  }
+  while (len > 0) {
+    int n = CAPTURE_FILE_BLOCK - filled[filling];
+    if (n > len) {
+      n = len;
+    }
+    memcpy(blocks[filling] + filled[filling], data, n);
+    filled[filling] += n;
+    data += n;
+    len -= n;
+    if (filled[filling] == CAPTURE_FILE_BLOCK) {
+      ready[filling] = true;
+      filling ^= 1;
+      if (ready[filling]) {
+        // the older block hasn't gone out yet, it has to now
+        captureFileStats.stalls++;
+        while (ready[filling]) {
+          if (!writeChunk(filling)) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void FileCaptureSink::service(void) {
+  int waiting = filling ^ 1;
+  if (failed || !ready[waiting]) {
+    return;
+  }
+  if (writeChunk(waiting)) {
+    captureFileStats.serviced++;
+  }
+}
+
+bool FileCaptureSink::end(void) {
+  if (file) {
+    // the waiting block first, then whatever's in the one being filled
+    int waiting = filling ^ 1;
+    while (ready[waiting] && !failed) {
+      writeChunk(waiting);
+    }
+    ready[filling] = filled[filling] > 0;
+    while (ready[filling] && !failed) {
+      writeChunk(filling);
+    }
+    file.close();
+  }
+  release();
+  return !failed;
+}
+
+uint32_t captureFileBenchmark(Stream *stream, const char *path, uint32_t bytes) {
+  uint8_t *chunk = new (std::nothrow) uint8_t[CAPTURE_FILE_CHUNK];
+  if (chunk == nullptr) {
+    stream->printf("no memory for the benchmark\n\r");
+    return 0;
+  }
+  File file = FatFS.open(path, "w");
+  if (!file) {
+    stream->printf("can't open %s\n\r", path);
+    delete[] chunk;
+    return 0;
+  }
+  for (int i = 0; i < CAPTURE_FILE_CHUNK; i++) {
+    chunk[i] = (uint8_t)(i * 131 + 7);
+  }
+
+  uint32_t slowest = 0;
+  uint32_t total = 0;
+  uint32_t start = micros();
+  while (total < bytes) {
+    uint32_t n = bytes - total;
+    if (n > CAPTURE_FILE_CHUNK) {
+      n = CAPTURE_FILE_CHUNK;
+    }
+    uint32_t t = micros();
+    if (file.write(chunk, n) != n) {
+      break;
+    }
+    t = micros() - t;
+    slowest = t > slowest ? t : slowest;
+    total += n;
+  }
+  file.close(); // the FAT update counts too
+  uint32_t us = micros() - start;
+  FatFS.remove(path);
+  delete[] chunk;
+
+  if (total < bytes) {
+    stream->printf("only %lu of %lu bytes fit\n\r", total, bytes);
+  }
+  if (total == 0 || us == 0) {
+    return 0;
+  }
+  uint32_t rate = (uint32_t)((uint64_t)total * 1000000 / us);
+  stream->printf("%lu bytes in %lu ms: %lu kB/s, slowest %d byte write %lu us\n\r",
+                 total, us / 1000, rate / 1024, CAPTURE_FILE_CHUNK, slowest);
+
+  // worst case is noise on the digital pins, raw blocks of 512 samples
+  static const int analogCounts[] = {0, 1, 4, 8};
+  for (int i = 0; i < 4; i++) {
+    int a = analogCounts[i];
+    uint32_t perBlock = BINARY_FRAME_OVERHEAD + 4 + 512;
+    if (a) {
+      perBlock += BINARY_FRAME_OVERHEAD + 5 + (512 * a * 3 + 1) / 2;
+    }
+    stream->printf("  %d analog: keeps up to %lu samples/s on busy signals\n\r", a,
+                   (uint32_t)((uint64_t)rate * 512 / perBlock));
+  }
+  stream->printf("  (quiet digital signals are run-length coded and go much further)\n\r");
+  return rate;
+}
+
+void printCaptureFileStats(Stream *stream) {
+  stream->printf("last file capture: %lu bytes in %lu writes (%lu while waiting "
+                 "on DMA), %lu stalls, slowest write %lu us",
+                 captureFileStats.bytes, captureFileStats.chunks,
+                 captureFileStats.serviced, captureFileStats.stalls,
+                 captureFileStats.maxWriteUs);
+  if (captureFileStats.totalWriteUs > 0) {
+    stream->printf(", %lu kB/s",
+                   (uint32_t)((uint64_t)captureFileStats.bytes * 1000000 /
+                              captureFileStats.totalWriteUs / 1024));
+  }
+  stream->printf("\n\r");
+}
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: MIT
+#ifndef CAPTURESINK_H
+#define CAPTURESINK_H
+
+#include <Arduino.h>
+#include <FatFS.h>
+
+// Where logic analyzer output goes
+//
+// The logic analyzer builds its output in txbuf and hands each full buffer to
+// a sink. UsbCaptureSink is the second CDC port, what it always did.
+// FileCaptureSink writes the binary frames (stream 'A', see LogicAnalyzer.h)
+// to a file on the FatFS partition, so the file is byte for byte what a "B1"
+// client would have received. scripts/la_capture_file.py checks one and turns
+// it into a sigrok session (.sr).
+//
+// Flash writes stall the CPU, not the DMA. The file sink has two
+// CAPTURE_FILE_BLOCK buffers: write() fills one while the other waits, and
+// service(), which the capture loop calls while it spins on the next DMA half,
+// writes the waiting one out CAPTURE_FILE_CHUNK at a time. The flash write
+// overlaps the next half filling instead of adding to the time between halves.
+// If both buffers are full when more comes in, write() has to write one out
+// there and then, which counts as a stall. captureFileBenchmark() measures how
+// fast the partition takes data, and so which rates keep up.
+
+#define CAPTURE_FILE_BLOCK 16384 // same as the logic analyzer's txbuf
+#define CAPTURE_FILE_CHUNK 4096  // one flash sector per service() call
+#define CAPTURE_FILE_PATH_MAX 48
+
+class CaptureSink {
+public:
+  virtual ~CaptureSink() {}
+  virtual bool begin(void) { return true; }
+  /// takes all of it or returns false
+  virtual bool write(const uint8_t *data, int len) = 0;
+  /// called while the capture loop waits on the DMA
+  virtual void service(void) {}
+  /// everything out, false if anything got lost on the way
+  virtual bool end(void) { return true; }
+  virtual bool isFile(void) const { return false; }
+};
+
+class UsbCaptureSink : public CaptureSink {
+public:
+  explicit UsbCaptureSink(int cdc) : cdc(cdc) {}
+  bool write(const uint8_t *data, int len) override;
+
+private:
+  int cdc;
+};
+
+class FileCaptureSink : public CaptureSink {
+public:
+  FileCaptureSink();
+  /// false if the path doesn't fit
+  bool setPath(const char *path);
+  const char *path(void) const { return filePath; }
+
+  bool begin(void) override;
+  bool write(const uint8_t *data, int len) override;
+  void service(void) override;
+  bool end(void) override;
+  bool isFile(void) const override { return true; }
+
+private:
+  bool writeChunk(int block);
+  void release(void);
+
+  char filePath[CAPTURE_FILE_PATH_MAX];
+  File file;
+  uint8_t *blocks[2];
+  int filled[2];   // bytes in each block
+  int written[2];  // of those, already in the file
+  bool ready[2];   // full (or last) and waiting to be written
+  int filling;
+  bool failed;
+};
+
+struct captureFileStatistics {
+  uint32_t bytes;       // this capture, in the file
+  uint32_t chunks;      // writes to the file
+  uint32_t serviced;    // of those, done while waiting on the DMA
+  uint32_t stalls;      // both buffers full, write() had to wait on flash
+  uint32_t maxWriteUs;  // slowest chunk
+  uint32_t totalWriteUs;
+};
+
+extern captureFileStatistics captureFileStats;
+
+/// writes bytes to a scratch file at path and prints the throughput and the
+/// sample rates that keeps up with, returns bytes per second (0 on failure)
+uint32_t captureFileBenchmark(Stream *stream, const char *path, uint32_t bytes);
+
+void printCaptureFileStats(Stream *stream);
+
+#endif
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MIT
+#include "CommandTemplate.h"
+#include <stdlib.h>
+#include <string.h>
+
+static bool isNameChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+         c == '_' || (unsigned char)c >= 0x80;
+}
+
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// code in these runs later, after the next command has bound __jl0.. to its
+// own numbers, so commands with them keep their numbers
+static bool isDeferredKeyword(const char *s, size_t length) {
+  static const char *const keywords[] = {"def", "lambda", "class", "for", "yield", "async"};
+  for (const char *k : keywords) {
+    if (strlen(k) == length && memcmp(s, k, length) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the length of the string literal starting at s, escapes and triple quotes included
+static size_t stringLength(const char *s) {
+  char quote = s[0];
+  bool triple = s[1] == quote && s[2] == quote;
+  size_t i = triple ? 3 : 1;
+  while (s[i] != '\0') {
+    if (s[i] == '\\' && s[i + 1] != '\0') {
+      i += 2;
+      continue;
+    }
+    if (s[i] == quote) {
+      if (!triple) {
+        return i + 1;
+      }
+      if (s[i + 1] == quote && s[i + 2] == quote) {
+        return i + 3;
+      }
+    }
+    i++;
+  }
+  return i; // unterminated, the compiler can say so
+}
+
+// a plain decimal int or float at s, its length or 0
+static size_t numberLength(const char *s, bool *isFloat) {
+  size_t i = 0;
+  while (isDigit(s[i])) {
+    i++;
+  }
+  *isFloat = false;
+  if (s[i] == '.') {
+    *isFloat = true;
+    i++;
+    while (isDigit(s[i])) {
+      i++;
+    }
+  }
+  if ((s[i] == 'e' || s[i] == 'E') &&
+      (isDigit(s[i + 1]) || ((s[i + 1] == '+' || s[i + 1] == '-') && isDigit(s[i + 2])))) {
+    *isFloat = true;
+    i += 2;
+    while (isDigit(s[i])) {
+      i++;
+    }
+  }
+  if (isNameChar(s[i]) || s[i] == '.') {
+    return 0; // 0x10, 1j, 1_000, 1.real
+  }
+  if (!*isFloat && (i > 9 || (s[0] == '0' && i > 1))) {
+    return 0; // too big for an int32, or not valid Python anyway
+  }
+  return i;
+}
+
+int commandTemplate(const char *command, char *key, size_t keySize, commandLiteral *literals) {
+  size_t out = 0;
+  int count = 0;
+  size_t i = 0;
+  bool deferred = false;
+
+  while (command[i] != '\0') {
+    const char *s = command + i;
+    size_t take = 0;    // copied as it is
+    const char *insert = nullptr;
+    char name[8];
+
+    if (*s == '\'' || *s == '"') {
+      take = stringLength(s);
+    } else if (*s == '#') {
+      take = strcspn(s, "\n");
+    } else if (isNameChar(*s) && !isDigit(*s)) {
+      take = 1;
+      while (isNameChar(s[take])) {
+        take++;
+      }
+      deferred |= isDeferredKeyword(s, take);
+    } else if (isDigit(*s) && !(i > 0 && command[i - 1] == '.')) {
+      bool isFloat;
+      size_t length = numberLength(s, &isFloat);
+      if (length > 0 && count < COMMAND_TEMPLATE_MAX_LITERALS) {
+        commandLiteral *lit = &literals[count];
+        lit->isFloat = isFloat;
+        if (isFloat) {
+          lit->f = strtod(s, nullptr);
+          lit->i = 0;
+        } else {
+          lit->i = (int32_t)strtol(s, nullptr, 10);
+          lit->f = 0;
+        }
+        memcpy(name, "__jl", 4);
+        name[4] = (char)('0' + count);
+        name[5] = '\0';
+        count++;
+        insert = name;
+        i += length;
+      } else {
+        take = 1;
+        while (isDigit(s[take])) {
+          take++;
+        }
+      }
+    } else {
+      take = 1;
+    }
+
+    const char *from = insert != nullptr ? insert : s;
+    size_t length = insert != nullptr ? strlen(insert) : take;
+    if (out + length + 1 > keySize) {
+      return -1;
+    }
+    memcpy(key + out, from, length);
+    out += length;
+    if (insert == nullptr) {
+      i += take;
+    }
+  }
+  key[out] = '\0';
+
+  if (deferred) {
+    size_t length = strlen(command);
+    if (length + 1 > keySize) {
+      return -1;
+    }
+    memcpy(key, command, length + 1);
+    return 0;
+  }
+  return count;
+}
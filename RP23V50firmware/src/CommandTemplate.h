@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: MIT
+#ifndef COMMANDTEMPLATE_H
+#define COMMANDTEMPLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Cache keys for single Python commands
+//
+// The host sends the same few commands over and over with different numbers
+// in them, gpio_get(2), dac_set(0, 2.5), dac_set(0, 2.6) ... commandTemplate()
+// takes the plain decimal numbers out and puts a name in their place,
+// __jl0, __jl1 and so on, so all of those compile to one function and the
+// numbers are handed in as globals each time it runs.
+//
+// Numbers inside strings and in names (D13, GPIO_1) are left alone, and so are
+// the ones that aren't plain decimal ints or floats (0x10, 1j, 1_000, .5).
+// They just stay part of the key.
+//
+// The globals are only right while the command runs, so a command that
+// leaves code behind to run later (def, lambda, class, generator expressions,
+// so anything with for) keeps all its numbers and is its own key.
+//
+// Kept free of Arduino and MicroPython headers, scripts/command_template_test.py
+// builds it on the host.
+
+#define COMMAND_TEMPLATE_MAX_LITERALS 8
+#define COMMAND_TEMPLATE_KEY_MAX 128
+
+struct commandLiteral {
+  bool isFloat;
+  int32_t i;
+  double f;
+};
+
+/// writes the template into key and the numbers it took out into literals,
+/// returns how many, or -1 if the command won't fit in keySize. Past
+/// COMMAND_TEMPLATE_MAX_LITERALS the rest of the numbers stay in the key
+int commandTemplate(const char *command, char *key, size_t keySize, commandLiteral *literals);
+
+#endif
@@ -1,5 +1,6 @@
 #include "Commands.h"
 #include "CH446Q.h"
+#include "EventDispatch.h"
 #include "FileParsing.h"
 #include "Graphics.h"
 #include "JumperlessDefines.h"
@@ -161,6 +162,7 @@ void refreshConnections(int ledShowOption, int fillUnused, int clean) {
 
   Serial.println(millis() - start);
 #endif
+  eventPush(EVENT_NETS, netSlot, numberOfNets);
   
   
   // sendPaths();
@@ -239,6 +241,7 @@ unsigned long start2 = millis();
   Serial.print("refreshLocalConnections after waitCore2 time = ");
   Serial.println(millis() - start2);
 #endif
+  eventPush(EVENT_NETS, netSlot, numberOfNets);
 
   // Serial.print("Free heap = ");
   // Serial.println(rp2040.getFreeHeap());
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MIT
+#include "DeepCapture.h"
+
+deepCaptureRing deepRing;
+
+/// gets a ring if there isn't one already, PSRAM when the board has it
+bool deepCaptureAllocate(void) {
+  if (deepRing.buffer != nullptr) {
+    return true;
+  }
+
+#ifdef RP2350_PSRAM_CS
+  if (rp2040.getFreePSRAMHeap() >= DEEP_CAPTURE_PSRAM_BYTES) {
+    deepRing.buffer = (uint8_t *)pmalloc(DEEP_CAPTURE_PSRAM_BYTES);
+    if (deepRing.buffer != nullptr) {
+      deepRing.size = DEEP_CAPTURE_PSRAM_BYTES;
+      deepRing.inPsram = true;
+      return true;
+    }
+  }
+#endif
+
+  uint32_t size = DEEP_CAPTURE_SRAM_BYTES;
+  uint32_t freeHeap = rp2040.getFreeHeap();
+  if (freeHeap < size + DEEP_CAPTURE_SRAM_RESERVE) {
+    if (freeHeap < DEEP_CAPTURE_SRAM_RESERVE + 4096) {
+      return false;
+    }
+    size = (freeHeap - DEEP_CAPTURE_SRAM_RESERVE) & ~3u;
+  }
+  deepRing.buffer = (uint8_t *)malloc(size);
+  if (deepRing.buffer == nullptr) {
+    return false;
+  }
+  deepRing.size = size;
+  deepRing.inPsram = false;
+  return true;
+}
+
+/// the PSRAM ring is kept for next time, an SRAM one is given back
+void deepCaptureFree(void) {
+  deepCaptureStop();
+  if (deepRing.buffer != nullptr && deepRing.inPsram == false) {
+    free(deepRing.buffer);
+    deepRing.buffer = nullptr;
+    deepRing.size = 0;
+  }
+}
+
+/// samples the ring holds (one byte each), 0 if there's no ring
+uint32_t deepCaptureCapacity(void) { return deepRing.size; }
+
+bool deepCaptureStart(PIO pio, uint sm) {
+  if (deepRing.buffer == nullptr || deepRing.size < 4) {
+    return false;
+  }
+  if (deepRing.dataChannel < 0) {
+    deepRing.dataChannel = dma_claim_unused_channel(false);
+  }
+  if (deepRing.controlChannel < 0) {
+    deepRing.controlChannel = dma_claim_unused_channel(false);
+  }
+  if (deepRing.dataChannel < 0 || deepRing.controlChannel < 0) {
+    deepCaptureStop();
+    return false;
+  }
+
+  deepRing.restartAddress = (uint32_t)deepRing.buffer;
+  deepRing.wraps = 0;
+  deepRing.lastOffset = 0;
+
+  // words, so the PIO has to autopush 4 samples at a time
+  dma_channel_config data = dma_channel_get_default_config(deepRing.dataChannel);
+  channel_config_set_transfer_data_size(&data, DMA_SIZE_32);
+  channel_config_set_read_increment(&data, false);
+  channel_config_set_write_increment(&data, true);
+  channel_config_set_dreq(&data, pio_get_dreq(pio, sm, false));
+  channel_config_set_chain_to(&data, deepRing.controlChannel);
+  channel_config_set_high_priority(&data, true);
+  dma_channel_configure(deepRing.dataChannel, &data, deepRing.buffer,
+                        &pio->rxf[sm], deepRing.size / 4, false);
+
+  dma_channel_config control =
+      dma_channel_get_default_config(deepRing.controlChannel);
+  channel_config_set_transfer_data_size(&control, DMA_SIZE_32);
+  channel_config_set_read_increment(&control, false);
+  channel_config_set_write_increment(&control, false);
+  dma_channel_configure(deepRing.controlChannel, &control,
+                        &dma_hw->ch[deepRing.dataChannel].al2_write_addr_trig,
+                        &deepRing.restartAddress, 1, false);
+
+  dma_channel_start(deepRing.dataChannel);
+  return true;
+}
+
+/// total samples written since deepCaptureStart(), has to be called at least
+/// once per trip around the ring to notice the wraps
+uint64_t deepCaptureWritten(void) {
+  if (deepRing.dataChannel < 0) {
+    return (uint64_t)deepRing.wraps * deepRing.size + deepRing.lastOffset;
+  }
+  uint32_t offset =
+      dma_hw->ch[deepRing.dataChannel].write_addr - (uint32_t)deepRing.buffer;
+  if (offset >= deepRing.size) { // caught it mid-restart
+    offset = 0;
+  }
+  if (offset < deepRing.lastOffset) {
+    deepRing.wraps++;
+  }
+  deepRing.lastOffset = offset;
+  return (uint64_t)deepRing.wraps * deepRing.size + offset;
+}
+
+void deepCaptureStop(void) {
+  if (deepRing.dataChannel >= 0) {
+    deepCaptureWritten(); // last position, before the channel goes away
+    // chain to itself (no chaining) so the control channel can't restart it
+    hw_write_masked(&dma_hw->ch[deepRing.dataChannel].al1_ctrl,
+                    (uint32_t)deepRing.dataChannel << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB,
+                    DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS);
+    if (deepRing.controlChannel >= 0) {
+      dma_channel_abort(deepRing.controlChannel);
+    }
+    dma_channel_abort(deepRing.dataChannel);
+    dma_channel_unclaim(deepRing.dataChannel);
+    deepRing.dataChannel = -1;
+  }
+  if (deepRing.controlChannel >= 0) {
+    dma_channel_unclaim(deepRing.controlChannel);
+    deepRing.controlChannel = -1;
+  }
+}
+
+/// index counts from the start of the capture like deepCaptureWritten()
+void deepCaptureCopy(uint64_t index, uint8_t *out, uint32_t length) {
+  uint32_t offset = (uint32_t)(index % deepRing.size);
+  while (length > 0) {
+    uint32_t chunk = deepRing.size - offset;
+    if (chunk > length) {
+      chunk = length;
+    }
+    memcpy(out, deepRing.buffer + offset, chunk);
+    out += chunk;
+    length -= chunk;
+    offset = 0;
+  }
+}
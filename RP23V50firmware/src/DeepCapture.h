@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MIT
+#ifndef DEEPCAPTURE_H
+#define DEEPCAPTURE_H
+
+#include <Arduino.h>
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+
+// Ring buffer capture for the logic analyzer
+//
+// A PIO state machine's RX FIFO is DMA'd into a ring forever: the data channel
+// fills the ring once and chains to a control channel that writes the ring's
+// start back into the data channel's write address trigger. Nothing on the
+// CPU side runs per sample, so the only limits are the PIO clock and memory
+// bandwidth, and the host only has to take the window around the trigger.
+//
+// With the PSRAM mod (RP2350_PSRAM_CS defined for the board) the ring goes in
+// PSRAM, otherwise a smaller one comes out of the SRAM heap for the capture.
+
+#ifndef DEEP_CAPTURE_PSRAM_BYTES
+#define DEEP_CAPTURE_PSRAM_BYTES (4 * 1024 * 1024)
+#endif
+#define DEEP_CAPTURE_SRAM_BYTES (96 * 1024)
+#define DEEP_CAPTURE_SRAM_RESERVE (48 * 1024) // heap left for everything else
+
+struct deepCaptureRing {
+  uint8_t *buffer = nullptr;
+  uint32_t size = 0; // bytes, a multiple of 4
+  bool inPsram = false;
+
+  int dataChannel = -1;
+  int controlChannel = -1;
+  uint32_t restartAddress = 0; // what the control channel copies
+
+  uint32_t wraps = 0;
+  uint32_t lastOffset = 0;
+};
+
+extern deepCaptureRing deepRing;
+
+bool deepCaptureAllocate(void);
+void deepCaptureFree(void);
+uint32_t deepCaptureCapacity(void);
+
+bool deepCaptureStart(PIO pio, uint sm);
+uint64_t deepCaptureWritten(void);
+void deepCaptureStop(void);
+
+void deepCaptureCopy(uint64_t index, uint8_t *out, uint32_t length);
+
+#endif
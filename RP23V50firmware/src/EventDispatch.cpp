@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: MIT
+#include "EventDispatch.h"
+#include "Peripherals.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/timer.h"
+
+#define EVENT_RING_MASK (EVENT_RING_SIZE - 1)
+#define EVENT_EDGES (GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL)
+
+eventStatistics eventStats = {};
+
+struct eventCell {
+  uint32_t sequence; // == position when free, position + 1 when it holds an event
+  jlEvent event;
+};
+
+static eventCell ring[EVENT_RING_SIZE];
+static uint32_t head = 0; // next position to push
+static uint32_t tail = 0; // next position to pop
+static bool ringReady = false;
+
+static uint32_t wanted = 0;      // a bit per eventSource
+static uint32_t gpioWatched = 0; // a bit per GPIO_1-8
+
+static void initRing(void) {
+  for (uint32_t i = 0; i < EVENT_RING_SIZE; i++) {
+    ring[i].sequence = i;
+  }
+  head = 0;
+  tail = 0;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  ringReady = true;
+}
+
+bool eventWanted(int source) {
+  return (__atomic_load_n(&wanted, __ATOMIC_ACQUIRE) >> source) & 1;
+}
+
+void eventEnable(int source, bool on) {
+  if (source < 0 || source >= EVENT_SOURCES) {
+    return;
+  }
+  if (!ringReady) {
+    initRing();
+  }
+  if (on) {
+    __atomic_fetch_or(&wanted, 1u << source, __ATOMIC_RELEASE);
+  } else {
+    __atomic_fetch_and(&wanted, ~(1u << source), __ATOMIC_RELEASE);
+  }
+}
+
+bool __not_in_flash_func(eventPush)(int source, int index, int value) {
+  if (!eventWanted(source)) {
+    return false;
+  }
+  uint32_t pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+  eventCell *cell;
+  for (;;) {
+    cell = &ring[pos & EVENT_RING_MASK];
+    uint32_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+    int32_t diff = (int32_t)(sequence - pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&head, &pos, pos + 1, true, __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED)) {
+        break;
+      }
+      // pos was reloaded by the failed exchange
+    } else if (diff < 0) {
+      __atomic_fetch_add(&eventStats.dropped, 1, __ATOMIC_RELAXED);
+      return false;
+    } else {
+      pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    }
+  }
+
+  cell->event.timeUs = time_us_32();
+  cell->event.value = (int16_t)value;
+  cell->event.source = (uint8_t)source;
+  cell->event.index = (uint8_t)index;
+  __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+  __atomic_fetch_add(&eventStats.pushed, 1, __ATOMIC_RELAXED);
+  uint32_t queued = pos + 1 - __atomic_load_n(&tail, __ATOMIC_RELAXED);
+  if (queued > eventStats.maxQueued) {
+    eventStats.maxQueued = queued;
+  }
+  return true;
+}
+
+bool eventPop(jlEvent *out) {
+  if (!ringReady) {
+    return false;
+  }
+  uint32_t pos = tail;
+  eventCell *cell = &ring[pos & EVENT_RING_MASK];
+  uint32_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+  if (sequence != pos + 1) {
+    return false; // empty, or a producer hasn't finished writing it
+  }
+  *out = cell->event;
+  __atomic_store_n(&cell->sequence, pos + EVENT_RING_SIZE, __ATOMIC_RELEASE);
+  __atomic_store_n(&tail, pos + 1, __ATOMIC_RELAXED);
+  eventStats.dispatched++;
+  return true;
+}
+
+int eventPending(void) {
+  if (!ringReady) {
+    return 0;
+  }
+  return (int)(__atomic_load_n(&head, __ATOMIC_RELAXED) - tail);
+}
+
+// one handler for all of GPIO_1-8, it runs for whichever of them has an edge
+static void __not_in_flash_func(onGpioEdge)(void) {
+  for (int i = 0; i < EVENT_GPIO_PINS; i++) {
+    if (!(gpioWatched & (1u << i))) {
+      continue;
+    }
+    uint gpio = gpioDef[i][0];
+    uint32_t edges = gpio_get_irq_event_mask(gpio) & EVENT_EDGES;
+    if (!edges) {
+      continue;
+    }
+    gpio_acknowledge_irq(gpio, edges);
+    if (edges == EVENT_EDGES) {
+      // both since the last interrupt, the pin's level says which came last
+      bool high = gpio_get(gpio);
+      eventPush(EVENT_GPIO, i + 1, high ? 0 : 1);
+      eventPush(EVENT_GPIO, i + 1, high ? 1 : 0);
+    } else {
+      eventPush(EVENT_GPIO, i + 1, (edges & GPIO_IRQ_EDGE_RISE) ? 1 : 0);
+    }
+  }
+}
+
+// GPIO_1-8 are all below 32, so the 32-bit masked calls cover them
+static uint32_t gpioEventMask(void) {
+  uint32_t mask = 0;
+  for (int i = 0; i < EVENT_GPIO_PINS; i++) {
+    mask |= 1u << gpioDef[i][0];
+  }
+  return mask;
+}
+
+bool eventGpioWatch(int pin, bool on) {
+  if (pin < 1 || pin > EVENT_GPIO_PINS) {
+    return false;
+  }
+  uint32_t bit = 1u << (pin - 1);
+  uint gpio = gpioDef[pin - 1][0];
+  if (on && !(gpioWatched & bit)) {
+    if (!gpioWatched) {
+      // the handler goes in once for all eight, after that it's only enables
+      gpio_add_raw_irq_handler_masked(gpioEventMask(), onGpioEdge);
+    }
+    gpioWatched |= bit;
+    gpio_acknowledge_irq(gpio, EVENT_EDGES);
+    gpio_set_irq_enabled(gpio, EVENT_EDGES, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+  } else if (!on && (gpioWatched & bit)) {
+    gpio_set_irq_enabled(gpio, EVENT_EDGES, false);
+    gpioWatched &= ~bit;
+    if (!gpioWatched) {
+      gpio_remove_raw_irq_handler_masked(gpioEventMask(), onGpioEdge);
+    }
+  }
+  return true;
+}
+
+void eventClear(void) {
+  for (int pin = 1; pin <= EVENT_GPIO_PINS; pin++) {
+    eventGpioWatch(pin, false);
+  }
+  __atomic_store_n(&wanted, 0, __ATOMIC_RELEASE);
+  jlEvent dropped;
+  while (eventPop(&dropped)) {
+  }
+}
+
+void printEventStats(Stream *stream) {
+  static const char *names[] = {"probe_button", "encoder", "encoder_button", "nets", "gpio"};
+  stream->printf("events: %lu pushed, %lu dispatched, %lu dropped, %d queued (max %lu of %d)\n\r",
+                 eventStats.pushed, eventStats.dispatched, eventStats.dropped, eventPending(),
+                 eventStats.maxQueued, EVENT_RING_SIZE);
+  stream->printf("listening:");
+  bool any = false;
+  for (int s = 0; s < EVENT_SOURCES; s++) {
+    if (eventWanted(s)) {
+      stream->printf(" %s", names[s]);
+      any = true;
+    }
+  }
+  if (gpioWatched) {
+    stream->printf(" (GPIO");
+    for (int i = 0; i < EVENT_GPIO_PINS; i++) {
+      if (gpioWatched & (1u << i)) {
+        stream->printf(" %d", i + 1);
+      }
+    }
+    stream->printf(")");
+  }
+  stream->printf("%s\n\r", any ? "" : " nothing");
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MIT
+#ifndef EVENTDISPATCH_H
+#define EVENTDISPATCH_H
+
+#include <Arduino.h>
+
+// Events for MicroPython callbacks
+//
+// Scripts used to sit in a loop reading probe_button(), the encoder, the GPIO
+// pins and the nets to see if anything had changed, which kept core 0 busy
+// and missed anything shorter than one pass of the loop. Now the places that
+// notice a change push a small event into a ring, and modjumperless.c pops
+// them on core 0 and runs the handlers the script registered with on(), or
+// wakes the tasks waiting in event().
+//
+// checkProbeButton() and rotaryEncoderStuff() run on both cores and the GPIO
+// edges come from an interrupt, so the ring is a bounded multi-producer one
+// (Vyukov's, a sequence number per cell) with nothing but atomics in it. A
+// producer never waits: if the ring is full the event is dropped and counted.
+// Nothing is pushed for a source unless something is listening to it.
+//
+//   source               index           value
+//   EVENT_PROBE_BUTTON   0               checkProbeButton(), 1 remove 2 connect
+//   EVENT_ENCODER        0               +1 or -1 a step
+//   EVENT_ENCODER_BUTTON 0               encoderButtonStates
+//   EVENT_NETS           netSlot         numberOfNets after the refresh
+//   EVENT_GPIO           1-8             1 rising, 0 falling
+
+#define EVENT_RING_SIZE 64 // power of two
+#define EVENT_GPIO_PINS 8
+
+enum eventSource {
+  EVENT_PROBE_BUTTON = 0,
+  EVENT_ENCODER = 1,
+  EVENT_ENCODER_BUTTON = 2,
+  EVENT_NETS = 3,
+  EVENT_GPIO = 4,
+  EVENT_SOURCES = 5,
+};
+
+struct jlEvent {
+  uint32_t timeUs;
+  int16_t value;
+  uint8_t source;
+  uint8_t index;
+};
+
+struct eventStatistics {
+  uint32_t pushed;
+  uint32_t dropped;    // the ring was full
+  uint32_t dispatched; // popped by core 0
+  uint32_t maxQueued;
+};
+
+extern eventStatistics eventStats;
+
+/// start or stop pushing events for a source (core 0)
+void eventEnable(int source, bool on);
+/// cheap check for producers, so they don't build events nobody wants
+bool eventWanted(int source);
+
+/// edge interrupts on GPIO_1-8 (pin 1-8) for EVENT_GPIO, false if pin is bad
+bool eventGpioWatch(int pin, bool on);
+
+/// from any core or interrupt, false if the ring was full
+bool eventPush(int source, int index, int value);
+
+/// core 0 only
+bool eventPop(jlEvent *out);
+int eventPending(void);
+/// stops every source and GPIO interrupt and drops what's queued
+void eventClear(void);
+
+void printEventStats(Stream *stream);
+
+#endif
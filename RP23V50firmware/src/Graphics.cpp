@@ -1,5 +1,6 @@
 #include "Graphics.h"
 #include "Adafruit_NeoPixel.h"
+#include "Animations.h"
 #include "Commands.h"
 #include "Highlighting.h"
 #include "JumperlessDefines.h"
@@ -230,7 +231,7 @@ const uint8_t lowercaseArrow[8][3] = {
 // char symbolMap[40] = {
 // '!', '$', '%', '^', '*', '_', '-', '+', '÷', 'x', '=', '±', '?', '<', '>', '~', '\'', ',', '.', '/', '\\', '(', ')', '[', ']', '{', '}', '|', ';', ':', 'µ', '°', '❬', '❭', '"', '\'', '𝟷', '𝟸', '𝟹'};
 
-const wchar_t fontMap[120] = {
+constexpr wchar_t fontMap[120] = {
 '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
@@ -239,7 +240,7 @@ const wchar_t fontMap[120] = {
 
 
 
-const uint8_t font[][3] = // 'JumperlessFontmap', 500x5px
+constexpr uint8_t font[][3] = // 'JumperlessFontmap', 500x5px
   { {
   0x1f, 0x11, 0x1f, },{ 0x12, 0x1f, 0x10, },{ 0x1d, 0x15, 0x17, },{ 0x11, 0x15, 0x1f, },{
   0x07, 0x04, 0x1f, },{ 0x17, 0x15, 0x1d, },{ 0x1f, 0x15, 0x1d, },{ 0x19, 0x05, 0x03, },{
@@ -279,6 +280,49 @@ const uint8_t font[][3] = // 'JumperlessFontmap', 500x5px
 
   };
 
+// Glyph atlas
+//
+// Latin-1 straight to the column bitmasks in font[], built by the compiler from
+// fontMap[] so printChar() doesn't have to search it for every character. That
+// covers ASCII and the four fontMap[] has above it: the degree, micro, plus-minus
+// and division signs, which arrive as single bytes. The second set is for
+// lowercaseNumber, where digits come from the small numerals at the end of the font.
+struct fontGlyph {
+  uint8_t columns[3];
+  uint8_t present;
+};
+
+struct fontAtlas {
+  fontGlyph glyphs[2][256];
+};
+
+static constexpr fontAtlas buildFontAtlas() {
+  fontAtlas atlas = {};
+  for (int set = 0; set < 2; set++) {
+    for (int c = 0; c < 256; c++) {
+      int start = (set == 1 && c >= '0' && c <= '9') ? 90 : 0;
+      // fontMap[] is zero padded past the end of font[]
+      for (int i = start; i < (int)(sizeof(font) / sizeof(font[0])); i++) {
+        if (fontMap[i] == (wchar_t)c) {
+          atlas.glyphs[set][c] = {{font[i][0], font[i][1], font[i][2]}, 1};
+          break;
+        }
+      }
+    }
+  }
+  return atlas;
+}
+
+static constexpr fontAtlas glyphAtlas = buildFontAtlas();
+
+static_assert(glyphAtlas.glyphs[0]['A'].present == 1, "glyph atlas is empty");
+static_assert(glyphAtlas.glyphs[0][0xB0].present == 1, "degree sign missing from the glyph atlas");
+
+static inline const fontGlyph *lookupGlyph(char c, int lowercaseNumber) {
+  const fontGlyph *glyph = &glyphAtlas.glyphs[lowercaseNumber > 0][(uint8_t)c];
+  return glyph->present ? glyph : nullptr;
+}
+
 
 //0=top rail, 1= gnd, 2 = bottom rail, 3 = gnd again, 4 = adc 1, 5 = adc 2, 6 = adc 3, 7 = adc 4, 8 = adc 5, 9 = adc 6, 10 = dac 0, 11 = dac 1, 12 = routable buffer in, 13 = routable buffer out, 14 = i sense +, 15 = isense -, 16 = gpio Tx, 17 = gpio Rx, 
 uint32_t specialColors[13][5] = {
@@ -1099,6 +1143,15 @@ void initRowAnimations() {
   }
 
   numberOfRowAnimations = currentIndex;
+
+  //! hand the frames to the keyframe engine, it keeps the timing from here on
+  for (int i = 0; i <= numberOfRowAnimations && i < ANIMATION_ROW_SLOTS; i++) {
+    rowAnimations[i].animationId = animationCreate(
+        rowAnimations[i].frames, rowAnimations[i].numberOfFrames,
+        rowAnimations[i].numberOfFrames * rowAnimations[i].frameInterval,
+        ANIM_LOOP, 0, i);
+    animationStart(rowAnimations[i].animationId, rowAnimations[i].currentFrame);
+  }
 }
 
 // 0-2 = top rail, gnd, bottom rail // type 1
@@ -1190,6 +1243,22 @@ void assignRowAnimations(void) {
       rowAnimations[33].net = warningNet;
     }
   }
+
+  // only advance the animations that are actually on screen
+  for (int i = 0; i <= numberOfRowAnimations && i < ANIMATION_ROW_SLOTS; i++) {
+    bool used = false;
+    for (int net = 0; net < numberOfNets; net++) {
+      if (assignedAnimations[net] == i) {
+        used = true;
+        break;
+      }
+    }
+    if (used == true && animationIsActive(rowAnimations[i].animationId) == false) {
+      animationStart(rowAnimations[i].animationId);
+    } else if (used == false) {
+      animationStop(rowAnimations[i].animationId);
+    }
+  }
   // Serial.println(" ");
   //   for (int i = 0; i < numberOfNets; i++) {
 
@@ -1251,13 +1320,23 @@ void showRowAnimation(int index, int net) {
   uint32_t frameColors[5];
   uint32_t brightenedNodeColors[5];
 
+  int animationId = rowAnimations[index].animationId;
+  rowAnimations[index].currentFrame = animationFrame(animationId);
+
   if (rowAnimations[index].net == warningNet) {
     // Serial.print("warningNet: ");
     // Serial.println(warningNet);
     rowAnimations[index].row = warningRow;
     uint32_t color;
 
-    for (int i = 0; i < rowAnimations[index].numberOfFrames; i++) {
+    // the frames only depend on the net color and brightness, so only rebuild
+    // the table when one of those changes
+    uint32_t sourceColor = packRgb(netColors[warningNet]) |
+                           ((uint32_t)jumperlessConfig.display.led_brightness << 24);
+
+    for (int i = 0; i < rowAnimations[index].numberOfFrames &&
+                    sourceColor != keyframeAnimations[animationId].sourceColor;
+         i++) {
 
       hsvColor colorHSV = RgbToHsv(netColors[warningNet]);
       colorHSV.h =
@@ -1272,11 +1351,14 @@ void showRowAnimation(int index, int net) {
 
       rowAnimations[index].frames[i] = color;
     }
+    if (sourceColor != keyframeAnimations[animationId].sourceColor) {
+      animationSetKeyframes(animationId, rowAnimations[index].frames,
+                            rowAnimations[index].numberOfFrames);
+      keyframeAnimations[animationId].sourceColor = sourceColor;
+    }
 
     for (int i = 0; i < 5; i++) {
-      frameColors[i] =
-          rowAnimations[index].frames[(rowAnimations[index].currentFrame + i) %
-                                      rowAnimations[index].numberOfFrames];
+      frameColors[i] = animationSample(animationId, i);
     }
 
     // handle the row animation for a single row, rather than the whole net
@@ -1285,9 +1367,7 @@ void showRowAnimation(int index, int net) {
       // Serial.println(rowAnimations[index].row);
       for (int i = 0; i < 5; i++) {
 
-        uint32_t color = rowAnimations[index]
-                             .frames[(rowAnimations[index].currentFrame + i) %
-                                     rowAnimations[index].numberOfFrames];
+        uint32_t color = animationSample(animationId, i);
         hsvColor colorHSV = RgbToHsv(unpackRgb(color));
         // colorHSV.h = (colorHSV.h + i*10) % 255;
         if (i == 2) {
@@ -1318,7 +1398,12 @@ void showRowAnimation(int index, int net) {
     rowAnimations[index].row = brightenedNode - 1;
     uint32_t color;
 
-    for (int i = 0; i < rowAnimations[index].numberOfFrames; i++) {
+    uint32_t sourceColor = packRgb(netColors[brightenedNet]) |
+                           ((uint32_t)jumperlessConfig.display.led_brightness << 24);
+
+    for (int i = 0; i < rowAnimations[index].numberOfFrames &&
+                    sourceColor != keyframeAnimations[animationId].sourceColor;
+         i++) {
       hsvColor colorHSV;
 
       // Serial.print("netColors[brightenedNet]: ");
@@ -1338,11 +1423,14 @@ void showRowAnimation(int index, int net) {
 
       rowAnimations[index].frames[i] = color;
     }
+    if (sourceColor != keyframeAnimations[animationId].sourceColor) {
+      animationSetKeyframes(animationId, rowAnimations[index].frames,
+                            rowAnimations[index].numberOfFrames);
+      keyframeAnimations[animationId].sourceColor = sourceColor;
+    }
 
     for (int i = 0; i < 5; i++) {
-      frameColors[i] =
-          rowAnimations[index].frames[(rowAnimations[index].currentFrame + i) %
-                                      rowAnimations[index].numberOfFrames];
+      frameColors[i] = animationSample(animationId, i);
     }
 
     // handle the row animation for a single row, rather than the whole net
@@ -1351,9 +1439,7 @@ void showRowAnimation(int index, int net) {
       // Serial.println(rowAnimations[index].row);
       for (int i = 0; i < 5; i++) {
 
-        uint32_t color = rowAnimations[index]
-                             .frames[(rowAnimations[index].currentFrame + i) %
-                                     rowAnimations[index].numberOfFrames];
+        uint32_t color = animationSample(animationId, i);
         hsvColor colorHSV = RgbToHsv(unpackRgb(color));
         // colorHSV.h = (colorHSV.h + i*10) % 255;
         // if (rowAnimations[index].net > 3) {
@@ -1380,9 +1466,7 @@ void showRowAnimation(int index, int net) {
 
   } else {
     for (int i = 0; i < 5; i++) {
-      frameColors[i] =
-          rowAnimations[index].frames[(rowAnimations[index].currentFrame + i) %
-                                      rowAnimations[index].numberOfFrames];
+      frameColors[i] = animationSample(animationId, i);
     }
   }
 
@@ -1415,15 +1499,7 @@ void showRowAnimation(int index, int net) {
     }
   }
 
-  if (millis() - rowAnimations[index].lastFrameTime >
-      rowAnimations[index].frameInterval) {
-    rowAnimations[index].currentFrame++;
-    if (rowAnimations[index].currentFrame >
-        rowAnimations[index].numberOfFrames) {
-      rowAnimations[index].currentFrame = 0;
-    }
-    rowAnimations[index].lastFrameTime = millis();
-  }
+  // frame timing is handled by animationScheduler() on core 2
 
   brightenedNodeColors[4] = brightenedNodeColors[0];
   brightenedNodeColors[3] = brightenedNodeColors[1];
@@ -1999,20 +2075,8 @@ void printChar(const char c, uint32_t color, uint32_t bg, int position,
   if (color == 0xFFFFFF) {
     color = defaultColor;
   }
-  int fontMapIndex = -1;
-  int start = 0;
-
-  if (lowercaseNumber > 0 && c >= 48 && c <= 57) {
-    start = 90;
-  }
-
-  for (int i = start; i < 120; i++) {
-    if (c == fontMap[i]) {
-      fontMapIndex = i;
-      break;
-    }
-  }
-  if (fontMapIndex == -1) {
+  const fontGlyph *glyph = lookupGlyph(c, lowercaseNumber);
+  if (glyph == nullptr) {
     return;
   }
   uint8_t columnMask[5] = // 'JumperlessFontmap', 500x5px
@@ -2021,7 +2085,7 @@ void printChar(const char c, uint32_t color, uint32_t bg, int position,
   if (bg == 0xFFFFFF) {
     for (int i = 0; i < 3; i++) {
       for (int j = 0; j < 5; j++) {
-        if (((font[fontMapIndex][i]) & columnMask[j]) != 0) {
+        if (((glyph->columns[i]) & columnMask[j]) != 0) {
           leds.setPixelColor(((charPosition + i + nudge) * 5) + j, color);
         } else {
           leds.setPixelColor(((charPosition + i + nudge) * 5) + j, 0);
@@ -2036,7 +2100,7 @@ void printChar(const char c, uint32_t color, uint32_t bg, int position,
 
     for (int i = 0; i < 3; i++) {
       for (int j = 0; j < 5; j++) {
-        if (((font[fontMapIndex][i]) & columnMask[j]) != 0) {
+        if (((glyph->columns[i]) & columnMask[j]) != 0) {
           leds.setPixelColor(((charPosition + i + nudge) * 5) + j, color);
         } else {
           leds.setPixelColor(((charPosition + i + nudge) * 5) + j, 0);
@@ -2050,7 +2114,7 @@ void printChar(const char c, uint32_t color, uint32_t bg, int position,
   } else if (bg == 0xFFFFFE) {
     for (int i = 0; i < 3; i++) {
       for (int j = 0; j < 5; j++) {
-        if (((font[fontMapIndex][i]) & columnMask[j]) != 0) {
+        if (((glyph->columns[i]) & columnMask[j]) != 0) {
           leds.setPixelColor(((charPosition + i + nudge) * 5) + j, color);
         } else {
           // leds.setPixelColor((i*5)+j, bg);
@@ -2067,7 +2131,7 @@ void printChar(const char c, uint32_t color, uint32_t bg, int position,
     for (int i = 0; i < 4; i++) {
       if (i < 3) {
         for (int j = 0; j < 5; j++) {
-          if (((font[fontMapIndex][i]) & columnMask[j]) != 0) {
+          if (((glyph->columns[i]) & columnMask[j]) != 0) {
             leds.setPixelColor(((charPosition + i + nudge) * 5) + j, color);
           } else {
             leds.setPixelColor(((charPosition + i + nudge) * 5) + j, bg);
@@ -2113,6 +2177,86 @@ void printString(const char *s, uint32_t color, uint32_t bg, int position,
   // Serial.println();
 }
 
+// Text layout cache
+//
+// Scrolling text gets laid out once into a strip of 5-bit columns (3 per
+// glyph plus a blank one, the same pitch printChar() uses) and drawing a
+// frame is just copying 60 columns out of it, so it costs the same no matter
+// how long the string is. Text that stays put (bread::print() and the rest of
+// printString()) doesn't need it, printChar() is one atlas lookup a glyph.
+static textStrip textStripCache[TEXT_STRIP_CACHE_SIZE];
+static uint32_t textStripUseCount = 0;
+
+const textStrip *layoutText(const char *s, int lowercaseNumber) {
+  textStripUseCount++;
+
+  textStrip *oldest = &textStripCache[0];
+  for (int i = 0; i < TEXT_STRIP_CACHE_SIZE; i++) {
+    textStrip *strip = &textStripCache[i];
+    if (strip->lastUsed != 0 && strip->lowercaseNumber == lowercaseNumber &&
+        strncmp(strip->text, s, TEXT_STRIP_MAX_CHARS) == 0) {
+      strip->lastUsed = textStripUseCount;
+      return strip;
+    }
+    if (strip->lastUsed < oldest->lastUsed) {
+      oldest = strip;
+    }
+  }
+
+  textStrip *strip = oldest;
+  strncpy(strip->text, s, TEXT_STRIP_MAX_CHARS);
+  strip->text[TEXT_STRIP_MAX_CHARS] = '\0';
+  strip->lowercaseNumber = lowercaseNumber;
+  strip->lastUsed = textStripUseCount;
+  strip->length = 0;
+
+  for (int i = 0; strip->text[i] != '\0'; i++) {
+    const fontGlyph *glyph = lookupGlyph(strip->text[i], lowercaseNumber);
+    for (int col = 0; col < 3; col++) {
+      strip->columns[strip->length++] = glyph ? glyph->columns[col] : 0;
+    }
+    strip->columns[strip->length++] = 0;
+  }
+  return strip;
+}
+
+/// scrollColumn wraps around the strip, topBottom -1 uses all 60 rows
+void drawTextStrip(const textStrip *strip, int scrollColumn, uint32_t color,
+                   uint32_t bg, int topBottom) {
+  int firstRow = (topBottom == 1) ? 30 : 0;
+  int lastRow = (topBottom == 0) ? 30 : 60;
+
+  color = scaleBrightness(color, menuBrightnessSetting);
+  if (color == 0xFFFFFF) {
+    color = defaultColor;
+  }
+  if (bg == 0xFFFFFF) {
+    bg = 0;
+  }
+
+  if (strip == nullptr || strip->length == 0) {
+    return;
+  }
+  int column = scrollColumn % strip->length;
+  if (column < 0) {
+    column += strip->length;
+  }
+
+  for (int row = firstRow; row < lastRow; row++) {
+    uint8_t bits = strip->columns[column];
+    for (int j = 0; j < 5; j++) {
+      if (bits & (1 << j)) {
+        leds.setPixelColor((row * 5) + j, color);
+      } else if (bg != 0xFFFFFE) {
+        leds.setPixelColor((row * 5) + j, bg);
+      }
+    }
+    if (++column >= strip->length) {
+      column = 0;
+    }
+  }
+}
+
 void bread::clear(int topBottom) {
   if (topBottom == -1) {
     for (int i = 0; i < 60; i++) {
@@ -2138,33 +2282,21 @@ void bread::clear(int topBottom) {
 
 void scrollFont() {
   // pauseCore2 = 1;
-  //  scroll font
-  //  uint8_t font[] = // 'JumperlessFontmap', 500x5px
-  //  {0x1f, 0x11, 0x1f, 0x00, 0x12, 0x1f, 0x10, 0x00, 0x1d, 0x15, 0x17, 0x00,
-  //  0x11, 0x15, 0x1f, 0x00,};
+  //  scroll through every glyph in the font
   uint32_t color = 0x060205;
   int scrollSpeed = 120;
   int scrollPosition = 0;
 
-  uint8_t columnMask[5] = // 'JumperlessFontmap', 500x5px
-      {0b00000001, 0b00000010, 0b00000100, 0b00001000, 0b00010000};
-  while (Serial.available() == 0) {
+  const textStrip *strip =
+      layoutText("0123456789 ABCDEFGHIJKLMNOPQRSTUVWXYZ "
+                 "abcdefghijklmnopqrstuvwxyz !$%^*_-+=?<>~,./\\()[]{}|;:\"'   ");
 
-    for (int i = 0; i < 60; i++) {
-      for (int j = 0; j < 5; j++) {
-        if ((font[(i + scrollPosition) % 500][0] & columnMask[j]) != 0) {
-          // Serial.print("1");
-          leds.setPixelColor((i * 5) + j, color);
-        } else {
-          // Serial.print("0");
-          leds.setPixelColor((i * 5) + j, 0x00, 0x00, 0x00);
-        }
-      }
-    }
+  while (Serial.available() == 0) {
+    drawTextStrip(strip, scrollPosition, color, 0x000000);
     leds.show();
     delay(scrollSpeed);
     scrollPosition++;
-    if (scrollPosition > 499) {
+    if (scrollPosition >= strip->length) {
       scrollPosition = 0;
     }
   }
@@ -2491,6 +2623,340 @@ unsigned long serial2ConnectTime = 0;
 int serial1ClearSent = 0;
 int serial2ClearSent = 0;
 
+// Delta renderer for dumpLEDs()
+//
+// The picture is still laid out as lines of text with SGR color escapes, but
+// those lines get parsed into a grid of cells and compared against a shadow of
+// what the terminal is already showing. Only cells that changed are sent, and
+// color escapes only go out when the color differs from the last cell written.
+#define TERM_ROWS 30
+#define TERM_COLS 80
+
+#define TERM_HAS_FG 0x01
+#define TERM_HAS_BG 0x02
+#define TERM_INVALID 0x80
+
+struct termCell {
+  uint32_t glyph; // one UTF-8 codepoint, bytes packed low to high
+  uint8_t fg;
+  uint8_t bg;
+  uint8_t attr;
+};
+
+static termCell termFrame[TERM_ROWS][TERM_COLS];
+static termCell termShadow[TERM_ROWS][TERM_COLS];
+static uint8_t termFrameLength[TERM_ROWS];
+static uint8_t termShadowLength[TERM_ROWS];
+static Stream *termShadowStream = nullptr;
+static bool termNeedsClear = true;
+
+static char termOut[1024];
+static int termOutLength = 0;
+
+ledDumpStatistics ledDumpStats = {0, 0, 0, 0, 0, 0, 0};
+
+// colorToVT100() goes through HSV and a palette search, so remember the
+// answer for each pixel until its color changes
+#define DUMP_COLOR_CACHE_SIZE (LED_COUNT + LED_COUNT_TOP)
+static uint32_t dumpColorCacheKey[DUMP_COLOR_CACHE_SIZE];
+static uint8_t dumpColorCacheTerm[DUMP_COLOR_CACHE_SIZE];
+
+static int pixelTermColor(int pixel, uint32_t color) {
+  color &= 0xffffff;
+  if (color == 0x000000) {
+    return 0;
+  }
+  if (pixel < 0 || pixel >= DUMP_COLOR_CACHE_SIZE) {
+    return colorToVT100(color, 256);
+  }
+  uint32_t key = color | 0x01000000; // so a zeroed entry never matches
+  if (dumpColorCacheKey[pixel] != key) {
+    dumpColorCacheKey[pixel] = key;
+    dumpColorCacheTerm[pixel] = colorToVT100(color, 256);
+  }
+  return dumpColorCacheTerm[pixel];
+}
+
+/// forget what the terminal is showing, the next dump redraws everything
+void invalidateLEDDump(void) {
+  for (int row = 0; row < TERM_ROWS; row++) {
+    for (int col = 0; col < TERM_COLS; col++) {
+      termShadow[row][col].attr = TERM_INVALID;
+    }
+    termShadowLength[row] = 0;
+  }
+  termNeedsClear = true;
+}
+
+// the terminal was just cleared, so every cell is a known blank
+static void blankTermShadow(void) {
+  for (int row = 0; row < TERM_ROWS; row++) {
+    for (int col = 0; col < TERM_COLS; col++) {
+      termShadow[row][col] = {' ', 0, 0, 0};
+    }
+    termShadowLength[row] = 0;
+  }
+  termNeedsClear = false;
+}
+
+// parses one line with SGR escapes into a row of cells
+static void termLoadLine(int row, const char *text) {
+  termCell *cells = termFrame[row];
+  uint8_t fg = 0;
+  uint8_t bg = 0;
+  uint8_t attr = 0;
+  int col = 0;
+  const uint8_t *p = (const uint8_t *)text;
+
+  while (*p != 0 && col < TERM_COLS) {
+    if (p[0] == '\033' && p[1] == '[') {
+      p += 2;
+      int params[8];
+      int numParams = 0;
+      int value = 0;
+      while ((*p >= '0' && *p <= '9') || *p == ';') {
+        if (*p == ';') {
+          if (numParams < 8) {
+            params[numParams++] = value;
+          }
+          value = 0;
+        } else {
+          value = value * 10 + (*p - '0');
+        }
+        p++;
+      }
+      if (numParams < 8) {
+        params[numParams++] = value;
+      }
+      if (*p != 'm') { // cursor moves and the like don't belong in the grid
+        if (*p != 0) {
+          p++;
+        }
+        continue;
+      }
+      p++;
+
+      for (int i = 0; i < numParams; i++) {
+        if (params[i] == 0) {
+          fg = 0;
+          bg = 0;
+          attr = 0;
+        } else if (params[i] == 38 && i + 2 < numParams && params[i + 1] == 5) {
+          fg = params[i + 2];
+          attr |= TERM_HAS_FG;
+          i += 2;
+        } else if (params[i] == 48 && i + 2 < numParams && params[i + 1] == 5) {
+          bg = params[i + 2];
+          attr |= TERM_HAS_BG;
+          i += 2;
+        }
+      }
+      continue;
+    }
+
+    if (*p == '\r' || *p == '\n') {
+      p++;
+      continue;
+    }
+
+    int length = 1;
+    if ((*p & 0xe0) == 0xc0) {
+      length = 2;
+    } else if ((*p & 0xf0) == 0xe0) {
+      length = 3;
+    } else if ((*p & 0xf8) == 0xf0) {
+      length = 4;
+    }
+
+    uint32_t glyph = 0;
+    for (int i = 0; i < length && p[i] != 0; i++) {
+      glyph |= (uint32_t)p[i] << (8 * i);
+    }
+    for (int i = 0; i < length && *p != 0; i++) {
+      p++;
+    }
+
+    cells[col++] = {glyph, (uint8_t)(attr & TERM_HAS_FG ? fg : 0),
+                    (uint8_t)(attr & TERM_HAS_BG ? bg : 0), attr};
+  }
+
+  termFrameLength[row] = col;
+  for (; col < TERM_COLS; col++) {
+    cells[col] = {' ', 0, 0, 0};
+  }
+}
+
+static inline bool termCellsMatch(const termCell &a, const termCell &b) {
+  return a.glyph == b.glyph && a.attr == b.attr && a.fg == b.fg &&
+         a.bg == b.bg;
+}
+
+static bool termOutFlush(Stream *stream, unsigned long deadline) {
+  int sent = 0;
+  while (sent < termOutLength) {
+    int room = stream->availableForWrite();
+    if (room <= 0) {
+      if ((long)(millis() - deadline) > 0) {
+        termOutLength = 0;
+        return false;
+      }
+      delayMicroseconds(10);
+      continue;
+    }
+    if (room > termOutLength - sent) {
+      room = termOutLength - sent;
+    }
+    sent += stream->write((const uint8_t *)termOut + sent, room);
+  }
+  ledDumpStats.lastBytes += termOutLength;
+  termOutLength = 0;
+  return true;
+}
+
+static bool termOutAppend(Stream *stream, const char *data, int length,
+                          unsigned long deadline) {
+  if (termOutLength + length > (int)sizeof(termOut)) {
+    if (!termOutFlush(stream, deadline)) {
+      return false;
+    }
+  }
+  memcpy(termOut + termOutLength, data, length);
+  termOutLength += length;
+  return true;
+}
+
+// SGR state of the terminal as of the last byte we queued
+static uint8_t termFg = 0;
+static uint8_t termBg = 0;
+static uint8_t termAttr = TERM_INVALID;
+
+static bool termWriteCell(Stream *stream, const termCell &cell,
+                          unsigned long deadline) {
+  char sgr[32];
+  int length = 0;
+
+  bool changed = cell.attr != termAttr || cell.fg != termFg ||
+                 cell.bg != termBg;
+  if (changed) {
+    // dropping a color needs a reset, adding or changing one doesn't
+    if ((termAttr & TERM_INVALID) || (termAttr & ~cell.attr)) {
+      length += snprintf(sgr + length, sizeof(sgr) - length, "\033[0m");
+      termAttr = 0;
+    }
+    bool setFg = (cell.attr & TERM_HAS_FG) &&
+                 (!(termAttr & TERM_HAS_FG) || termFg != cell.fg);
+    bool setBg = (cell.attr & TERM_HAS_BG) &&
+                 (!(termAttr & TERM_HAS_BG) || termBg != cell.bg);
+    if (setFg && setBg) {
+      length += snprintf(sgr + length, sizeof(sgr) - length,
+                         "\033[38;5;%d;48;5;%dm", cell.fg, cell.bg);
+    } else if (setFg) {
+      length += snprintf(sgr + length, sizeof(sgr) - length, "\033[38;5;%dm",
+                         cell.fg);
+    } else if (setBg) {
+      length += snprintf(sgr + length, sizeof(sgr) - length, "\033[48;5;%dm",
+                         cell.bg);
+    }
+    termFg = cell.fg;
+    termBg = cell.bg;
+    termAttr = cell.attr;
+  }
+
+  for (int i = 0; i < 4 && (cell.glyph >> (8 * i)) != 0; i++) {
+    sgr[length++] = (cell.glyph >> (8 * i)) & 0xff;
+  }
+  return termOutAppend(stream, sgr, length, deadline);
+}
+
+// sends whatever differs between termFrame and termShadow, relative mode is
+// for the main serial where the picture sits above the cursor instead of at
+// a fixed place on screen
+static bool termSendChanges(Stream *stream, int rows, bool relative,
+                            int xOffset, unsigned long deadline) {
+  char move[24];
+  int cursorRow = 0;
+  int cursorCol = -1; // unknown until the first move
+  uint32_t cellsSent = 0;
+
+  for (int row = 0; row < rows; row++) {
+    int width = max(termFrameLength[row], termShadowLength[row]);
+
+    for (int col = 0; col < width; col++) {
+      if (termCellsMatch(termFrame[row][col], termShadow[row][col])) {
+        continue;
+      }
+
+      if (cursorRow == row && col > cursorCol && cursorCol >= 0 &&
+          col - cursorCol <= 3) {
+        // a short run of unchanged cells is cheaper to resend than to skip
+        for (int gap = cursorCol; gap < col; gap++) {
+          if (!termWriteCell(stream, termFrame[row][gap], deadline)) {
+            return false;
+          }
+          termShadow[row][gap] = termFrame[row][gap];
+        }
+      } else if (cursorRow != row || cursorCol != col) {
+        int length;
+        if (relative == false) {
+          length = snprintf(move, sizeof(move), "\033[%d;%dH", row + 1,
+                            col + 1);
+        } else if (row > cursorRow) {
+          length = snprintf(move, sizeof(move), "\033[%dB\033[%dG",
+                            row - cursorRow, xOffset + col + 1);
+        } else if (row < cursorRow) {
+          length = snprintf(move, sizeof(move), "\033[%dA\033[%dG",
+                            cursorRow - row, xOffset + col + 1);
+        } else {
+          length = snprintf(move, sizeof(move), "\033[%dG", xOffset + col + 1);
+        }
+        if (!termOutAppend(stream, move, length, deadline)) {
+          return false;
+        }
+      }
+
+      if (!termWriteCell(stream, termFrame[row][col], deadline)) {
+        return false;
+      }
+      termShadow[row][col] = termFrame[row][col];
+      cursorRow = row;
+      cursorCol = col + 1;
+      cellsSent++;
+    }
+    termShadowLength[row] = termFrameLength[row];
+  }
+
+  if (relative == true) {
+    // back down to the line we started from
+    int length = snprintf(move, sizeof(move), "\033[0m\033[%dB\033[0G",
+                          TERM_ROWS - cursorRow);
+    if (!termOutAppend(stream, move, length, deadline)) {
+      return false;
+    }
+  } else if (cellsSent > 0) {
+    if (!termOutAppend(stream, "\033[0m", 4, deadline)) {
+      return false;
+    }
+  }
+  termAttr = TERM_INVALID;
+
+  ledDumpStats.lastCells = cellsSent;
+  return termOutFlush(stream, deadline);
+}
+
+void printLEDDumpStats(Stream *stream) {
+  stream->printf("LED dump: %lu frames (%lu full redraws, %lu timed out)\n\r",
+                 ledDumpStats.frames, ledDumpStats.fullFrames,
+                 ledDumpStats.timeouts);
+  stream->printf("last frame: %lu bytes, %lu cells  max: %lu bytes\n\r",
+                 ledDumpStats.lastBytes, ledDumpStats.lastCells,
+                 ledDumpStats.maxBytes);
+  if (ledDumpStats.frames > 0) {
+    stream->printf("average: %lu bytes/frame\n\r",
+                   (unsigned long)(ledDumpStats.totalBytes /
+                                   ledDumpStats.frames));
+  }
+}
+
 // #define CSI "\033[
 
 void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
@@ -2523,6 +2989,7 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
     if (!currentlyConnected) {
       serial2Connected = false;
       serial2ClearSent = 0;
+      invalidateLEDDump();
       dumpingToSerial = false;
       return;
     }
@@ -2543,6 +3010,7 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
         return;
       }
       serial2ClearSent++;
+      blankTermShadow();
     }
   } else if (jumperlessConfig.serial_1.function == 5 ||
              jumperlessConfig.serial_1.function == 6) {
@@ -2553,6 +3021,7 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
     if (!currentlyConnected) {
       serial1Connected = false;
       serial1ClearSent = 0;
+      invalidateLEDDump();
       dumpingToSerial = false;
       return;
     }
@@ -2573,6 +3042,7 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
         return;
       }
       serial1ClearSent++;
+      blankTermShadow();
     }
   } else {
     // dumpHeaderMain();
@@ -2596,18 +3066,20 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
   static char screenLines[MAX_LINES][LINE_WIDTH];
   int currentLine = 0;
 
-  // Clear all lines
-  for (int i = 0; i < MAX_LINES; i++) {
-    memset(screenLines[i], 0, LINE_WIDTH);
-  }
-
-  int logoColor0 = colorToVT100(leds.getPixelColor(LOGO_LED_START), 256);
-  int logoColor1 = colorToVT100(leds.getPixelColor(LOGO_LED_START + 1), 256);
-  int logoColor2 = colorToVT100(leds.getPixelColor(LOGO_LED_START + 2), 256);
-  int logoColor3 = colorToVT100(leds.getPixelColor(LOGO_LED_START + 3), 256);
-  int logoColor4 = colorToVT100(leds.getPixelColor(LOGO_LED_START + 4), 256);
-  int logoColor5 = colorToVT100(leds.getPixelColor(LOGO_LED_START + 5), 256);
-  int logoColor6 = colorToVT100(leds.getPixelColor(LOGO_LED_START + 6), 256);
+  int logoColor0 = pixelTermColor(LOGO_LED_START,
+                                  leds.getPixelColor(LOGO_LED_START));
+  int logoColor1 = pixelTermColor(LOGO_LED_START + 1,
+                                  leds.getPixelColor(LOGO_LED_START + 1));
+  int logoColor2 = pixelTermColor(LOGO_LED_START + 2,
+                                  leds.getPixelColor(LOGO_LED_START + 2));
+  int logoColor3 = pixelTermColor(LOGO_LED_START + 3,
+                                  leds.getPixelColor(LOGO_LED_START + 3));
+  int logoColor4 = pixelTermColor(LOGO_LED_START + 4,
+                                  leds.getPixelColor(LOGO_LED_START + 4));
+  int logoColor5 = pixelTermColor(LOGO_LED_START + 5,
+                                  leds.getPixelColor(LOGO_LED_START + 5));
+  int logoColor6 = pixelTermColor(LOGO_LED_START + 6,
+                                  leds.getPixelColor(LOGO_LED_START + 6));
 
   // Get logo colors with override handling for all LED pairs
   uint32_t adc0Color = leds.getPixelColor(ADC_LED_0) | 0x00000f;
@@ -2653,25 +3125,12 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
   }
 
   // Convert to terminal colors
-  int adc0TermColor = colorToVT100(adc0Color, 256);
-  int adc1TermColor = colorToVT100(adc1Color, 256);
-  int dac0TermColor = colorToVT100(dac0Color, 256);
-  int dac1TermColor = colorToVT100(dac1Color, 256);
-  int gpio0TermColor = colorToVT100(gpio0Color, 256);
-  int gpio1TermColor = colorToVT100(gpio1Color, 256);
-
-  if (adc0Color == 0x000000)
-    adc0TermColor = 0;
-  if (adc1Color == 0x000000)
-    adc1TermColor = 0;
-  if (dac0Color == 0x000000)
-    dac0TermColor = 0;
-  if (dac1Color == 0x000000)
-    dac1TermColor = 0;
-  if (gpio0Color == 0x000000)
-    gpio0TermColor = 0;
-  if (gpio1Color == 0x000000)
-    gpio1TermColor = 0;
+  int adc0TermColor = pixelTermColor(ADC_LED_0, adc0Color);
+  int adc1TermColor = pixelTermColor(ADC_LED_1, adc1Color);
+  int dac0TermColor = pixelTermColor(DAC_LED_0, dac0Color);
+  int dac1TermColor = pixelTermColor(DAC_LED_1, dac1Color);
+  int gpio0TermColor = pixelTermColor(GPIO_LED_0, gpio0Color);
+  int gpio1TermColor = pixelTermColor(GPIO_LED_1, gpio1Color);
 
   // Header section with integrated logo
   snprintf(screenLines[currentLine++], LINE_WIDTH,
@@ -2698,12 +3157,9 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
 
   for (int i = 0; i < 15; i++) {
     int headerIndex = headerMapPrintOrder[i];
-    uint32_t color = leds.getPixelColor(headerMap[headerIndex].pixel);
-    int termColor = colorToVT100(color, 256);
-
-    if (color == 0x000000) {
-      termColor = 0;
-    }
+    int termColor = pixelTermColor(
+        headerMap[headerIndex].pixel,
+        leds.getPixelColor(headerMap[headerIndex].pixel));
 
     pos += snprintf(dacHeaderLine + pos, LINE_WIDTH - pos,
                     "\033[48;5;%dm%3s\033[0m", termColor,
@@ -2733,12 +3189,9 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
 
   for (int i = 15; i < 30; i++) {
     int headerIndex = headerMapPrintOrder[i];
-    uint32_t color = leds.getPixelColor(headerMap[headerIndex].pixel);
-    int termColor = colorToVT100(color, 256);
-
-    if (color == 0x000000) {
-      termColor = 0;
-    }
+    int termColor = pixelTermColor(
+        headerMap[headerIndex].pixel,
+        leds.getPixelColor(headerMap[headerIndex].pixel));
 
     pos += snprintf(gpioHeaderLine + pos, LINE_WIDTH - pos,
                     "\033[48;5;%dm%3s\033[0m", termColor,
@@ -2778,12 +3231,7 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
 
       int mapIndex = row * 30 + col;
       int ledIndex = screenMap[mapIndex];
-      uint32_t color = leds.getPixelColor(ledIndex);
-      int termColor = colorToVT100(color, 256);
-
-      if (color == 0x000000) {
-        termColor = 0;
-      }
+      int termColor = pixelTermColor(ledIndex, leds.getPixelColor(ledIndex));
 
       const char *pattern = rail ? "▐█" : "█▏";
       pos += snprintf(ledLine + pos, LINE_WIDTH - pos, "\033[38;5;%dm%s\033[0m",
@@ -2815,59 +3263,64 @@ void dumpLEDs(int posX, int posY, int pixelsOrRows, int header, int rgbOrRaw,
 
   logoLedAccess = false;
 
-      // Start with cursor reset
-    if (mainSerial == true) {
-      // restoreCursorPosition();
-      int clearAbove = 6;
-      stream->printf("\033[%dA", 30);
-      stream->printf("\033[%dA", clearAbove);
-      // stream->printf("\033[%dC", xOffset);
-      for (int i = 0; i < clearAbove; i++) {
-        stream->printf("\033[%dC\033[0K\033[1B\033[0G", xOffset);
-      }
-      stream->print("\033[0G");
-      // stream->printf("\033[%dC", xOffset);
+  for (int i = 0; i < currentLine && i < TERM_ROWS; i++) {
+    termLoadLine(i, screenLines[i]);
+  }
 
-    } else {
-      snprintf(screenLines[currentLine++], LINE_WIDTH, "\033[0;0H\033[0m");
-    }
+  if (stream != termShadowStream) {
+    invalidateLEDDump();
+    termShadowStream = stream;
+  }
 
+  unsigned long deadline = functionStartTime + FUNCTION_TIMEOUT_MS;
+  bool fullFrame = false;
+  bool sent = true;
+  ledDumpStats.lastBytes = 0;
 
-  // Send all lines
-  for (int i = 0; i < currentLine; i++) {
-    // Quick timeout check
-    if (millis() - functionStartTime > FUNCTION_TIMEOUT_MS) {
-      break;
+  if (mainSerial == true) {
+    // anything printed on the main serial scrolls the picture away, so there's
+    // no shadow to trust, but the escapes are still coalesced
+    invalidateLEDDump();
+    fullFrame = true;
+
+    int clearAbove = 6;
+    char move[32];
+    int length = snprintf(move, sizeof(move), "\033[%dA", 30 + clearAbove);
+    sent = termOutAppend(stream, move, length, deadline);
+    for (int i = 0; i < clearAbove && sent; i++) {
+      length = snprintf(move, sizeof(move), "\033[%dC\033[0K\033[1B\033[0G",
+                        xOffset);
+      sent = termOutAppend(stream, move, length, deadline);
     }
-
-    // Wait for buffer space if needed
-    int lineLen = strlen(screenLines[i]);
-    if (stream->availableForWrite() < lineLen + 3) { // +3 for \r\n\0
-      unsigned long waitStart = millis();
-      while (stream->availableForWrite() < lineLen + 3 &&
-             (millis() - waitStart) < 10) {
-        delayMicroseconds(10);
-      }
+    if (sent) {
+      sent = termSendChanges(stream, currentLine, true, xOffset, deadline);
     }
-
-
-    // Send line with proper line ending
-    if (mainSerial == true) {
-
-      stream->printf("\033[%dC", xOffset);
+  } else {
+    if (termNeedsClear == true) {
+      sent = termOutAppend(stream, "\033[2J\033[?25l", 10, deadline);
+      blankTermShadow();
+      fullFrame = true;
+    }
+    if (sent) {
+      sent = termSendChanges(stream, currentLine, false, 0, deadline);
     }
-
-    stream->print(screenLines[i]);
-    stream->print("\r\n");
   }
 
-  if (mainSerial == true) {
-    stream->printf("\033[%dB", 4);
+  if (sent == false) {
+    // some of the frame never made it out, redraw from scratch next time
+    termOutLength = 0;
+    invalidateLEDDump();
+    ledDumpStats.timeouts++;
   }
 
-
-
-
+  ledDumpStats.frames++;
+  if (fullFrame == true) {
+    ledDumpStats.fullFrames++;
+  }
+  ledDumpStats.totalBytes += ledDumpStats.lastBytes;
+  if (ledDumpStats.lastBytes > ledDumpStats.maxBytes) {
+    ledDumpStats.maxBytes = ledDumpStats.lastBytes;
+  }
 
   // Final flush
   safeFlush(stream, 10);
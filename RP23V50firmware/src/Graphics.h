@@ -90,6 +90,7 @@ struct specialRowAnimation {
   unsigned long lastFrameTime;
   unsigned long frameInterval = 100;
   int type;
+  int animationId = -1; // slot in keyframeAnimations[]
 };
 
 extern int defNudge;
@@ -140,6 +141,23 @@ void printString(const char *s, uint32_t color = 0xFFFFFF,
                  uint32_t bg = 0xFFFFFF, int position = 0, int topBottom = -1,
                  int nudge = 0, int lowercase = 0);
 
+#define TEXT_STRIP_MAX_CHARS 128
+#define TEXT_STRIP_CACHE_SIZE 4
+
+// a string laid out as breadboard row columns, see layoutText()
+struct textStrip {
+  char text[TEXT_STRIP_MAX_CHARS + 1];
+  int lowercaseNumber;
+  uint8_t columns[TEXT_STRIP_MAX_CHARS * 4];
+  int length;
+  uint32_t lastUsed;
+};
+
+const textStrip *layoutText(const char *s, int lowercaseNumber = 0);
+void drawTextStrip(const textStrip *strip, int scrollColumn,
+                   uint32_t color = 0xFFFFFF, uint32_t bg = 0xFFFFFF,
+                   int topBottom = -1);
+
 void drawWires(int net = -1);
 void printWireStatus(void);
 
@@ -174,6 +192,20 @@ void printAllRLEimageData(void);
 void dumpLEDs(int posX = 50, int posY = 27, int pixelsOrRows = 0,
               int header = 0, int rgbOrRaw = 0, int logo = 0,
               Stream *stream = &Serial);
+struct ledDumpStatistics {
+  uint32_t frames;
+  uint32_t fullFrames;
+  uint32_t timeouts;
+  uint32_t lastBytes;
+  uint32_t lastCells;
+  uint32_t maxBytes;
+  uint64_t totalBytes;
+};
+
+extern ledDumpStatistics ledDumpStats;
+
+void invalidateLEDDump(void);
+void printLEDDumpStats(Stream *stream = &Serial);
 void dumpHeader(int posX = 50, int posY = 20, int absolute = 1, int wide = 0,
                 Stream *stream = &Serial);
 void dumpHeaderHex(Stream *stream = &Serial);
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: MIT
+#include "InaSampler.h"
+#include "Peripherals.h"
+#include "Sequencer.h"
+#include "WaveGen.h"
+#include <Wire.h>
+
+inaSamplerStatistics inaSamplerStats[INA_SAMPLER_SENSORS] = {};
+
+// same chips as INA0 and INA1 in Peripherals.cpp
+static const uint8_t addresses[INA_SAMPLER_SENSORS] = {0x40, 0x41};
+static INA219 *const sensors[INA_SAMPLER_SENSORS] = {&INA0, &INA1};
+
+#define INA_REG_SHUNT 0x01
+#define INA_REG_BUS 0x02
+#define INA_REG_POWER 0x03 // reading it clears the conversion ready flag
+#define INA_REG_CURRENT 0x04
+
+#define INA_BUS_CNVR 0x0002
+#define INA_BUS_OVF 0x0001
+
+static volatile float latest[INA_SAMPLER_SENSORS][3];
+static float window[INA_SAMPLER_SENSORS][3][INA_SAMPLER_WINDOW];
+static volatile uint32_t sequence[INA_SAMPLER_SENSORS];
+static unsigned long sampleTime[INA_SAMPLER_SENSORS];
+
+static unsigned long lastPoll = 0;
+static int nextSensor = 0;
+static bool servicing = false;
+
+static bool readRegister(int sensor, uint8_t reg, uint16_t *value) {
+  Wire.beginTransmission(addresses[sensor]);
+  Wire.write(reg);
+  if (Wire.endTransmission() != 0 ||
+      Wire.requestFrom(addresses[sensor], (uint8_t)2) != 2) {
+    inaSamplerStats[sensor].busErrors++;
+    return false;
+  }
+  *value = Wire.read() << 8;
+  *value |= Wire.read();
+  return true;
+}
+
+// with the bus register already in hand, reads the rest and stores it
+static bool sample(int sensor, uint16_t bus) {
+  uint16_t current;
+  uint16_t power;
+  if (!readRegister(sensor, INA_REG_CURRENT, &current) ||
+      !readRegister(sensor, INA_REG_POWER, &power)) {
+    return false;
+  }
+
+  float lsb = sensors[sensor]->getCurrentLSB();
+  float values[3];
+  values[INA_CURRENT] = (int16_t)current * lsb * 1e3f;
+  // the library reports a math overflow as -100 V, keep doing that
+  values[INA_BUS_VOLTAGE] = (bus & INA_BUS_OVF) ? -100.0f : (bus >> 3) * 4e-3f;
+  values[INA_POWER] = power * 20 * lsb * 1e3f;
+
+  uint32_t seq = sequence[sensor] + 1;
+  for (int q = 0; q < 3; q++) {
+    window[sensor][q][seq & (INA_SAMPLER_WINDOW - 1)] = values[q];
+    latest[sensor][q] = values[q];
+  }
+  sampleTime[sensor] = millis();
+  sequence[sensor] = seq;
+  inaSamplerStats[sensor].samples++;
+  inaSamplerStats[sensor].lastSampleMs = sampleTime[sensor];
+  return true;
+}
+
+void inaSamplerService(void) {
+  if (servicing || get_core_num() != 0 || millis() - lastPoll < INA_SAMPLER_POLL_MS ||
+      waveGenOwnsWire() || sequencerOwnsWire()) {
+    return;
+  }
+  servicing = true;
+  lastPoll = millis();
+
+  int sensor = nextSensor;
+  nextSensor = (nextSensor + 1) % INA_SAMPLER_SENSORS;
+
+  uint16_t bus;
+  if (readRegister(sensor, INA_REG_BUS, &bus) && (bus & INA_BUS_CNVR)) {
+    sample(sensor, bus);
+  }
+  servicing = false;
+}
+
+static bool valid(int sensor, int quantity) {
+  return sensor >= 0 && sensor < INA_SAMPLER_SENSORS && quantity >= 0 &&
+         quantity <= INA_POWER;
+}
+
+float inaSamplerCached(int sensor, int quantity) {
+  if (!valid(sensor, quantity)) {
+    return 0.0f;
+  }
+  return latest[sensor][quantity];
+}
+
+float inaSamplerLatest(int sensor, int quantity) {
+  if (!valid(sensor, quantity)) {
+    return 0.0f;
+  }
+  if ((sequence[sensor] == 0 || inaSamplerAge(sensor) > INA_SAMPLER_STALE_MS) &&
+      get_core_num() == 0 && !servicing && !waveGenOwnsWire() &&
+      !sequencerOwnsWire()) {
+    // whatever the chip has now, ready flag or not
+    inaSamplerStats[sensor].staleReads++;
+    servicing = true;
+    uint16_t bus;
+    if (readRegister(sensor, INA_REG_BUS, &bus)) {
+      sample(sensor, bus);
+    }
+    servicing = false;
+  }
+  return latest[sensor][quantity];
+}
+
+bool inaSamplerWindow(int sensor, int quantity, inaWindow *out, int count) {
+  if (!valid(sensor, quantity)) {
+    return false;
+  }
+  uint32_t seq = sequence[sensor];
+  if (count > INA_SAMPLER_WINDOW) {
+    count = INA_SAMPLER_WINDOW;
+  }
+  if (count > (int)seq) {
+    count = seq;
+  }
+  if (count <= 0) {
+    return false;
+  }
+
+  const float *values = window[sensor][quantity];
+  float first = values[seq & (INA_SAMPLER_WINDOW - 1)];
+  out->min = first;
+  out->max = first;
+  float sum = 0.0f;
+  for (int i = 0; i < count; i++) {
+    float v = values[(seq - i) & (INA_SAMPLER_WINDOW - 1)];
+    out->min = v < out->min ? v : out->min;
+    out->max = v > out->max ? v : out->max;
+    sum += v;
+  }
+  out->average = sum / count;
+  out->count = count;
+  return true;
+}
+
+uint32_t inaSamplerSequence(int sensor) {
+  if (sensor < 0 || sensor >= INA_SAMPLER_SENSORS) {
+    return 0;
+  }
+  return sequence[sensor];
+}
+
+uint32_t inaSamplerAge(int sensor) {
+  if (sensor < 0 || sensor >= INA_SAMPLER_SENSORS || sequence[sensor] == 0) {
+    return UINT32_MAX;
+  }
+  return millis() - sampleTime[sensor];
+}
+
+bool inaSamplerWaitNext(int sensor, unsigned long timeoutMs) {
+  if (sensor < 0 || sensor >= INA_SAMPLER_SENSORS) {
+    return false;
+  }
+  uint32_t start = sequence[sensor];
+  unsigned long startTime = millis();
+  // poll only this one so the other sensor doesn't take every other turn
+  while (sequence[sensor] == start && millis() - startTime < timeoutMs) {
+    nextSensor = sensor;
+    inaSamplerService();
+    delayMicroseconds(100);
+  }
+  return sequence[sensor] != start;
+}
+
+void printInaSamplerStats(Stream *stream) {
+  static const char *names[] = {"current", "bus", "power"};
+  static const char *units[] = {"mA", "V", "mW"};
+  for (int s = 0; s < INA_SAMPLER_SENSORS; s++) {
+    stream->printf("INA%d: %lu samples, %lu bus errors, %lu stale reads, ", s,
+                   inaSamplerStats[s].samples, inaSamplerStats[s].busErrors,
+                   inaSamplerStats[s].staleReads);
+    if (sequence[s] == 0) {
+      stream->printf("nothing read yet\n\r");
+      continue;
+    }
+    stream->printf("last %lu ms ago\n\r", inaSamplerAge(s));
+    for (int q = 0; q < 3; q++) {
+      inaWindow w;
+      inaSamplerWindow(s, q, &w);
+      stream->printf("  %-7s %8.3f %s  (min %.3f  max %.3f  avg %.3f over %d)\n\r",
+                     names[q], latest[s][q], units[q], w.min, w.max, w.average,
+                     w.count);
+    }
+  }
+}
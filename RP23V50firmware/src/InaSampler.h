@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MIT
+#ifndef INASAMPLER_H
+#define INASAMPLER_H
+
+#include <Arduino.h>
+
+// Background INA219 polling
+//
+// Both INA219s free-run in continuous shunt+bus mode. inaSamplerService() is
+// called from the main loop (and from MicroPython's delay while a script has
+// core 0), and every INA_SAMPLER_POLL_MS it checks one sensor's conversion
+// ready flag. Only when there's a new conversion does it read current and
+// power, so a call costs one or three short register reads and never waits on
+// the chip. Readers get the cached values and a window of recent ones.
+//
+// Wire is shared with the DAC, so all of this stays on core 0. A reader on
+// core 0 that finds the cache stale (the main loop was stuck somewhere) reads
+// the registers itself, the way everything did before.
+
+#define INA_SAMPLER_SENSORS 2
+#define INA_SAMPLER_WINDOW 16   // readings kept per sensor, power of two
+#define INA_SAMPLER_POLL_MS 2   // a conversion takes ~17 ms with 16x averaging
+#define INA_SAMPLER_STALE_MS 50
+
+enum inaQuantity {
+  INA_CURRENT = 0,     // mA
+  INA_BUS_VOLTAGE = 1, // V
+  INA_POWER = 2,       // mW
+};
+
+struct inaWindow {
+  float min;
+  float max;
+  float average;
+  int count;
+};
+
+struct inaSamplerStatistics {
+  uint32_t samples;     // conversions read
+  uint32_t busErrors;   // register reads that NAKed or came back short
+  uint32_t staleReads;  // reads that had to go to the bus themselves
+  uint32_t lastSampleMs;
+};
+
+extern inaSamplerStatistics inaSamplerStats[INA_SAMPLER_SENSORS];
+
+/// main loop (core 0), cheap to call as often as you like
+void inaSamplerService(void);
+
+/// cached value, never touches the bus (safe from interrupts and core 1)
+float inaSamplerCached(int sensor, int quantity);
+/// cached value, refreshed from the chip first if it's gone stale
+float inaSamplerLatest(int sensor, int quantity);
+/// min/max/average over the last count readings (1 to INA_SAMPLER_WINDOW)
+bool inaSamplerWindow(int sensor, int quantity, inaWindow *out,
+                      int count = INA_SAMPLER_WINDOW);
+
+/// goes up by one with every conversion read
+uint32_t inaSamplerSequence(int sensor);
+/// ms since the last conversion was read
+uint32_t inaSamplerAge(int sensor);
+/// services until the sensor has a conversion newer than the call, false on
+/// timeout
+bool inaSamplerWaitNext(int sensor, unsigned long timeoutMs = 20);
+
+void printInaSamplerStats(Stream *stream);
+
+#endif
@@ -11,6 +11,11 @@ bool la_enabled = true;
 #include "Peripherals.h"
 
 #include "JulseView.h"
+#include "JulseViewEncode.h"
+#include "DeepCapture.h"
+#include "JulseViewTrigger.h"
+#include "ProtocolDecode.h"
+#include "AdcSampler.h"
 #include "class/cdc/cdc_device.h"
 #include "config.h"
 #include "hardware/pio_instructions.h"
@@ -203,6 +208,10 @@ uint8_t get_first_adc_channel( uint8_t adc_mask ) {
     return 0; // Fallback to channel 0 if no channels enabled
 }
 
+bool JulseViewUsbSink::write( const uint8_t* data, int len ) {
+    return owner->julseview_usb_out_chars( (const char*)data, len );
+}
+
 bool julseview::julseview_usb_out_chars( const char* buf, int length ) {
     // CRITICAL SAFETY: Add null pointer and bounds checking
     if ( !buf || length <= 0 || length > 4096 ) {
@@ -418,7 +427,7 @@ bool julseview::init( ) {
     // Claim a state machine if we don't already have one
     JULSEDEBUG_STA( "INIT: piosm before claiming: %d\n\r", piosm );
     if ( piosm < 0 ) {
-        piosm = pio_claim_unused_sm( lapio, true );
+        piosm = pio_claim_unused_sm( lapio, false );
         if ( piosm < 0 ) {
             JULSEDEBUG_ERR( "ERROR: Failed to claim PIO state machine on PIO1!\n\r" );
             return false;
@@ -461,10 +470,13 @@ void julseview::reset( ) {
     trigger_config.var_address = 0;
     trigger_config.var_value = 0;
     trigger_config.enabled = false;
+    trigger_config.pattern.stages = 0;
     trigger_armed = false;
     trigger_detected = false;
     pre_trigger_samples = 0;
     post_trigger_samples = 0;
+    deep_capture_enabled = false;
+    deep_pre_samples = 0;
 
     //  Reset ping-pong buffer state to ensure consistent behavior
     current_dma_half = 0; // Always start with buffer 0
@@ -815,6 +827,7 @@ void julseview::arm( ) {
             }
         }
         JULSEDEBUG_STA( "Initializing ADC...\n\r" );
+        adcSamplerStop( ); // end() starts it again
         adc_init( );
         JULSEDEBUG_ANA( "ADC initialized for %d analog channels\n\r", a_chan_cnt );
         JULSEDEBUG_STA( "Claiming analog DMA channels...\n\r" );
@@ -1037,6 +1050,21 @@ void julseview::arm( ) {
 void julseview::run( ) {
     JULSEDEBUG_STA( "=== JULSEVIEW RUN() START ===\n\r" );
 
+    if ( !sink_begin( ) ) {
+        JULSEDEBUG_ERR( "JulseView: can't open %s\n\r", file_sink.path( ) );
+        julseview_usb_out_chars( "!", 1 );
+        end( );
+        return;
+    }
+
+    if ( deep_capture_wanted( ) ) {
+        run_deep_capture( );
+        return;
+    }
+
+    // decoder event samples count from the first sample sigrok gets
+    protocolDecodeBegin( sample_rate );
+
     // DEBUG: Print PIO state machine status before running
     /// printPIOStateMachines();
     bool trigger_monitoring = trigger_config.enabled && !trigger_detected;
@@ -1075,7 +1103,25 @@ void julseview::run( ) {
     // Initialize current DMA half tracking
     current_dma_half = 0; // Start with half 0
 
-    pio_sm_set_enabled( lapio, piosm, true );
+    // Digital triggers run on their own SM when they compile, the capture SM
+    // is parked on the trigger IRQ (latched while it's still disabled) so DMA
+    // only sees samples from the match on
+    bool pio_trigger = false;
+    if ( trigger_config.enabled && !trigger_detected && d_chan_cnt > 0 ) {
+        pio_trigger = arm_pio_trigger( );
+        if ( pio_trigger ) {
+            pio_sm_exec( lapio, piosm, jv_pio_wait_irq( true, JV_TRIGGER_IRQ_CAPTURE ) );
+        }
+    }
+
+    // Analog and software triggers are waited on by the CPU before the DMA
+    // starts. The capture SM stays stopped until then, or its FIFO and ISR
+    // would fill with samples from before the trigger and stall there, and
+    // those would be the first ones the DMA picked up.
+    bool cpu_trigger = trigger_config.enabled && !trigger_detected && !pio_trigger;
+    if ( !cpu_trigger ) {
+        pio_sm_set_enabled( lapio, piosm, true );
+    }
 
     //adc_fifo_setup( false, false, 1, false, false );
 
@@ -1101,6 +1147,12 @@ void julseview::run( ) {
 
     // Start analog DMA after FCS/CS are programmed
 
+    if ( trigger_config.enabled && !trigger_detected && trigger_config.type == TRIGGER_ANALOG_LEVEL ) {
+        // has the ADC to itself until the crossing, before the capture DMA is listening
+        waitForAnalogTrigger( );
+        scnt = 0;
+    }
+
     if ( a_chan_cnt > 0 ) {
         dma_channel_start( admachan0 );
         delayMicroseconds( 1000 );
@@ -1109,7 +1161,7 @@ void julseview::run( ) {
     uint32_t loop_count = 0;
     uint32_t last_debug_time = millis( );
 
-    if ( trigger_config.enabled && !trigger_detected ) {
+    if ( trigger_config.enabled && !trigger_detected && !pio_trigger ) {
         JULSEDEBUG_CMD( "Waiting for trigger before starting capture...\n\r" );
         waitForTrigger( );
         // JULSEDEBUG_CMD("Trigger detected - starting capture  scnt=%d\n\r", scnt);
@@ -1130,6 +1182,14 @@ void julseview::run( ) {
         dma_channel_start( pdmachan0 );
         // JULSEDEBUG_CMD("Digital DMA STARTED: %s mode\n\r", trigger_config.enabled ? "Post-trigger" : "Normal");
     }
+    if ( cpu_trigger ) {
+        pio_sm_set_enabled( lapio, piosm, true );
+    }
+    if ( pio_trigger ) {
+        // DMA is armed, the PIO lets the first sample through on the match
+        waitForTrigger( );
+        scnt = 0;
+    }
     if ( a_chan_cnt > 0 ) {
 
         // FIFO control and status
@@ -1189,6 +1249,8 @@ void julseview::run( ) {
         // tud_task();
 
         dma_check( );
+        // hardware paced, a file sink writes out what's waiting meanwhile
+        sink->service( );
 
         if ( scnt % 32 == 0 && scnt > 100 ) {
             uint8_t c = 0;
@@ -1240,6 +1302,264 @@ void julseview::run( ) {
     JULSEDEBUG_STA( "=== JULSEVIEW RUN() COMPLETE ===\n\r" );
 }
 
+// ============================================================================
+// DEEP CAPTURE
+// ============================================================================
+
+#define DEEP_TRIGGER_SEARCH 64 // FIFO and DMA lag between a sample and the ring
+#define DEEP_TRIGGER_CHUNK 256  // ring samples the software trigger takes at a time
+#define DEEP_RING_SLACK 512    // never let the window get this close to the ring size
+
+// A triggered capture with pre-trigger samples asked for, or any capture after
+// 'M1', as long as it's 8 GPIO channels and nothing else
+bool julseview::deep_capture_wanted( ) {
+    jv_trigger_spec spec;
+    bool triggered = trigger_config.enabled && digital_trigger_spec( &spec );
+    if ( !deep_capture_enabled && !( triggered && deep_pre_samples > 0 ) ) {
+        return false;
+    }
+    if ( a_chan_cnt != 0 || c_mask != 0 || d_chan_cnt == 0 || d_tx_bps != 2 ) {
+        return false;
+    }
+    if ( trigger_config.enabled && !triggered ) {
+        return false; // analog and internal triggers stay on the normal path
+    }
+    return deepCaptureAllocate( ) && deepCaptureCapacity( ) > DEEP_RING_SLACK * 2;
+}
+
+void julseview::run_deep_capture( ) {
+    JULSEDEBUG_STA( "=== JULSEVIEW DEEP CAPTURE START (%u byte ring in %s) ===\n\r",
+                    (unsigned)deepCaptureCapacity( ), deepRing.inPsram ? "PSRAM" : "SRAM" );
+
+    sending = true;
+    started = true;
+    isRunning = true;
+    isArmed = false;
+    heartbeat_enabled = 1;
+    completion_signal_sent = false;
+    scnt = 0;
+
+    uint32_t window = num_samples;
+    if ( window > deepCaptureCapacity( ) - DEEP_RING_SLACK ) {
+        window = deepCaptureCapacity( ) - DEEP_RING_SLACK;
+    }
+    jv_trigger_spec spec;
+    bool edge_trigger = trigger_config.enabled && digital_trigger_spec( &spec );
+    uint32_t pre = edge_trigger ? deep_pre_samples : 0;
+    if ( pre > window ) {
+        pre = window;
+    }
+    uint32_t post = window - pre;
+    num_samples = window;
+
+    // 4 samples per FIFO word, shifted right so the first one lands in the low byte
+    pio_sm_set_enabled( lapio, piosm, false );
+    pio_sm_clear_fifos( lapio, piosm );
+    hw_write_masked( &lapio->sm[ piosm ].shiftctrl,
+                     PIO_SM0_SHIFTCTRL_IN_SHIFTDIR_BITS | PIO_SM0_SHIFTCTRL_AUTOPUSH_BITS,
+                     PIO_SM0_SHIFTCTRL_IN_SHIFTDIR_BITS | PIO_SM0_SHIFTCTRL_AUTOPUSH_BITS |
+                         PIO_SM0_SHIFTCTRL_PUSH_THRESH_BITS );
+    pio_sm_restart( lapio, piosm );
+
+    watchdog_enable( 4000, true );
+
+    bool stopped = !deepCaptureStart( lapio, piosm );
+    if ( stopped ) {
+        JULSEDEBUG_ERR( "Deep capture: no DMA channels for the ring\n\r" );
+    } else {
+        pio_sm_set_enabled( lapio, piosm, true );
+    }
+
+    // Wait for enough history, then watch for the trigger while the ring keeps
+    // filling, then for the post-trigger samples. The trigger SM only reports
+    // here, the capture SM never waits on it. Without the trigger SM the
+    // trigger runs over the ring's data as it lands, so it sees every sample.
+    bool pio_trigger = edge_trigger && arm_pio_trigger( );
+    bool armed = false;
+    jv_trigger_state state;
+    jv_trigger_reset( &state );
+    bool triggered = false;
+    bool exact = false;       // trigger_at is the trigger's own sample
+    uint64_t trigger_at = 0;
+    uint64_t seen_at = 0;     // written when the trigger was noticed
+    uint64_t quiet_at = 0;    // written at the last poll the trigger SM hadn't fired by
+    uint64_t scanned = pre;   // next sample for the software trigger
+    uint64_t lapped = 0;      // samples it fell too far behind to look at
+    uint32_t polls = 0;
+    uint8_t chunk[ DEEP_TRIGGER_CHUNK ];
+
+    while ( !stopped && julseview_active ) {
+        uint64_t written = deepCaptureWritten( );
+
+        if ( !triggered && written >= pre + DEEP_TRIGGER_SEARCH ) {
+            if ( !edge_trigger ) {
+                triggered = true;
+                exact = true;
+                trigger_at = written;
+            } else if ( pio_trigger ) {
+                if ( !armed ) {
+                    pio_sm_set_enabled( lapio, trigger_sm, true );
+                    armed = true;
+                    quiet_at = written;
+                } else if ( lapio->irq & ( 1u << JV_TRIGGER_IRQ_CPU ) ) {
+                    triggered = true;
+                    trigger_at = written;
+                } else {
+                    quiet_at = written;
+                }
+            } else {
+                if ( written - scanned > deepCaptureCapacity( ) - DEEP_RING_SLACK ) {
+                    // the ring has come round over samples that weren't looked at
+                    uint64_t resume = written - DEEP_TRIGGER_CHUNK;
+                    lapped += resume - scanned;
+                    scanned = resume;
+                    jv_trigger_reset( &state );
+                }
+                uint32_t n = ( written - scanned > DEEP_TRIGGER_CHUNK ) ? DEEP_TRIGGER_CHUNK
+                                                                        : (uint32_t)( written - scanned );
+                deepCaptureCopy( scanned, chunk, n );
+                for ( uint32_t i = 0; i < n; i++ ) {
+                    if ( jv_trigger_feed( &spec, &state, chunk[ i ] ) ) {
+                        triggered = true;
+                        exact = true;
+                        trigger_at = scanned + i;
+                        break;
+                    }
+                }
+                scanned += n;
+            }
+            if ( triggered ) {
+                seen_at = written;
+                trigger_detected = true;
+                isTriggered = true;
+            }
+        } else if ( triggered && written >= ( exact ? trigger_at + post : seen_at + post + DEEP_TRIGGER_SEARCH ) ) {
+            // a software trigger that was behind the ring already has its
+            // sample, waiting from where it was noticed would lose the window
+            break;
+        }
+
+        if ( ( ++polls & 0xFFF ) == 0 ) {
+            watchdog_update( );
+            uint8_t c = 0;
+            if ( tud_cdc_n_peek( 2, &c ) == 1 && c == '+' ) {
+                JULSEDEBUG_ERR( "Deep capture stopped with signal\n\r" );
+                stopped = true;
+            }
+        }
+    }
+
+    uint64_t written_end = deepCaptureWritten( );
+    pio_sm_set_enabled( lapio, piosm, false );
+    deepCaptureStop( );
+    release_pio_trigger( );
+
+    if ( triggered && !stopped ) {
+        if ( !exact ) {
+            // The trigger SM fired somewhere between the last quiet poll and
+            // this one, plus what was still in the FIFO. Find the last stage
+            // in that stretch of the data.
+            const jv_trigger_stage* last = &spec.stage[ spec.stages - 1 ];
+            bool level_only = !( last->rising | last->falling );
+            jv_trigger_spec last_only = { 1, { *last } };
+            uint64_t from = quiet_at - DEEP_TRIGGER_SEARCH;
+            uint64_t oldest = written_end - ( deepCaptureCapacity( ) - DEEP_RING_SLACK );
+            if ( written_end > deepCaptureCapacity( ) - DEEP_RING_SLACK && from < oldest ) {
+                from = oldest;
+            }
+            uint64_t to = seen_at + DEEP_TRIGGER_SEARCH;
+            jv_trigger_reset( &state );
+            bool found = false;
+            for ( uint64_t at = from; at < to && !found; ) {
+                uint32_t n = ( to - at > DEEP_TRIGGER_CHUNK ) ? DEEP_TRIGGER_CHUNK : (uint32_t)( to - at );
+                deepCaptureCopy( at, chunk, n );
+                for ( uint32_t i = 0; i < n; i++ ) {
+                    if ( jv_trigger_feed( &last_only, &state, chunk[ i ] ) ) {
+                        // a level that already held where the search starts
+                        // could have started earlier, that one's a guess
+                        found = true;
+                        if ( !( level_only && at + i == from ) ) {
+                            trigger_at = at + i;
+                            exact = true;
+                        }
+                        break;
+                    }
+                }
+                at += n;
+            }
+        }
+        if ( !exact ) {
+            deep_unrefined_triggers++;
+            JULSEDEBUG_ERR( "Deep capture: trigger not found in the data, window placed where it was seen (%u so far)\n\r",
+                            (unsigned)deep_unrefined_triggers );
+        }
+        if ( lapped ) {
+            JULSEDEBUG_ERR( "Deep capture: trigger fell behind and skipped %llu samples\n\r", lapped );
+        }
+
+        uint64_t first = trigger_at - pre;
+        uint64_t room = deepCaptureCapacity( ) - DEEP_RING_SLACK;
+        if ( written_end - first > room ) {
+            // the start of the window has been written over, send what's left
+            uint32_t lost = (uint32_t)( written_end - room - first );
+            JULSEDEBUG_ERR( "Deep capture: %u samples before the trigger were overwritten, sending %u before instead of %u\n\r",
+                            (unsigned)lost, lost < pre ? (unsigned)( pre - lost ) : 0u, (unsigned)pre );
+            if ( lost > window ) {
+                lost = window;
+            }
+            first += lost;
+            window -= lost;
+            pre = lost < pre ? pre - lost : 0;
+            post = window - pre;
+            num_samples = window;
+        }
+        JULSEDEBUG_CMD( "Deep capture: trigger at sample %llu, sending %u before and %u after\n\r",
+                        trigger_at, pre, post );
+
+        const uint32_t tx_threshold = JULSEVIEW_TX_BUF_SIZE * 2 / 3;
+        uint8_t block[ JULSEVIEW_BLOCK_SAMPLES ];
+        txbufidx = 0;
+        protocolDecodeBegin( sample_rate );
+        bool decode = protocolDecodeActive( );
+
+        while ( scnt < window && julseview_active ) {
+            uint32_t n = window - scnt;
+            if ( n > JULSEVIEW_BLOCK_SAMPLES ) {
+                n = JULSEVIEW_BLOCK_SAMPLES;
+            }
+            deepCaptureCopy( first + scnt, block, n );
+            if ( decode ) {
+                protocolDecodeFeed( block, n );
+            }
+            if ( txbufidx + n * 2 >= tx_threshold ) {
+                check_tx_buf( 1 );
+            }
+            txbufidx += jv_encode_block( block, nullptr, n, 0, &txbuf[ txbufidx ] );
+            scnt += n;
+            check_tx_buf( JULSEVIEW_TX_BUF_THRESH );
+
+            if ( ( scnt & 0x3FFF ) == 0 ) {
+                watchdog_update( );
+                uint8_t c = 0;
+                if ( tud_cdc_n_peek( 2, &c ) == 1 && c == '+' ) {
+                    break;
+                }
+            }
+        }
+        if ( txbufidx > 0 ) {
+            check_tx_buf( 1 );
+        }
+    }
+
+    heartbeat_enabled = 0;
+    send_capture_completion_signal( false );
+    delayMicroseconds( 15000 );
+    end( );
+    deepCaptureFree( );
+    watchdog_disable( );
+    JULSEDEBUG_STA( "=== JULSEVIEW DEEP CAPTURE COMPLETE (%u samples) ===\n\r", scnt );
+}
+
 // Remove timer-based control channel update mechanism (replaced by DMA paced by PIO DREQ)
 
 void julseview::dma_check( ) {
@@ -1353,6 +1673,8 @@ void julseview::end( ) {
     }
     dma_ended_flag = true;
 
+    release_pio_trigger( );
+
     // === STEP 1: STOP ALL DMA OPERATIONS ===
     JULSEDEBUG_DMA( "END: Breaking ping-pong chaining and stopping DMA channels\n\r" );
 
@@ -1501,6 +1823,7 @@ void julseview::end( ) {
         JULSEDEBUG_DIG( "END: Control channel resources cleaned up\n\r" );
     }
 
+    adcSamplerStop( );
     adc_fifo_setup( false, false, 0, false, false );
     adc_fifo_drain( );
 
@@ -1529,6 +1852,7 @@ void julseview::end( ) {
         int raw_reading = adc_read( );
         //JULSEDEBUG_ANA( "DEINIT: ADC pin %d restored - voltage: %f, raw: %d\n\r", 40 + i, voltage, raw_reading );
     }
+    adcSamplerStart( );
 
     // === STEP 5: RESET STATE FLAGS ===
     sending = false;
@@ -1666,6 +1990,12 @@ bool julseview::process_char( char charin ) {
                 JULSEDEBUG_CMD( "JulseView ID command received - initializing\n\r" );
                 julseview::init( );
             }
+            if ( piosm < 0 ) {
+                // pio1 had no SM left, there's nothing to capture with
+                strcpy( rspstr, "!" );
+                needs_response = true;
+                break;
+            }
             sprintf( rspstr, "SRJLV5,A%02d2D%02d,02", JULSEVIEW_DEFAULT_ANALOG_CHANNELS, JULSEVIEW_DEFAULT_DIGITAL_CHANNELS );
             JULSEDEBUG_CMD( "JulseView ID response: %s\n\r", rspstr );
             needs_response = true;
@@ -1722,6 +2052,11 @@ bool julseview::process_char( char charin ) {
             break;
         case 'F':
             cont = false;
+            if ( piosm < 0 ) {
+                strcpy( rspstr, "!" );
+                needs_response = true;
+                break;
+            }
 
             arm( );
             run( ); // Start capture immediately after arming
@@ -1766,6 +2101,11 @@ bool julseview::process_char( char charin ) {
                     JULSEDEBUG_CMD( "JulseView ID command received - initializing\n\r" );
                     julseview::init( );
                 }
+                if ( piosm < 0 ) {
+                    strcpy( rspstr, "!" );
+                    needs_response = true;
+                    break;
+                }
                 //cont = true;
                 arm( );
 
@@ -1980,6 +2320,34 @@ bool julseview::process_char( char charin ) {
                 JULSEDEBUG_ERR( "Trigger command too short: %d chars\n\r", cmdstrptr );
             }
             break;
+        case 'g':
+            // Digital pattern trigger stages: 'g' clears them, then one
+            // g<op><mask><value><rising><falling> per stage, op 'A'nd or 'O'r,
+            // the rest 2 hex digits each (channel 0 = bit 0)
+            if ( cmdstrptr == 1 ) {
+                trigger_config.pattern.stages = 0;
+                if ( trigger_config.type == TRIGGER_DIGITAL_PATTERN ) {
+                    trigger_config.enabled = false;
+                }
+                needs_response = true;
+            } else if ( cmdstrptr >= 10 && trigger_config.pattern.stages < JV_TRIGGER_MAX_STAGES ) {
+                uint8_t field[ 4 ];
+                for ( int i = 0; i < 4; i++ ) {
+                    char hex[ 3 ] = { cmdstr[ 2 + i * 2 ], cmdstr[ 3 + i * 2 ], 0 };
+                    field[ i ] = strtoul( hex, NULL, 16 );
+                }
+                uint8_t op = ( cmdstr[ 1 ] == 'O' ) ? JV_TRIGGER_OR : JV_TRIGGER_AND;
+                trigger_config.pattern.stage[ trigger_config.pattern.stages++ ] =
+                    jv_trigger_make_stage( op, field[ 0 ], field[ 1 ], field[ 2 ], field[ 3 ] );
+                trigger_config.type = TRIGGER_DIGITAL_PATTERN;
+                trigger_config.enabled = true;
+                JULSEDEBUG_CMD( "Pattern trigger stage %d: op=%d mask=0x%02X value=0x%02X rise=0x%02X fall=0x%02X\n\r",
+                                trigger_config.pattern.stages, op, field[ 0 ], field[ 1 ], field[ 2 ], field[ 3 ] );
+                needs_response = true;
+            } else {
+                JULSEDEBUG_ERR( "Pattern trigger command invalid or too many stages: %s\n\r", cmdstr );
+            }
+            break;
         case 'd':
             // Disable trigger command
             trigger_config.enabled = false;
@@ -1992,6 +2360,7 @@ bool julseview::process_char( char charin ) {
             // Pre-trigger samples command: p<pre> - force to 0 for now
             if ( cmdstrptr >= 2 ) {
                 int requested_pre = atoi( &cmdstr[ 1 ] );
+                deep_pre_samples = ( requested_pre > 0 ) ? requested_pre : 0; // only deep capture can honor it
                 pre_trigger_samples = 0; // Force pre-trigger to 0
                 // Set post-trigger samples to a reasonable default if not specified
                 if ( post_trigger_samples == 0 ) {
@@ -2001,6 +2370,33 @@ bool julseview::process_char( char charin ) {
                 needs_response = true;
             }
             break;
+        case 'M':
+            // Deep capture: 'M' -> "*<ring size in samples>", 'M1' on, 'M0' off
+            if ( cmdstrptr == 1 ) {
+                deepCaptureAllocate( );
+                sprintf( rspstr, "*%u", (unsigned)deepCaptureCapacity( ) );
+            } else {
+                deep_capture_enabled = ( cmdstr[ 1 ] == '1' );
+            }
+            JULSEDEBUG_CMD( "JulseView M command: deep capture %s, ring %u (%s), %u unrefined triggers\n\r",
+                            deep_capture_enabled ? "on" : "off", (unsigned)deepCaptureCapacity( ),
+                            deepRing.inPsram ? "PSRAM" : "SRAM", (unsigned)deep_unrefined_triggers );
+            needs_response = true;
+            break;
+        case 'W':
+            // 'W' -> where captures go; 'W<file>' -> to that file; 'W-' -> back to USB
+            if ( cmdstrptr == 1 ) {
+                snprintf( rspstr, sizeof( rspstr ), "W%s", to_file ? file_sink.path( ) : "-" );
+            } else if ( strcmp( cmdstr, "W-" ) == 0 ) {
+                to_file = false;
+            } else if ( file_sink.setPath( &cmdstr[ 1 ] ) ) {
+                to_file = true;
+            } else {
+                strcpy( rspstr, "!" );
+            }
+            JULSEDEBUG_CMD( "JulseView W command -> %s\n\r", to_file ? file_sink.path( ) : "USB" );
+            needs_response = true;
+            break;
         case 'E':
             // Control channel enable command: E<n> where n is number of control channels (0-16)
             tmpint = atoi( &cmdstr[ 1 ] );
@@ -2084,18 +2480,45 @@ void julseview::check_rle( ) {
     }
 }
 
+// Picks the sink for this capture, a file one gets opened here
+bool julseview::sink_begin( ) {
+    sink = to_file ? (CaptureSink*)&file_sink : &usb_sink;
+    byte_cnt = 0;
+    sink_ok = sink->begin( );
+    if ( !sink_ok ) {
+        sink = &usb_sink;
+    }
+    return sink_ok;
+}
+
+// Flushes txbuf and closes a file sink, false if anything didn't make it
+bool julseview::sink_end( ) {
+    if ( txbufidx > 0 ) {
+        check_tx_buf( 1 );
+    }
+    if ( !sink->end( ) ) {
+        sink_ok = false;
+    }
+    sink = &usb_sink;
+    return sink_ok;
+}
+
 // Send txbuf to USB based on threshold - STREAMING OPTIMIZED VERSION
 void julseview::check_tx_buf( uint16_t cnt ) {
     if ( txbufidx >= cnt ) {
         // Check if we have data to transmit
         if ( txbufidx > 0 ) {
             // STREAMING-OPTIMIZED TRANSMISSION: Minimal retries, fast recovery
-            bool success = this->julseview_usb_out_chars( (char*)txbuf, txbufidx );
+            bool success = sink->write( txbuf, txbufidx );
 
             if ( success ) {
                 // Success - update counters and reset buffer
                 byte_cnt += txbufidx;
                 txbufidx = 0;
+            } else if ( sink->isFile( ) ) {
+                // the file sink already waited on flash, trying again won't help
+                sink_ok = false;
+                txbufidx = 0;
             } else {
                 // STREAMING FAILURE RECOVERY: Check USB buffer status and adjust strategy
                 int usb_available = tud_cdc_n_write_available( 2 );
@@ -2118,7 +2541,7 @@ void julseview::check_tx_buf( uint16_t cnt ) {
                 // delayMicroseconds( 5000 ); // Longer delay for persistent issues
                 // tud_cdc_n_write_flush(2);
 
-                success = this->julseview_usb_out_chars( (char*)txbuf, txbufidx );
+                success = sink->write( txbuf, txbufidx );
 
                 if ( success ) {
                     // Second attempt succeeded
@@ -2217,15 +2640,45 @@ void julseview::send_slices_analog( uint8_t* dbuf, uint8_t* abuf ) {
 #endif
 
     // OPTIMIZED: Process samples in smaller batches for better USB flow control
-    const uint32_t batch_size = use_decimation_mode ? 16 : 32; // Even smaller batches for better reliability
+    const uint32_t batch_size = use_decimation_mode ? 16 : JULSEVIEW_BLOCK_SAMPLES; // Even smaller batches for better reliability
     uint32_t samples_processed = 0;
 
+    // 8 GPIO channels without decimation is nearly every capture, those get
+    // encoded a whole batch at a time (JulseViewEncode.h) with the bounds
+    // checked once per batch. The sample table printout needs the slow path.
+    const bool block_encode = d_tx_bps == 2 && d_chan_cnt <= 8 && c_mask == 0 && !use_decimation_mode &&
+                              !( PRINT_DATA_SAMPLES && JULSEDEBUG_CHECK( JULSEDEBUG_STATE ) );
+    const uint8_t block_a_cnt = ( abuf != nullptr ) ? a_chan_cnt : 0;
+    const uint32_t tx_threshold = JULSEVIEW_TX_BUF_SIZE * 2 / 3;
+    // the protocol decoders only ride along on the block path
+    const bool decode = block_encode && protocolDecodeActive( );
+
     while ( samples_processed < samp_remain ) {
         uint32_t batch_end = samples_processed + batch_size;
         if ( batch_end > samp_remain ) {
             batch_end = samp_remain;
         }
 
+        if ( block_encode && batch_end * d_dma_bps <= d_size &&
+             batch_end * block_a_cnt * 2 <= a_size ) {
+            uint32_t count = batch_end - samples_processed;
+            if ( decode ) {
+                protocolDecodeFeed( dbuf + rxbufdidx, count );
+            }
+            if ( txbufidx + count * ( 2 + block_a_cnt * 2 ) >= tx_threshold ) {
+                check_tx_buf( 1 );
+            }
+            txbufidx += jv_encode_block( dbuf + rxbufdidx,
+                                         block_a_cnt ? abuf + samples_processed * block_a_cnt * 2 : nullptr,
+                                         count, block_a_cnt, &txbuf[ txbufidx ] );
+            rxbufdidx += count;
+
+            samples_processed = batch_end;
+            check_tx_buf( JULSEVIEW_TX_BUF_THRESH );
+            watchdog_update( );
+            continue;
+        }
+
         // Process each sample in the batch
         for ( uint32_t s = samples_processed; s < batch_end; s++ ) {
             // CRITICAL: Check bounds before processing - simplified but effective
@@ -2900,8 +3353,118 @@ void julseview::configure_internal_trigger( uint32_t var_address, uint32_t var_v
                     var_address, var_value );
 }
 
+// Edge and pattern triggers as trigger stages, false for anything that isn't
+// on the 8 GPIO channels
+bool julseview::digital_trigger_spec( jv_trigger_spec* spec ) {
+    if ( trigger_config.type == TRIGGER_DIGITAL_PATTERN ) {
+        *spec = trigger_config.pattern;
+        return spec->stages > 0;
+    }
+    if ( trigger_config.type != TRIGGER_DIGITAL_EDGE || trigger_config.channel > 7 ) {
+        return false;
+    }
+    uint8_t bit = 1 << trigger_config.channel;
+    spec->stages = 1;
+    spec->stage[ 0 ] = jv_trigger_make_stage( JV_TRIGGER_AND, bit, 0,
+                                              trigger_config.edge != EDGE_FALLING ? bit : 0,
+                                              trigger_config.edge != EDGE_RISING ? bit : 0 );
+    return true;
+}
+
+static uint16_t trigger_code[ JV_TRIGGER_MAX_PROGRAM ];
+static struct pio_program trigger_program = {
+    .instructions = trigger_code,
+    .length = 0,
+    .origin = -1,
+};
+
+// Compiles the trigger and loads it next to the capture program on a spare SM
+// of lapio, left disabled until waitForTrigger(). False if it doesn't compile
+// or there's no room, the software check is used then.
+bool julseview::arm_pio_trigger( ) {
+    release_pio_trigger( );
+
+    jv_trigger_spec spec;
+    if ( !digital_trigger_spec( &spec ) ) {
+        return false;
+    }
+    int pass = 0;
+    int len = jv_trigger_compile( &spec, trigger_code, JV_TRIGGER_MAX_PROGRAM, &pass );
+    if ( len <= 0 ) {
+        JULSEDEBUG_CMD( "Trigger doesn't compile for PIO, checking it in software\n\r" );
+        return false;
+    }
+    trigger_program.length = len;
+    if ( !pio_can_add_program( lapio, &trigger_program ) ) {
+        JULSEDEBUG_CMD( "No room for the %d word trigger program, checking it in software\n\r", len );
+        return false;
+    }
+    int sm = pio_claim_unused_sm( lapio, false );
+    if ( sm < 0 ) {
+        JULSEDEBUG_CMD( "No free SM for the trigger, checking it in software\n\r" );
+        return false;
+    }
+    trigger_offset = pio_add_program( lapio, &trigger_program );
+    trigger_sm = sm;
+
+    // full speed, channel 0 is the first bit out of the OSR
+    pio_sm_config c = pio_get_default_sm_config( );
+    sm_config_set_in_pins( &c, 20 );
+    sm_config_set_out_shift( &c, true, false, 32 );
+    sm_config_set_wrap( &c, trigger_offset, trigger_offset + len - 1 );
+    sm_config_set_clkdiv( &c, 1.0f );
+    pio_sm_init( lapio, trigger_sm, trigger_offset, &c );
+    lapio->irq = ( 1u << JV_TRIGGER_IRQ_CPU ) | ( 1u << JV_TRIGGER_IRQ_CAPTURE );
+
+    JULSEDEBUG_CMD( "PIO trigger: %d stages, %d words at offset %d on SM %d\n\r",
+                    spec.stages, len, trigger_offset, trigger_sm );
+    uint32_t keeps_up = clock_get_hz( clk_sys ) / ( pass > 0 ? pass : 1 );
+    if ( sample_rate > keeps_up ) {
+        JULSEDEBUG_ERR( "PIO trigger checks every %d cycles, %u samples/s at most, patterns shorter than that can be missed at %u\n\r",
+                        pass, (unsigned)keeps_up, (unsigned)sample_rate );
+    }
+    return true;
+}
+
+void julseview::release_pio_trigger( ) {
+    if ( trigger_sm < 0 ) {
+        return;
+    }
+    pio_sm_set_enabled( lapio, trigger_sm, false );
+    pio_remove_program( lapio, &trigger_program, trigger_offset );
+    pio_sm_unclaim( lapio, trigger_sm );
+    lapio->irq = 1u << JV_TRIGGER_IRQ_CPU;
+    trigger_sm = -1;
+    trigger_offset = -1;
+}
+
 void julseview::waitForTrigger( ) {
-    JULSEDEBUG_CMD( "waitForTrigger() - starting trigger monitoring with GPIO polling (sio gpio_in)\n\r" );
+    JULSEDEBUG_CMD( "waitForTrigger() - starting trigger monitoring\n\r" );
+    uint32_t polls = 0;
+
+    if ( trigger_sm >= 0 ) {
+        // the PIO does the matching, this just waits to hear about it
+        pio_sm_set_enabled( lapio, trigger_sm, true );
+        while ( !trigger_detected && julseview_active ) {
+            if ( lapio->irq & ( 1u << JV_TRIGGER_IRQ_CPU ) ) {
+                trigger_detected = true;
+                isTriggered = true;
+                break;
+            }
+            if ( ( ++polls & 0xFFF ) == 0 ) {
+                watchdog_update( );
+                uint8_t c = 0;
+                if ( tud_cdc_n_peek( 2, &c ) == 1 && c == '+' ) {
+                    // let the parked capture SM go so the capture loop sees the stop
+                    lapio->irq_force = 1u << JV_TRIGGER_IRQ_CAPTURE;
+                    break;
+                }
+            }
+        }
+        release_pio_trigger( );
+        JULSEDEBUG_CMD( "waitForTrigger() - completed\n\r" );
+        return;
+    }
 
     if ( trigger_config.type == TRIGGER_DIGITAL_EDGE ) {
         uint8_t trigger_pin = trigger_config.channel + 20; // GPIO 20-27 for channels 0-7
@@ -2937,11 +3500,98 @@ void julseview::waitForTrigger( ) {
             prev = curr;
             watchdog_update( );
         }
+    } else if ( trigger_config.type == TRIGGER_DIGITAL_PATTERN && trigger_config.pattern.stages > 0 ) {
+        // didn't fit in the PIO, same stages one GPIO read at a time
+        jv_trigger_state state;
+        jv_trigger_reset( &state );
+        while ( !trigger_detected && julseview_active ) {
+            if ( jv_trigger_feed( &trigger_config.pattern, &state, ( sio_hw->gpio_in >> 20 ) & 0xFF ) ) {
+                trigger_detected = true;
+                isTriggered = true;
+                return;
+            }
+            if ( ( ++polls & 0xFFF ) == 0 ) {
+                watchdog_update( );
+                uint8_t c = 0;
+                if ( tud_cdc_n_peek( 2, &c ) == 1 && c == '+' ) {
+                    break;
+                }
+            }
+        }
     }
 
     JULSEDEBUG_CMD( "waitForTrigger() - completed\n\r" );
 }
 
+#define ANALOG_TRIGGER_RING_BITS 9 // 256 samples, ring-wrapped by the DMA
+
+// The ADC free-runs on the trigger input into a DMA ring and the CPU scans
+// whatever has landed since the last look, so the check keeps up at full ADC
+// rate instead of one adc_read() per loop. Leaves the ADC stopped and drained
+// for run() to set up the capture.
+void julseview::waitForAnalogTrigger( ) {
+    static uint16_t ring[ 1 << ( ANALOG_TRIGGER_RING_BITS - 1 ) ] __attribute__( ( aligned( 1 << ANALOG_TRIGGER_RING_BITS ) ) );
+    const uint32_t ring_mask = ( 1 << ( ANALOG_TRIGGER_RING_BITS - 1 ) ) - 1;
+
+    int chan = dma_claim_unused_channel( false );
+    if ( chan < 0 ) {
+        JULSEDEBUG_ERR( "Analog trigger: no DMA channel, not waiting\n\r" );
+        return;
+    }
+    JULSEDEBUG_CMD( "Analog trigger: ADC %d, level %d, edge %d\n\r",
+                    trigger_config.channel, trigger_config.level, trigger_config.edge );
+
+    adcSamplerStop( );
+    adc_run( false );
+    adc_fifo_drain( );
+    adc_select_input( trigger_config.channel );
+    adc_set_round_robin( 0 );
+    adc_fifo_setup( true, true, 1, false, false );
+
+    dma_channel_config cfg = dma_channel_get_default_config( chan );
+    channel_config_set_transfer_data_size( &cfg, DMA_SIZE_16 );
+    channel_config_set_read_increment( &cfg, false );
+    channel_config_set_write_increment( &cfg, true );
+    channel_config_set_ring( &cfg, true, ANALOG_TRIGGER_RING_BITS );
+    channel_config_set_dreq( &cfg, DREQ_ADC );
+    dma_channel_configure( chan, &cfg, ring, &adc_hw->fifo, 0xFFFFFFFF, true ); // endless on RP2350
+    adc_run( true );
+
+    uint32_t seen = 0;
+    uint16_t last = 0;
+    bool primed = false;
+    uint32_t polls = 0;
+    while ( !trigger_detected && julseview_active ) {
+        uint32_t at = ( ( dma_channel_hw_addr( chan )->write_addr - (uint32_t)ring ) >> 1 ) & ring_mask;
+        if ( at != seen ) {
+            if ( !primed ) {
+                last = ring[ seen ] & 0x0FFF; // first sample only sets the baseline
+                seen = ( seen + 1 ) & ring_mask;
+                primed = true;
+            }
+            if ( jv_analog_level_scan( ring, ring_mask, seen, at, trigger_config.level, trigger_config.edge, &last ) >= 0 ) {
+                trigger_detected = true;
+                isTriggered = true;
+            }
+            seen = at;
+        }
+        if ( ( ++polls & 0xFFF ) == 0 ) {
+            watchdog_update( );
+            uint8_t c = 0;
+            if ( tud_cdc_n_peek( 2, &c ) == 1 && c == '+' ) {
+                break;
+            }
+        }
+    }
+
+    adc_run( false );
+    dma_channel_abort( chan );
+    dma_channel_unclaim( chan );
+    adc_fifo_setup( false, false, 1, false, false );
+    adc_fifo_drain( );
+    JULSEDEBUG_CMD( "Analog trigger %s\n\r", trigger_detected ? "fired" : "abandoned" );
+}
+
 // Pre-trigger functionality removed - simplified to post-trigger only
 
 // ============================================================================
@@ -3345,6 +3995,23 @@ void julseview::send_capture_completion_signal( bool is_watchdog_timeout ) {
         return;
     }
 
+    if ( sink->isFile( ) ) {
+        // nothing on USB but the reply, the samples went to the file
+        end( );
+        bool ok = sink_end( ) && !is_watchdog_timeout;
+        char reply[ 16 ];
+        if ( ok ) {
+            sprintf( reply, "W%u", (unsigned)byte_cnt );
+        } else {
+            strcpy( reply, "!" );
+        }
+        julseview_usb_out_chars( reply, strlen( reply ) );
+        JULSEDEBUG_STA( "JulseView: %u bytes to %s, %lu stalls\n\r", (unsigned)byte_cnt, file_sink.path( ),
+                        captureFileStats.stalls );
+        completion_signal_sent = true;
+        return;
+    }
+
     if ( is_watchdog_timeout ) {
         JULSEDEBUG_CMD( "Watchdog timeout - sending error completion signal\n\r" );
         char error_str[ 64 ];
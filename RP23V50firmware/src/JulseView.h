@@ -4,6 +4,8 @@
 #include <Arduino.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include "JulseViewTrigger.h"
+#include "CaptureSink.h"
 
 #ifndef PICO_STDIO_USB_STDOUT_TIMEOUT_US
 #define PICO_STDIO_USB_STDOUT_TIMEOUT_US 500000
@@ -64,7 +66,8 @@ typedef enum {
     TRIGGER_ANALOG_LEVEL = 1,
     TRIGGER_ANALOG_EDGE = 2,
     TRIGGER_DIGITAL_EDGE = 3,
-    TRIGGER_INTERNAL_VAR = 4
+    TRIGGER_INTERNAL_VAR = 4,
+    TRIGGER_DIGITAL_PATTERN = 5  // 'g' stages, see JulseViewTrigger.h
 } trigger_type_t;
 
 // Edge types for edge triggering
@@ -83,11 +86,27 @@ typedef struct {
     uint32_t var_address;      // Memory address for internal variable trigger
     uint32_t var_value;        // Expected value for internal variable trigger
     bool enabled;              // Whether trigger is enabled
+    jv_trigger_spec pattern;   // Stages for TRIGGER_DIGITAL_PATTERN
 } trigger_config_t;
 
+class julseview;
+
+// The USB sink for JulseView: julseview_usb_out_chars() as it always was, with
+// its length check, backoff and debug output, behind the CaptureSink interface
+class JulseViewUsbSink : public CaptureSink {
+public:
+    explicit JulseViewUsbSink(julseview *owner) : owner(owner) {}
+    bool write(const uint8_t *data, int len) override;
+
+private:
+    julseview *owner;
+};
+
 // This class will handle the JulseView commands and data
 // and send it to the custom sigrok driver for pulseview.
 class julseview {
+    friend class JulseViewUsbSink;
+
 public:
     // Constructor to initialize member variables
     julseview();
@@ -270,6 +289,14 @@ private:
     void configure_digital_trigger(uint8_t channel, edge_type_t edge);
     void configure_internal_trigger(uint32_t var_address, uint32_t var_value);
     void waitForTrigger();
+    void waitForAnalogTrigger();
+
+    // Compiled digital triggers on their own state machine of lapio
+    int trigger_sm = -1;
+    int trigger_offset = -1;
+    bool digital_trigger_spec(jv_trigger_spec *spec);
+    bool arm_pio_trigger();
+    void release_pio_trigger();
     
     // Internal trigger check methods
     bool check_analog_level_trigger(uint16_t analog_value);
@@ -287,6 +314,26 @@ private:
     void send_slices_2B(uint8_t *dbuf);
     void send_slices_4B(uint8_t *dbuf);
     void send_slices_analog(uint8_t *dbuf, uint8_t *abuf);
+
+    // Deep capture (DeepCapture.h): digital only, runs into a ring and
+    // uploads the pre/post-trigger window once the trigger has fired
+    bool deep_capture_enabled = false; // 'M1', also untriggered captures
+    uint32_t deep_pre_samples = 0;     // what 'p' asked for
+    uint32_t deep_unrefined_triggers = 0; // placed where the poll saw them, not on their sample
+    bool deep_capture_wanted();
+    void run_deep_capture();
+
+    // Where the sample stream goes (CaptureSink.h): 'W<file>' sends the
+    // following captures to a file on the FatFS partition, 'W-' back to USB.
+    // The file holds the RLE stream sigrok would have read, and the capture
+    // answers "W<bytes>" (or '!' if the file didn't take it) instead of "$<bytes>+"
+    JulseViewUsbSink usb_sink{this};
+    FileCaptureSink file_sink;
+    CaptureSink *sink = &usb_sink;
+    bool to_file = false;
+    bool sink_ok = true;
+    bool sink_begin();
+    bool sink_end();
     
     // Firmware-side decimation helpers
     void process_analog_sample(uint8_t* abuf, uint32_t sample_index);
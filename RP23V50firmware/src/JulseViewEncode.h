@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+#ifndef JULSEVIEWENCODE_H
+#define JULSEVIEWENCODE_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Block encoders for the JulseView 7-bit sample stream
+//
+// Same bytes as julseview::encode_digital_data() and process_analog_sample()
+// produce one sample at a time for 8 digital channels without decimation,
+// but four digital samples or two analog values are packed per 32-bit word.
+// Kept free of Arduino headers so scripts/julseview_encode_test.py can build
+// it on the host and check it against the per-sample encoding.
+
+#define JULSEVIEW_BLOCK_SAMPLES 32
+
+static inline uint32_t jv_load32( const uint8_t* p ) {
+    uint32_t v;
+    memcpy( &v, p, 4 );
+    return v;
+}
+
+static inline void jv_store32( uint8_t* p, uint32_t v ) { memcpy( p, &v, 4 ); }
+
+// 0x0000abcd -> 0x00ab00cd
+static inline uint32_t jv_spread16( uint32_t x ) {
+    x &= 0xFFFF;
+    return ( x | ( x << 8 ) ) & 0x00FF00FF;
+}
+
+// Digital byte 0 is (v & 0x7F) + 0x30 with the high bit forced on, byte 1 is
+// bit 7 + 0x30, also with the high bit on. Neither add can carry into the
+// next byte lane, so four samples go through at once.
+static inline void jv_encode_digital8( const uint8_t* in, uint32_t count, uint8_t* out ) {
+    uint32_t i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        uint32_t w = jv_load32( in + i );
+        uint32_t lo = ( ( w & 0x7F7F7F7F ) + 0x30303030 ) | 0x80808080;
+        uint32_t hi = ( ( w >> 7 ) & 0x01010101 ) + 0xB0B0B0B0;
+        jv_store32( out, jv_spread16( lo ) | ( jv_spread16( hi ) << 8 ) );
+        jv_store32( out + 4, jv_spread16( lo >> 16 ) | ( jv_spread16( hi >> 16 ) << 8 ) );
+        out += 8;
+    }
+    for ( ; i < count; i++ ) {
+        *out++ = ( ( in[ i ] & 0x7F ) + 0x30 ) | 0x80;
+        *out++ = ( ( in[ i ] >> 7 ) & 0x01 ) + 0xB0;
+    }
+}
+
+// Analog values are 12 bits in 16-bit little endian words, sent as the low 7
+// bits + 0x30 then the high 5 bits + 0x30 (no high bit). Two per word.
+static inline void jv_encode_analog12( const uint8_t* in, uint32_t count, uint8_t* out ) {
+    uint32_t i = 0;
+    for ( ; i + 2 <= count; i += 2 ) {
+        uint32_t x = jv_load32( in + i * 2 );
+        uint32_t lo = ( x & 0x007F007F ) + 0x00300030;
+        uint32_t hi = ( ( x >> 7 ) & 0x001F001F ) + 0x00300030;
+        jv_store32( out, lo | ( hi << 8 ) );
+        out += 4;
+    }
+    if ( i < count ) {
+        uint16_t v = ( in[ i * 2 ] | ( in[ i * 2 + 1 ] << 8 ) ) & 0x0FFF;
+        *out++ = ( v & 0x7F ) + 0x30;
+        *out++ = ( ( v >> 7 ) & 0x1F ) + 0x30;
+    }
+}
+
+// count samples of 1 digital byte and a_cnt analog words each, interleaved the
+// way the driver expects them. Returns the number of bytes written.
+static inline uint32_t jv_encode_block( const uint8_t* dbuf, const uint8_t* abuf,
+                                        uint32_t count, uint8_t a_cnt, uint8_t* out ) {
+    if ( a_cnt == 0 || abuf == nullptr ) {
+        jv_encode_digital8( dbuf, count, out );
+        return count * 2;
+    }
+
+    uint32_t stride = 2 + a_cnt * 2;
+    uint8_t digital[ 8 ];
+    for ( uint32_t s = 0; s < count; s += 4 ) {
+        uint32_t n = ( count - s < 4 ) ? count - s : 4;
+        jv_encode_digital8( dbuf + s, n, digital );
+        for ( uint32_t j = 0; j < n; j++ ) {
+            out[ 0 ] = digital[ j * 2 ];
+            out[ 1 ] = digital[ j * 2 + 1 ];
+            jv_encode_analog12( abuf + ( s + j ) * a_cnt * 2, a_cnt, out + 2 );
+            out += stride;
+        }
+    }
+    return count * stride;
+}
+
+#endif
@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: MIT
+#ifndef JULSEVIEWTRIGGER_H
+#define JULSEVIEWTRIGGER_H
+
+#include <stdint.h>
+
+// Digital trigger compiler for JulseView
+//
+// A trigger is up to JV_TRIGGER_MAX_STAGES stages matched one after the other.
+// Each stage looks at the 8 logic analyzer channels (GPIO 20-27) and either
+// needs all of its channels at their levels (AND, with at most one edge
+// channel) or any one of them (OR, levels only). jv_trigger_compile() turns
+// that into a PIO program that runs on its own state machine, takes one
+// snapshot of the pins per check and raises JV_TRIGGER_IRQ_CAPTURE the moment
+// the last stage matches, which is what the capture SM is held on.
+//
+// The trigger SM runs at the system clock, one cycle a word, and a check can
+// take up to a stage's length before the next snapshot (jv_trigger_compile()
+// reports the longest as pass_cycles). Up to clk_sys / pass_cycles samples a
+// second it sees every sample, though a stage that already holds on the
+// sample the one before it matched lands a sample later than the software
+// check says, up to one per stage. Above that rate a pattern shorter than a
+// pass can go by between two snapshots. It's still far quicker than the
+// software check, so arm_pio_trigger() only logs it.
+//
+// jv_trigger_feed() is the same trigger evaluated one sample at a time. It's
+// the fallback for triggers that don't compile (or don't fit next to the
+// capture program) and what scripts/julseview_trigger_test.py checks the
+// generated programs against. Kept free of SDK headers for that reason, the
+// encoders below produce the same words as hardware/pio_instructions.h.
+
+#define JV_TRIGGER_MAX_STAGES 4
+#define JV_TRIGGER_MAX_PROGRAM 32
+
+#define JV_TRIGGER_IRQ_CAPTURE 7 // capture SM waits on (and clears) this one
+#define JV_TRIGGER_IRQ_CPU 6     // left set for the CPU to poll
+
+enum {
+    JV_TRIGGER_AND = 0,
+    JV_TRIGGER_OR = 1,
+};
+
+struct jv_trigger_stage {
+    uint8_t op;      // JV_TRIGGER_AND / JV_TRIGGER_OR
+    uint8_t mask;    // channels that take part
+    uint8_t value;   // levels they need, edge channels land on theirs
+    uint8_t rising;  // edge channels, both bits set for either edge
+    uint8_t falling;
+};
+
+struct jv_trigger_spec {
+    uint8_t stages;
+    jv_trigger_stage stage[ JV_TRIGGER_MAX_STAGES ];
+};
+
+struct jv_trigger_state {
+    uint8_t stage;
+    uint8_t prev;
+    bool primed; // prev holds a real sample
+};
+
+// --- PIO instruction encoding ---
+
+enum {
+    JV_PIO_JMP_ALWAYS = 0,
+    JV_PIO_JMP_NOT_X = 1,
+    JV_PIO_JMP_X_DEC = 2,
+    JV_PIO_JMP_X_NE_Y = 5,
+};
+
+enum {
+    JV_PIO_SRC_PINS = 0,
+    JV_PIO_SRC_X = 1,
+    JV_PIO_SRC_Y = 2,
+    JV_PIO_SRC_NULL = 3,
+    JV_PIO_SRC_ISR = 6,
+    JV_PIO_SRC_OSR = 7,
+};
+
+static inline uint16_t jv_pio_jmp( uint8_t cond, uint8_t addr ) { return ( cond << 5 ) | ( addr & 0x1F ); }
+
+static inline uint16_t jv_pio_wait_irq( bool level, uint8_t irq ) {
+    return 0x2000 | ( level ? 0x80 : 0 ) | ( 2 << 5 ) | ( irq & 0x07 );
+}
+
+// out <dest>, count with dest x (1), y (2) or null (3)
+static inline uint16_t jv_pio_out( uint8_t dest, uint8_t count ) { return 0x6000 | ( dest << 5 ) | ( count & 0x1F ); }
+
+static inline uint16_t jv_pio_mov( uint8_t dest, uint8_t src ) { return 0xA000 | ( dest << 5 ) | src; }
+
+static inline uint16_t jv_pio_irq_set( uint8_t irq ) { return 0xC000 | ( irq & 0x07 ); }
+
+// --- Compiler ---
+
+static inline bool jv_emit( uint16_t* code, int* len, int max, uint16_t instr ) {
+    if ( *len >= max ) {
+        return false;
+    }
+    code[ ( *len )++ ] = instr;
+    return true;
+}
+
+static inline int jv_lowest_bit( uint8_t v ) {
+    for ( int i = 0; i < 8; i++ ) {
+        if ( v & ( 1u << i ) ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/// edges and levels of a stage made consistent (edge channels in mask, value
+/// matching the edge), so both the compiler and the evaluator can trust it
+static inline jv_trigger_stage jv_trigger_make_stage( uint8_t op, uint8_t mask, uint8_t value, uint8_t rising,
+                                                      uint8_t falling ) {
+    jv_trigger_stage s;
+    s.op = op;
+    s.rising = rising;
+    s.falling = falling;
+    s.mask = mask | rising | falling;
+    s.value = ( value | rising ) & ~( falling & ~rising ) & s.mask;
+    return s;
+}
+
+/// program words for the spec, or -1 if it can't be done in PIO (OR with
+/// edges, more than one edge per stage, too long for max). pass_cycles gets
+/// the most PIO cycles between two snapshots of the pins
+static inline int jv_trigger_compile( const jv_trigger_spec* spec, uint16_t* code, int max,
+                                      int* pass_cycles = nullptr ) {
+    int len = 0;
+    int pass = 0;
+    int last_check = -1;
+    if ( spec->stages == 0 || spec->stages > JV_TRIGGER_MAX_STAGES ) {
+        return -1;
+    }
+
+    for ( int i = 0; i < spec->stages; i++ ) {
+        const jv_trigger_stage* s = &spec->stage[ i ];
+        uint8_t edges = s->rising | s->falling;
+        int edge = jv_lowest_bit( edges );
+
+        if ( s->mask == 0 || ( edges & ( edges - 1 ) ) != 0 || ( s->op == JV_TRIGGER_OR && edges ) ) {
+            return -1;
+        }
+        // the next stage's edge starts from the sample this one matched on
+        bool keep = i + 1 < spec->stages && ( spec->stage[ i + 1 ].rising | spec->stage[ i + 1 ].falling );
+        bool in_isr = edge >= 0 || keep;
+
+        // arm: y = where the edge channel is, taken from the snapshot the
+        // stage before matched on (still in the ISR) so an edge right after
+        // it isn't missed
+        if ( edge >= 0 ) {
+            uint8_t from = i > 0 ? JV_PIO_SRC_ISR : JV_PIO_SRC_PINS;
+            if ( !jv_emit( code, &len, max, jv_pio_mov( JV_PIO_SRC_OSR, from ) ) ||
+                 ( edge > 0 && !jv_emit( code, &len, max, jv_pio_out( JV_PIO_SRC_NULL, edge ) ) ) ||
+                 !jv_emit( code, &len, max, jv_pio_out( JV_PIO_SRC_Y, 1 ) ) ) {
+                return -1;
+            }
+        }
+
+        // check: one snapshot of the pins, shifted out a channel at a time
+        int check = len;
+        if ( last_check >= 0 && check - last_check > pass ) {
+            pass = check - last_check; // the stage before matched on its snapshot
+        }
+        last_check = check;
+        if ( in_isr ) {
+            if ( !jv_emit( code, &len, max, jv_pio_mov( JV_PIO_SRC_ISR, JV_PIO_SRC_PINS ) ) ||
+                 !jv_emit( code, &len, max, jv_pio_mov( JV_PIO_SRC_OSR, JV_PIO_SRC_ISR ) ) ) {
+                return -1;
+            }
+        } else if ( !jv_emit( code, &len, max, jv_pio_mov( JV_PIO_SRC_OSR, JV_PIO_SRC_PINS ) ) ) {
+            return -1;
+        }
+
+        uint8_t rest = s->mask;
+        if ( edge >= 0 ) {
+            // edge channel first: nothing to do unless it moved, and once it
+            // has y follows it so a rejected edge can't match again
+            bool either = s->rising & s->falling & ( 1u << edge );
+            int changed = len + ( edge > 0 ? 4 : 3 );
+            if ( ( edge > 0 && !jv_emit( code, &len, max, jv_pio_out( JV_PIO_SRC_NULL, edge ) ) ) ||
+                 !jv_emit( code, &len, max, jv_pio_out( JV_PIO_SRC_X, 1 ) ) ||
+                 !jv_emit( code, &len, max, jv_pio_jmp( JV_PIO_JMP_X_NE_Y, changed ) ) ||
+                 !jv_emit( code, &len, max, jv_pio_jmp( JV_PIO_JMP_ALWAYS, check ) ) ||
+                 !jv_emit( code, &len, max, jv_pio_mov( JV_PIO_SRC_Y, JV_PIO_SRC_X ) ) ) {
+                return -1;
+            }
+            if ( !either ) {
+                bool rising = s->rising >> edge & 1;
+                if ( !jv_emit( code, &len, max, jv_pio_jmp( rising ? JV_PIO_JMP_NOT_X : JV_PIO_JMP_X_DEC, check ) ) ) {
+                    return -1;
+                }
+            }
+            if ( !jv_emit( code, &len, max, jv_pio_mov( JV_PIO_SRC_OSR, JV_PIO_SRC_ISR ) ) ) {
+                return -1;
+            }
+            rest &= ~( 1u << edge );
+        }
+
+        int matchJumps[ 8 ];
+        int matches = 0;
+        int shifted = 0;
+        for ( int ch = 0; ch < 8; ch++ ) {
+            if ( !( rest & ( 1u << ch ) ) ) {
+                continue;
+            }
+            if ( ch > shifted && !jv_emit( code, &len, max, jv_pio_out( JV_PIO_SRC_NULL, ch - shifted ) ) ) {
+                return -1;
+            }
+            if ( !jv_emit( code, &len, max, jv_pio_out( JV_PIO_SRC_X, 1 ) ) ) {
+                return -1;
+            }
+            shifted = ch + 1;
+
+            bool want = s->value >> ch & 1;
+            if ( s->op == JV_TRIGGER_OR ) {
+                // this one matching is enough, target patched below
+                matchJumps[ matches++ ] = len;
+                if ( !jv_emit( code, &len, max, jv_pio_jmp( want ? JV_PIO_JMP_X_DEC : JV_PIO_JMP_NOT_X, 0 ) ) ) {
+                    return -1;
+                }
+            } else if ( !jv_emit( code, &len, max, jv_pio_jmp( want ? JV_PIO_JMP_NOT_X : JV_PIO_JMP_X_DEC, check ) ) ) {
+                return -1;
+            }
+        }
+        if ( s->op == JV_TRIGGER_OR ) {
+            if ( !jv_emit( code, &len, max, jv_pio_jmp( JV_PIO_JMP_ALWAYS, check ) ) ) {
+                return -1;
+            }
+            for ( int m = 0; m < matches; m++ ) {
+                code[ matchJumps[ m ] ] |= len;
+            }
+        }
+        // worst case back to check is every word of the stage, one cycle each
+        if ( len - check > pass ) {
+            pass = len - check;
+        }
+    }
+
+    // matched: let the capture go, tell the CPU, then park
+    if ( !jv_emit( code, &len, max, jv_pio_irq_set( JV_TRIGGER_IRQ_CAPTURE ) ) ||
+         !jv_emit( code, &len, max, jv_pio_irq_set( JV_TRIGGER_IRQ_CPU ) ) ||
+         !jv_emit( code, &len, max, jv_pio_jmp( JV_PIO_JMP_ALWAYS, len ) ) ) {
+        return -1;
+    }
+    if ( pass_cycles ) {
+        *pass_cycles = pass;
+    }
+    return len;
+}
+
+// --- Sample-at-a-time evaluation ---
+
+static inline void jv_trigger_reset( jv_trigger_state* st ) {
+    st->stage = 0;
+    st->prev = 0;
+    st->primed = false;
+}
+
+static inline bool jv_trigger_stage_match( const jv_trigger_stage* s, uint8_t prev, uint8_t curr, bool primed ) {
+    uint8_t edges = s->rising | s->falling;
+    uint8_t levels = s->mask & ~edges;
+    uint8_t rose = primed ? ( ~prev & curr ) : 0;
+    uint8_t fell = primed ? ( prev & ~curr ) : 0;
+    uint8_t edged = ( rose & s->rising ) | ( fell & s->falling );
+    uint8_t level_ok = ~( curr ^ s->value ) & levels;
+
+    if ( s->op == JV_TRIGGER_OR ) {
+        return ( level_ok | edged ) != 0;
+    }
+    return level_ok == levels && edged == edges;
+}
+
+/// feed samples in order, true on the one that completes the last stage;
+/// a level-only stage can match on the same sample as the stage before it
+static inline bool jv_trigger_feed( const jv_trigger_spec* spec, jv_trigger_state* st, uint8_t sample ) {
+    bool fired = false;
+    bool fresh = true; // edge stages only look at samples after the stage started
+    while ( st->stage < spec->stages ) {
+        const jv_trigger_stage* s = &spec->stage[ st->stage ];
+        bool has_edges = ( s->rising | s->falling ) != 0;
+        if ( ( has_edges && !fresh ) || !jv_trigger_stage_match( s, st->prev, sample, st->primed ) ) {
+            break;
+        }
+        fresh = false;
+        if ( ++st->stage == spec->stages ) {
+            fired = true;
+        }
+    }
+    st->prev = sample;
+    st->primed = true;
+    return fired;
+}
+
+// --- Analog level ---
+
+/// first crossing of level in ring[from..to) (indexes wrap with ring_mask),
+/// same rule as julseview::check_analog_level_trigger(); returns the ring
+/// index or -1, *last carries the previous sample between calls
+static inline int32_t jv_analog_level_scan( const uint16_t* ring, uint32_t ring_mask, uint32_t from, uint32_t to,
+                                           uint16_t level, uint8_t edge, uint16_t* last ) {
+    uint16_t prev = *last;
+    for ( uint32_t i = from; i != to; i = ( i + 1 ) & ring_mask ) {
+        uint16_t v = ring[ i ] & 0x0FFF;
+        bool up = prev < level && v >= level;
+        bool down = prev > level && v <= level;
+        prev = v;
+        if ( ( edge != 1 && up ) || ( edge != 0 && down ) ) {
+            *last = prev;
+            return (int32_t)i;
+        }
+    }
+    *last = prev;
+    return -1;
+}
+
+#endif
@@ -19,6 +19,7 @@
 #include "JumperlessDefines.h"
 #include "hardware/gpio.h"
 #include "SafeString.h"
+#include <new>
 
 #include "LogicAnalyzer.h"
 #include "WaveGen.h"
@@ -38,6 +39,16 @@ extern SafeString nodeFileString;
 #include "FatFS.h"
 
 #include "JulseView.h"
+#include "Animations.h"
+#include "LEDAssets.h"
+#include "ProtocolDecode.h"
+#include "AdcSampler.h"
+#include "Telemetry.h"
+#include "InaSampler.h"
+#include "BulkSampler.h"
+#include "Sequencer.h"
+#include "ScriptCache.h"
+#include "EventDispatch.h"
 
 
 
@@ -112,7 +123,7 @@ void jl_wavegen_set_freq(float hz) {
 
 void jl_wavegen_set_wave(int wave) {
     if (wave < 0) wave = 0;
-    if (wave > 3) wave = 3;
+    if (wave > WAVEGEN_PLAYBACK) wave = WAVEGEN_PLAYBACK;
     wavegen.setWaveform((waveGen_waveform_t)wave);
     s_wg_user_set_wave = true;
 }
@@ -131,20 +142,141 @@ void jl_wavegen_set_offset(float v) {
     s_wg_user_set_offset = true;
 }
 
-void jl_wavegen_set_sweep(float start_hz, float end_hz, float seconds) {
+void jl_wavegen_set_sweep(float start_hz, float end_hz, float seconds, int logarithmic, int repeat) {
     if (start_hz <= 0.0f) start_hz = 0.0001f;
     if (end_hz <= 0.0f) end_hz = 0.0001f;
     if (seconds < 0.0f) seconds = 0.0f;
     s_wg_sweep_start_hz = start_hz;
     s_wg_sweep_end_hz = end_hz;
     s_wg_sweep_time_s = seconds;
+    // 0 seconds goes back to the set frequency
+    wavegen.sweep(start_hz, end_hz, seconds, logarithmic != 0, repeat != 0);
+}
+
+void jl_wavegen_add_output(int channel) {
+    if (channel < 0) channel = 0;
+    if (channel > 3) channel = 3;
+    if (!s_wg_user_set_output) {
+        // the default output isn't one the user asked for
+        wavegen.setChannel((waveGen_channel_t)channel);
+    } else {
+        wavegen.addChannel((waveGen_channel_t)channel);
+    }
+    s_wg_user_set_output = true;
+}
+
+void jl_wavegen_remove_output(int channel) {
+    if (channel < 0 || channel > 3) return;
+    wavegen.removeChannel((waveGen_channel_t)channel);
+}
+
+void jl_wavegen_set_phase(float degrees) {
+    wavegen.setPhase(degrees);
+}
+
+void jl_wavegen_set_harmonic(int multiple) {
+    if (multiple < 1) multiple = 1;
+    if (multiple > 255) multiple = 255;
+    wavegen.setHarmonic((uint8_t)multiple);
+}
+
+void jl_wavegen_stats(void) {
+    wavegen.printStats(&Serial);
+}
+
+int jl_wavegen_load_cycle(const char *path) {
+    if (!wavegen.loadCycle(path)) return 0;
+    s_wg_user_set_wave = true;
+    return 1;
+}
+
+int jl_wavegen_set_cycle(const void *samples, uint32_t count, int format) {
+    if (!wavegen.setCycle(samples, count, (uint8_t)format)) return 0;
+    s_wg_user_set_wave = true;
+    return 1;
+}
+
+int jl_wavegen_play_file(const char *path, float sample_rate, int loop) {
+    if (!wavegen.playFile(path, sample_rate, loop != 0)) return 0;
+    s_wg_user_set_wave = true;
+    return 1;
+}
+
+int jl_wavegen_play_buffer(const void *samples, uint32_t count, int format, float sample_rate, int loop) {
+    if (!wavegen.playBuffer(samples, count, (uint8_t)format, sample_rate, loop != 0)) return 0;
+    s_wg_user_set_wave = true;
+    return 1;
+}
+
+void jl_wavegen_play_stop(void) {
+    wavegen.stopPlayback();
+}
+
+void jl_wavegen_play_status(uint32_t *out) {
+    out[0] = wavegen.isPlaying() ? 1 : 0;
+    out[1] = wavegen.getPlayPosition();
+    out[2] = wavegen.getPlayStarved();
+}
+
+void jl_sequence_clear(void) {
+    sequencerClear();
+}
+
+int jl_sequence_add(uint32_t at_us, int output, int value) {
+    return sequencerAdd(at_us, output, (uint16_t)value) ? 1 : 0;
+}
+
+int jl_sequence_add_volts(uint32_t at_us, int output, float volts) {
+    return sequencerAddVolts(at_us, output, volts) ? 1 : 0;
+}
+
+int jl_sequence_start(int loops, uint32_t period_us, int trigger, int rising) {
+    return sequencerStart(loops, period_us, trigger, rising != 0);
+}
+
+int jl_sequence_bad_event(void) {
+    return sequencerBadEvent();
+}
+
+const char *jl_sequence_error_text(int error) {
+    return seqErrorText(error);
+}
+
+void jl_sequence_stop(void) {
+    sequencerStop();
+}
+
+void jl_sequence_status(int32_t *out) {
+    out[0] = sequencerRunning() ? 1 : 0;
+    out[1] = sequencerWaiting() ? 1 : 0;
+    out[2] = (int32_t)sequencerStats.passes;
+    out[3] = sequencerStats.worstLateUs;
+}
+
+int jl_sequence_events(void) {
+    return sequencerEvents();
+}
+
+uint32_t jl_sequence_scheduled_at(int event) {
+    return sequencerScheduledAt(event);
+}
+
+int32_t jl_sequence_fired_at(int event) {
+    return sequencerFiredAt(event);
+}
+
+void jl_sequence_stats(void) {
+    printSequencerStats(&Serial);
+}
+
+int jl_sequence_owns_dac(void) {
+    return sequencerOwnsWire() ? 1 : 0;
 }
 
 void jl_wavegen_start(int start) {
     if (start) {
-        // Ensure initialized and safe mode
+        // Ensure initialized, service() on core 2 starts the DMA stream
         wavegen.begin();
-        wavegen.setFallbackMode(true);
         // Apply defaults if user didn't set anything yet
         if (!s_wg_user_set_output) {
             jl_wavegen_set_output(1); // default DAC1
@@ -239,44 +371,95 @@ float jl_dac_get(int channel) {
 
 // ADC Functions  
 float jl_adc_get(int channel) {
+    // a script's dac_set() or connect() right before has to show up
+    settleAdcIfChanged(channel, 32);
     return readAdcVoltage(channel, 32);
 }
 
+void jl_adc_stats(void) {
+    printAdcSamplerStats(&Serial);
+}
+
 // INA Functions
 float jl_ina_get_current(int sensor) {
-    if (sensor == 0) {
-        return INA0.getCurrent();
-    } else if (sensor == 1) {
-        return INA1.getCurrent();
-    }
-    return 0.0f;
+    return inaSamplerLatest(sensor, INA_CURRENT) / 1000.0f;
 }
 
 float jl_ina_get_voltage(int sensor) {
-    if (sensor == 0) {
-        return INA0.getBusVoltage();
-    } else if (sensor == 1) {
-        return INA1.getBusVoltage();
-    }
-    return 0.0f;
+    return inaSamplerLatest(sensor, INA_BUS_VOLTAGE);
 }
 
 float jl_ina_get_bus_voltage(int sensor) {
-    if (sensor == 0) {
-        return INA0.getBusVoltage();
-    } else if (sensor == 1) {
-        return INA1.getBusVoltage();
-    }
-    return 0.0f;
+    return inaSamplerLatest(sensor, INA_BUS_VOLTAGE);
 }
 
 float jl_ina_get_power(int sensor) {
-    if (sensor == 0) {
-        return INA0.getPower();
-    } else if (sensor == 1) {
-        return INA1.getPower();
+    return inaSamplerLatest(sensor, INA_POWER) / 1000.0f;
+}
+
+// 9 floats, min/max/avg for current (A), bus voltage (V) and power (W)
+int jl_ina_window(int sensor, float* out) {
+    static const float scale[3] = {0.001f, 1.0f, 0.001f};
+    for (int q = 0; q < 3; q++) {
+        inaWindow window;
+        if (!inaSamplerWindow(sensor, q, &window)) {
+            return 0;
+        }
+        out[q * 3] = window.min * scale[q];
+        out[q * 3 + 1] = window.max * scale[q];
+        out[q * 3 + 2] = window.average * scale[q];
     }
-    return 0.0f;
+    return 1;
+}
+
+void jl_ina_stats(void) {
+    printInaSamplerStats(&Serial);
+}
+
+// Bulk sampling
+int jl_bulk_start(int source, int mask, int quantity, int volts, void* out, uint32_t rows,
+                  float rate, uint32_t* times) {
+    bulkRequest request;
+    request.source = source;
+    request.mask = mask;
+    request.quantity = quantity;
+    request.volts = volts != 0;
+    request.out = out;
+    request.rows = rows;
+    request.rateHz = rate;
+    request.times = times;
+    return bulkSamplerStart(&request);
+}
+
+// the INA cache and the wavegen are fed while it waits, like a delay
+void jl_bulk_wait(void) {
+    while (bulkSamplerBusy()) {
+        mp_hal_check_interrupt();
+        inaSamplerService();
+        waveGenFeed();
+    }
+}
+
+void jl_bulk_stop(void) {
+    bulkSamplerStop();
+}
+
+// rows, start us, interval us, late rows
+void jl_bulk_finish(uint32_t* rows, uint32_t* start_us, float* interval_us, uint32_t* late) {
+    bulkResult result;
+    bulkSamplerFinish(&result);
+    *rows = result.rows;
+    *start_us = result.startUs;
+    *interval_us = result.intervalUs;
+    *late = result.late;
+}
+
+const char* jl_bulk_error_text(int error) {
+    return bulkErrorText(error);
+}
+
+void jl_bulk_stats(void) {
+    printBulkSamplerStats(&Serial);
 }
 
 // GPIO Functions
@@ -471,6 +654,131 @@ int jl_nodes_save(int slot) {
     return target_slot;  // Return the slot that was saved to
 }
 
+// Connection batches
+//
+// Between jl_batch_begin() and jl_batch_commit() connect/disconnect only go
+// into this list. Commit applies them all to the local nodeFileString, routes
+// once, sends the crossbars what changed once and writes the slot once if
+// anything asked to be saved. Nothing is touched before the commit, so
+// aborting is just forgetting the list.
+#define JL_BATCH_MAX 256
+
+struct jlBatchOp {
+    int16_t node1;
+    int16_t node2;   // -1 with remove takes node1 off everything
+    uint8_t remove;
+};
+
+static jlBatchOp *batchOps = nullptr;
+static int batchCount = 0;
+static bool batchOpen = false;
+static bool batchSave = false;   // an op that would have saved on its own, or batch(save=True)
+static bool batchClear = false;  // nodes_clear() came first
+
+int jl_batch_begin(int save) {
+    if (batchOpen) {
+        return 0;
+    }
+    if (batchOps == nullptr) {
+        batchOps = new (std::nothrow) jlBatchOp[JL_BATCH_MAX];
+        if (batchOps == nullptr) {
+            return -1;
+        }
+    }
+    batchCount = 0;
+    batchSave = save != 0;
+    batchClear = false;
+    batchOpen = true;
+    return 1;
+}
+
+int jl_batch_active(void) {
+    return batchOpen ? 1 : 0;
+}
+
+int jl_batch_count(void) {
+    return batchOpen ? batchCount : 0;
+}
+
+// 1, 0 if the batch is full, -1 for a bad node
+int jl_batch_add(int node1, int node2, int remove, int save) {
+    if (isNodeValid(node1) != 1 || (node2 != -1 && isNodeValid(node2) != 1) ||
+        (node2 == -1 && !remove) || node1 == node2) {
+        return -1;
+    }
+    if (batchCount >= JL_BATCH_MAX) {
+        return 0;
+    }
+    batchOps[batchCount].node1 = node1;
+    batchOps[batchCount].node2 = node2;
+    batchOps[batchCount].remove = remove ? 1 : 0;
+    batchCount++;
+    if (save || remove) {
+        batchSave = true;
+    }
+    return 1;
+}
+
+void jl_batch_clear(void) {
+    batchCount = 0;
+    batchClear = true;
+    batchSave = true;
+}
+
+void jl_batch_abort(void) {
+    batchCount = 0;
+    batchClear = false;
+    batchOpen = false;
+}
+
+// ops applied, or -1 if the node file ran out of room and nothing changed
+int jl_batch_commit(int save) {
+    if (!batchOpen) {
+        return 0;
+    }
+    batchOpen = false;
+    if (batchCount == 0 && !batchClear) {
+        return 0;
+    }
+
+    char *before = new (std::nothrow) char[nodeFileString.length() + 1];
+    if (before == nullptr) {
+        jl_batch_abort();
+        return -1;
+    }
+    strcpy(before, nodeFileString.c_str());
+    nodeFileString.hasError(); // clears it
+
+    if (batchClear) {
+        nodeFileString.clear();
+        nodeFileString.concat("{ } ");
+    }
+    for (int i = 0; i < batchCount; i++) {
+        const jlBatchOp &op = batchOps[i];
+        if (op.remove) {
+            removeBridgeFromNodeFile(op.node1, op.node2, netSlot, 1);
+        } else {
+            addBridgeToNodeFile(op.node1, op.node2, netSlot, 1, 0);
+        }
+    }
+
+    int applied = batchCount;
+    if (nodeFileString.hasError()) {
+        nodeFileString.clear();
+        nodeFileString.concat(before);
+        applied = -1;
+    } else {
+        refreshLocalConnections();
+        if (save || batchSave) {
+            saveLocalNodeFile(netSlot);
+        }
+    }
+    delete[] before;
+    batchCount = 0;
+    batchClear = false;
+    return applied;
+}
+
 void jl_init_micropython_local_copy(void) {
     // Use the generalized backup system to store entry state
     storeNodeFileBackup();
@@ -479,6 +787,7 @@ void jl_init_micropython_local_copy(void) {
 void jl_exit_micropython_restore_entry_state(void) {
     // By default, restore to entry state (discard Python changes)
     // This makes Python connections temporary unless explicitly saved
+    jl_batch_abort();
     restoreAndSaveNodeFileBackup();
     
     // Refresh connections to match the restored state
@@ -487,6 +796,7 @@ void jl_exit_micropython_restore_entry_state(void) {
 
 void jl_restore_micropython_entry_state(void) {
     // Use the generalized backup system to restore entry state
+    jl_batch_abort();
     restoreAndSaveNodeFileBackup();
     
     // Refresh connections to match the restored state
@@ -666,6 +976,29 @@ bool jl_la_get_control_digital(int channel) {
    return false;
 }
 
+// bytes written, -1 if the file couldn't be written, -2 if a capture is going
+int jl_la_capture_file(const char* path) {
+    if (logicAnalyzer.getIsRunning()) return -2;
+    if (path == nullptr || path[0] == 0 || !logicAnalyzer.set_capture_file(path)) return -1;
+    bool ok = logicAnalyzer.arm();
+    if (ok) {
+        logicAnalyzer.run();
+        ok = logicAnalyzer.last_capture_ok();
+    } else {
+        logicAnalyzer.stop();
+    }
+    logicAnalyzer.set_capture_file(nullptr);
+    return ok ? (int)logicAnalyzer.last_capture_bytes() : -1;
+}
+
+int jl_la_file_bench(int kbytes) {
+    return (int)captureFileBenchmark(&Serial, "la_bench.tmp", (uint32_t)kbytes * 1024);
+}
+
+void jl_la_file_stats(void) {
+    printCaptureFileStats(&Serial);
+}
+
 // OLED Functions
 int jl_oled_print(const char* text, int size) {
     mp_hal_check_interrupt();
@@ -709,6 +1042,55 @@ void jl_arduino_reset(void) {
     resetArduino();
 }
 
+void jl_command_cache_stats(void) {
+    printCommandCacheStats(&Serial);
+}
+
+int jl_run_script(const char* name) {
+    return scriptCacheRunFile(name, true) ? 1 : 0;
+}
+
+int jl_script_cache_warm(void) {
+    return scriptCacheWarm();
+}
+
+void jl_script_cache_stats(void) {
+    printScriptCacheStats(&Serial);
+}
+
+// Event Functions
+void jl_event_enable(int source, int on) {
+    eventEnable(source, on != 0);
+}
+
+int jl_event_gpio_watch(int pin, int on) {
+    return eventGpioWatch(pin, on != 0) ? 1 : 0;
+}
+
+int jl_event_pop(int* source, int* index, int* value, uint32_t* time_us) {
+    jlEvent event;
+    if (!eventPop(&event)) {
+        return 0;
+    }
+    *source = event.source;
+    *index = event.index;
+    *value = event.value;
+    *time_us = event.timeUs;
+    return 1;
+}
+
+int jl_event_pending(void) {
+    return eventPending();
+}
+
+void jl_event_clear(void) {
+    eventClear();
+}
+
+void jl_event_stats(void) {
+    printEventStats(&Serial);
+}
+
 // Status Functions
 int jl_nodes_print_bridges(void) {
     printPathsCompact();
@@ -808,6 +1190,10 @@ extern "C" int jl_pwm_stop(int gpio_pin) {
     return stopPWM(gpio_pin);
 }
 
+extern "C" int jl_pwm_sync(int pins) {
+    return syncPWM((uint8_t)pins);
+}
+
 // Filesystem Functions
 int jl_fs_exists(const char* path) {
     if (!path) return 0;
@@ -986,4 +1372,142 @@ int jl_fs_used_bytes(void) {
     return -1;
 }
 
+// Animation Functions
+int jl_animation_create(const uint32_t* colors, int num_colors, int period_ms, int mode, int length) {
+    return animationCreate(colors, num_colors, period_ms, mode, length);
+}
+
+// the first ANIMATION_ROW_SLOTS belong to the row animations, scripts only
+// get to touch the ones animation_create() gave them
+static bool scriptAnimation(int id) {
+    return id >= ANIMATION_ROW_SLOTS && id < MAX_KEYFRAME_ANIMATIONS;
+}
+
+int jl_animation_play(int id, int node, int spread) {
+    if (!scriptAnimation(id) || keyframeAnimations[id].allocated == 0) {
+        return 0;
+    }
+    animationSetTarget(id, node, spread);
+    animationStart(id, 0);
+    showLEDsCore2 = 1;
+    return 1;
+}
+
+void jl_animation_stop(int id) {
+    if (!scriptAnimation(id)) {
+        return;
+    }
+    animationStop(id);
+    showLEDsCore2 = 1;
+}
+
+void jl_animation_delete(int id) {
+    if (!scriptAnimation(id)) {
+        return;
+    }
+    animationDelete(id);
+    showLEDsCore2 = 1;
+}
+
+void jl_animation_set_period(int id, int period_ms) {
+    if (!scriptAnimation(id)) {
+        return;
+    }
+    animationSetPeriod(id, period_ms);
+}
+
+void jl_animation_stats(void) {
+    printAnimationStats(&Serial);
+}
+
+int jl_animation_play_file(const char* path, int loops, int brightness) {
+    return playLEDAsset(path, loops, brightness, &Serial);
+}
+
+// -1 bad pins or rate, -2 no free slot
+int jl_decoder_add(int protocol, const int* pins, int num_pins, int rate, int mode) {
+    uint8_t channels[4] = {PROTOCOL_PIN_UNUSED, PROTOCOL_PIN_UNUSED,
+                           PROTOCOL_PIN_UNUSED, PROTOCOL_PIN_UNUSED};
+    for (int i = 0; i < num_pins && i < 4; i++) {
+        if (pins[i] >= 0) {
+            channels[i] = pins[i] > 7 ? 8 : (uint8_t)pins[i];
+        }
+    }
+    bool room = false;
+    for (int i = 0; i < MAX_PROTOCOL_DECODERS; i++) {
+        room |= protocolDecoders[i].protocol == PROTOCOL_NONE;
+    }
+    if (!room) {
+        return -2;
+    }
+    return protocolDecoderSet(-1, protocol, channels, rate, mode);
+}
+
+void jl_decoder_remove(int slot) {
+    protocolDecoderClear(slot);
+}
+
+// two words per event: sample, then slot | type << 8 | data << 16
+int jl_decoder_read(uint32_t* out, int max) {
+    protocolEvent events[16];
+    int total = 0;
+    while (total < max) {
+        int want = max - total < 16 ? max - total : 16;
+        int n = protocolDecodeRead(events, want);
+        for (int i = 0; i < n; i++) {
+            out[2 * (total + i)] = events[i].sample;
+            out[2 * (total + i) + 1] = events[i].decoder | (events[i].type << 8) |
+                                       ((uint32_t)events[i].data << 16);
+        }
+        total += n;
+        if (n < want) {
+            break;
+        }
+    }
+    return total;
+}
+
+int jl_decoder_feed(const uint8_t* samples, int count, int sample_rate) {
+    protocolDecodeBegin(sample_rate);
+    protocolDecodeFeed(samples, count);
+    return protocolDecodePending();
+}
+
+void jl_decoder_stats(uint32_t* out) {
+    out[0] = protocolDecodeStats.sampleRate;
+    out[1] = protocolDecodeStats.samples;
+    out[2] = protocolDecodeStats.events;
+    out[3] = protocolDecodeStats.dropped;
+}
+
+// record size, -1 for a bad mask or rate
+int jl_telemetry_start(uint32_t mask, int rate) {
+    if (!telemetryStart(mask, rate, TELEMETRY_OWNER_PYTHON)) {
+        return -1;
+    }
+    return telemetryRecordSize();
+}
+
+void jl_telemetry_stop(void) {
+    telemetryStop();
+}
+
+// nothing if the host has the stream, it'd be taking records out from under it
+int jl_telemetry_read(uint8_t* out, int max_bytes) {
+    if (telemetryOwnedBy() != TELEMETRY_OWNER_PYTHON) {
+        return 0;
+    }
+    inaSamplerService();
+    return telemetryRead(out, max_bytes);
+}
+
+void jl_telemetry_info(uint32_t* out) {
+    out[0] = telemetryMask();
+    out[1] = telemetryRate();
+    out[2] = telemetryRecordSize();
+    out[3] = telemetryPending() / telemetryRecordSize();
+    out[4] = telemetryStats.records;
+    out[5] = telemetryStats.dropped;
+}
+
 } // extern "C" 
\ No newline at end of file
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: MIT
+#include "LEDAssets.h"
+#include "Commands.h"
+#include "LEDs.h"
+
+static bool refill(ledAssetPlayer *player) {
+  player->bufferLength = player->file.read(player->buffer, LED_ASSET_BUFFER_SIZE);
+  player->bufferPos = 0;
+  return player->bufferLength > 0;
+}
+
+static inline int readByte(ledAssetPlayer *player) {
+  if (player->bufferPos >= player->bufferLength && !refill(player)) {
+    return -1;
+  }
+  return player->buffer[player->bufferPos++];
+}
+
+static inline bool readColor(ledAssetPlayer *player, uint32_t *color) {
+  int r = readByte(player);
+  int g = readByte(player);
+  int b = readByte(player);
+  if (b < 0) {
+    return false;
+  }
+  *color = ((uint32_t)r << 16) | ((uint32_t)g << 8) | (uint32_t)b;
+  return true;
+}
+
+static inline uint16_t get16(const uint8_t *in) { return in[0] | (in[1] << 8); }
+
+bool ledAssetOpen(ledAssetPlayer *player, const char *path) {
+  player->file = FatFS.open(path, "r");
+  if (!player->file) {
+    return false;
+  }
+
+  uint8_t header[LED_ASSET_HEADER_SIZE];
+  if (player->file.read(header, sizeof(header)) != sizeof(header) ||
+      memcmp(header, "JLA1", 4) != 0) {
+    player->file.close();
+    return false;
+  }
+
+  player->pixels = get16(header + 4);
+  player->frames = get16(header + 6);
+  player->frameMs = get16(header + 8);
+  if (player->pixels > LED_ASSET_MAX_PIXELS) {
+    player->pixels = LED_ASSET_MAX_PIXELS;
+  }
+
+  player->frame = 0;
+  player->bufferLength = 0;
+  player->bufferPos = 0;
+  player->lastDecodeUs = 0;
+  player->maxDecodeUs = 0;
+  player->totalDecodeUs = 0;
+  player->decodedFrames = 0;
+  return true;
+}
+
+void ledAssetRewind(ledAssetPlayer *player) {
+  player->file.seek(LED_ASSET_HEADER_SIZE);
+  player->frame = 0;
+  player->bufferLength = 0;
+  player->bufferPos = 0;
+}
+
+/// decodes the next frame into the LEDs, returns how long it should stay up
+/// in ms or -1 at the end of the file (or if it's broken)
+int ledAssetDecodeFrame(ledAssetPlayer *player, int brightness) {
+  if (player->frame >= player->frames) {
+    return -1;
+  }
+  unsigned long start = micros();
+
+  uint8_t frameHeader[LED_ASSET_FRAME_HEADER_SIZE];
+  for (int i = 0; i < LED_ASSET_FRAME_HEADER_SIZE; i++) {
+    int c = readByte(player);
+    if (c < 0) {
+      return -1;
+    }
+    frameHeader[i] = c;
+  }
+  int remaining = get16(frameHeader);
+  int duration = get16(frameHeader + 2);
+  bool keyframe = frameHeader[4] == LED_ASSET_KEYFRAME;
+
+  int pixel = 0;
+  while (remaining > 0) {
+    int op = readByte(player);
+    if (op < 0) {
+      return -1;
+    }
+    remaining--;
+
+    if (op < 0x80) {
+      int count = op + 1;
+      if (keyframe == true) {
+        for (int i = 0; i < count && pixel + i < player->pixels; i++) {
+          leds.setPixelColor(pixel + i, 0);
+        }
+      }
+      pixel += count;
+    } else if (op < 0xc0) {
+      uint32_t color;
+      if (!readColor(player, &color)) {
+        return -1;
+      }
+      remaining -= 3;
+      if (brightness != 0) {
+        color = scaleBrightness(color, brightness);
+      }
+      int count = (op & 0x3f) + 1;
+      for (int i = 0; i < count && pixel < player->pixels; i++) {
+        leds.setPixelColor(pixel++, color);
+      }
+    } else {
+      int count = (op & 0x3f) + 1;
+      for (int i = 0; i < count; i++) {
+        uint32_t color;
+        if (!readColor(player, &color)) {
+          return -1;
+        }
+        if (brightness != 0) {
+          color = scaleBrightness(color, brightness);
+        }
+        if (pixel < player->pixels) {
+          leds.setPixelColor(pixel, color);
+        }
+        pixel++;
+      }
+      remaining -= count * 3;
+    }
+  }
+
+  // a keyframe that stops early leaves the rest black
+  if (keyframe == true) {
+    for (; pixel < player->pixels; pixel++) {
+      leds.setPixelColor(pixel, 0);
+    }
+  }
+
+  player->frame++;
+  player->lastDecodeUs = micros() - start;
+  player->totalDecodeUs += player->lastDecodeUs;
+  player->decodedFrames++;
+  if (player->lastDecodeUs > player->maxDecodeUs) {
+    player->maxDecodeUs = player->lastDecodeUs;
+  }
+
+  return duration > 0 ? duration : player->frameMs;
+}
+
+void ledAssetClose(ledAssetPlayer *player) {
+  if (player->file) {
+    player->file.close();
+  }
+}
+
+// "boot" and "boot.jla" are under LED_ASSET_DIRECTORY, "/x/boot.jla" is as it is
+static bool ledAssetPath(const char *name, char *path, size_t size) {
+  const char *dir = name[0] == '/' ? "" : LED_ASSET_DIRECTORY "/";
+  const char *ext = strchr(name, '.') != nullptr ? "" : ".jla";
+  if (strlen(dir) + strlen(name) + strlen(ext) + 1 > size) {
+    return false;
+  }
+  strcpy(path, dir);
+  strcat(path, name);
+  strcat(path, ext);
+  return true;
+}
+
+/// blocking, like drawAnimatedImage(). Returns the number of frames shown
+/// or -1 if the file couldn't be opened
+int playLEDAsset(const char *name, int loops, int brightness, Stream *report) {
+  static ledAssetPlayer player;
+  char path[LED_ASSET_PATH_MAX];
+
+  if (!ledAssetPath(name, path, sizeof(path)) || !ledAssetOpen(&player, path)) {
+    if (report != nullptr) {
+      report->printf("Couldn't open %s as an LED asset\n\r", name);
+    }
+    return -1;
+  }
+
+  if (loops < 1) {
+    loops = 1;
+  }
+
+  showLEDsCore2 = -3;
+  leds.clear();
+
+  for (int loop = 0; loop < loops; loop++) {
+    if (loop > 0) {
+      ledAssetRewind(&player);
+    }
+    while (true) {
+      unsigned long frameStart = millis();
+      int duration = ledAssetDecodeFrame(&player, brightness);
+      if (duration < 0) {
+        break;
+      }
+      leds.show();
+      while (millis() - frameStart < (unsigned long)duration) {
+        delayMicroseconds(100);
+      }
+    }
+  }
+
+  if (report != nullptr && player.decodedFrames > 0) {
+    report->printf("%s: %lu frames, decode %lu us/frame avg, %lu us max\n\r",
+                   path, player.decodedFrames,
+                   player.totalDecodeUs / player.decodedFrames,
+                   player.maxDecodeUs);
+  }
+
+  int shown = player.decodedFrames;
+  ledAssetClose(&player);
+  showLEDsCore2 = -1;
+  return shown;
+}
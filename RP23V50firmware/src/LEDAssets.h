@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+#ifndef LEDASSETS_H
+#define LEDASSETS_H
+
+#include <Arduino.h>
+#include <FatFS.h>
+
+// Compressed LED images and animations on the FatFS partition (.jla)
+//
+// Frames are decoded straight into the LED framebuffer through a small read
+// buffer, so an animation costs the same RAM whether it's one frame or five
+// hundred. scripts/led_asset_encoder.py makes them from PNGs, JSON or the
+// arrays in Images.h.
+//
+// The startup animation stays on the Images.h arrays (drawAnimatedImage()).
+// It has to play on a board whose filesystem is empty or was just formatted,
+// and its logo, rail and ADC/DAC LEDs are worked out per frame from
+// cycleCount rather than stored, which a .jla would bake in. The arrays sit in
+// flash and cost no RAM either way. The encoder's --images-h output is there
+// for anyone who wants it from the filesystem instead.
+//
+// header (16 bytes, little endian)
+//   "JLA1"  u16 pixels  u16 frames  u16 frameMs  u16 flags  u32 reserved
+// frame
+//   u16 length  u16 durationMs (0 = frameMs)  u8 type  length bytes of ops
+//   type 0 is a keyframe (skipped pixels go black), 1 is a delta (skipped
+//   pixels keep whatever the last frame left there)
+// ops
+//   0x00-0x7f  skip n + 1 pixels
+//   0x80-0xbf  (n & 0x3f) + 1 pixels of the RGB that follows
+//   0xc0-0xff  (n & 0x3f) + 1 RGB triples follow
+
+#define LED_ASSET_DIRECTORY "/images" // where playLEDAsset() looks for a bare name
+#define LED_ASSET_PATH_MAX 96
+#define LED_ASSET_HEADER_SIZE 16
+#define LED_ASSET_FRAME_HEADER_SIZE 5
+#define LED_ASSET_BUFFER_SIZE 64
+#define LED_ASSET_MAX_PIXELS 445
+
+#define LED_ASSET_KEYFRAME 0
+#define LED_ASSET_DELTA 1
+
+struct ledAssetPlayer {
+  File file;
+  uint16_t pixels = 0;
+  uint16_t frames = 0;
+  uint16_t frameMs = 0;
+  int frame = 0; // next frame to decode
+
+  uint8_t buffer[LED_ASSET_BUFFER_SIZE];
+  int bufferLength = 0;
+  int bufferPos = 0;
+
+  uint32_t lastDecodeUs = 0;
+  uint32_t maxDecodeUs = 0;
+  uint32_t totalDecodeUs = 0;
+  uint32_t decodedFrames = 0;
+};
+
+bool ledAssetOpen(ledAssetPlayer *player, const char *path);
+void ledAssetRewind(ledAssetPlayer *player);
+int ledAssetDecodeFrame(ledAssetPlayer *player, int brightness = 0);
+void ledAssetClose(ledAssetPlayer *player);
+
+/// name is a path, or "boot" / "boot.jla" for LED_ASSET_DIRECTORY/boot.jla
+int playLEDAsset(const char *name, int loops = 1, int brightness = 0,
+                 Stream *report = &Serial);
+
+#endif
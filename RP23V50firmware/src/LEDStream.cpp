@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: MIT
+#include "LEDStream.h"
+#include "ArduinoStuff.h"
+#include "BinaryStream.h"
+#include "Graphics.h"
+#include "LEDs.h"
+#include "config.h"
+
+ledStreamStatistics ledStreamStats = {0, 0, 0, 0, 0, 0};
+
+// what the host has (ledStreamSent) and what the LEDs show now
+static uint8_t ledStreamCurrent[LED_STREAM_PIXELS * 3];
+static uint8_t ledStreamSent[LED_STREAM_PIXELS * 3];
+static uint8_t ledStreamPayload[2 + LED_STREAM_PIXELS * 3];
+
+static Adafruit_USBD_CDC *ledStreamLastPort = nullptr;
+static bool streaming = false;
+static bool pullMode = false;
+static uint16_t credits = 0;
+static uint16_t frameIntervalMs = 20;
+static unsigned long lastFrameTime = 0;
+static unsigned long lastCaptureTime = 0;
+static bool needKeyframe = true;
+static int framesSinceKeyframe = 0;
+static uint16_t frameSeq = 0;
+
+// command parser state, 'S' and 'C' take arguments
+static char pendingCommand = 0;
+static uint8_t pendingArgs[2];
+static int pendingArgCount = 0;
+
+static Adafruit_USBD_CDC *ledStreamCdc(void) {
+  if (jumperlessConfig.display.dump_format != DUMP_FORMAT_BINARY) {
+    return nullptr;
+  }
+  if (jumperlessConfig.serial_2.function == 5 ||
+      jumperlessConfig.serial_2.function == 6) {
+    return &USBSer2;
+  }
+  if (jumperlessConfig.serial_1.function == 5 ||
+      jumperlessConfig.serial_1.function == 6) {
+    return &USBSer1;
+  }
+  return nullptr;
+}
+
+Stream *ledStreamPort(void) { return ledStreamCdc(); }
+
+void ledStreamReset(void) {
+  streaming = false;
+  pullMode = false;
+  credits = 0;
+  needKeyframe = true;
+  framesSinceKeyframe = 0;
+  pendingCommand = 0;
+  pendingArgCount = 0;
+}
+
+static inline void put16(uint8_t *out, uint16_t value) {
+  out[0] = value & 0xff;
+  out[1] = value >> 8;
+}
+
+static inline void put32(uint8_t *out, uint32_t value) {
+  out[0] = value & 0xff;
+  out[1] = (value >> 8) & 0xff;
+  out[2] = (value >> 16) & 0xff;
+  out[3] = value >> 24;
+}
+
+static void ledStreamSendInfo(Stream *port) {
+  uint8_t info[27];
+  info[0] = LED_STREAM_VERSION;
+  put16(info + 1, LED_STREAM_PIXELS);
+  put16(info + 3, LED_STREAM_KEYFRAME_INTERVAL);
+  put16(info + 5, frameIntervalMs);
+  put32(info + 7, ledStreamStats.frames);
+  put32(info + 11, ledStreamStats.keyframes);
+  put32(info + 15, ledStreamStats.bytes);
+  put32(info + 19, ledStreamStats.dropped);
+  put32(info + 23, ledStreamStats.lastEncodeUs);
+  writeBinaryFrame(port, BINARY_STREAM_LEDS, LED_STREAM_INFO, frameSeq, info,
+                   sizeof(info));
+}
+
+static void runCommand(Stream *port, char command) {
+  switch (command) {
+  case 'S':
+    frameIntervalMs = pendingArgs[0] | (pendingArgs[1] << 8);
+    streaming = true;
+    pullMode = false;
+    needKeyframe = true;
+    break;
+  case 'C':
+    if (pullMode == false || streaming == false) {
+      needKeyframe = true;
+    }
+    streaming = true;
+    pullMode = true;
+    if (credits < 60000) {
+      credits += pendingArgs[0];
+    }
+    break;
+  case 'K':
+    needKeyframe = true;
+    break;
+  case 'I':
+    ledStreamSendInfo(port);
+    break;
+  case 'X':
+    streaming = false;
+    break;
+  }
+}
+
+static void handleCommands(Stream *port) {
+  for (int i = 0; i < 16 && port->available() > 0; i++) {
+    uint8_t c = port->read();
+
+    if (pendingCommand != 0) {
+      pendingArgs[pendingArgCount++] = c;
+      int needed = (pendingCommand == 'S') ? 2 : 1;
+      if (pendingArgCount >= needed) {
+        runCommand(port, pendingCommand);
+        pendingCommand = 0;
+      }
+      continue;
+    }
+
+    if (c == 'S' || c == 'C') {
+      pendingCommand = c;
+      pendingArgCount = 0;
+    } else {
+      runCommand(port, c);
+    }
+  }
+}
+
+static inline bool pixelChanged(int pixel) {
+  const uint8_t *a = ledStreamCurrent + pixel * 3;
+  const uint8_t *b = ledStreamSent + pixel * 3;
+  return a[0] != b[0] || a[1] != b[1] || a[2] != b[2];
+}
+
+static int encodeKeyframe(void) {
+  put16(ledStreamPayload, LED_STREAM_PIXELS);
+  memcpy(ledStreamPayload + 2, ledStreamCurrent, sizeof(ledStreamCurrent));
+  return 2 + sizeof(ledStreamCurrent);
+}
+
+// runs of changed pixels, a single unchanged pixel between two changed ones
+// costs the same 3 bytes as a new run header so it gets folded in. Returns -1
+// if the delta wouldn't be smaller than a keyframe
+static int encodeDelta(void) {
+  const int keyframeSize = 2 + sizeof(ledStreamCurrent);
+  int length = 0;
+  int pixel = 0;
+
+  while (pixel < LED_STREAM_PIXELS) {
+    if (!pixelChanged(pixel)) {
+      pixel++;
+      continue;
+    }
+
+    int start = pixel;
+    int end = pixel + 1;
+    while (end < LED_STREAM_PIXELS && end - start < 255) {
+      if (pixelChanged(end)) {
+        end++;
+      } else if (end + 1 < LED_STREAM_PIXELS && end + 2 - start <= 255 &&
+                 pixelChanged(end + 1)) {
+        end += 2;
+      } else {
+        break;
+      }
+    }
+
+    int count = end - start;
+    if (length + 3 + count * 3 >= keyframeSize) {
+      return -1;
+    }
+    put16(ledStreamPayload + length, start);
+    ledStreamPayload[length + 2] = count;
+    memcpy(ledStreamPayload + length + 3, ledStreamCurrent + start * 3,
+           count * 3);
+    length += 3 + count * 3;
+    pixel = end;
+  }
+  return length;
+}
+
+/// called from loop1() in place of dumpLEDs() when dump_format is binary
+void ledStreamService(void) {
+  Adafruit_USBD_CDC *port = ledStreamCdc();
+
+  if (port != ledStreamLastPort) {
+    ledStreamReset();
+    ledStreamLastPort = port;
+  }
+  if (port == nullptr) {
+    return;
+  }
+  if (!port->dtr()) {
+    if (streaming == true) {
+      ledStreamReset();
+    }
+    return;
+  }
+
+  handleCommands(port);
+
+  if (streaming == false || (pullMode == true && credits == 0)) {
+    return;
+  }
+  if (millis() - lastFrameTime < frameIntervalMs ||
+      millis() - lastCaptureTime < 2) {
+    return; // the LEDs don't update faster than this anyway
+  }
+  if (port->availableForWrite() < 64) {
+    return; // host isn't keeping up, let it drain instead of blocking core 2
+  }
+
+  if (logoLedAccess == true) {
+    return;
+  }
+  logoLedAccess = true;
+  lastCaptureTime = millis();
+
+  unsigned long encodeStart = micros();
+  for (int i = 0; i < LED_STREAM_PIXELS; i++) {
+    uint32_t color = leds.getPixelColor(i);
+    ledStreamCurrent[i * 3] = (color >> 16) & 0xff;
+    ledStreamCurrent[i * 3 + 1] = (color >> 8) & 0xff;
+    ledStreamCurrent[i * 3 + 2] = color & 0xff;
+  }
+  logoLedAccess = false;
+
+  uint8_t type = LED_STREAM_DELTA;
+  int length = -1;
+  if (needKeyframe == false &&
+      framesSinceKeyframe < LED_STREAM_KEYFRAME_INTERVAL) {
+    length = encodeDelta();
+  }
+  if (length < 0) {
+    type = LED_STREAM_KEYFRAME;
+    length = encodeKeyframe();
+  }
+
+  ledStreamStats.lastEncodeUs = micros() - encodeStart;
+  if (ledStreamStats.lastEncodeUs > ledStreamStats.maxEncodeUs) {
+    ledStreamStats.maxEncodeUs = ledStreamStats.lastEncodeUs;
+  }
+
+  // nothing changed, only send the empty delta now and then as a heartbeat
+  if (length == 0 && millis() - lastFrameTime < 500) {
+    return;
+  }
+  lastFrameTime = millis();
+
+  if (writeBinaryFrame(port, BINARY_STREAM_LEDS, type, frameSeq,
+                       ledStreamPayload, length)) {
+    memcpy(ledStreamSent, ledStreamCurrent, sizeof(ledStreamSent));
+    ledStreamStats.frames++;
+    ledStreamStats.bytes += length + BINARY_FRAME_OVERHEAD;
+    if (type == LED_STREAM_KEYFRAME) {
+      ledStreamStats.keyframes++;
+      framesSinceKeyframe = 0;
+      needKeyframe = false;
+    } else {
+      framesSinceKeyframe++;
+    }
+    if (pullMode == true) {
+      credits--;
+    }
+  } else {
+    // the host got a partial frame, so it can't be trusted to have the last
+    // full one either
+    ledStreamStats.dropped++;
+    needKeyframe = true;
+  }
+  frameSeq++;
+}
+
+void printLEDStreamStats(Stream *stream) {
+  stream->printf("LED stream: %lu frames (%lu keyframes), %lu dropped\n\r",
+                 ledStreamStats.frames, ledStreamStats.keyframes,
+                 ledStreamStats.dropped);
+  stream->printf("%lu bytes sent", ledStreamStats.bytes);
+  if (ledStreamStats.frames > 0) {
+    stream->printf(", %lu bytes/frame",
+                   ledStreamStats.bytes / ledStreamStats.frames);
+  }
+  stream->printf("\n\rencode: %lu us (max %lu us)\n\r",
+                 ledStreamStats.lastEncodeUs, ledStreamStats.maxEncodeUs);
+}
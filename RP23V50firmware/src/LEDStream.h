@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: MIT
+#ifndef LEDSTREAM_H
+#define LEDSTREAM_H
+
+#include <Arduino.h>
+
+// Binary LED mirror for host-side visualizers (dump_format = binary)
+//
+// Frames use the BinaryStream framing with stream id 'L'. A keyframe carries
+// every LED, a delta carries runs of LEDs that changed since the last frame
+// the host was sent. The host drives it with single byte commands on the same
+// CDC port:
+//
+//   'S' lo hi   stream continuously, at most one frame every (hi<<8|lo) ms
+//   'C' n       pull mode, send up to n more frames then wait
+//   'K'         make the next frame a keyframe
+//   'I'         send an info frame
+//   'X'         stop
+//
+// scripts/led_stream.py is the reference decoder and benchmark.
+
+// display.dump_format value that selects this instead of the ANSI dump
+#define DUMP_FORMAT_BINARY 3
+
+#define LED_STREAM_VERSION 1
+#define LED_STREAM_PIXELS 445
+
+#define LED_STREAM_KEYFRAME 0 // u16 count, count * RGB
+#define LED_STREAM_DELTA 1    // repeated: u16 first, u8 count, count * RGB
+#define LED_STREAM_INFO 2     // see ledStreamSendInfo()
+
+// a keyframe goes out at least this often so a host that joins late or drops
+// a frame doesn't have to ask
+#define LED_STREAM_KEYFRAME_INTERVAL 100
+
+struct ledStreamStatistics {
+  uint32_t frames;
+  uint32_t keyframes;
+  uint32_t bytes;
+  uint32_t dropped;
+  uint32_t lastEncodeUs;
+  uint32_t maxEncodeUs;
+};
+
+extern ledStreamStatistics ledStreamStats;
+
+Stream *ledStreamPort(void);
+void ledStreamService(void);
+void ledStreamReset(void);
+void printLEDStreamStats(Stream *stream = &Serial);
+
+#endif
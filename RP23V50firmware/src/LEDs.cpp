@@ -3280,6 +3280,8 @@ uint8_t eightSelectHues[LOGO_COLOR_LENGTH + 11] = {
     27,  23,  19,  16,  13,  10,  7,   4,   3,   2,   1,   0,   254, 253, 251,
     248, 242, 236, 230, 224, 218, 212, 207, 202, 199, 197 };
 
+uint32_t logoSwirlTables[LOGO_SWIRL_PALETTES][LOGO_COLOR_LENGTH];
+
 void setupSwirlColors(void) {
   rgbColor logoColorsRGB[LOGO_COLOR_LENGTH + 12];
   int fudgeMult = 1;
@@ -3377,6 +3379,17 @@ void setupSwirlColors(void) {
     //  logoColors8vSelect[LOGO_COLOR_LENGTH - i] =   logoColors8vSelect[i];
     }
 
+  // dimLogoColor() does an HSV round trip per LED, so do it once per palette
+  // entry here instead of 8 times every swirl frame
+  for (int i = 0; i < LOGO_COLOR_LENGTH; i++) {
+    logoSwirlTables[LOGO_SWIRL_RAINBOW][i] = dimLogoColor(logoColors[i]);
+    logoSwirlTables[LOGO_SWIRL_COLD][i] = dimLogoColor(logoColorsCold[i]);
+    logoSwirlTables[LOGO_SWIRL_HOT][i] = dimLogoColor(logoColorsHot[i]);
+    logoSwirlTables[LOGO_SWIRL_PINK][i] = dimLogoColor(logoColorsPink[i]);
+    logoSwirlTables[LOGO_SWIRL_PINK_SELECTED][i] =
+        dimLogoColor(logoColorsPink[i], 33);
+    }
+
 
   }
 
@@ -3395,139 +3408,29 @@ if (logoLedAccess == true) {
 }
 logoLedAccess = true;
 
-  if (probe == 1) {
-    int selectionBrightness = 33;
-
+  // palettes are pre-dimmed in setupSwirlColors(), this is just table lookups
+  const uint32_t *firstPalette = logoSwirlTables[LOGO_SWIRL_RAINBOW];
+  const uint32_t *palette = logoSwirlTables[LOGO_SWIRL_RAINBOW];
 
+  if (probe == 1) {
     if (connectOrClearProbe == 1 && node1or2 == 0) {
       // Serial.println("connectOrClearProbe == 1 && node1or2 == 0");
-
-      leds.setPixelColor(
-          LOGO_LED_START, dimLogoColor(logoColorsCold[start % (LOGO_COLOR_LENGTH - 1)]));
-      leds.setPixelColor(
-          LOGO_LED_START + 1,
-          dimLogoColor(
-            logoColorsCold[(start + (spread)) % (LOGO_COLOR_LENGTH - 1)]));
-      leds.setPixelColor(LOGO_LED_START + 2,
-                         dimLogoColor(logoColorsCold[(start + (spread * 2)) %
-                                      (LOGO_COLOR_LENGTH - 1)]));
-      leds.setPixelColor(LOGO_LED_START + 3,
-                         dimLogoColor(logoColorsCold[(start + (spread * 3)) %
-                                      (LOGO_COLOR_LENGTH - 1)]));
-      leds.setPixelColor(LOGO_LED_START + 4,
-                         dimLogoColor(logoColorsCold[(start + (spread * 4)) %
-                                      (LOGO_COLOR_LENGTH - 1)]));
-      leds.setPixelColor(LOGO_LED_START + 5,
-                         dimLogoColor(logoColorsCold[(start + (spread * 5)) %
-                                      (LOGO_COLOR_LENGTH - 1)]));
-      leds.setPixelColor(LOGO_LED_START + 6,
-                         dimLogoColor(logoColorsCold[(start + (spread * 6)) %
-                                      (LOGO_COLOR_LENGTH - 1)]));
-      leds.setPixelColor(LOGO_LED_START + 7,
-                         dimLogoColor(logoColorsCold[(start + (spread * 7)) %
-                                      (LOGO_COLOR_LENGTH - 1)]));
+      firstPalette = logoSwirlTables[LOGO_SWIRL_COLD];
+      palette = logoSwirlTables[LOGO_SWIRL_COLD];
       } else if (connectOrClearProbe == 1 && node1or2 != 0) {
-        leds.setPixelColor(
-            LOGO_LED_START, dimLogoColor(logoColorsPink[start % (LOGO_COLOR_LENGTH - 1)]));
-        leds.setPixelColor(
-            LOGO_LED_START + 1, dimLogoColor(
-              logoColorsPink[(start + (spread)) % (LOGO_COLOR_LENGTH - 1)],
-              selectionBrightness));
-        leds.setPixelColor(
-            LOGO_LED_START + 2,
-            dimLogoColor(
-              logoColorsPink[(start + (spread * 2)) % (LOGO_COLOR_LENGTH - 1)],
-              selectionBrightness));
-        leds.setPixelColor(
-            LOGO_LED_START + 3,
-            dimLogoColor(
-              logoColorsPink[(start + (spread * 3)) % (LOGO_COLOR_LENGTH - 1)],
-              selectionBrightness));
-        leds.setPixelColor(
-            LOGO_LED_START + 4,
-            dimLogoColor(
-              logoColorsPink[(start + (spread * 4)) % (LOGO_COLOR_LENGTH - 1)],
-              selectionBrightness));
-        leds.setPixelColor(
-            LOGO_LED_START + 5,
-            dimLogoColor(
-              logoColorsPink[(start + (spread * 5)) % (LOGO_COLOR_LENGTH - 1)],
-              selectionBrightness));
-        leds.setPixelColor(
-            LOGO_LED_START + 6,
-            dimLogoColor(
-              logoColorsPink[(start + (spread * 6)) % (LOGO_COLOR_LENGTH - 1)],
-              selectionBrightness));
-        leds.setPixelColor(
-            LOGO_LED_START + 7,
-            dimLogoColor(
-              logoColorsPink[(start + (spread * 7)) % (LOGO_COLOR_LENGTH - 1)],
-              selectionBrightness));
-
+        firstPalette = logoSwirlTables[LOGO_SWIRL_PINK];
+        palette = logoSwirlTables[LOGO_SWIRL_PINK_SELECTED];
         } else {
-
-
-        leds.setPixelColor(
-            LOGO_LED_START, dimLogoColor(logoColorsHot[start % (LOGO_COLOR_LENGTH - 1)]));
-        leds.setPixelColor(
-            LOGO_LED_START + 1,
-            dimLogoColor(
-              logoColorsHot[(start + (spread)) % (LOGO_COLOR_LENGTH - 1)]));
-        leds.setPixelColor(
-            LOGO_LED_START + 2,
-            dimLogoColor(
-              logoColorsHot[(start + (spread * 2)) % (LOGO_COLOR_LENGTH - 1)]));
-        leds.setPixelColor(
-            LOGO_LED_START + 3,
-            dimLogoColor(
-              logoColorsHot[(start + (spread * 3)) % (LOGO_COLOR_LENGTH - 1)]));
-        leds.setPixelColor(
-            LOGO_LED_START + 4,
-            dimLogoColor(
-              logoColorsHot[(start + (spread * 4)) % (LOGO_COLOR_LENGTH - 1)]));
-        leds.setPixelColor(
-            LOGO_LED_START + 5,
-            dimLogoColor(
-              logoColorsHot[(start + (spread * 5)) % (LOGO_COLOR_LENGTH - 1)]));
-        leds.setPixelColor(
-            LOGO_LED_START + 6,
-            dimLogoColor(
-              logoColorsHot[(start + (spread * 6)) % (LOGO_COLOR_LENGTH - 1)]));
-        leds.setPixelColor(
-            LOGO_LED_START + 7,
-            dimLogoColor(
-              logoColorsHot[(start + (spread * 7)) % (LOGO_COLOR_LENGTH - 1)]));
+        firstPalette = logoSwirlTables[LOGO_SWIRL_HOT];
+        palette = logoSwirlTables[LOGO_SWIRL_HOT];
         }
+    }
 
-    } else {
-    //     for (int i = 0; i < (LOGO_COLOR_LENGTH-1); i++) {
-
-    //  // b.printRawRow(0b11111111, i, 0, 0xffffff);
-    // }
-   
-    leds.setPixelColor(
-        LOGO_LED_START, dimLogoColor(logoColors[start % (LOGO_COLOR_LENGTH - 1)]));
-    leds.setPixelColor(
-        LOGO_LED_START + 1,
-        dimLogoColor(logoColors[(start + (spread)) % (LOGO_COLOR_LENGTH - 1)]));
-    leds.setPixelColor(
-        LOGO_LED_START + 2, dimLogoColor(
-          logoColors[(start + (spread * 2)) % (LOGO_COLOR_LENGTH - 1)]));
-    leds.setPixelColor(
-        LOGO_LED_START + 3, dimLogoColor(
-          logoColors[(start + (spread * 3)) % (LOGO_COLOR_LENGTH - 1)]));
-    leds.setPixelColor(
-        LOGO_LED_START + 4, dimLogoColor(
-          logoColors[(start + (spread * 4)) % (LOGO_COLOR_LENGTH - 1)]));
-    leds.setPixelColor(
-        LOGO_LED_START + 5, dimLogoColor(
-          logoColors[(start + (spread * 5)) % (LOGO_COLOR_LENGTH - 1)]));
-    leds.setPixelColor(
-        LOGO_LED_START + 6, dimLogoColor(
-          logoColors[(start + (spread * 6)) % (LOGO_COLOR_LENGTH - 1)]));
-    leds.setPixelColor(
-        LOGO_LED_START + 7, dimLogoColor(
-          logoColors[(start + (spread * 7)) % (LOGO_COLOR_LENGTH - 1)]));
+  leds.setPixelColor(LOGO_LED_START,
+                     firstPalette[start % (LOGO_COLOR_LENGTH - 1)]);
+  for (int i = 1; i < 8; i++) {
+    leds.setPixelColor(LOGO_LED_START + i,
+                       palette[(start + (spread * i)) % (LOGO_COLOR_LENGTH - 1)]);
     }
 
   if (logoColorOverride != -1) {
@@ -269,6 +269,17 @@ extern uint32_t logoColorsPink[LOGO_COLOR_LENGTH+1];
 extern uint32_t logoColors8vSelect[LOGO_COLOR_LENGTH+11];
 extern uint32_t logoColorsAll[8][LOGO_COLOR_LENGTH + 11];
 
+typedef enum {
+  LOGO_SWIRL_RAINBOW,
+  LOGO_SWIRL_COLD,
+  LOGO_SWIRL_HOT,
+  LOGO_SWIRL_PINK,
+  LOGO_SWIRL_PINK_SELECTED,
+  LOGO_SWIRL_PALETTES,
+} logoSwirlPalette;
+
+extern uint32_t logoSwirlTables[LOGO_SWIRL_PALETTES][LOGO_COLOR_LENGTH];
+
 
 const int bbPixelToNodesMap[120] = {
     0,         1,          2,        3,        4,          5,         6,
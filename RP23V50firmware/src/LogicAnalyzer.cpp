@@ -8,6 +8,11 @@
 #include "hardware/gpio.h"
 #include "hardware/watchdog.h"
 #include "configManager.h"
+#include "LEDStream.h"
+#include "Telemetry.h"
+#include "BinaryStream.h"
+#include "ProtocolDecode.h"
+#include "AdcSampler.h"
 #include "Peripherals.h"
 
 // // ADC register definitions (matching JulseView)
@@ -44,6 +49,8 @@ LogicAnalyzer::LogicAnalyzer()
 	  num_samples(5000),
 	  a_mask(0x0F),
 	  d_mask(0xFF),
+	  transport(LA_TRANSPORT_ASCII),
+	  events_only(false),
 	  initialized(false),
 	  armed(false),
 	  running(false),
@@ -53,18 +60,17 @@ LogicAnalyzer::LogicAnalyzer()
 	  dma_dig_0(-1), dma_dig_1(-1), dma_ana_0(-1), dma_ana_1(-1),
 	  dig_half0(nullptr), dig_half1(nullptr), ana_half0(nullptr), ana_half1(nullptr),
 	  samples_per_half(0), digital_bytes_per_half(0), analog_words_per_half(0),
-    txidx(0), cmdidx(0) {
+    txidx(0), frame_seq(0), sample_index(0), bytes_sent(0), cmdidx(0) {
 }
 
 LogicAnalyzer* LogicAnalyzer::active_instance = nullptr;
 
 bool LogicAnalyzer::init() {
-	initialized = true;
 	JULSEDEBUG_STA("LA init()\n\r");
 
 	// Deterministic PIO selection: always use PIO0
 	lapio = pio0;
-	if (lasm < 0) lasm = pio_claim_unused_sm(lapio, true);
+	if (lasm < 0) lasm = pio_claim_unused_sm(lapio, false);
 	if (lasm < 0) {
 		JULSEDEBUG_ERR("LA: Failed to claim PIO0 SM at init\n\r");
 		return false;
@@ -72,11 +78,18 @@ bool LogicAnalyzer::init() {
 
 	// Load the slow program once by scanning for a free offset on PIO0
 	if (!pio_loaded) {
+		if (!pio_can_add_program(lapio, &prog_slow)) {
+			JULSEDEBUG_ERR("LA: no room for the capture program on PIO0\n\r");
+			pio_sm_unclaim(lapio, lasm);
+			lasm = -1;
+			return false;
+		}
         int offset = pio_add_program(lapio, &prog_slow);
         pio_slow_offset = offset;
         pio_loaded = true;
         JULSEDEBUG_DIG("LA PIO init: loaded slow program at PIO0 offset=%d, SM%d\n\r", pio_slow_offset, lasm);
     }
+	initialized = true;
 	return true;
 }
 
@@ -94,6 +107,8 @@ bool LogicAnalyzer::is_slow_mode() const {
 void LogicAnalyzer::handler() {
 #ifdef USE_TINYUSB
 	if (!USBSer2 || !USBSer2.available()) return;
+	if (ledStreamPort() == &USBSer2) return; // the LED stream reads its own commands
+	if (telemetryPort() == &USBSer2) return;
 	char ch = USBSer2.read();
     last_command_time = millis();
 	if (process_char(ch)) {
@@ -106,14 +121,18 @@ unsigned long last_command_time = 0;
 
 bool LogicAnalyzer::process_char(char ch) {
 	if (cmdidx >= sizeof(cmdstr) - 1) cmdidx = 0;
-	if (ch == '*') { cmdidx = 0; return false; }
+	if (ch == '*') { cmdidx = 0; transport = LA_TRANSPORT_ASCII; events_only = false; return false; }
 	if (ch == '+') { stop(); return false; }
 	if (ch == '\r' || ch == '\n') {
 		cmdstr[cmdidx] = 0; cmdidx = 0;
 		// Minimal subset for driver bring-up
 		switch (cmdstr[0]) {
 		case 'i': {
-			if (!initialized) init();
+			if (!initialized && !init()) {
+				// pio0 had no SM or program space left
+				snprintf(rsp, sizeof(rsp), "!");
+				return true;
+			}
 			// Respond with device ID + 7-bit framing meta (mirrors JulseView style)
 			// A08=8 analog channels supported, D08=8 digital channels
 			snprintf(rsp, sizeof(rsp), "SRJLV5,A%02d2D%02d,02", 8, 8);
@@ -210,6 +229,10 @@ bool LogicAnalyzer::process_char(char ch) {
 					return true;
 				}
 				run();
+				if (to_file) {
+					file_capture_reply();
+					return true;
+				}
 				rsp[0] = 0; return false;
 			} else {
 				snprintf(rsp, sizeof(rsp), "*");
@@ -234,9 +257,53 @@ bool LogicAnalyzer::process_char(char ch) {
 			watchdog_enable(4000, true);
 			run();
 			watchdog_disable();
+			if (to_file) {
+				file_capture_reply();
+				return true;
+			}
 			rsp[0] = 0; // no reply while running
 			return false;
 		}
+		case 'B': {
+			// 'B' -> highest binary version we speak; 'B1' -> binary frames, 'B0' -> ASCII
+			if (strlen(cmdstr) == 1) {
+				snprintf(rsp, sizeof(rsp), "B%d", LA_TRANSPORT_BINARY);
+			} else {
+				int v = atoi(&cmdstr[1]);
+				if (v == LA_TRANSPORT_ASCII || v == LA_TRANSPORT_BINARY) {
+					transport = (uint8_t)v;
+					snprintf(rsp, sizeof(rsp), "*");
+				} else {
+					snprintf(rsp, sizeof(rsp), "!");
+				}
+			}
+			JULSEDEBUG_CMD("LA CMD B -> transport=%u\n\r", transport);
+			return true;
+		}
+		case 'P': {
+			// 'P' -> decoders set up; 'P1' -> binary sends decoder events only, 'P0' -> samples too
+			if (strlen(cmdstr) == 1) {
+				snprintf(rsp, sizeof(rsp), "P%d", protocolDecodeActive() ? 1 : 0);
+			} else {
+				events_only = atoi(&cmdstr[1]) != 0;
+				snprintf(rsp, sizeof(rsp), "*");
+			}
+			JULSEDEBUG_CMD("LA CMD P -> events_only=%u\n\r", events_only);
+			return true;
+		}
+		case 'W': {
+			// 'W' -> where captures go; 'W<file>' -> to that file; 'W-' -> back to USB
+			if (strlen(cmdstr) == 1) {
+				snprintf(rsp, sizeof(rsp), "W%s", to_file ? file_sink.path() : "-");
+			} else if (strcmp(cmdstr, "W-") == 0) {
+				set_capture_file(nullptr);
+				snprintf(rsp, sizeof(rsp), "*");
+			} else {
+				snprintf(rsp, sizeof(rsp), set_capture_file(&cmdstr[1]) ? "*" : "!");
+			}
+			JULSEDEBUG_CMD("LA CMD W -> %s\n\r", to_file ? file_sink.path() : "USB");
+			return true;
+		}
 		case 'S': {
 			// Status: Armed (A), Started (S), Sending (R), Trigger enabled (T)
 			// Keep simple mappings: A,S,R all 0/1
@@ -435,6 +502,7 @@ bool LogicAnalyzer::setup_adc_for_analog() {
 	for (int i = 0; i < 8; i++) if ((a_mask >> i) & 1) { a_cnt++; adc_rr_mask |= (1u << i); }
 	if (a_cnt == 0) return true; // no analog
 
+	adcSamplerStop(); // stop() -> initADC() starts it again
 	adc_init();
 	// Configure FIFO: EN write results, DREQ_EN, THRESH=1 (trigger DREQ when 1+ samples ready)
 	// Use threshold=1 for immediate response and tight synchronization with PIO
@@ -506,7 +574,7 @@ bool LogicAnalyzer::setup_dma_for_analog() {
 }
 
 bool LogicAnalyzer::arm() {
-	if (!initialized) init();
+	if (!initialized && !init()) return false;
 	JULSEDEBUG_STA("LA arm() start\n\r");
 	// Compute and allocate ping-pong halves
 	if (!compute_layout()) return false;
@@ -605,6 +673,20 @@ int usb_send_idx = 0;
 
 void LogicAnalyzer::run() {
 	if (!armed) return;
+
+	// A file gets binary frames, ASCII has nothing to check it against afterwards
+	uint8_t saved_transport = transport;
+	sink = to_file ? (CaptureSink*)&file_sink : &usb_sink;
+	if (sink->isFile()) transport = LA_TRANSPORT_BINARY;
+	sink_ok = sink->begin();
+	if (!sink_ok) {
+		JULSEDEBUG_ERR("LA: can't open %s\n\r", file_sink.path());
+		transport = saved_transport;
+		sink = &usb_sink;
+		stop();
+		deinit();
+		return;
+	}
 	running = true;
 
     for (int i = 0; i < 50; i++) usb_send_time[i] = 0;
@@ -634,6 +716,10 @@ void LogicAnalyzer::run() {
 	tud_cdc_n_write_flush(2);
 #endif
 	txidx = 0;
+	bytes_sent = 0;
+	sample_index = 0;
+	protocolDecodeBegin(sample_rate_hz);
+	if (transport == LA_TRANSPORT_BINARY) send_binary_info();
 	
 	uint8_t a_cnt_runtime = ana_enabled_count;
 	JULSEDEBUG_DMA("LA DMA counts preset in setup (acnt=%u)\n\r", a_cnt_runtime);
@@ -692,7 +778,8 @@ void LogicAnalyzer::run() {
 		int ch_d = (idx == 0) ? dma_dig_0 : dma_dig_1;
 		int ch_a = (idx == 0) ? dma_ana_0 : dma_ana_1;
 		while (dma_channel_is_busy(ch_d) || (a_cnt_runtime && dma_channel_is_busy(ch_a))) {
-			// spin; hardware paced
+			// hardware paced; a file sink writes out the last half meanwhile
+			sink->service();
 		}
 	};
 
@@ -733,11 +820,21 @@ void LogicAnalyzer::run() {
 	}
 	
 
-	char completion[32];
 	uint32_t a_cnt = ana_enabled_count;
 	uint32_t bytes_per_sample = 2 + (a_cnt * 2);
-	sprintf(completion, "$%u+", total_sent * bytes_per_sample);
-	usb_write_blocking((const uint8_t*)completion, strlen(completion));
+	if (transport == LA_TRANSPORT_BINARY) {
+		send_binary_end(total_sent);
+	} else {
+		char completion[32];
+		sprintf(completion, "$%u+", total_sent * bytes_per_sample);
+		usb_write_blocking((const uint8_t*)completion, strlen(completion));
+	}
+	if (!sink->end()) sink_ok = false;
+	if (sink->isFile()) {
+		JULSEDEBUG_STA("LA: %u bytes to %s, %lu stalls\n\r", bytes_sent, file_sink.path(), captureFileStats.stalls);
+	}
+	sink = &usb_sink;
+	transport = saved_transport;
 	stop();
 	
     // Print USB send times
@@ -755,7 +852,8 @@ void LogicAnalyzer::run() {
     JULSEDEBUG_USB("\n\r");
 
     //running = false;
-    JULSEDEBUG_STA("LA run() complete: total_sent=%u bytes/sample=%u\n\r", total_sent, bytes_per_sample);
+    JULSEDEBUG_STA("LA run() complete: total_sent=%u bytes/sample=%u wire=%u bytes (%s)\n\r", total_sent, bytes_per_sample,
+                   bytes_sent, transport == LA_TRANSPORT_BINARY ? "binary" : "ascii");
 
 #ifdef USE_TINYUSB
     tud_task();
@@ -882,43 +980,28 @@ void LogicAnalyzer::encode_and_queue_analog(uint16_t v12) {
 }
 
 bool LogicAnalyzer::usb_write_blocking(const uint8_t* data, int len) {
-#ifdef USE_TINYUSB
-	if (!tud_cdc_n_connected(2)) {
-		Serial.println("LA: USB not connected");
-		Serial.flush();
-		return false;
-	}
-	// Push big chunks into TinyUSB TX fifo; rely on its flush threshold to xfer
-	int off = 0;
-	while (off < len) {
-		uint32_t space = tud_cdc_n_write_available(2);
-		if (space == 0) {
-			// Give TinyUSB a chance to move data to USB IN endpoint
-			tud_task();
-			// Try to flush any queued packet if endpoint claimed
-			tud_cdc_n_write_flush(2);
-			// brief wait to avoid busy-spin
-			delayMicroseconds(10);
-			continue;
-		}
-		uint32_t chunk = (uint32_t)(len - off);
-		if (chunk > space) chunk = space;
-		uint32_t w = tud_cdc_n_write(2, data + off, chunk);
-		off += (int)w;
-		// Periodically service USB
-		tud_task();
+	return usb_sink.write(data, len);
+}
+
+bool LogicAnalyzer::set_capture_file(const char* path) {
+	if (path == nullptr || path[0] == 0) {
+		to_file = false;
+		return true;
 	}
-	// Final flush ensures tail < packet size is sent promptly
-	tud_cdc_n_write_flush(2);
+	if (!file_sink.setPath(path)) return false;
+	to_file = true;
 	return true;
-#else
-	return false;
-#endif
+}
+
+void LogicAnalyzer::file_capture_reply() {
+	if (sink_ok) snprintf(rsp, sizeof(rsp), "W%u", bytes_sent);
+	else snprintf(rsp, sizeof(rsp), "!");
 }
 
 void LogicAnalyzer::send_flush() {
 	if (txidx == 0) return;
-	usb_write_blocking(txbuf, txidx);
+	if (!sink->write(txbuf, txidx)) sink_ok = false;
+	bytes_sent += txidx;
 	txidx = 0;
 }
 
@@ -928,21 +1011,29 @@ void LogicAnalyzer::send_half(uint32_t half_index, uint32_t samples_in_half) {
 	uint8_t a_cnt = 0; for (int i=0;i<8;i++) if ((a_mask>>i)&1) a_cnt++;
 
     unsigned long start_time = micros();
-	// Larger batching with partial flush: try to fill big TX buffer, flush only when needed
-	for (uint32_t i = 0; i < samples_in_half; i++) {
-		uint8_t digi = pack_digital_8(dptr[i]);
-		encode_and_queue_digital(digi);
-		if (a_cnt) {
-			uint32_t base = i * a_cnt;
-			for (int ch = 0; ch < 8; ch++) {
-				if (!((a_mask >> ch) & 1)) continue;
-				uint16_t raw = aptr[base++];
-				uint16_t v12 = raw & 0x0FFF; // 12-bit
-				encode_and_queue_analog(v12);
+	if (protocolDecodeActive()) protocolDecodeFeed(dptr, samples_in_half);
+
+	if (transport == LA_TRANSPORT_BINARY) {
+		if (events_only) sample_index += samples_in_half;
+		else send_half_binary(dptr, aptr, samples_in_half, a_cnt);
+		send_binary_events();
+	} else {
+		// Larger batching with partial flush: try to fill big TX buffer, flush only when needed
+		for (uint32_t i = 0; i < samples_in_half; i++) {
+			uint8_t digi = pack_digital_8(dptr[i]);
+			encode_and_queue_digital(digi);
+			if (a_cnt) {
+				uint32_t base = i * a_cnt;
+				for (int ch = 0; ch < 8; ch++) {
+					if (!((a_mask >> ch) & 1)) continue;
+					uint16_t raw = aptr[base++];
+					uint16_t v12 = raw & 0x0FFF; // 12-bit
+					encode_and_queue_analog(v12);
+				}
 			}
+			// Flush when buffer is nearing capacity; keep 256-byte headroom
+			if (txidx >= (TX_BUF_SIZE - 256)) send_flush();
 		}
-		// Flush when buffer is nearing capacity; keep 256-byte headroom
-		if (txidx >= (TX_BUF_SIZE - 256)) send_flush();
 	}
 	send_flush();
     usb_send_time[usb_send_idx] = micros() - start_time;
@@ -951,6 +1042,119 @@ void LogicAnalyzer::send_half(uint32_t half_index, uint32_t samples_in_half) {
 	watchdog_update();
 }
 
+static inline void put_u32(uint8_t* out, uint32_t v) {
+	out[0] = v; out[1] = v >> 8; out[2] = v >> 16; out[3] = v >> 24;
+}
+
+void LogicAnalyzer::finish_frame(uint8_t type, uint16_t length) {
+	txidx += finishBinaryFrame(&txbuf[txidx], BINARY_STREAM_CAPTURE, type, frame_seq++, length);
+}
+
+// Returns 0 when the runs wouldn't come out smaller than the raw bytes
+uint16_t LogicAnalyzer::encode_digital_rle(const uint8_t* samples, uint32_t count, uint8_t* out) {
+	uint32_t len = 0;
+	uint32_t i = 0;
+	while (i < count) {
+		uint8_t value = samples[i];
+		uint32_t run = 1;
+		while (i + run < count && samples[i + run] == value) run++;
+		i += run;
+		if (len + 1 + 5 >= count) return 0; // value + worst case varint
+		out[len++] = value;
+		while (run >= 0x80) { out[len++] = (uint8_t)(run | 0x80); run >>= 7; }
+		out[len++] = (uint8_t)run;
+	}
+	return (uint16_t)len;
+}
+
+uint16_t LogicAnalyzer::encode_analog_packed(const uint16_t* values, uint32_t count, uint8_t* out) {
+	uint32_t len = 0;
+	uint32_t i = 0;
+	for (; i + 1 < count; i += 2) {
+		uint32_t pair = (values[i] & 0x0FFF) | ((uint32_t)(values[i + 1] & 0x0FFF) << 12);
+		out[len++] = pair; out[len++] = pair >> 8; out[len++] = pair >> 16;
+	}
+	if (i < count) { // odd one out gets 2 bytes
+		uint16_t v = values[i] & 0x0FFF;
+		out[len++] = v; out[len++] = v >> 8;
+	}
+	return (uint16_t)len;
+}
+
+void LogicAnalyzer::send_half_binary(const uint8_t* dptr, const uint16_t* aptr,
+                                     uint32_t samples_in_half, uint8_t a_cnt) {
+	for (uint32_t first = 0; first < samples_in_half; first += LA_BINARY_BLOCK_SAMPLES) {
+		uint32_t n = samples_in_half - first;
+		if (n > LA_BINARY_BLOCK_SAMPLES) n = LA_BINARY_BLOCK_SAMPLES;
+
+		uint32_t worst = 2 * BINARY_FRAME_OVERHEAD + 4 + n + 5 + (n * a_cnt * 3 + 1) / 2 + 1;
+		if (txidx + worst > TX_BUF_SIZE) send_flush();
+
+		// Digital: runs if that's smaller, raw bytes otherwise
+		uint8_t* payload = &txbuf[txidx + BINARY_FRAME_HEADER_SIZE];
+		put_u32(payload, sample_index);
+		uint16_t len = encode_digital_rle(dptr + first, n, payload + 4);
+		if (len > 0) {
+			finish_frame(LA_FRAME_DIGITAL_RLE, 4 + len);
+		} else {
+			memcpy(payload + 4, dptr + first, n);
+			finish_frame(LA_FRAME_DIGITAL_RAW, 4 + n);
+		}
+
+		if (a_cnt) {
+			payload = &txbuf[txidx + BINARY_FRAME_HEADER_SIZE];
+			put_u32(payload, sample_index);
+			payload[4] = (uint8_t)(a_mask & 0xFF);
+			len = encode_analog_packed(aptr + first * a_cnt, n * a_cnt, payload + 5);
+			finish_frame(LA_FRAME_ANALOG, 5 + len);
+		}
+		sample_index += n;
+	}
+}
+
+void LogicAnalyzer::send_binary_info() {
+	uint8_t* payload = &txbuf[txidx + BINARY_FRAME_HEADER_SIZE];
+	payload[0] = LA_TRANSPORT_BINARY;
+	payload[1] = 1; // bytes per digital sample
+	payload[2] = 8; // digital channels (GP20..GP27)
+	payload[3] = (uint8_t)(a_mask & 0xFF);
+	put_u32(payload + 4, sample_rate_hz);
+	put_u32(payload + 8, num_samples);
+	payload[12] = LA_BINARY_BLOCK_SAMPLES & 0xFF;
+	payload[13] = LA_BINARY_BLOCK_SAMPLES >> 8;
+	finish_frame(LA_FRAME_INFO, 14);
+	send_flush();
+}
+
+// Drains the decoder ring; in ASCII mode it's left for MicroPython to read
+void LogicAnalyzer::send_binary_events() {
+	protocolEvent ev[LA_EVENTS_PER_FRAME];
+	int n;
+	while ((n = protocolDecodeRead(ev, LA_EVENTS_PER_FRAME)) > 0) {
+		if (txidx + BINARY_FRAME_OVERHEAD + n * 8 > TX_BUF_SIZE) send_flush();
+		uint8_t* payload = &txbuf[txidx + BINARY_FRAME_HEADER_SIZE];
+		for (int i = 0; i < n; i++) {
+			uint8_t* e = payload + i * 8;
+			put_u32(e, ev[i].sample);
+			e[4] = ev[i].decoder;
+			e[5] = ev[i].type;
+			e[6] = ev[i].data & 0xFF;
+			e[7] = ev[i].data >> 8;
+		}
+		finish_frame(LA_FRAME_EVENTS, n * 8);
+	}
+}
+
+void LogicAnalyzer::send_binary_end(uint32_t total_samples) {
+	uint32_t ascii_bytes = total_samples * (2 + 2 * ana_enabled_count);
+	uint8_t* payload = &txbuf[txidx + BINARY_FRAME_HEADER_SIZE];
+	put_u32(payload, total_samples);
+	put_u32(payload + 4, bytes_sent + BINARY_FRAME_OVERHEAD + 12);
+	put_u32(payload + 8, ascii_bytes);
+	finish_frame(LA_FRAME_END, 12);
+	send_flush();
+}
+
 void LogicAnalyzer::pio_irq1_isr() {
 	if (active_instance) active_instance->on_pio_irq1();
 }
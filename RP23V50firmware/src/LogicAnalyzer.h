@@ -6,6 +6,7 @@
 #include <stdbool.h>
 
 #include "ArduinoStuff.h"
+#include "CaptureSink.h"
 
 #include "hardware/adc.h"
 #include "hardware/clocks.h"
@@ -24,8 +25,43 @@
 // - Normal mode: sample_rate >= 5 kHz and sample_rate * a_chan_cnt <= 200 kHz
 // - Slow mode:   sample_rate < 5 kHz and num_samples > 1000 (stream as we go)
 // - Decimation:  TODO (when digital rate exceeds ADC capability)
-
-
+//
+// Transport:
+// - ASCII (default): every digital and analog value is 7-bit packed into two
+//   bytes, what the JulseView driver has always spoken.
+// - Binary v1: a client that sends "B1" after reset gets BinaryStream frames
+//   (stream 'A') instead. Digital blocks are run-length coded when that's
+//   smaller, analog values are packed two per three bytes. '*' drops back to
+//   ASCII so clients that don't know about it never see it.
+// - Protocol decoders (ProtocolDecode.h) see every half as it goes out. In
+//   binary mode their events follow each half as LA_FRAME_EVENTS, and "P1"
+//   leaves the raw blocks out so only the decoded events cross the wire.
+//
+// Sink:
+// - Output goes to a CaptureSink (CaptureSink.h), the CDC port by default.
+//   "W<file>" sends the following captures to a file on the FatFS partition
+//   instead, always in binary, and 'F' answers "W<bytes>" when it's written
+//   ("!" if it isn't). "W-" goes back to USB, "W" alone says where it's going.
+
+
+
+#define LA_TRANSPORT_ASCII 0
+#define LA_TRANSPORT_BINARY 1 // also the binary protocol version
+
+#define LA_BINARY_BLOCK_SAMPLES 512
+
+// binary frame types
+#define LA_FRAME_INFO 0        // u8 version, u8 digital bytes/sample, u8 digital channels,
+                               // u8 analog mask, u32 rate, u32 samples, u16 block samples
+#define LA_FRAME_DIGITAL_RAW 1 // u32 first sample, one byte per sample
+#define LA_FRAME_DIGITAL_RLE 2 // u32 first sample, (u8 value, varint run length)...
+#define LA_FRAME_ANALOG 3      // u32 first sample, u8 analog mask, 12-bit values
+                               // packed a | b << 12 into 3 bytes, channels interleaved
+#define LA_FRAME_END 4         // u32 samples, u32 bytes sent, u32 bytes ASCII would have taken
+#define LA_FRAME_EVENTS 5      // protocol decoder events, 8 bytes each: u32 sample,
+                               // u8 decoder, u8 type, u16 data
+
+#define LA_EVENTS_PER_FRAME 64
 
 class LogicAnalyzer {
 public:
@@ -36,10 +72,18 @@ public:
 	uint32_t num_samples;      // total time-samples to capture
 	uint32_t a_mask;           // analog channels bitmask (0..7)
 	uint32_t d_mask;           // digital mask (currently informational)
+	uint8_t transport;         // LA_TRANSPORT_ASCII or LA_TRANSPORT_BINARY
+	bool events_only;          // binary: send decoder events, not the samples
 
 
 	Stream* la_stream = &USBSer2;
 
+	// Capture to a file instead of USB, nullptr or "" goes back to USB
+	bool set_capture_file(const char* path);
+	const char* capture_file() const { return to_file ? file_sink.path() : nullptr; }
+	bool last_capture_ok() const { return sink_ok; }
+	uint32_t last_capture_bytes() const { return bytes_sent; }
+
 	// Lifecycle
 	bool init();
 	bool arm();      // configures PIO/DMA and allocates ping-pong buffers
@@ -75,6 +119,7 @@ private:
 	void send_half(uint32_t half_index, uint32_t samples_in_half);
 	void send_flush();
 	bool usb_write_blocking(const uint8_t* data, int len);
+	void file_capture_reply();
 
 	// Packs the 16-bit digital value per sample using current GPIO readings and
 	// the 8-bit PIO sample (GP20..GP27). Mapping (bit15..bit0):
@@ -85,6 +130,16 @@ private:
 	void encode_and_queue_digital(uint8_t digi);
 	void encode_and_queue_analog(uint16_t value_12b);
 
+	// Binary transport, frames are built in place in txbuf
+	void send_half_binary(const uint8_t* dptr, const uint16_t* aptr,
+	                      uint32_t samples_in_half, uint8_t a_cnt);
+	uint16_t encode_digital_rle(const uint8_t* samples, uint32_t count, uint8_t* out);
+	uint16_t encode_analog_packed(const uint16_t* values, uint32_t count, uint8_t* out);
+	void finish_frame(uint8_t type, uint16_t length);
+	void send_binary_info();
+	void send_binary_end(uint32_t total_samples);
+	void send_binary_events();
+
 	// Mode selection
 	bool is_normal_mode() const;
 	bool is_slow_mode() const;
@@ -132,10 +187,22 @@ private:
 	uint8_t txbuf[TX_BUF_SIZE];
 	uint16_t txidx;
 
+	// Binary transport state
+	uint16_t frame_seq;
+	uint32_t sample_index;     // first sample of the next block
+	uint32_t bytes_sent;       // on the wire this capture
+
+	// Where the capture goes
+	UsbCaptureSink usb_sink{2};
+	FileCaptureSink file_sink;
+	CaptureSink* sink = &usb_sink;
+	bool to_file = false;
+	bool sink_ok = true;       // the last capture all made it to the sink
+
 	// Command parser state
-	char cmdstr[20];
+	char cmdstr[CAPTURE_FILE_PATH_MAX + 2];
 	uint8_t cmdidx;
-	char rsp[32];
+	char rsp[CAPTURE_FILE_PATH_MAX + 8];
 
 	// Slow-mode analog pacing
 	uint8_t ana_enabled_count;
@@ -10,7 +10,9 @@
 #include "NetManager.h"
 
 #include "hardware/adc.h"
+#include "hardware/clocks.h"
 #include "hardware/gpio.h"
+#include "hardware/pio.h"
 #include "hardware/pwm.h"
 #include "hardware/structs/io_bank0.h"
 #include "pico/time.h" // For hardware timer support
@@ -25,9 +27,13 @@
 #include "Probing.h"
 #include "Highlighting.h"
 #include "LogicAnalyzer.h"
+#include "AdcSampler.h"
+#include "InaSampler.h"
+#include "WaveGen.h"
 #include "ArduinoStuff.h"
 
 #include "MCP4728.h"  // New library
+#include "pwm.pio.h"
 
 
 int i2cSpeed = 400000;
@@ -150,13 +156,20 @@ float gpioPWMDutyCycle[ 10 ] = { 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.
 bool gpioPWMEnabled[ 10 ] = { false, false, false, false, false,
                               false, false, false, false, false };
 
-// Slow PWM state tracking (for frequencies below 10Hz)
-bool gpioSlowPWMEnabled[ 10 ] = { false, false, false, false, false,
-                                  false, false, false, false, false };
-repeating_timer_t gpioSlowPWMTimers[ 10 ];
-volatile uint32_t gpioSlowPWMCounter[ 10 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-volatile uint32_t gpioSlowPWMPeriod[ 10 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-volatile uint32_t gpioSlowPWMDutyTicks[ 10 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+// PIO PWM (pwm.pio) for the pins a slice can't run, see setupPWM()
+struct pioPWMChannel {
+    PIO pio; // nullptr when the pin's on a slice or off
+    int sm;
+    uint offset;
+    uint32_t period; // counts, pwm.pio
+    uint32_t level;
+};
+static pioPWMChannel gpioPioPWM[ 8 ] = { };
+// pio2 only: CH446Q and the logic analyzer are on pio0, JulseView on pio1,
+// and those claim their SMs with nothing to fall back on
+static PIO const pioPWMBlock = pio2;
+static int pioPWMOffset = -1;
+static uint8_t pioPWMUsers = 0;
 
 void initGPIO( void ) {
     for ( int i = 0; i < 8; i++ ) {
@@ -210,6 +223,7 @@ int reads[ 30 ][ 2 ];
 int readIndex = 0;
 
 void initADC( void ) {
+    adcSamplerStop( );
     // Initialize pico-sdk ADC for direct hardware access
     adc_init( );
 
@@ -232,6 +246,10 @@ void initADC( void ) {
 
     // Set Arduino ADC resolution to 12 bits for compatibility
     analogReadResolution( 12 );
+
+    // readAdc() reads from here from now on, also after the logic analyzer
+    // hands the ADC back
+    adcSamplerStart( );
 }
 
 void initDAC( void ) {
@@ -866,6 +884,20 @@ void setRailsAndDACs( int saveEEPROM ) {
     setDac1voltage( jumperlessConfig.dacs.dac_1, 1, saveEEPROM );
     // delay(10);
 }
+// every MCP4728 write after setup goes through here. The wavegen's DMA stream
+// holds I2C0 while it runs, so it steps aside for the write and starts again.
+static bool writeDacChannel( MCP4728_channel_t channel, uint16_t value ) {
+    bool paused = waveGenPauseWire( );
+    digitalWrite( LDAC, HIGH );
+    bool ok = mcp.setChannelValue( channel, value );
+    digitalWrite( LDAC, LOW );
+    markAdcInputsChanged( );
+    if ( paused ) {
+        waveGenResumeWire( );
+    }
+    return ok;
+}
+
 void setTopRail( float value, int save, int saveEEPROM ) {
 
     int dacValue = ( value * 4095 / dacSpread[ 2 ] ) + dacZero[ 2 ];
@@ -876,9 +908,7 @@ void setTopRail( float value, int save, int saveEEPROM ) {
         dacValue = 0;
     }
 
-    digitalWrite( LDAC, HIGH );
-    mcp.setChannelValue( MCP4728_CHANNEL_C, dacValue );
-    digitalWrite( LDAC, LOW );
+    writeDacChannel( MCP4728_CHANNEL_C, dacValue );
     if ( save ) {
         jumperlessConfig.dacs.top_rail = value;
         railVoltage[ 0 ] = value; // Keep legacy variable in sync
@@ -902,9 +932,7 @@ void setBotRail( float value, int save, int saveEEPROM ) {
         dacValue = 0;
     }
 
-    digitalWrite( LDAC, HIGH );
-    mcp.setChannelValue( MCP4728_CHANNEL_D, dacValue );
-    digitalWrite( LDAC, LOW );
+    writeDacChannel( MCP4728_CHANNEL_D, dacValue );
     if ( save ) {
         jumperlessConfig.dacs.bottom_rail = value;
         railVoltage[ 1 ] = value; // Keep legacy variable in sync
@@ -954,14 +982,10 @@ void setDac0voltage( float voltage, int save, int saveEEPROM,
         dacValue = 0;
     }
 
-    digitalWrite( LDAC, HIGH );
-    // delay(10);
-    if ( mcp.setChannelValue( MCP4728_CHANNEL_A, dacValue ) == false ) {
+    if ( writeDacChannel( MCP4728_CHANNEL_A, dacValue ) == false ) {
         // delay(3000);
         Serial.println( "Failed to set DAC0 value" );
     }
-    // delay(10);
-    digitalWrite( LDAC, LOW );
     // if (save) {
 
     dacOutput[ 0 ] = voltage;
@@ -974,9 +998,7 @@ void setDac0voltage( float voltage, int save, int saveEEPROM,
 }
 
 void setDac0voltage( uint16_t inputCode ) {
-    digitalWrite( LDAC, HIGH );
-    mcp.setChannelValue( MCP4728_CHANNEL_A, inputCode );
-    digitalWrite( LDAC, LOW );
+    writeDacChannel( MCP4728_CHANNEL_A, inputCode );
 }
 
 void setDac1voltage( float voltage, int save, int saveEEPROM,
@@ -1001,9 +1023,7 @@ void setDac1voltage( float voltage, int save, int saveEEPROM,
         routableBufferPower( 1, 0 );
     }
 
-    digitalWrite( LDAC, HIGH );
-    mcp.setChannelValue( MCP4728_CHANNEL_B, dacValue );
-    digitalWrite( LDAC, LOW );
+    writeDacChannel( MCP4728_CHANNEL_B, dacValue );
     // if (save) {
 
     dacOutput[ 1 ] = voltage;
@@ -1016,9 +1036,7 @@ void setDac1voltage( float voltage, int save, int saveEEPROM,
 }
 
 void setDac1voltage( uint16_t inputCode ) {
-    digitalWrite( LDAC, HIGH );
-    mcp.setChannelValue( MCP4728_CHANNEL_B, inputCode );
-    digitalWrite( LDAC, LOW );
+    writeDacChannel( MCP4728_CHANNEL_B, inputCode );
 }
 
 uint8_t csToPin[ 16 ] = { 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7 };
@@ -1111,6 +1129,9 @@ void initINA219( void ) {
     INA0.setBusVoltageRange( 16 );
     INA1.setBusVoltageRange( 16 );
 
+    // free-running, InaSampler picks up each conversion as it lands
+    INA0.setModeShuntBusContinuous( );
+    INA1.setModeShuntBusContinuous( );
 
 }
 
@@ -1775,7 +1796,7 @@ void showMeasurements( int samples, int printOrBB, int oneShot ) {
 
     if ( showINA0[ 0 ] == 1 ) {
         bs += Serial.print( "INA 0: " );
-        bs += Serial.print( INA0.getCurrent_mA( ) );
+        bs += Serial.print( inaSamplerLatest( 0, INA_CURRENT ) );
         bs += Serial.print( "mA\t" );
         // bs += Serial.print("\tINA 1: ");
         // bs += Serial.print(INA1.getCurrent_mA());
@@ -1784,12 +1805,12 @@ void showMeasurements( int samples, int printOrBB, int oneShot ) {
 
     if ( showINA0[ 1 ] == 1 ) {
         bs += Serial.print( " V: " );
-        bs += Serial.print( INA0.getBusVoltage( ) );
+        bs += Serial.print( inaSamplerLatest( 0, INA_BUS_VOLTAGE ) );
         bs += Serial.print( "V\t" );
     }
     if ( showINA0[ 2 ] == 1 ) {
         bs += Serial.print( "P: " );
-        bs += Serial.print( INA0.getPower_mW( ) );
+        bs += Serial.print( inaSamplerLatest( 0, INA_POWER ) );
         bs += Serial.print( "mW\t" );
     }
     // Serial.print(digitalRead(buttonPin));
@@ -1848,6 +1869,43 @@ float readAdcVoltage( int channel, int samples ) {
     return adcReading;
 }
 
+// history entries readAdc() averages for this many samples
+static int adcAverages( int samples ) {
+    int averages = ( samples + ADC_SAMPLER_DECIMATE - 1 ) / ADC_SAMPLER_DECIMATE;
+    if ( averages < 1 ) {
+        averages = 1;
+    } else if ( averages > ADC_SAMPLER_HISTORY ) {
+        averages = ADC_SAMPLER_HISTORY;
+    }
+    return averages;
+}
+
+// channels that haven't been settled since a DAC or the crossbar last changed
+static volatile uint8_t adcUnsettled = 0;
+
+void markAdcInputsChanged( void ) {
+    adcUnsettled = 0xFF;
+}
+
+void settleAdc( int channel, int samples ) {
+    if ( channel < 0 || channel >= ADC_SAMPLER_CHANNELS ) {
+        return;
+    }
+    if ( adcSamplerHas( channel ) ) {
+        // the history fills up with averages taken after this, the polled
+        // fallback is fresh anyway
+        adcSamplerFresh( channel, adcAverages( samples ) );
+    }
+    adcUnsettled &= ~( 1 << channel );
+}
+
+void settleAdcIfChanged( int channel, int samples ) {
+    if ( channel >= 0 && channel < ADC_SAMPLER_CHANNELS &&
+         ( adcUnsettled & ( 1 << channel ) ) ) {
+        settleAdc( channel, samples );
+    }
+}
+
 int readAdc( int channel, int samples ) {
     unsigned long adcReadingAverage = 0;
     // if (channel == 0) { // I have no fucking idea why this works //future me:
@@ -1860,6 +1918,20 @@ int readAdc( int channel, int samples ) {
     if ( channel > 8 ) {
         return 0;
     }
+
+    if ( adcSamplerHas( channel ) ) {
+        // each history entry is already ADC_SAMPLER_DECIMATE conversions,
+        // up to a few ms old. settleAdc() first if that matters
+        return adcSamplerAverage( channel, adcAverages( samples ) );
+    }
+
+    // not sampled in the background (temperature sensor, or the analyzers
+    // have the ADC), poll it. Selecting an input would scramble the
+    // round-robin so the sampler has to sit this one out.
+    uint8_t resumeMask = adcSamplerRunning( ) ? adcSamplerMask( ) : 0;
+    adcSamplerStop( );
+    adcSamplerStats.fallbacks++;
+
     unsigned long timeoutTimer = micros( );
 
     int actualSamples = 0;
@@ -1878,6 +1950,10 @@ int readAdc( int channel, int samples ) {
     int adcReading =
         ( actualSamples > 0 ) ? ( adcReadingAverage / actualSamples ) : 0;
 
+    if ( resumeMask ) {
+        adcSamplerStart( resumeMask );
+    }
+
     // float adc3Voltage = (adc3Reading - 2528) / 220.0; // painstakingly measured
 
     // if (channel == 0) {
@@ -1893,203 +1969,143 @@ int readAdc( int channel, int samples ) {
     return adcReading;
 }
 
-// Slow PWM Functions (for frequencies below 10Hz)
-// Hardware timer callback for slow PWM
-bool __not_in_flash_func( slowPWMTimerCallback )( repeating_timer_t* rt ) {
-    // Get the GPIO index from the user data
-    int gpio_index = (int)(uintptr_t)rt->user_data;
-
-    // Increment counter
-    gpioSlowPWMCounter[ gpio_index ]++;
-
-    // Check if we've reached the period
-    if ( gpioSlowPWMCounter[ gpio_index ] >= gpioSlowPWMPeriod[ gpio_index ] ) {
-        gpioSlowPWMCounter[ gpio_index ] = 0; // Reset counter
-    }
+// PWM Functions
+//
+// A pin gets a PWM slice when the slice can do the frequency with 16 bits of
+// duty (PWM_SLICE_MIN_HZ up) and isn't running its other pin at a different
+// one. Anything else goes on a PIO state machine (pwm.pio) with a 32-bit period
+// and level, from a thousandth of a hertz to a sixth of the system clock.
+// Either way the pin runs with no CPU once it's set up, and syncPWM() restarts
+// any set of them in step.
+
+// the slice's other pin is GPIO_(n^1), running at another frequency
+static bool sliceTaken( int gpio_index, float frequency ) {
+    int other = gpio_index ^ 1;
+    return gpioPWMEnabled[ other ] && gpioPioPWM[ other ].pio == nullptr &&
+           gpioPWMFrequency[ other ] != frequency;
+}
 
-    // Set pin state based on duty cycle
-    int physical_pin = gpioDef[ gpio_index ][ 0 ];
-    if ( gpioSlowPWMCounter[ gpio_index ] < gpioSlowPWMDutyTicks[ gpio_index ] ) {
-        gpio_put( physical_pin, 1 ); // HIGH
-    } else {
-        gpio_put( physical_pin, 0 ); // LOW
+// turn the slice off unless the other pin on it is still using it
+static void releaseSlicePWM( int gpio_index ) {
+    int other = gpio_index ^ 1;
+    if ( gpioPWMEnabled[ other ] && gpioPioPWM[ other ].pio == nullptr ) {
+        return;
     }
-
-    return true; // Continue timer
+    pwm_set_enabled( pwm_gpio_to_slice_num( gpioDef[ gpio_index ][ 0 ] ), false );
 }
 
-// Setup slow PWM using hardware timer
-int setupSlowPWM( int gpio_pin, float frequency, float duty_cycle ) {
-    // Validate GPIO pin number (1-8 for regular GPIO pins)
-    if ( gpio_pin < 1 || gpio_pin > 8 ) {
-        return -1; // Invalid pin
+static bool claimPioPWM( int gpio_index ) {
+    pioPWMChannel* ch = &gpioPioPWM[ gpio_index ];
+    if ( ch->pio != nullptr ) {
+        return true;
     }
-
-    // Validate frequency (0.001Hz to 10Hz for slow PWM)
-    if ( frequency < 0.001 || frequency > 10.0 ) {
-        return -2; // Invalid frequency
+    int sm = pio_claim_unused_sm( pioPWMBlock, false );
+    if ( sm < 0 ) {
+        return false;
     }
-
-    // Validate duty cycle (0.0 to 1.0)
-    if ( duty_cycle < 0.0 || duty_cycle > 1.0 ) {
-        return -3; // Invalid duty cycle
+    if ( pioPWMOffset < 0 ) {
+        if ( !pio_can_add_program( pioPWMBlock, &pio_pwm_program ) ) {
+            pio_sm_unclaim( pioPWMBlock, sm );
+            return false;
+        }
+        pioPWMOffset = pio_add_program( pioPWMBlock, &pio_pwm_program );
     }
+    pioPWMUsers++;
+    ch->pio = pioPWMBlock;
+    ch->sm = sm;
+    ch->offset = pioPWMOffset;
+    return true;
+}
 
-    int gpio_index = gpio_pin - 1;                 // Convert to 0-based index
-    int physical_pin = gpioDef[ gpio_index ][ 0 ]; // Get physical pin number
-
-    // Stop any existing slow PWM on this pin
-    if ( gpioSlowPWMEnabled[ gpio_index ] ) {
-        cancel_repeating_timer( &gpioSlowPWMTimers[ gpio_index ] );
-        gpioSlowPWMEnabled[ gpio_index ] = false;
+static void releasePioPWM( int gpio_index ) {
+    pioPWMChannel* ch = &gpioPioPWM[ gpio_index ];
+    if ( ch->pio == nullptr ) {
+        return;
     }
-
-    // Configure pin as output
-    gpio_set_function( physical_pin, GPIO_FUNC_SIO );
-    gpio_set_dir( physical_pin, true );
-    gpio_put( physical_pin, 0 ); // Start low
-
-    // Calculate timer parameters
-    // Use 1ms timer resolution for good precision
-    uint32_t timer_interval_us = 1000; // 1ms intervals
-    uint32_t period_ms = (uint32_t)( 1000.0f / frequency );
-    uint32_t duty_ms = (uint32_t)( period_ms * duty_cycle );
-
-    // Convert to timer ticks
-    gpioSlowPWMPeriod[ gpio_index ] = period_ms;  // Period in ms
-    gpioSlowPWMDutyTicks[ gpio_index ] = duty_ms; // Duty cycle in ms
-    gpioSlowPWMCounter[ gpio_index ] = 0;
-
-    // Start the repeating timer
-    bool success = add_repeating_timer_ms( -1, slowPWMTimerCallback,
-                                           (void*)(uintptr_t)gpio_index,
-                                           &gpioSlowPWMTimers[ gpio_index ] );
-    if ( !success ) {
-        return -4; // Timer setup failed
+    pio_sm_set_enabled( ch->pio, ch->sm, false );
+    pio_sm_unclaim( ch->pio, ch->sm );
+    gpio_set_outover( gpioDef[ gpio_index ][ 0 ], GPIO_OVERRIDE_NORMAL );
+    if ( --pioPWMUsers == 0 ) {
+        pio_remove_program( ch->pio, &pio_pwm_program, pioPWMOffset );
+        pioPWMOffset = -1;
     }
-
-    // Update state tracking
-    gpioPWMFrequency[ gpio_index ] = frequency;
-    gpioPWMDutyCycle[ gpio_index ] = duty_cycle;
-    gpioSlowPWMEnabled[ gpio_index ] = true;
-    gpioPWMEnabled[ gpio_index ] = false; // Not using hardware PWM
-
-    // Update config
-    jumperlessConfig.gpio.pwm_frequency[ gpio_index ] = frequency;
-    jumperlessConfig.gpio.pwm_duty_cycle[ gpio_index ] = duty_cycle;
-    jumperlessConfig.gpio.pwm_enabled[ gpio_index ] = true;
-
-    return 0; // Success
+    ch->pio = nullptr;
 }
 
-// Set slow PWM duty cycle
-int setSlowPWMDutyCycle( int gpio_pin, float duty_cycle ) {
-    // Validate GPIO pin number (1-8 for regular GPIO pins)
-    if ( gpio_pin < 1 || gpio_pin > 8 ) {
-        return -1; // Invalid pin
-    }
-
-    // Validate duty cycle (0.0 to 1.0)
-    if ( duty_cycle < 0.0 || duty_cycle > 1.0 ) {
-        return -2; // Invalid duty cycle
+// the count the pin goes low at for a duty of frac / 2^32. pwm.pio is high
+// for 3(p - x) + 4 of every 3p + 6 cycles, and all of them when x > p
+static uint32_t __not_in_flash_func( pioPWMLevel )( uint32_t period, uint64_t frac ) {
+    if ( frac >= 0xFFFFFFFFull ) {
+        return 0xFFFFFFFF;
     }
+    uint64_t x = ( ( (uint64_t)period + 2 ) * ( 0x100000000ull - frac ) ) >> 32;
+    return x > period ? period : (uint32_t)x;
+}
 
-    int gpio_index = gpio_pin - 1; // Convert to 0-based index
-
-    // Check if slow PWM is enabled
-    if ( !gpioSlowPWMEnabled[ gpio_index ] ) {
-        // Set up slow PWM with default frequency if not already enabled
-        float default_freq = ( gpioPWMFrequency[ gpio_index ] < 0.01 )
-                                 ? 1.0
-                                 : gpioPWMFrequency[ gpio_index ];
-        return setupSlowPWM( gpio_pin, default_freq, duty_cycle );
-    }
+// picked up at the start of the next period, so changes don't glitch
+static void __not_in_flash_func( putPioPWM )( int gpio_index, uint64_t frac ) {
+    pioPWMChannel* ch = &gpioPioPWM[ gpio_index ];
+    ch->level = pioPWMLevel( ch->period, frac );
+    // every period starts high, 0% has to be forced
+    gpio_set_outover( gpioDef[ gpio_index ][ 0 ],
+                      frac == 0 ? GPIO_OVERRIDE_LOW : GPIO_OVERRIDE_NORMAL );
+    if ( pio_sm_is_tx_fifo_full( ch->pio, ch->sm ) ) {
+        pio_sm_clear_fifos( ch->pio, ch->sm );
+    }
+    pio_sm_put( ch->pio, ch->sm, ch->level );
+}
 
-    // Update duty cycle
-    uint32_t period_ms = gpioSlowPWMPeriod[ gpio_index ];
-    uint32_t duty_ms = (uint32_t)( period_ms * duty_cycle );
-    gpioSlowPWMDutyTicks[ gpio_index ] = duty_ms;
-    gpioPWMDutyCycle[ gpio_index ] = duty_cycle;
-    jumperlessConfig.gpio.pwm_duty_cycle[ gpio_index ] = duty_cycle;
+// the period into ISR and the level into the FIFO, from the top of the program
+static void loadPioPWM( pioPWMChannel* ch ) {
+    pio_sm_clear_fifos( ch->pio, ch->sm );
+    pio_sm_put( ch->pio, ch->sm, ch->period );
+    pio_sm_exec( ch->pio, ch->sm, pio_encode_pull( false, false ) );
+    pio_sm_exec( ch->pio, ch->sm, pio_encode_out( pio_isr, 32 ) );
+    pio_sm_put( ch->pio, ch->sm, ch->level );
+    pio_sm_exec( ch->pio, ch->sm, pio_encode_jmp( ch->offset ) );
+}
 
-    return 0; // Success
+static uint64_t pioPWMFrac( float duty_cycle ) {
+    return (uint64_t)( (double)duty_cycle * 4294967296.0 + 0.5 );
 }
 
-// Set slow PWM frequency
-int setSlowPWMFrequency( int gpio_pin, float frequency ) {
-    // Validate GPIO pin number (1-8 for regular GPIO pins)
-    if ( gpio_pin < 1 || gpio_pin > 8 ) {
-        return -1; // Invalid pin
+static int setupPioPWM( int gpio_index, float frequency, float duty_cycle ) {
+    uint32_t clock_freq = clock_get_hz( clk_sys );
+    if ( frequency * 6.0f > clock_freq ) {
+        return -2; // the shortest period is 6 cycles
     }
-
-    // Validate frequency (0.001Hz to 10Hz for slow PWM)
-    if ( frequency < 0.001 || frequency > 10.0 ) {
-        return -2; // Invalid frequency
+    bool was_on_slice = gpioPWMEnabled[ gpio_index ] && gpioPioPWM[ gpio_index ].pio == nullptr;
+    if ( !claimPioPWM( gpio_index ) ) {
+        return -4; // no state machine free
     }
-
-    int gpio_index = gpio_pin - 1; // Convert to 0-based index
-
-    // Check if slow PWM is enabled
-    if ( !gpioSlowPWMEnabled[ gpio_index ] ) {
-        // Set up slow PWM with default duty cycle if not already enabled
-        float default_duty = ( gpioPWMDutyCycle[ gpio_index ] < 0.0 ||
-                               gpioPWMDutyCycle[ gpio_index ] > 1.0 )
-                                 ? 0.5
-                                 : gpioPWMDutyCycle[ gpio_index ];
-        return setupSlowPWM( gpio_pin, frequency, default_duty );
+    if ( was_on_slice ) {
+        releaseSlicePWM( gpio_index );
     }
+    pioPWMChannel* ch = &gpioPioPWM[ gpio_index ];
 
-    // Re-setup slow PWM with new frequency
-    return setupSlowPWM( gpio_pin, frequency, gpioPWMDutyCycle[ gpio_index ] );
-}
-
-// Stop slow PWM
-int stopSlowPWM( int gpio_pin ) {
-    // Validate GPIO pin number (1-8 for regular GPIO pins)
-    if ( gpio_pin < 1 || gpio_pin > 8 ) {
-        return -1; // Invalid pin
+    // 3 cycles a count, the divider only comes in below about 0.012 Hz
+    double counts = (double)clock_freq / frequency / 3.0;
+    uint32_t divider = (uint32_t)( counts / 4294967000.0 ) + 1;
+    if ( divider > 65535 ) {
+        divider = 65535;
     }
-
-    int gpio_index = gpio_pin - 1;                 // Convert to 0-based index
-    int physical_pin = gpioDef[ gpio_index ][ 0 ]; // Get physical pin number
-
-    // Stop the timer
-    if ( gpioSlowPWMEnabled[ gpio_index ] ) {
-        cancel_repeating_timer( &gpioSlowPWMTimers[ gpio_index ] );
-        gpioSlowPWMEnabled[ gpio_index ] = false;
+    double period = counts / divider - 2.0;
+    if ( period < 0.0 ) {
+        period = 0.0;
     }
+    ch->period = period > 4294967000.0 ? 4294967000u : (uint32_t)( period + 0.5 );
 
-    // Set pin low and back to input
-    gpio_put( physical_pin, 0 );
-    gpio_set_function( physical_pin, GPIO_FUNC_SIO );
-    gpio_set_dir( physical_pin, false );
-
-    // Update state tracking
-    gpioPWMEnabled[ gpio_index ] = false;
-    jumperlessConfig.gpio.pwm_enabled[ gpio_index ] = false;
-
-    return 0; // Success
+    pio_pwm_program_init( ch->pio, ch->sm, ch->offset, gpioDef[ gpio_index ][ 0 ], divider );
+    gpio_function_map[ gpio_index ] = GPIO_FUNC_PWM; // it's a PWM as far as the rest is concerned
+    putPioPWM( gpio_index, pioPWMFrac( duty_cycle ) );
+    loadPioPWM( ch );
+    pio_sm_set_enabled( ch->pio, ch->sm, true );
+    return 0;
 }
 
-// PWM Functions
-int setupPWM( int gpio_pin, float frequency, float duty_cycle ) {
-    // Validate GPIO pin number (1-8 for regular GPIO pins)
-    if ( gpio_pin < 1 || gpio_pin > 8 ) {
-        return -1; // Invalid pin
-    }
-
-    // Validate frequency (0.01Hz to 62.5MHz)
-    if ( frequency < 0.01 || frequency > 62500000.0 ) {
-        return -2; // Invalid frequency
-    }
-
-    // For frequencies below 10Hz, use slow PWM with hardware timer
-    if ( frequency < 10.0 ) {
-        return setupSlowPWM( gpio_pin, frequency, duty_cycle );
-    }
-
-    int gpio_index = gpio_pin - 1;                 // Convert to 0-based index
+static int setupSlicePWM( int gpio_index, float frequency, float duty_cycle ) {
     int physical_pin = gpioDef[ gpio_index ][ 0 ]; // Get physical pin number
+    releasePioPWM( gpio_index );
 
     // Set up PWM
     gpio_set_function( physical_pin, GPIO_FUNC_PWM );
@@ -2119,6 +2135,36 @@ int setupPWM( int gpio_pin, float frequency, float duty_cycle ) {
 
     // Enable PWM
     pwm_set_enabled( slice_num, true );
+    return 0;
+}
+
+int setupPWM( int gpio_pin, float frequency, float duty_cycle ) {
+    // Validate GPIO pin number (1-8 for regular GPIO pins)
+    if ( gpio_pin < 1 || gpio_pin > 8 ) {
+        return -1; // Invalid pin
+    }
+
+    // Validate frequency (0.001Hz to 62.5MHz)
+    if ( frequency < 0.001 || frequency > 62500000.0 ) {
+        return -2; // Invalid frequency
+    }
+
+    // Validate duty cycle (0.0 to 1.0)
+    if ( duty_cycle < 0.0 || duty_cycle > 1.0 ) {
+        return -3; // Invalid duty cycle
+    }
+
+    int gpio_index = gpio_pin - 1; // Convert to 0-based index
+
+    int result;
+    if ( frequency < PWM_SLICE_MIN_HZ || sliceTaken( gpio_index, frequency ) ) {
+        result = setupPioPWM( gpio_index, frequency, duty_cycle );
+    } else {
+        result = setupSlicePWM( gpio_index, frequency, duty_cycle );
+    }
+    if ( result != 0 ) {
+        return result;
+    }
 
     // Update state tracking
     gpioPWMFrequency[ gpio_index ] = frequency;
@@ -2144,23 +2190,25 @@ int setPWMDutyCycle( int gpio_pin, float duty_cycle ) {
         return -2; // Invalid duty cycle
     }
 
-    int gpio_index = gpio_pin - 1;                 // Convert to 0-based index
-    int physical_pin = gpioDef[ gpio_index ][ 0 ]; // Get physical pin number
-
-    // Check if slow PWM is enabled
-    if ( gpioSlowPWMEnabled[ gpio_index ] ) {
-        return setSlowPWMDutyCycle( gpio_pin, duty_cycle );
-    }
+    int gpio_index = gpio_pin - 1; // Convert to 0-based index
 
-    // Check if regular PWM is enabled
+    // Check if PWM is enabled
     if ( !gpioPWMEnabled[ gpio_index ] ) {
         // Set up PWM with default frequency if not already enabled
-        float default_freq = ( gpioPWMFrequency[ gpio_index ] < 0.01 )
+        float default_freq = ( gpioPWMFrequency[ gpio_index ] < 0.001 )
                                  ? 1000.0
                                  : gpioPWMFrequency[ gpio_index ];
         return setupPWM( gpio_pin, default_freq, duty_cycle );
     }
 
+    if ( gpioPioPWM[ gpio_index ].pio != nullptr ) {
+        // takes over at the end of the period it's in
+        putPioPWM( gpio_index, pioPWMFrac( duty_cycle ) );
+        gpioPWMDutyCycle[ gpio_index ] = duty_cycle;
+        jumperlessConfig.gpio.pwm_duty_cycle[ gpio_index ] = duty_cycle;
+        return 0;
+    }
+
     // Re-setup PWM with the new duty cycle (simpler approach)
     return setupPWM( gpio_pin, gpioPWMFrequency[ gpio_index ], duty_cycle );
 }
@@ -2171,19 +2219,14 @@ int setPWMFrequency( int gpio_pin, float frequency ) {
         return -1; // Invalid pin
     }
 
-    // Validate frequency (0.01Hz to 62.5MHz)
-    if ( frequency < 0.01 || frequency > 62500000.0 ) {
+    // Validate frequency (0.001Hz to 62.5MHz)
+    if ( frequency < 0.001 || frequency > 62500000.0 ) {
         return -2; // Invalid frequency
     }
 
     int gpio_index = gpio_pin - 1; // Convert to 0-based index
 
-    // Check if slow PWM is enabled
-    if ( gpioSlowPWMEnabled[ gpio_index ] ) {
-        return setSlowPWMFrequency( gpio_pin, frequency );
-    }
-
-    // Check if regular PWM is enabled
+    // Check if PWM is enabled
     if ( !gpioPWMEnabled[ gpio_index ] ) {
         // Set up PWM with default duty cycle if not already enabled
         float default_duty = ( gpioPWMDutyCycle[ gpio_index ] < 0.0 ||
@@ -2193,7 +2236,7 @@ int setPWMFrequency( int gpio_pin, float frequency ) {
         return setupPWM( gpio_pin, frequency, default_duty );
     }
 
-    // Re-setup PWM with new frequency
+    // Re-setup PWM with new frequency, it moves between a slice and a PIO if it has to
     return setupPWM( gpio_pin, frequency, gpioPWMDutyCycle[ gpio_index ] );
 }
 
@@ -2206,20 +2249,21 @@ int stopPWM( int gpio_pin ) {
     int gpio_index = gpio_pin - 1;                 // Convert to 0-based index
     int physical_pin = gpioDef[ gpio_index ][ 0 ]; // Get physical pin number
 
-    // Check if slow PWM is enabled
-    if ( gpioSlowPWMEnabled[ gpio_index ] ) {
-        return stopSlowPWM( gpio_pin );
-    }
+    if ( gpioPioPWM[ gpio_index ].pio != nullptr ) {
+        releasePioPWM( gpio_index );
 
-    // Regular hardware PWM
-    // Find out which PWM slice is connected to this GPIO
-    uint slice_num = pwm_gpio_to_slice_num( physical_pin );
-
-    // Disable PWM
-    pwm_set_enabled( slice_num, false );
+        // Set pin low and back to input
+        gpio_put( physical_pin, 0 );
+        gpio_set_function( physical_pin, GPIO_FUNC_SIO );
+        gpio_set_dir( physical_pin, false );
+    } else {
+        // Update state tracking first so the slice can tell it's free
+        gpioPWMEnabled[ gpio_index ] = false;
+        releaseSlicePWM( gpio_index );
 
-    // Set pin back to SIO function
-    gpio_set_function( physical_pin, GPIO_FUNC_SIO );
+        // Set pin back to SIO function
+        gpio_set_function( physical_pin, GPIO_FUNC_SIO );
+    }
 
     // Update state tracking
     gpioPWMEnabled[ gpio_index ] = false;
@@ -2228,13 +2272,64 @@ int stopPWM( int gpio_pin ) {
     return 0; // Success
 }
 
+void __not_in_flash_func( pwmWriteDuty )( int gpio_index, uint16_t duty ) {
+    uint64_t frac = (uint64_t)duty * 65537; // 65535 is 0xFFFFFFFF, all the way high
+    if ( gpioPioPWM[ gpio_index ].pio != nullptr ) {
+        putPioPWM( gpio_index, frac );
+        return;
+    }
+    int physical_pin = gpioDef[ gpio_index ][ 0 ];
+    uint32_t top = pwm_hw->slice[ pwm_gpio_to_slice_num( physical_pin ) ].top;
+    uint32_t level = duty == 0xFFFF ? top + 1 : (uint32_t)( ( ( top + 1 ) * frac ) >> 32 );
+    pwm_set_gpio_level( physical_pin, level > 0xFFFF ? 0xFFFF : level );
+}
+
+int syncPWM( uint8_t pins ) {
+    uint32_t pio_mask = 0;
+    uint32_t slice_mask = 0;
+    for ( int i = 0; i < 8; i++ ) {
+        if ( !( pins & ( 1 << i ) ) || !gpioPWMEnabled[ i ] ) {
+            continue;
+        }
+        pioPWMChannel* ch = &gpioPioPWM[ i ];
+        if ( ch->pio != nullptr ) {
+            // a restart clears ISR, so the period goes back in
+            pio_sm_set_enabled( ch->pio, ch->sm, false );
+            pio_sm_restart( ch->pio, ch->sm );
+            loadPioPWM( ch );
+            pio_mask |= 1u << ch->sm;
+        } else {
+            slice_mask |= 1u << pwm_gpio_to_slice_num( gpioDef[ i ][ 0 ] );
+        }
+    }
+    if ( slice_mask == 0 && pio_mask == 0 ) {
+        return -1; // none of them running
+    }
+
+    uint32_t enabled = pwm_hw->en;
+    pwm_set_mask_enabled( enabled & ~slice_mask );
+    for ( uint slice = 0; slice < NUM_PWM_SLICES; slice++ ) {
+        if ( slice_mask & ( 1u << slice ) ) {
+            pwm_set_counter( slice, 0 );
+        }
+    }
+    // every one starts its period high, a few cycles apart at most
+    uint32_t saved = save_and_disable_interrupts( );
+    if ( pio_mask ) {
+        pio_enable_sm_mask_in_sync( pioPWMBlock, pio_mask );
+    }
+    pwm_set_mask_enabled( enabled | slice_mask );
+    restore_interrupts( saved );
+    return 0;
+}
+
 void printPWMState( void ) {
     Serial.println( "\n   PWM State:" );
     Serial.println( "   number:\t\b1\t\b2\t\b3\t\b4\t\b5\t\b6\t\b7\t\b8" );
 
     Serial.print( "  enabled:\t" );
     for ( int i = 0; i < 8; i++ ) {
-        bool is_enabled = gpioPWMEnabled[ i ] || gpioSlowPWMEnabled[ i ];
+        bool is_enabled = gpioPWMEnabled[ i ];
         Serial.print( is_enabled ? "yes" : "no" );
         Serial.print( "\t" );
     }
@@ -2242,10 +2337,10 @@ void printPWMState( void ) {
 
     Serial.print( "frequency:\t" );
     for ( int i = 0; i < 8; i++ ) {
-        if ( gpioPWMEnabled[ i ] || gpioSlowPWMEnabled[ i ] ) {
+        if ( gpioPWMEnabled[ i ] ) {
             Serial.print( gpioPWMFrequency[ i ], 1 );
-            if ( gpioSlowPWMEnabled[ i ] ) {
-                Serial.print( "(S)" ); // Mark slow PWM
+            if ( gpioPioPWM[ i ].pio != nullptr ) {
+                Serial.print( "(P)" ); // Mark PIO PWM
             }
         } else {
             Serial.print( "-" );
@@ -2256,7 +2351,7 @@ void printPWMState( void ) {
 
     Serial.print( "duty_cycle:\t" );
     for ( int i = 0; i < 8; i++ ) {
-        if ( gpioPWMEnabled[ i ] || gpioSlowPWMEnabled[ i ] ) {
+        if ( gpioPWMEnabled[ i ] ) {
             Serial.print( gpioPWMDutyCycle[ i ], 2 );
         } else {
             Serial.print( "-" );
@@ -2267,8 +2362,8 @@ void printPWMState( void ) {
 
     Serial.print( "    type:\t" );
     for ( int i = 0; i < 8; i++ ) {
-        if ( gpioSlowPWMEnabled[ i ] ) {
-            Serial.print( "slow" );
+        if ( gpioPWMEnabled[ i ] && gpioPioPWM[ i ].pio != nullptr ) {
+            Serial.printf( "pio%d", pio_get_index( gpioPioPWM[ i ].pio ) );
         } else if ( gpioPWMEnabled[ i ] ) {
             Serial.print( "hw" );
         } else {
@@ -145,6 +145,14 @@ void GetAdc29Status(int i);
 
 float readAdcVoltage(int channel, int samples = 8);
 int readAdc(int channel, int samples = 8);
+/// readAdc() averages what the background sampler already has, a few ms old.
+/// settleAdc() waits until that many samples were all taken after the call,
+/// for reads that have to see a DAC or connection change made just before
+void settleAdc(int channel, int samples = 8);
+/// a DAC or the crossbar changed (the DAC setters and sendAllPaths() call it)
+void markAdcInputsChanged(void);
+/// settleAdc() only if something changed since this channel was last settled
+void settleAdcIfChanged(int channel, int samples = 8);
 
 void chooseShownReadings(void);
 void showMeasurements(int samples = 8, int printOrBB = 2, int oneShot = 0);// 0 = print, 1 = breadboard 2 = both
@@ -291,18 +299,20 @@ const uint16_t DACLookup_FullSine_5Bit[32] =
         2048, 1648, 1264, 910, 600, 345, 156, 39,
         0, 39, 156, 345, 600, 910, 1264, 1648};
 
-// PWM functions
+// PWM functions, 0.001Hz to 62.5MHz. Below PWM_SLICE_MIN_HZ, or when the
+// slice is running the pin's neighbour at another frequency, a PIO state
+// machine runs it instead of the slice
+#define PWM_SLICE_MIN_HZ 10.0f
 int setupPWM(int gpio_pin, float frequency = 1000.0, float duty_cycle = 0.5);
 int setPWMDutyCycle(int gpio_pin, float duty_cycle);
 int setPWMFrequency(int gpio_pin, float frequency);
 int stopPWM(int gpio_pin);
+// restarts the running PWMs in pins (bit n is GPIO_(n+1)) together, each
+// starting its period high
+int syncPWM(uint8_t pins);
+// duty 0-65535 straight to the hardware, safe from an IRQ, for the sequencer
+void pwmWriteDuty(int gpio_index, uint16_t duty);
 void printPWMState(void);
 void printPIOStateMachines(void);
 
-// Slow PWM functions (for frequencies below 10Hz)
-int setupSlowPWM(int gpio_pin, float frequency, float duty_cycle);
-int setSlowPWMDutyCycle(int gpio_pin, float duty_cycle);
-int setSlowPWMFrequency(int gpio_pin, float frequency);
-int stopSlowPWM(int gpio_pin);
-
 #endif
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: MIT
+#include "ProbeSense.h"
+#include "AdcSampler.h"
+#include "config.h"
+#include <FatFS.h>
+
+probeSenseStatistics probeSenseStats = {0, 0, 0};
+
+#define PROBE_ADC_CHANNEL 5
+#define FIRST_PAD 1
+#define LAST_PAD (PROBE_CALIBRATION_PADS - 1)
+
+static uint16_t measured[PROBE_CALIBRATION_PADS]; // 0 = not measured
+static int centers[PROBE_CALIBRATION_PADS];       // measured or filled in
+static int measuredCount = 0;
+static bool loadAttempted = false;
+
+int probeSenseRead(int *value) {
+  if (!adcSamplerHas(PROBE_ADC_CHANNEL)) {
+    return -1;
+  }
+  probeSenseStats.reads++;
+
+  uint16_t recent[PROBE_SENSE_WINDOW];
+  int n = adcSamplerHistory(PROBE_ADC_CHANNEL, recent, PROBE_SENSE_WINDOW);
+  if (n == 0) {
+    *value = 0;
+    return 0;
+  }
+
+  // insertion sort, it's four values
+  for (int i = 1; i < n; i++) {
+    uint16_t v = recent[i];
+    int j = i - 1;
+    while (j >= 0 && recent[j] > v) {
+      recent[j + 1] = recent[j];
+      j--;
+    }
+    recent[j + 1] = v;
+  }
+
+  int sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += recent[i];
+  }
+  if (n == PROBE_SENSE_WINDOW &&
+      recent[n - 1] - recent[0] <= PROBE_SENSE_SPREAD) {
+    *value = (sum + n / 2) / n;
+    probeSenseStats.settled++;
+    return 1;
+  }
+
+  // the tightest run of PROBE_SENSE_AGREE, the rest get outvoted
+  int best = -1;
+  int bestSpread = 0x7fff;
+  for (int i = 0; i + PROBE_SENSE_AGREE <= n; i++) {
+    int spread = recent[i + PROBE_SENSE_AGREE - 1] - recent[i];
+    if (spread < bestSpread) {
+      bestSpread = spread;
+      best = i;
+    }
+  }
+  if (best >= 0 && bestSpread <= PROBE_SENSE_SPREAD) {
+    int agreed = 0;
+    for (int i = best; i < best + PROBE_SENSE_AGREE; i++) {
+      agreed += recent[i];
+    }
+    *value = (agreed + PROBE_SENSE_AGREE / 2) / PROBE_SENSE_AGREE;
+    probeSenseStats.settled++;
+    probeSenseStats.outvoted++;
+    return 1;
+  }
+
+  *value = (sum + n / 2) / n;
+  return 0;
+}
+
+static int linearCenter(int index) {
+  int low = jumperlessConfig.calibration.probe_min;
+  int high = jumperlessConfig.calibration.probe_max;
+  return low + (LAST_PAD - index) * (high - low) / LAST_PAD;
+}
+
+int probeSenseLinearIndex(int raw) {
+  int index = map(raw, jumperlessConfig.calibration.probe_min,
+                  jumperlessConfig.calibration.probe_max, LAST_PAD, 0);
+  if (index < FIRST_PAD || index > LAST_PAD) {
+    return -1;
+  }
+  return index;
+}
+
+// fills in the pads nobody measured: between two measured ones it's a straight
+// line, past the last one it follows the linear map's slope from there
+static void rebuild(void) {
+  measuredCount = 0;
+  for (int i = FIRST_PAD; i <= LAST_PAD; i++) {
+    measuredCount += measured[i] != 0;
+  }
+  if (measuredCount == 0) {
+    return;
+  }
+
+  for (int i = FIRST_PAD; i <= LAST_PAD; i++) {
+    if (measured[i] != 0) {
+      centers[i] = measured[i];
+      continue;
+    }
+    int before = i - 1;
+    while (before >= FIRST_PAD && measured[before] == 0) {
+      before--;
+    }
+    int after = i + 1;
+    while (after <= LAST_PAD && measured[after] == 0) {
+      after++;
+    }
+
+    if (before >= FIRST_PAD && after <= LAST_PAD) {
+      centers[i] = measured[before] + (measured[after] - measured[before]) *
+                                          (i - before) / (after - before);
+    } else {
+      int anchor = before >= FIRST_PAD ? before : after;
+      centers[i] = measured[anchor] + linearCenter(i) - linearCenter(anchor);
+    }
+  }
+}
+
+int probeSenseIndex(int raw) {
+  if (!loadAttempted) {
+    probeCalibrationLoad();
+  }
+  if (measuredCount == 0) {
+    return probeSenseLinearIndex(raw);
+  }
+
+  int best = -1;
+  int bestDistance = 0x7fffffff;
+  for (int i = FIRST_PAD; i <= LAST_PAD; i++) {
+    int distance = abs(raw - centers[i]);
+    if (distance < bestDistance) {
+      bestDistance = distance;
+      best = i;
+    }
+  }
+
+  // past either end, only count it if it's within half a pad of the last one.
+  // That's also where "nothing touched" starts below pad 101, probe_min
+  // doesn't come into it once there's a table
+  int neighbour = best == FIRST_PAD ? FIRST_PAD + 1 : best - 1;
+  int halfGap = abs(centers[best] - centers[neighbour]) / 2 + PROBE_SENSE_SPREAD;
+  if ((best == FIRST_PAD || best == LAST_PAD) && bestDistance > halfGap) {
+    return -1;
+  }
+  return best;
+}
+
+bool probeCalibrationLoad(void) {
+  loadAttempted = true;
+  memset(measured, 0, sizeof(measured));
+
+  File file = FatFS.open(PROBE_CALIBRATION_FILE, "r");
+  if (!file) {
+    rebuild();
+    return false;
+  }
+  // "index reading" per line, # comments
+  while (file.available()) {
+    String line = file.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0 || line[0] == '#') {
+      continue;
+    }
+    int index = 0;
+    int raw = 0;
+    if (sscanf(line.c_str(), "%d %d", &index, &raw) == 2 &&
+        index >= FIRST_PAD && index <= LAST_PAD && raw > 0 && raw < 4096) {
+      measured[index] = raw;
+    }
+  }
+  file.close();
+  rebuild();
+  return measuredCount > 0;
+}
+
+bool probeCalibrationSave(void) {
+  File file = FatFS.open(PROBE_CALIBRATION_FILE, "w");
+  if (!file) {
+    return false;
+  }
+  file.println("# probe pad calibration from the Probe Calib app");
+  file.println("# probeRowMap index, ADC 5 reading on that pad");
+  for (int i = FIRST_PAD; i <= LAST_PAD; i++) {
+    if (measured[i] != 0) {
+      file.printf("%d %d\n", i, measured[i]);
+    }
+  }
+  file.close();
+  loadAttempted = true;
+  return true;
+}
+
+void probeCalibrationClear(void) {
+  memset(measured, 0, sizeof(measured));
+  loadAttempted = true;
+  rebuild();
+}
+
+void probeCalibrationSet(int index, int raw) {
+  if (index < FIRST_PAD || index > LAST_PAD || raw < 0 || raw > 4095) {
+    return;
+  }
+  if (!loadAttempted) {
+    probeCalibrationLoad();
+  }
+  measured[index] = raw;
+  rebuild();
+}
+
+int probeCalibrationMeasured(int index) {
+  if (index < FIRST_PAD || index > LAST_PAD) {
+    return 0;
+  }
+  return measured[index];
+}
+
+int probeCalibrationCount(void) {
+  if (!loadAttempted) {
+    probeCalibrationLoad();
+  }
+  return measuredCount;
+}
+
+void printProbeSenseStats(Stream *stream) {
+  stream->printf("probe: %lu reads, %lu settled (%lu with an average outvoted)\n\r",
+                 probeSenseStats.reads, probeSenseStats.settled,
+                 probeSenseStats.outvoted);
+  int count = probeCalibrationCount();
+  if (count == 0) {
+    stream->printf("mapping: linear %d..%d\n\r",
+                   jumperlessConfig.calibration.probe_min,
+                   jumperlessConfig.calibration.probe_max);
+  } else {
+    stream->printf("mapping: %d of %d pads measured\n\r", count,
+                   LAST_PAD - FIRST_PAD + 1);
+  }
+}
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: MIT
+#ifndef PROBESENSE_H
+#define PROBESENSE_H
+
+#include <Arduino.h>
+
+// Probe reading filter and per-board pad calibration
+//
+// With the background ADC sampler running, a probe reading is the last
+// PROBE_SENSE_WINDOW averages of ADC 5 and it counts as settled when any
+// PROBE_SENSE_AGREE of them are within PROBE_SENSE_SPREAD counts of each
+// other. A single spike or the one average that straddled the touch gets
+// outvoted instead of restarting the wait, so a clean touch settles after
+// PROBE_SENSE_AGREE averages (~1.3 ms each).
+//
+// Readings map to an index into probeRowMap/probeRowMapByPad. Without a
+// calibration that's the old linear map from probe_min..probe_max. With one,
+// each index has the reading measured on that pad (probeCalibApp() takes them)
+// and a reading goes to the nearest pad, with the thresholds halfway between
+// neighbours. Pads that weren't measured are interpolated from the ones that
+// were. Past the pads at either end a reading has to be within half a gap of
+// the end pad, anything further out is nothing touched.
+
+#define PROBE_SENSE_WINDOW 4
+#define PROBE_SENSE_AGREE 3
+#define PROBE_SENSE_SPREAD 4
+
+#define PROBE_CALIBRATION_PADS 102 // probeRowMap indices 1-101 are pads
+#define PROBE_CALIBRATION_FILE "probe_calibration.txt"
+
+struct probeSenseStatistics {
+  uint32_t reads;
+  uint32_t settled;
+  uint32_t outvoted;  // settled with one average thrown out
+};
+
+extern probeSenseStatistics probeSenseStats;
+
+/// the filtered ADC 5 reading in *value, 1 if it's settled, 0 if not, -1 if
+/// the sampler isn't running (and readProbeRaw() has to poll)
+int probeSenseRead(int *value);
+
+/// probeRowMap index for a raw reading, -1 if it's outside every pad
+int probeSenseIndex(int raw);
+/// same, ignoring the calibration table
+int probeSenseLinearIndex(int raw);
+
+/// loads PROBE_CALIBRATION_FILE, false if there isn't a usable one
+bool probeCalibrationLoad(void);
+bool probeCalibrationSave(void);
+/// forgets every measured pad (the file stays until the next save)
+void probeCalibrationClear(void);
+/// records the reading for one index, 0 unmeasures it
+void probeCalibrationSet(int index, int raw);
+int probeCalibrationMeasured(int index);
+/// measured pads, 0 if the linear map is in use
+int probeCalibrationCount(void);
+
+void printProbeSenseStats(Stream *stream);
+
+#endif
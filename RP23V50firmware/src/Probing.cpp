@@ -26,6 +26,10 @@
 #include "config.h"
 #include "oled.h"
 #include "externVars.h"
+#include "AdcSampler.h"
+#include "InaSampler.h"
+#include "ProbeSense.h"
+#include "EventDispatch.h"
 
 int debugProbing = 0;
 
@@ -2282,22 +2286,12 @@ float checkProbeCurrent( void ) {
 
     float current = 0.0;
     
-    // Wait for INA219 conversion to complete (~8.5ms with 16 sample averaging)
-    // The conversion flag indicates when a new reading is ready
-    unsigned long timeout_start = millis();
-    while (!INA1.getConversionFlag() && (millis() - timeout_start < 20)) {
-        delayMicroseconds(100);
-    }
-    
     // Take fewer samples since INA219 is already doing 16x averaging internally
     for ( int i = 0; i < div; i++ ) {
-        // Wait for conversion flag before each read
-        timeout_start = millis();
-        while (!INA1.getConversionFlag() && (millis() - timeout_start < 20)) {
-            delayMicroseconds(100);
-        }
-        current += INA1.getCurrent_mA( );
-        //delayMicroseconds( 2000 );  // Allow time for next conversion (~8.5ms needed)
+        // a conversion that lands after this point, not one from before the
+        // probe LEDs changed
+        inaSamplerWaitNext( 1 );
+        current += inaSamplerLatest( 1, INA_CURRENT );
     }
     current = current / (float)div;
     // Serial.print("current (before zero) = ");
@@ -2357,20 +2351,9 @@ float checkProbeCurrentZero( void ) {
     float currentSum = 0.0;
 
     // With 16x averaging in the INA219, we can take fewer samples here
-    // Wait for first conversion to complete
-    unsigned long timeout_start = millis();
-    while (!INA1.getConversionFlag() && (millis() - timeout_start < 20)) {
-        delayMicroseconds(100);
-    }
-
     for ( int i = 0; i < div; i++ ) {
-        // Wait for conversion flag before each read
-        timeout_start = millis();
-        while (!INA1.getConversionFlag() && (millis() - timeout_start < 20)) {
-            delayMicroseconds(100);
-        }
-        currentSum += INA1.getCurrent_mA( );
-        //delayMicroseconds( 2000 );  // Allow time for next conversion
+        inaSamplerWaitNext( 1 );
+        currentSum += inaSamplerLatest( 1, INA_CURRENT );
     }
 
     // Serial.print("currentSum = ");
@@ -2911,6 +2894,9 @@ if (blockProbeButton != 0) {
     // Serial.println(buttonState2);
     // Serial.println(" ");
 
+    if (returnState != lastProbeButtonState) {
+        eventPush(EVENT_PROBE_BUTTON, 0, returnState);
+    }
     lastProbeButtonState = returnState;
 
 
@@ -3250,7 +3236,8 @@ void checkPads( void ) {
 
     /* clang-format on */
     // probeReading = probeRowMap[map(probeReading, 30, 4050, 101, 0)];
-    probeReading = probeRowMap[ map( probeReading, jumperlessConfig.calibration.probe_min, jumperlessConfig.calibration.probe_max, 101, 0 ) ];
+    int padIndex = probeSenseIndex( probeReading );
+    probeReading = padIndex < 0 ? -1 : probeRowMap[ padIndex ];
     // stopProbe();
 
     if ( probeReading != lastPadTouched ) {
@@ -3378,8 +3365,19 @@ int readProbeRaw( int readNothingTouched, bool allowDuplicates ) {
     int lowReads = 0;
 
     int measurements[ 16 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    int sum = 0;
+    int maxVariance = 0;
+    int variance = 0;
+    int average = 0;
+
     // digitalWrite(PROBE_PIN, HIGH);
-    if ( connectOrClearProbe == 1 ) {
+    int settled = probeSenseRead( &average );
+    if ( settled >= 0 ) {
+        // filtered from the background averages, an unsettled reading fails
+        // the variance check below the same way a noisy burst would
+        maxVariance = settled == 1 ? 0 : PROBE_SENSE_SPREAD + 1;
+    } else if ( connectOrClearProbe == 1 ) {
 
         for ( int i = 0; i < numberOfReads; i++ ) {
             measurements[ i ] = readAdc( 5, 12 );
@@ -3418,19 +3416,18 @@ int readProbeRaw( int readNothingTouched, bool allowDuplicates ) {
         }
     }
 
-    int sum = 0;
-    int maxVariance = 0;
-    int variance = 0;
-    for ( int i = 0; i < numberOfReads; i++ ) {
-        sum += measurements[ i ];
-        if ( i < 3 ) {
-            variance = abs( measurements[ i ] - measurements[ i + 1 ] );
-            if ( variance > maxVariance ) {
-                maxVariance = variance;
+    if ( settled < 0 ) {
+        for ( int i = 0; i < numberOfReads; i++ ) {
+            sum += measurements[ i ];
+            if ( i < 3 ) {
+                variance = abs( measurements[ i ] - measurements[ i + 1 ] );
+                if ( variance > maxVariance ) {
+                    maxVariance = variance;
+                }
             }
         }
+        average = sum / numberOfReads;
     }
-    int average = sum / numberOfReads;
     // Serial.print("average ");
     // Serial.println(average);
     int rowProbed = -1;
@@ -3524,7 +3521,7 @@ int justReadProbe( bool allowDuplicates, int rawPad ) {
     // Serial.println(probeRead);
 
     // int rowProbed = map(probeRead, mapFrom, 4045, 101, 0);
-    int rowProbed = map( probeRead, jumperlessConfig.calibration.probe_min, jumperlessConfig.calibration.probe_max, 101, 0 );
+    int rowProbed = probeSenseIndex( probeRead );
     // Serial.print("rowProbed: ");
     // Serial.println(rowProbed);
 
@@ -3677,7 +3674,7 @@ int readProbe( ) {
         // Serial.flush();
     }
 
-    int rowProbed = map( probeRead, jumperlessConfig.calibration.probe_min, jumperlessConfig.calibration.probe_max, 101, 0 );
+    int rowProbed = probeSenseIndex( probeRead );
     // Serial.print("\n\n\rprobeRead: ");
     // Serial.println(probeRead);
 
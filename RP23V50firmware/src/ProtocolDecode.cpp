@@ -0,0 +1,392 @@
+// SPDX-License-Identifier: MIT
+#include "ProtocolDecode.h"
+
+protocolDecoder protocolDecoders[MAX_PROTOCOL_DECODERS];
+protocolDecodeStatistics protocolDecodeStats = {0, 0, 0, 0};
+
+// 1-Wire timing in microseconds, loose enough for overdrive-ish slaves and
+// masters that stretch their slots
+#define ONEWIRE_SHORT_US 15    // write 1 / read 1 slots are shorter than this
+#define ONEWIRE_RESET_US 400   // spec says 480, some masters cut it close
+#define ONEWIRE_PRESENCE_US 80 // presence starts 15-60 us after the reset ends
+
+static protocolEvent eventRing[PROTOCOL_EVENT_RING];
+static volatile uint32_t ringHead = 0; // written by the feed
+static volatile uint32_t ringTail = 0; // written by the reader
+
+static void pushEvent(uint32_t sample, int slot, uint8_t type, uint16_t data) {
+  uint32_t head = ringHead;
+  if (head - ringTail >= PROTOCOL_EVENT_RING) {
+    // keep the oldest, a test rig cares about what happened first
+    protocolDecodeStats.dropped++;
+    return;
+  }
+  protocolEvent *e = &eventRing[head & (PROTOCOL_EVENT_RING - 1)];
+  e->sample = sample;
+  e->decoder = slot;
+  e->type = type;
+  e->data = data;
+  ringHead = head + 1;
+  protocolDecodeStats.events++;
+}
+
+static int pinsUsed(int protocol) {
+  switch (protocol) {
+  case PROTOCOL_UART:
+  case PROTOCOL_ONEWIRE:
+    return 1;
+  case PROTOCOL_I2C:
+    return 2;
+  case PROTOCOL_SPI:
+    return 4;
+  }
+  return 0;
+}
+
+static uint32_t usToSamples(uint32_t us, uint32_t sampleRate) {
+  return (uint32_t)(((uint64_t)us * sampleRate + 999999) / 1000000);
+}
+
+static void resetDecoder(protocolDecoder *d, uint32_t sampleRate) {
+  d->primed = 0;
+  d->last = 0;
+  d->state = 0;
+  d->bits = 0;
+  d->shift = 0;
+  d->shift2 = 0;
+  d->start = 0;
+  d->mark = 0;
+  d->wait = 0;
+  d->period = 0;
+  if (d->protocol == PROTOCOL_UART && d->rate > 0) {
+    d->period = (uint32_t)(((uint64_t)sampleRate << 8) / d->rate);
+  }
+  d->short1 = usToSamples(ONEWIRE_SHORT_US, sampleRate);
+  d->reset = usToSamples(ONEWIRE_RESET_US, sampleRate);
+  d->window = usToSamples(ONEWIRE_PRESENCE_US, sampleRate);
+}
+
+int protocolDecoderSet(int slot, int protocol, const uint8_t *pins,
+                       uint32_t rate, uint8_t mode) {
+  int needed = pinsUsed(protocol);
+  if (needed == 0 || pins == nullptr) {
+    return -1;
+  }
+  if (protocol == PROTOCOL_UART && rate == 0) {
+    return -1;
+  }
+  // SPI can do without MISO and CS, everything else needs all its pins
+  int required = (protocol == PROTOCOL_SPI) ? 2 : needed;
+  for (int i = 0; i < needed; i++) {
+    if (pins[i] > 7 && (i < required || pins[i] != PROTOCOL_PIN_UNUSED)) {
+      return -1;
+    }
+  }
+
+  if (slot < 0) {
+    for (int i = 0; i < MAX_PROTOCOL_DECODERS; i++) {
+      if (protocolDecoders[i].protocol == PROTOCOL_NONE) {
+        slot = i;
+        break;
+      }
+    }
+  }
+  if (slot < 0 || slot >= MAX_PROTOCOL_DECODERS) {
+    return -1;
+  }
+
+  protocolDecoder *d = &protocolDecoders[slot];
+  d->protocol = PROTOCOL_NONE; // the feed skips it while we rebuild
+  for (int i = 0; i < 4; i++) {
+    d->pins[i] = (i < needed) ? pins[i] : PROTOCOL_PIN_UNUSED;
+  }
+  d->rate = rate;
+  d->mode = mode;
+  d->protocol = protocol;
+  resetDecoder(d, protocolDecodeStats.sampleRate);
+  return slot;
+}
+
+void protocolDecoderClear(int slot) {
+  for (int i = 0; i < MAX_PROTOCOL_DECODERS; i++) {
+    if (slot < 0 || slot == i) {
+      protocolDecoders[i].protocol = PROTOCOL_NONE;
+    }
+  }
+}
+
+bool protocolDecodeActive(void) {
+  for (int i = 0; i < MAX_PROTOCOL_DECODERS; i++) {
+    if (protocolDecoders[i].protocol != PROTOCOL_NONE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void protocolDecodeBegin(uint32_t sampleRate) {
+  protocolDecodeStats.sampleRate = sampleRate;
+  protocolDecodeStats.samples = 0;
+  protocolDecodeStats.events = 0;
+  protocolDecodeStats.dropped = 0;
+  ringTail = ringHead;
+  for (int i = 0; i < MAX_PROTOCOL_DECODERS; i++) {
+    resetDecoder(&protocolDecoders[i], sampleRate);
+  }
+}
+
+// 8N1, LSB first, sampled in the middle of each bit
+static void feedUart(int slot, protocolDecoder *d, const uint8_t *samples,
+                     uint32_t count, uint32_t base) {
+  uint8_t pin = d->pins[0];
+  uint8_t invert = (d->mode & PROTOCOL_UART_INVERTED) ? 1 : 0;
+  uint32_t i = 0;
+
+  if (d->period < 256) {
+    return; // less than a sample per bit, nothing sensible to do
+  }
+  if (!d->primed && count > 0) {
+    d->last = ((samples[0] >> pin) & 1) ^ invert;
+    d->primed = 1;
+    i = 1;
+  }
+
+  for (; i < count; i++) {
+    uint8_t level = ((samples[i] >> pin) & 1) ^ invert;
+
+    if (d->state == 0) {
+      if (d->last && !level) {
+        // start bit edge, first data bit is 1.5 bits away
+        d->state = 1;
+        d->start = base + i;
+        d->bits = 0;
+        d->shift = 0;
+        d->wait = (int32_t)(d->period + d->period / 2) - 256;
+      }
+    } else {
+      d->wait -= 256;
+      if (d->wait < 0) {
+        if (d->bits < 8) {
+          d->shift |= level << d->bits;
+          d->bits++;
+          d->wait += d->period;
+        } else {
+          pushEvent(d->start, slot,
+                    level ? PROTOCOL_EVENT_DATA : PROTOCOL_EVENT_ERROR,
+                    d->shift);
+          d->state = 0;
+          // a low stop bit has to go high again before the next start bit
+          // counts, so a break doesn't read as a string of zeros
+        }
+      }
+    }
+    d->last = level;
+  }
+}
+
+// START / STOP while SCL is high, bits on the SCL rising edge, 9th is ACK
+static void feedI2c(int slot, protocolDecoder *d, const uint8_t *samples,
+                    uint32_t count, uint32_t base) {
+  uint8_t scl = d->pins[0];
+  uint8_t sda = d->pins[1];
+  uint32_t i = 0;
+
+  if (!d->primed && count > 0) {
+    d->last = ((samples[0] >> scl) & 1) | (((samples[0] >> sda) & 1) << 1);
+    d->primed = 1;
+    i = 1;
+  }
+
+  for (; i < count; i++) {
+    uint8_t c = (samples[i] >> scl) & 1;
+    uint8_t dl = (samples[i] >> sda) & 1;
+    uint8_t lastC = d->last & 1;
+    uint8_t lastD = (d->last >> 1) & 1;
+
+    if (c && lastC && dl != lastD) {
+      if (!dl) {
+        pushEvent(base + i, slot, PROTOCOL_EVENT_START, 0);
+        d->state = 1; // next byte is an address
+      } else {
+        pushEvent(base + i, slot, PROTOCOL_EVENT_STOP, 0);
+        d->state = 0;
+      }
+      d->bits = 0;
+      d->shift = 0;
+    } else if (c && !lastC && d->state != 0) {
+      if (d->bits == 0) {
+        d->start = base + i;
+      }
+      d->shift = (d->shift << 1) | dl;
+      if (++d->bits == 9) {
+        uint16_t data = ((d->shift >> 1) & 0xFF) | ((d->shift & 1) << 8);
+        pushEvent(d->start, slot,
+                  d->state == 1 ? PROTOCOL_EVENT_ADDRESS : PROTOCOL_EVENT_DATA,
+                  data);
+        d->state = 2;
+        d->bits = 0;
+        d->shift = 0;
+      }
+    }
+    d->last = c | (dl << 1);
+  }
+}
+
+// CPOL/CPHA from mode, 8 bit words, CS optional (without it there's no
+// telling where a word starts, so it counts from the first clock it sees)
+static void feedSpi(int slot, protocolDecoder *d, const uint8_t *samples,
+                    uint32_t count, uint32_t base) {
+  uint8_t clk = d->pins[0];
+  uint8_t mosi = d->pins[1];
+  uint8_t miso = d->pins[2];
+  uint8_t cs = d->pins[3];
+  bool hasMiso = miso != PROTOCOL_PIN_UNUSED;
+  bool hasCs = cs != PROTOCOL_PIN_UNUSED;
+  bool lsbFirst = d->mode & PROTOCOL_SPI_LSB_FIRST;
+  // modes 0 and 3 sample on the rising edge, 1 and 2 on the falling one
+  uint8_t sampleLevel =
+      ((d->mode & PROTOCOL_SPI_CPOL) ? 1 : 0) == ((d->mode & PROTOCOL_SPI_CPHA) ? 1 : 0);
+  uint32_t i = 0;
+
+  if (!d->primed && count > 0) {
+    d->last = ((samples[0] >> clk) & 1) |
+              ((hasCs ? (samples[0] >> cs) & 1 : 0) << 1);
+    d->primed = 1;
+    i = 1;
+  }
+
+  for (; i < count; i++) {
+    uint8_t s = samples[i];
+    uint8_t c = (s >> clk) & 1;
+    uint8_t sel = hasCs ? (s >> cs) & 1 : 0;
+    uint8_t lastC = d->last & 1;
+    uint8_t lastSel = (d->last >> 1) & 1;
+    d->last = c | (sel << 1);
+
+    if (hasCs && sel != lastSel) {
+      pushEvent(base + i, slot, sel ? PROTOCOL_EVENT_STOP : PROTOCOL_EVENT_START, 0);
+      d->bits = 0;
+      d->shift = 0;
+      d->shift2 = 0;
+      continue;
+    }
+    if (sel || c == lastC || c != sampleLevel) {
+      continue;
+    }
+
+    uint8_t o = (s >> mosi) & 1;
+    uint8_t in = hasMiso ? (s >> miso) & 1 : 0;
+    if (d->bits == 0) {
+      d->start = base + i;
+    }
+    if (lsbFirst) {
+      d->shift |= o << d->bits;
+      d->shift2 |= in << d->bits;
+    } else {
+      d->shift = (d->shift << 1) | o;
+      d->shift2 = (d->shift2 << 1) | in;
+    }
+    if (++d->bits == 8) {
+      pushEvent(d->start, slot, PROTOCOL_EVENT_DATA,
+                (d->shift & 0xFF) | ((d->shift2 & 0xFF) << 8));
+      d->bits = 0;
+      d->shift = 0;
+      d->shift2 = 0;
+    }
+  }
+}
+
+// everything is in the width of the low pulses: resets, presence, and slots
+// that are either short (1) or long (0), LSB first
+static void feedOneWire(int slot, protocolDecoder *d, const uint8_t *samples,
+                        uint32_t count, uint32_t base) {
+  uint8_t pin = d->pins[0];
+  uint32_t i = 0;
+
+  if (!d->primed && count > 0) {
+    d->last = (samples[0] >> pin) & 1;
+    d->mark = base;
+    d->primed = 1;
+    i = 1;
+  }
+
+  for (; i < count; i++) {
+    uint8_t level = (samples[i] >> pin) & 1;
+    if (level == d->last) {
+      continue;
+    }
+    uint32_t now = base + i;
+    d->last = level;
+
+    if (!level) {
+      // state 1: a reset just ended at mark, a quick low is the presence
+      if (d->state == 1 && now - d->mark > d->window) {
+        d->state = 2; // nobody answered
+      }
+      d->mark = now;
+      continue;
+    }
+
+    uint32_t width = now - d->mark;
+    uint32_t fell = d->mark;
+    d->mark = now;
+
+    if (width >= d->reset) {
+      pushEvent(fell, slot, PROTOCOL_EVENT_START, 0);
+      d->state = 1;
+      d->bits = 0;
+      d->shift = 0;
+    } else if (d->state == 1) {
+      pushEvent(fell, slot, PROTOCOL_EVENT_PRESENCE, 0);
+      d->state = 2;
+    } else {
+      if (d->bits == 0) {
+        d->start = fell;
+      }
+      d->shift |= (width < d->short1 ? 1 : 0) << d->bits;
+      if (++d->bits == 8) {
+        pushEvent(d->start, slot, PROTOCOL_EVENT_DATA, d->shift);
+        d->bits = 0;
+        d->shift = 0;
+      }
+    }
+  }
+}
+
+void protocolDecodeFeed(const uint8_t *samples, uint32_t count) {
+  uint32_t base = protocolDecodeStats.samples;
+
+  // one decoder over the whole block at a time keeps its state in registers
+  for (int slot = 0; slot < MAX_PROTOCOL_DECODERS; slot++) {
+    protocolDecoder *d = &protocolDecoders[slot];
+    switch (d->protocol) {
+    case PROTOCOL_UART:
+      feedUart(slot, d, samples, count, base);
+      break;
+    case PROTOCOL_I2C:
+      feedI2c(slot, d, samples, count, base);
+      break;
+    case PROTOCOL_SPI:
+      feedSpi(slot, d, samples, count, base);
+      break;
+    case PROTOCOL_ONEWIRE:
+      feedOneWire(slot, d, samples, count, base);
+      break;
+    }
+  }
+  protocolDecodeStats.samples = base + count;
+}
+
+int protocolDecodePending(void) { return (int)(ringHead - ringTail); }
+
+int protocolDecodeRead(protocolEvent *out, int max) {
+  uint32_t tail = ringTail;
+  uint32_t head = ringHead;
+  int n = 0;
+  while (tail != head && n < max) {
+    out[n++] = eventRing[tail & (PROTOCOL_EVENT_RING - 1)];
+    tail++;
+  }
+  ringTail = tail;
+  return n;
+}
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+#ifndef PROTOCOLDECODE_H
+#define PROTOCOLDECODE_H
+
+#include <stdint.h>
+
+// Streaming UART / I2C / SPI / 1-Wire decoders for logic analyzer captures
+//
+// Samples are one byte each, bit n = capture channel n (GP20 + n), which is
+// what the LogicAnalyzer and JulseView DMA buffers already hold. Blocks can be
+// fed in any size; every decoder keeps its own state between blocks so a byte
+// split across two halves comes out whole. Decoded results go into one ring of
+// 8 byte events that MicroPython reads with decoder_read() and the capture
+// stream ships as 'D' frames.
+//
+// Nothing in here touches the SDK so scripts/protocol_decode_test.py can build
+// it on the host.
+
+#define MAX_PROTOCOL_DECODERS 4
+#define PROTOCOL_EVENT_RING 1024 // power of two
+
+typedef enum {
+  PROTOCOL_NONE = 0,
+  PROTOCOL_UART = 1,
+  PROTOCOL_I2C = 2,
+  PROTOCOL_SPI = 3,
+  PROTOCOL_ONEWIRE = 4,
+} protocolType;
+
+typedef enum {
+  PROTOCOL_EVENT_DATA = 0,     // UART / 1-Wire byte, I2C byte (bit 8 = NACK), SPI mosi | miso << 8
+  PROTOCOL_EVENT_START = 1,    // I2C (repeated) start, SPI CS low, 1-Wire reset pulse
+  PROTOCOL_EVENT_STOP = 2,     // I2C stop, SPI CS high
+  PROTOCOL_EVENT_ADDRESS = 3,  // I2C address byte, addr << 1 | read (bit 8 = NACK)
+  PROTOCOL_EVENT_PRESENCE = 4, // 1-Wire presence pulse after a reset
+  PROTOCOL_EVENT_ERROR = 5,    // UART bad stop bit (data = the byte anyway)
+} protocolEventType;
+
+// SPI mode bits
+#define PROTOCOL_SPI_CPHA 0x01
+#define PROTOCOL_SPI_CPOL 0x02
+#define PROTOCOL_SPI_LSB_FIRST 0x04
+
+// UART mode bits
+#define PROTOCOL_UART_INVERTED 0x01
+
+#define PROTOCOL_PIN_UNUSED 0xFF
+
+struct protocolEvent {
+  uint32_t sample; // since protocolDecodeBegin(), where the byte / condition started
+  uint8_t decoder; // slot
+  uint8_t type;    // protocolEventType
+  uint16_t data;
+};
+
+struct protocolDecoder {
+  uint8_t protocol = PROTOCOL_NONE;
+  // capture channels 0-7, PROTOCOL_PIN_UNUSED for optional ones
+  //   UART rx | I2C scl, sda | SPI clk, mosi, miso, cs | 1-Wire dq
+  uint8_t pins[4] = {PROTOCOL_PIN_UNUSED, PROTOCOL_PIN_UNUSED,
+                     PROTOCOL_PIN_UNUSED, PROTOCOL_PIN_UNUSED};
+  uint8_t mode = 0;  // PROTOCOL_SPI_* / PROTOCOL_UART_*
+  uint32_t rate = 0; // UART baud
+
+  // running state, cleared by protocolDecodeBegin()
+  uint8_t primed = 0; // seen the first sample, `last` is valid
+  uint8_t last = 0;   // previous levels, one bit per pins[] entry
+  uint8_t state = 0;
+  uint8_t bits = 0;
+  uint16_t shift = 0;
+  uint16_t shift2 = 0;
+  uint32_t start = 0;  // sample the current byte began on
+  uint32_t mark = 0;   // 1-Wire: sample the line last changed on
+  int32_t wait = 0;    // UART: 24.8 samples until the next bit is read
+  uint32_t period = 0; // UART: 24.8 samples per bit
+  uint32_t short1 = 0; // 1-Wire: low pulses shorter than this are a 1
+  uint32_t reset = 0;  // 1-Wire: low pulses at least this long are a reset
+  uint32_t window = 0; // 1-Wire: a pulse starting this soon after a reset is presence
+};
+
+struct protocolDecodeStatistics {
+  uint32_t sampleRate;
+  uint32_t samples; // fed since protocolDecodeBegin()
+  uint32_t events;
+  uint32_t dropped; // ring was full
+};
+
+extern protocolDecoder protocolDecoders[MAX_PROTOCOL_DECODERS];
+extern protocolDecodeStatistics protocolDecodeStats;
+
+/// pins holds as many channels as the protocol uses, returns the slot or -1
+int protocolDecoderSet(int slot, int protocol, const uint8_t *pins,
+                       uint32_t rate, uint8_t mode);
+/// slot -1 clears them all
+void protocolDecoderClear(int slot);
+bool protocolDecodeActive(void);
+
+/// call at the start of every capture, resets the decoders, the sample
+/// counter and the event ring
+void protocolDecodeBegin(uint32_t sampleRate);
+void protocolDecodeFeed(const uint8_t *samples, uint32_t count);
+
+int protocolDecodePending(void);
+/// copies out up to max events, oldest first, returns how many
+int protocolDecodeRead(protocolEvent *out, int max);
+
+#endif
@@ -10,9 +10,16 @@
 #include "AsyncPassthrough.h"
 
 #include "LEDs.h"
+#include "InaSampler.h"
+#include "WaveGen.h"
+#include "CommandTemplate.h"
+#include "ScriptCache.h"
 
 extern "C" {
+#include "py/compile.h"
 #include "py/gc.h"
+#include "py/lexer.h"
+#include "py/parse.h"
 #include "py/runtime.h"
 #include "py/stackctrl.h"
 #include "py/mpstate.h"
@@ -21,6 +28,8 @@ extern "C" {
 #include <micropython_embed.h>
 }
 
+extern WaveGen wavegen;
+
 // Global state for proper MicroPython integration
 static char mp_heap[MICROPY_HEAP_SIZE]; //heap for MicroPython (reduced to free memory for editor)
 static bool mp_initialized = false;
@@ -40,6 +49,9 @@ static char mp_command_buffer[512];
 static bool mp_command_ready = false;
 static char mp_response_buffer[1024];
 
+// Compiled single commands, see execCachedCommand()
+static void commandCacheClear(void);
+
 // Terminal colors for different REPL states
 /// 0 = menu (cyan) 1 = prompt (light blue) 2 = output (chartreuse) 3 = input
 /// (orange-yellow) 4 = error (orange-red) 5 = purple 6 = dark purple 7 = light
@@ -84,6 +96,9 @@ mp_uint_t mp_hal_ticks_ms(void);
 // Forward declaration for filesystem setup
 void setupFilesystemAndPaths(void);
 
+// Event handlers registered with on() (modjumperless.c)
+void jl_events_reset(void);
+
 // Forward declaration for interrupt checking  
 // (Note: Actual function is C++ linkage for use by other modules)
 
@@ -105,6 +120,10 @@ extern "C" void mp_hal_delay_ms(mp_uint_t ms) {
   while (millis() - start_time < ms) {
     // Check for interrupt every millisecond during delays
     mp_hal_check_interrupt();
+    inaSamplerService(); // loop() doesn't run while a script has core 0
+    waveGenFeed();
+    jl_events_poll();
+    mp_handle_pending(true); // event handlers run during sleeps too
     delay(1); // Small delay to prevent overwhelming the system
   }
 }
@@ -115,6 +134,22 @@ extern "C" mp_uint_t mp_hal_ticks_ms(void) {
   return millis(); 
 }
 
+// The REPL isn't running any bytecode while it waits for a key, so nothing
+// would get to the scheduled event handlers until the next line was entered
+static void runEventHandlers(void) {
+  jl_events_poll();
+  if (MP_STATE_VM(sched_state) != MP_SCHED_PENDING) {
+    return;
+  }
+  nlr_buf_t nlr;
+  if (nlr_push(&nlr) == 0) {
+    mp_handle_pending(true);
+    nlr_pop();
+  } else {
+    mp_obj_print_exception(&mp_plat_print, (mp_obj_t)nlr.ret_val);
+  }
+}
+
 // Arduino wrapper functions for the HAL layer
 extern "C" int arduino_serial_available(Stream *stream) {
   // Check for interrupt request before checking availability
@@ -264,6 +299,7 @@ bool initMicroPythonProper(Stream *stream) {
 
   changeTerminalColor(replColors[11], true, global_mp_stream);
   mp_embed_init(mp_heap, sizeof(mp_heap), stack_top);
+  commandCacheClear();
 
   // Set Ctrl+Q (ASCII 17) as the keyboard interrupt character instead of Ctrl+C (ASCII 3)
   // This enables proper KeyboardInterrupt exceptions that can be caught by try/except
@@ -299,6 +335,15 @@ void deinitMicroPythonProper(void) {
     
     // Close any open files before deinitializing MicroPython
     closeAllOpenFiles();
+
+    // the heap's going, so are any buffers the wavegen reads in place
+    wavegen.dropExternal();
+    for (int i = 0; i < 4; i++) {
+      MP_STATE_VM(jl_wavegen_cycle_obj)[i] = MP_OBJ_NULL;
+    }
+    MP_STATE_VM(jl_wavegen_play_obj) = MP_OBJ_NULL;
+    commandCacheClear();
+    jl_events_reset();
     
     mp_embed_deinit();
     mp_initialized = false;
@@ -470,6 +515,10 @@ void enterMicroPythonREPLWithFile(Stream *stream, const String& filepath) {
   // Blocking loop - stay in REPL until user exits
   while (mp_repl_active) {
     processMicroPythonInput(global_mp_stream);
+    if (global_mp_stream->available() == 0) {
+      runEventHandlers();
+      scriptCacheService(); // compile a queued script while there's nothing to do
+    }
    // mp_hal_check_interrupt();
     delayMicroseconds(1); // Small delay to prevent overwhelming
   }
@@ -525,6 +574,7 @@ void processMicroPythonInput(Stream *stream) {
         file.close();
 
         // Show the loaded content
+        scriptCacheNoteLoaded(repl_initial_filepath.c_str(), fileContent.c_str());
         editor.loadScriptContent(fileContent, "Script loaded from file: " + repl_initial_filepath);
       } else {
         changeTerminalColor(replColors[4], true, global_mp_stream);
@@ -1150,8 +1200,8 @@ void processMicroPythonInput(Stream *stream) {
               // Reset local nodefile copy for multiline scripts (start fresh each time)
               jl_init_micropython_local_copy();
 
-              // Execute the complete script
-              mp_embed_exec_str(script_to_execute.c_str());
+              // Execute the complete script, from its .mpy if it's a loaded file
+              scriptCacheExec(script_to_execute.c_str());
             }
 
             // Reset and show new prompt
@@ -1297,7 +1347,7 @@ void processMicroPythonInput(Stream *stream) {
               history.resetHistoryNavigation();
 
               // Let MicroPython handle the complete statement
-              mp_embed_exec_str(clean_input.c_str());
+              scriptCacheExec(clean_input.c_str());
             }
 
             changeTerminalColor(replColors[1], true, global_mp_stream);
@@ -2029,6 +2079,7 @@ String ScriptHistory::loadScript(const String &filename) {
 
   String content = file.readString();
   file.close();
+  scriptCacheNoteLoaded(fullPath.c_str(), content.c_str());
 
   global_mp_stream->println("Script loaded: " + fullPath);
   return content;
@@ -3092,6 +3143,7 @@ bool initMicroPythonQuiet(void) {
 
   // Initialize MicroPython silently
   mp_embed_init(mp_heap, sizeof(mp_heap), stack_top);
+  commandCacheClear();
   
   // Set Ctrl+Q (ASCII 17) as the keyboard interrupt character instead of Ctrl+C (ASCII 3)
   // This enables proper KeyboardInterrupt exceptions that can be caught by try/except
@@ -3416,6 +3468,176 @@ String parseCommandWithPrefix(const char* command) {
   return cmd;
 }
 
+// Compiled-command cache
+//
+// The host sends the same few commands thousands of times, gpio_get(2),
+// adc_get(0), dac_set(0, 2.5) ... and lexing, parsing and compiling each one
+// again costs more than running it. So the compiled module function is kept
+// and called again next time. commandTemplate() takes the plain numbers out
+// first, so dac_set(0, 2.5) and dac_set(0, 2.6) share one entry and only the
+// __jl0, __jl1 globals change between calls.
+//
+// The functions are held in MP_STATE_VM(jl_command_cache) so the GC keeps
+// them, and they're all dropped when the VM goes or comes back up.
+#define COMMAND_CACHE_ENTRIES 16  // jl_command_cache[16] in modjumperless.c
+#define COMMAND_CACHE_LATENCIES 128
+
+struct commandCacheEntry {
+  char key[COMMAND_TEMPLATE_KEY_MAX];
+  uint32_t lastUsed; // 0 for an empty slot
+};
+
+struct commandCacheStatistics {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint32_t uncacheable; // too long, or didn't compile once its numbers were out
+};
+
+static commandCacheEntry commandCache[COMMAND_CACHE_ENTRIES];
+static uint32_t commandCacheClock = 0;
+static commandCacheStatistics commandCacheStats = {0, 0, 0, 0};
+
+// the last COMMAND_CACHE_LATENCIES of each, compile (on a miss) and run, in us
+static uint32_t hitLatency[COMMAND_CACHE_LATENCIES];
+static uint32_t missLatency[COMMAND_CACHE_LATENCIES];
+
+static const qstr templateNames[COMMAND_TEMPLATE_MAX_LITERALS] = {
+    MP_QSTR___jl0, MP_QSTR___jl1, MP_QSTR___jl2, MP_QSTR___jl3,
+    MP_QSTR___jl4, MP_QSTR___jl5, MP_QSTR___jl6, MP_QSTR___jl7,
+};
+
+static void commandCacheClear(void) {
+  for (int i = 0; i < COMMAND_CACHE_ENTRIES; i++) {
+    commandCache[i].key[0] = '\0';
+    commandCache[i].lastUsed = 0;
+    MP_STATE_VM(jl_command_cache)[i] = MP_OBJ_NULL;
+  }
+}
+
+// the module function for key, or MP_OBJ_NULL if it won't compile
+static mp_obj_t compileCommand(const char *key) {
+  nlr_buf_t nlr;
+  if (nlr_push(&nlr) == 0) {
+    mp_lexer_t *lex = mp_lexer_new_from_str_len(MP_QSTR__lt_stdin_gt_, key, strlen(key), 0);
+    qstr source_name = lex->source_name;
+    mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+    mp_obj_t fun = mp_compile(&parse_tree, source_name, true);
+    nlr_pop();
+    return fun;
+  }
+  return MP_OBJ_NULL;
+}
+
+// runs command like mp_embed_exec_str(), from the cache when it can
+static void execCachedCommand(const char *command) {
+  char key[COMMAND_TEMPLATE_KEY_MAX];
+  commandLiteral literals[COMMAND_TEMPLATE_MAX_LITERALS];
+  int count = commandTemplate(command, key, sizeof(key), literals);
+  if (count < 0) {
+    commandCacheStats.uncacheable++;
+    mp_embed_exec_str(command);
+    return;
+  }
+
+  uint32_t start = time_us_32();
+  int slot = -1;
+  int oldest = 0;
+  for (int i = 0; i < COMMAND_CACHE_ENTRIES; i++) {
+    if (commandCache[i].lastUsed != 0 && strcmp(commandCache[i].key, key) == 0) {
+      slot = i;
+      break;
+    }
+    if (commandCache[i].lastUsed < commandCache[oldest].lastUsed) {
+      oldest = i;
+    }
+  }
+
+  bool hit = slot >= 0;
+  if (!hit) {
+    mp_obj_t fun = compileCommand(key);
+    if (fun == MP_OBJ_NULL) {
+      // a syntax error, or a number that has to stay a literal (const(5));
+      // run it as it came so any error is about what was typed
+      commandCacheStats.uncacheable++;
+      mp_embed_exec_str(command);
+      return;
+    }
+    slot = oldest;
+    if (commandCache[slot].lastUsed != 0) {
+      commandCacheStats.evictions++;
+    }
+    strcpy(commandCache[slot].key, key);
+    MP_STATE_VM(jl_command_cache)[slot] = fun;
+  }
+  commandCache[slot].lastUsed = ++commandCacheClock;
+
+  nlr_buf_t nlr;
+  if (nlr_push(&nlr) == 0) {
+    for (int i = 0; i < count; i++) {
+      mp_obj_t value = literals[i].isFloat ? mp_obj_new_float((mp_float_t)literals[i].f)
+                                           : mp_obj_new_int(literals[i].i);
+      mp_store_global(templateNames[i], value);
+    }
+    mp_call_function_0(MP_STATE_VM(jl_command_cache)[slot]);
+    nlr_pop();
+  } else {
+    mp_obj_print_exception(&mp_plat_print, (mp_obj_t)nlr.ret_val);
+  }
+
+  uint32_t us = time_us_32() - start;
+  if (hit) {
+    hitLatency[commandCacheStats.hits % COMMAND_CACHE_LATENCIES] = us;
+    commandCacheStats.hits++;
+  } else {
+    missLatency[commandCacheStats.misses % COMMAND_CACHE_LATENCIES] = us;
+    commandCacheStats.misses++;
+  }
+}
+
+// p50, p90 and p99 of the samples kept so far
+static void latencyPercentiles(const uint32_t *samples, uint32_t total, uint32_t *out) {
+  uint32_t n = total < COMMAND_CACHE_LATENCIES ? total : COMMAND_CACHE_LATENCIES;
+  uint32_t sorted[COMMAND_CACHE_LATENCIES];
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t v = samples[i];
+    uint32_t j = i;
+    while (j > 0 && sorted[j - 1] > v) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = v;
+  }
+  static const uint32_t percent[3] = {50, 90, 99};
+  for (int k = 0; k < 3; k++) {
+    out[k] = n == 0 ? 0 : sorted[(n - 1) * percent[k] / 100];
+  }
+}
+
+void printCommandCacheStats(Stream *stream) {
+  int used = 0;
+  for (int i = 0; i < COMMAND_CACHE_ENTRIES; i++) {
+    if (commandCache[i].lastUsed != 0) {
+      used++;
+    }
+  }
+  uint32_t lookups = commandCacheStats.hits + commandCacheStats.misses;
+  float hitRate = lookups == 0 ? 0 : 100.0f * commandCacheStats.hits / lookups;
+  stream->printf("command cache: %d/%d entries, %lu hits, %lu misses (%.1f%% hit rate)\n\r",
+                 used, COMMAND_CACHE_ENTRIES, commandCacheStats.hits, commandCacheStats.misses,
+                 hitRate);
+  stream->printf("evictions: %lu  uncacheable: %lu\n\r", commandCacheStats.evictions,
+                 commandCacheStats.uncacheable);
+
+  uint32_t hitP[3];
+  uint32_t missP[3];
+  latencyPercentiles(hitLatency, commandCacheStats.hits, hitP);
+  latencyPercentiles(missLatency, commandCacheStats.misses, missP);
+  stream->printf("hit  p50/p90/p99: %lu/%lu/%lu us\n\r", hitP[0], hitP[1], hitP[2]);
+  stream->printf("miss p50/p90/p99: %lu/%lu/%lu us (last %d of each)\n\r", missP[0], missP[1],
+                 missP[2], COMMAND_CACHE_LATENCIES);
+}
+
 /**
  * Execute a single MicroPython command with automatic initialization and prefix handling
  * This function can be called from main.cpp
@@ -3447,8 +3669,8 @@ bool executeSinglePythonCommand(const char* command, char* result_buffer, size_t
   
   bool success = true;
   
-  // Execute the command directly - MicroPython will handle errors internally
-  mp_embed_exec_str(parsed_command.c_str());
+  // Run it from the compiled-command cache - MicroPython still handles errors internally
+  execCachedCommand(parsed_command.c_str());
   
 
   if (result_buffer && buffer_size > 0) {
@@ -3487,7 +3709,7 @@ bool executeSinglePythonCommandFormatted(const char* command, char* result_buffe
   // Functions automatically return formatted strings like "HIGH", "3.300V", "123.4mA"
   
   // Simply execute the command - formatting is now handled by the native C module
-  mp_embed_exec_str(parsed_command.c_str());
+  execCachedCommand(parsed_command.c_str());
   
   // if (result_buffer && buffer_size > 0) {
   //   strncpy(result_buffer, "Formatted by native module", buffer_size - 1);
@@ -3523,7 +3745,7 @@ bool executeSinglePythonCommandFloat(const char* command, float* result) {
   
   // For now, just execute the command directly
   // TODO: Implement proper result capture to get the actual return value
-  mp_embed_exec_str(parsed_command.c_str());
+  execCachedCommand(parsed_command.c_str());
   
   return success;
 }
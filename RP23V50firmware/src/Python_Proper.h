@@ -127,6 +127,7 @@ bool executeSinglePythonCommand(const char* command, char* result_buffer = nullp
 bool executeSinglePythonCommandFormatted(const char* command, char* result_buffer, size_t buffer_size);
 bool executeSinglePythonCommandFloat(const char* command, float* result);
 float quickPythonCommand(const char* command);
+void printCommandCacheStats(Stream *stream = global_mp_stream);
 String parseCommandWithPrefix(const char* command);
 bool isJumperlessFunction(const char* function_name);
 
@@ -15,6 +15,7 @@
 #include "Graphics.h"
 #include "Menus.h"
 #include "Commands.h"
+#include "EventDispatch.h"
 
 
 
@@ -377,6 +378,13 @@ numberOfSteps = lastPositionEncoder - encoderRaw;
     encoderDirectionState = NONE;
   }
 
+  if (encoderDirectionState != NONE) {
+    eventPush(EVENT_ENCODER, 0, encoderDirectionState == UP ? 1 : -1);
+  }
+  if (encoderButtonState != lastButtonEncoderState) {
+    eventPush(EVENT_ENCODER_BUTTON, 0, encoderButtonState);
+  }
+
   // slotManager();
 
   // buttonState = digitalRead(BUTTON_ENC);
@@ -0,0 +1,453 @@
+// SPDX-License-Identifier: MIT
+#include "ScriptCache.h"
+#include "Python_Proper.h"
+#include <FatFS.h>
+#include <new>
+
+extern "C" {
+#include "py/compile.h"
+#include "py/lexer.h"
+#include "py/mperrno.h"
+#include "py/parse.h"
+#include "py/persistentcode.h"
+#include "py/reader.h"
+#include "py/runtime.h"
+#include <micropython_embed.h>
+}
+
+extern const char firmwareVersion[]; // main.cpp
+
+scriptCacheStatistics scriptCacheStats = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+struct scriptCacheTrailer {
+  char magic[4];         // "JLSC"
+  uint32_t sourceHash;
+  uint32_t sourceLength;
+  uint32_t micropython;  // MICROPY_VERSION
+  char firmware[16];
+};
+static_assert(sizeof(scriptCacheTrailer) == 32, "the trailer's read and written as it is");
+
+static const char trailerMagic[4] = {'J', 'L', 'S', 'C'};
+
+// what the REPL editor has, see scriptCacheNoteLoaded()
+static char loadedPath[SCRIPT_CACHE_PATH_MAX] = "";
+static uint32_t loadedHash = 0;
+static size_t loadedLength = 0;
+
+static String *warmQueue = nullptr;
+static int warmCount = 0;
+static int warmNext = 0;
+
+static bool saveError = false;
+
+// trailing whitespace doesn't count, the REPL strips it before running
+static size_t trimmedLength(const char *source, size_t length) {
+  while (length > 0 && (unsigned char)source[length - 1] <= ' ') {
+    length--;
+  }
+  return length;
+}
+
+static uint32_t sourceHash(const char *source, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ (uint8_t)source[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static void makeTrailer(scriptCacheTrailer *trailer, uint32_t hash, size_t length) {
+  memset(trailer, 0, sizeof(*trailer));
+  memcpy(trailer->magic, trailerMagic, sizeof(trailerMagic));
+  trailer->sourceHash = hash;
+  trailer->sourceLength = length;
+  trailer->micropython = MICROPY_VERSION;
+  strncpy(trailer->firmware, firmwareVersion, sizeof(trailer->firmware) - 1);
+}
+
+// name.py under SCRIPT_CACHE_DIR gets name.mpy, anything else isn't cached
+static bool mpyPathFor(const char *path, char *mpyPath, size_t size) {
+  size_t length = strlen(path);
+  size_t dirLength = strlen(SCRIPT_CACHE_DIR);
+  if (strncmp(path, SCRIPT_CACHE_DIR "/", dirLength + 1) != 0 || length < 4 ||
+      strcmp(path + length - 3, ".py") != 0 || length + 2 > size) {
+    return false;
+  }
+  memcpy(mpyPath, path, length - 2);
+  strcpy(mpyPath + length - 2, "mpy");
+  return true;
+}
+
+// the whole file in a new[] buffer, nullptr if it's missing or too big
+static char *readSource(const char *path, size_t *length) {
+  File file = FatFS.open(path, "r");
+  if (!file) {
+    return nullptr;
+  }
+  size_t size = file.size();
+  char *source = size <= SCRIPT_CACHE_MAX_SOURCE ? new (std::nothrow) char[size + 1] : nullptr;
+  if (source != nullptr && file.read((uint8_t *)source, size) != (int)size) {
+    delete[] source;
+    source = nullptr;
+  }
+  file.close();
+  if (source != nullptr) {
+    source[size] = '\0';
+    *length = size;
+  }
+  return source;
+}
+
+// whether the file's trailer is for this source, firmware and MicroPython
+static bool checkTrailer(File &file, uint32_t hash, size_t length) {
+  scriptCacheTrailer want;
+  scriptCacheTrailer have;
+  makeTrailer(&want, hash, length);
+  size_t size = file.size();
+  if (size <= sizeof(have) || !file.seek(size - sizeof(have)) ||
+      file.read((uint8_t *)&have, sizeof(have)) != (int)sizeof(have)) {
+    return false;
+  }
+  return memcmp(&want, &have, sizeof(have)) == 0;
+}
+
+static bool upToDate(const char *mpyPath, uint32_t hash, size_t length) {
+  File file = FatFS.open(mpyPath, "r");
+  if (!file) {
+    return false;
+  }
+  bool match = checkTrailer(file, hash, length);
+  file.close();
+  return match;
+}
+
+static void newContext(mp_compiled_module_t *cm) {
+  cm->context = m_new_obj(mp_module_context_t);
+  cm->context->module.globals = mp_globals_get();
+}
+
+// the bytecode in mpyPath into cm, if it was compiled from this source
+static bool loadCached(const char *mpyPath, uint32_t hash, size_t length, mp_compiled_module_t *cm) {
+  File file = FatFS.open(mpyPath, "r");
+  if (!file) {
+    scriptCacheStats.misses++;
+    return false;
+  }
+  if (!checkTrailer(file, hash, length)) {
+    file.close();
+    scriptCacheStats.stale++;
+    return false;
+  }
+  size_t mpyLength = file.size() - sizeof(scriptCacheTrailer);
+  uint8_t *data = new (std::nothrow) uint8_t[mpyLength];
+  bool ok = data != nullptr && file.seek(0) && file.read(data, mpyLength) == (int)mpyLength;
+  file.close();
+
+  if (ok) {
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+      newContext(cm);
+      mp_raw_code_load_mem(data, mpyLength, cm); // copies the bytecode to the heap
+      nlr_pop();
+    } else {
+      ok = false; // "incompatible .mpy file" or out of heap, compile it instead
+    }
+  }
+  delete[] data;
+  if (!ok) {
+    scriptCacheStats.stale++;
+  }
+  return ok;
+}
+
+static void filePrint(void *data, const char *str, size_t len) {
+  if (((File *)data)->write((const uint8_t *)str, len) != len) {
+    saveError = true;
+  }
+}
+
+static void saveCached(const char *mpyPath, mp_compiled_module_t *cm, uint32_t hash, size_t length) {
+  File file = FatFS.open(mpyPath, "w");
+  if (!file) {
+    scriptCacheStats.saveFailed++;
+    return;
+  }
+  saveError = false;
+  mp_print_t print = {&file, filePrint};
+  nlr_buf_t nlr;
+  if (nlr_push(&nlr) == 0) {
+    mp_raw_code_save(cm, &print);
+    nlr_pop();
+  } else {
+    saveError = true;
+  }
+  // the trailer goes last, so a half written file never matches
+  scriptCacheTrailer trailer;
+  makeTrailer(&trailer, hash, length);
+  if (!saveError) {
+    filePrint(&file, (const char *)&trailer, sizeof(trailer));
+  }
+  file.close();
+  if (saveError) {
+    FatFS.remove(mpyPath);
+    scriptCacheStats.saveFailed++;
+  } else {
+    scriptCacheStats.saved++;
+  }
+}
+
+// compiles source into cm, or returns the exception
+static mp_obj_t compileSource(const char *path, const char *source, size_t length,
+                              mp_compiled_module_t *cm) {
+  nlr_buf_t nlr;
+  if (nlr_push(&nlr) == 0) {
+    mp_lexer_t *lex = mp_lexer_new_from_str_len(qstr_from_str(path), source, length, 0);
+    qstr source_name = lex->source_name;
+    mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+    newContext(cm);
+    // compiled like the REPL always ran them, bare expressions print
+    mp_compile_to_raw_code(&parse_tree, source_name, true, cm);
+    nlr_pop();
+    return MP_OBJ_NULL;
+  }
+  return (mp_obj_t)nlr.ret_val;
+}
+
+// a script too big for readSource(), fed to the lexer straight off the file
+struct streamReader {
+  File file;
+  uint8_t buffer[256];
+  int length;
+  int next;
+};
+
+static mp_uint_t streamReadByte(void *data) {
+  streamReader *reader = (streamReader *)data;
+  if (reader->next >= reader->length) {
+    reader->length = reader->file.read(reader->buffer, sizeof(reader->buffer));
+    reader->next = 0;
+    if (reader->length <= 0) {
+      reader->length = 0;
+      return MP_READER_EOF;
+    }
+  }
+  return reader->buffer[reader->next++];
+}
+
+static void streamClose(void *data) {
+  streamReader *reader = (streamReader *)data;
+  reader->file.close();
+  delete reader;
+}
+
+// compiles and runs path without holding its source or caching it.
+// Returns the exception it raised, if any
+static mp_obj_t runStreamed(const char *path) {
+  streamReader *state = new (std::nothrow) streamReader();
+  if (state == nullptr) {
+    return mp_obj_new_exception(&mp_type_MemoryError);
+  }
+  state->file = FatFS.open(path, "r");
+  if (!state->file) {
+    delete state;
+    return mp_obj_new_exception_arg1(&mp_type_OSError, MP_OBJ_NEW_SMALL_INT(MP_EIO));
+  }
+  state->length = 0;
+  state->next = 0;
+  scriptCacheStats.uncached++;
+
+  volatile bool lexerOwns = false; // it closes the reader when it's done
+  nlr_buf_t nlr;
+  if (nlr_push(&nlr) == 0) {
+    uint32_t start = micros();
+    mp_reader_t reader = {state, streamReadByte, streamClose};
+    mp_lexer_t *lex = mp_lexer_new(qstr_from_str(path), reader);
+    lexerOwns = true;
+    qstr source_name = lex->source_name;
+    mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+    mp_compiled_module_t cm;
+    newContext(&cm);
+    mp_compile_to_raw_code(&parse_tree, source_name, true, &cm);
+    scriptCacheStats.lastCompileUs = micros() - start;
+    mp_call_function_0(mp_make_function_from_proto_fun(cm.rc, cm.context, NULL));
+    nlr_pop();
+    return MP_OBJ_NULL;
+  }
+  if (!lexerOwns) {
+    streamClose(state);
+  }
+  return (mp_obj_t)nlr.ret_val;
+}
+
+// runs source, from path's .mpy when it's up to date and saving one when it
+// isn't. Returns the exception it raised, if any
+static mp_obj_t runCached(const char *path, const char *source, size_t length) {
+  length = trimmedLength(source, length);
+  uint32_t hash = sourceHash(source, length);
+  char mpyPath[SCRIPT_CACHE_PATH_MAX];
+  bool cacheable = mpyPathFor(path, mpyPath, sizeof(mpyPath));
+
+  mp_compiled_module_t cm;
+  uint32_t start = micros();
+  if (cacheable && loadCached(mpyPath, hash, length, &cm)) {
+    scriptCacheStats.hits++;
+    scriptCacheStats.lastLoadUs = micros() - start;
+  } else {
+    mp_obj_t error = compileSource(path, source, length, &cm);
+    if (error != MP_OBJ_NULL) {
+      return error;
+    }
+    scriptCacheStats.lastCompileUs = micros() - start;
+    if (cacheable) {
+      saveCached(mpyPath, &cm, hash, length);
+    }
+  }
+
+  nlr_buf_t nlr;
+  if (nlr_push(&nlr) == 0) {
+    mp_call_function_0(mp_make_function_from_proto_fun(cm.rc, cm.context, NULL));
+    nlr_pop();
+    return MP_OBJ_NULL;
+  }
+  return (mp_obj_t)nlr.ret_val;
+}
+
+void scriptCacheNoteLoaded(const char *path, const char *source) {
+  if (strlen(path) >= sizeof(loadedPath)) {
+    loadedPath[0] = '\0';
+    return;
+  }
+  strcpy(loadedPath, path);
+  loadedLength = trimmedLength(source, strlen(source));
+  loadedHash = sourceHash(source, loadedLength);
+}
+
+void scriptCacheExec(const char *source) {
+  size_t length = trimmedLength(source, strlen(source));
+  if (loadedPath[0] == '\0' || length != loadedLength || sourceHash(source, length) != loadedHash) {
+    mp_embed_exec_str(source); // typed or edited, it has no file to cache next to
+    return;
+  }
+  mp_obj_t error = runCached(loadedPath, source, length);
+  if (error != MP_OBJ_NULL) {
+    mp_obj_print_exception(&mp_plat_print, error);
+  }
+}
+
+// "test", "test.py" and "examples/test.py" are under SCRIPT_CACHE_DIR, "/x/test.py" is as it is
+static bool scriptPath(const char *name, char *path, size_t size) {
+  const char *dir = name[0] == '/' ? "" : SCRIPT_CACHE_DIR "/";
+  size_t length = strlen(name);
+  const char *ext = length >= 3 && strcmp(name + length - 3, ".py") == 0 ? "" : ".py";
+  if (strlen(dir) + length + strlen(ext) + 1 > size) {
+    return false;
+  }
+  strcpy(path, dir);
+  strcat(path, name);
+  strcat(path, ext);
+  return true;
+}
+
+bool scriptCacheRunFile(const char *name, bool raise) {
+  char path[SCRIPT_CACHE_PATH_MAX];
+  if (!scriptPath(name, path, sizeof(path)) || !FatFS.exists(path)) {
+    return false;
+  }
+  size_t length = 0;
+  char *source = readSource(path, &length);
+  mp_obj_t error;
+  if (source != nullptr) {
+    error = runCached(path, source, length);
+    delete[] source;
+  } else {
+    // over SCRIPT_CACHE_MAX_SOURCE, or no room to read it in
+    error = runStreamed(path);
+  }
+  if (error != MP_OBJ_NULL) {
+    if (raise) {
+      nlr_raise(error);
+    }
+    mp_obj_print_exception(&mp_plat_print, error);
+  }
+  return true;
+}
+
+static void queueScripts(const String &dir, int depth) {
+  Dir entries = FatFS.openDir(dir);
+  while (entries.next() && warmCount < SCRIPT_CACHE_WARM_MAX) {
+    String path = dir + "/" + entries.fileName();
+    if (entries.isDirectory()) {
+      if (depth < 2) {
+        queueScripts(path, depth + 1);
+      }
+    } else if (path.endsWith(".py")) {
+      warmQueue[warmCount++] = path;
+    }
+  }
+}
+
+int scriptCacheWarm(void) {
+  if (warmQueue == nullptr) {
+    warmQueue = new (std::nothrow) String[SCRIPT_CACHE_WARM_MAX];
+    if (warmQueue == nullptr) {
+      return 0;
+    }
+  }
+  warmCount = 0;
+  warmNext = 0;
+  queueScripts(SCRIPT_CACHE_DIR, 0);
+  return warmCount;
+}
+
+bool scriptCacheWarming(void) { return warmQueue != nullptr && warmNext < warmCount; }
+
+void scriptCacheService(void) {
+  if (!scriptCacheWarming() || !isMicroPythonInitialized()) {
+    return;
+  }
+  // one script a call, skipping the ones that are already up to date
+  while (warmNext < warmCount) {
+    String path = warmQueue[warmNext++];
+    char mpyPath[SCRIPT_CACHE_PATH_MAX];
+    size_t length = 0;
+    char *source = mpyPathFor(path.c_str(), mpyPath, sizeof(mpyPath))
+                       ? readSource(path.c_str(), &length)
+                       : nullptr;
+    if (source == nullptr) {
+      continue;
+    }
+    length = trimmedLength(source, length);
+    uint32_t hash = sourceHash(source, length);
+    bool compiled = false;
+    if (!upToDate(mpyPath, hash, length)) {
+      mp_compiled_module_t cm;
+      // a script that doesn't compile is left for its run to complain about
+      if (compileSource(path.c_str(), source, length, &cm) == MP_OBJ_NULL) {
+        saveCached(mpyPath, &cm, hash, length);
+        scriptCacheStats.warmed++;
+      }
+      compiled = true;
+    }
+    delete[] source;
+    if (compiled) {
+      break;
+    }
+  }
+  if (warmNext >= warmCount) {
+    delete[] warmQueue;
+    warmQueue = nullptr;
+    warmCount = 0;
+    warmNext = 0;
+  }
+}
+
+void printScriptCacheStats(Stream *stream) {
+  stream->printf("script cache: %lu hits, %lu misses, %lu stale, %lu saved (%lu failed)\n\r",
+                 scriptCacheStats.hits, scriptCacheStats.misses, scriptCacheStats.stale,
+                 scriptCacheStats.saved, scriptCacheStats.saveFailed);
+  stream->printf("last .mpy load: %lu us  last compile: %lu us\n\r", scriptCacheStats.lastLoadUs,
+                 scriptCacheStats.lastCompileUs);
+  stream->printf("warmed: %lu  still queued: %d  run uncached: %lu\n\r", scriptCacheStats.warmed,
+                 scriptCacheWarming() ? warmCount - warmNext : 0, scriptCacheStats.uncached);
+}
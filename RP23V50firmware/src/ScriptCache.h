@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+#ifndef SCRIPTCACHE_H
+#define SCRIPTCACHE_H
+
+#include <Arduino.h>
+
+// Compiled-script cache for /python_scripts
+//
+// Compiling a long test script on the device takes a while and a good part of
+// the MicroPython heap, and it used to happen on every run. Now the first run
+// saves the compiled module next to the script, test.py -> test.mpy, and later
+// runs load that bytecode instead of compiling the source again.
+//
+// The .mpy is an ordinary one with a 32 byte trailer after it (the loader
+// stops before it) that says what it was compiled from: the source's FNV-1a
+// hash and length, the firmware version and the MicroPython version. If any
+// of them don't match, it's compiled again and the .mpy rewritten.
+//
+// scriptCacheWarm() queues every script under /python_scripts and
+// scriptCacheService() compiles one of them a call, from the main loop and
+// while the REPL waits for a key, so they're all ready before they're run.
+
+#define SCRIPT_CACHE_DIR "/python_scripts"
+#define SCRIPT_CACHE_PATH_MAX 128
+#define SCRIPT_CACHE_MAX_SOURCE 65536 // bigger ones are streamed to the lexer, not cached
+#define SCRIPT_CACHE_WARM_MAX 64
+
+struct scriptCacheStatistics {
+  uint32_t hits;
+  uint32_t misses;       // no .mpy yet
+  uint32_t stale;        // a .mpy from other source, firmware or MicroPython
+  uint32_t saved;
+  uint32_t saveFailed;
+  uint32_t warmed;       // compiled by scriptCacheService()
+  uint32_t uncached;     // too big to read in, compiled off the file every run
+  uint32_t lastLoadUs;   // reading and loading the .mpy
+  uint32_t lastCompileUs;
+};
+
+extern scriptCacheStatistics scriptCacheStats;
+
+/// the REPL loaded this script into its editor, so if that text is run
+/// unchanged scriptCacheExec() knows which file it came from
+void scriptCacheNoteLoaded(const char *path, const char *source);
+
+/// runs REPL input like mp_embed_exec_str(), through the cache when it's the
+/// script noted by scriptCacheNoteLoaded()
+void scriptCacheExec(const char *source);
+
+/// runs a script, name.py or a path, through the cache. false only if there's
+/// no such file; one over SCRIPT_CACHE_MAX_SOURCE is compiled straight off the
+/// file instead, uncached. With raise, the script's exception goes to the caller's nlr handler
+/// instead of being printed
+bool scriptCacheRunFile(const char *name, bool raise);
+
+/// queues every .py under SCRIPT_CACHE_DIR, returns how many
+int scriptCacheWarm(void);
+bool scriptCacheWarming(void);
+void scriptCacheService(void);
+
+void printScriptCacheStats(Stream *stream);
+
+#endif
@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: MIT
+#include "SequencePlan.h"
+#include <string.h>
+
+uint32_t seqPreloadUs(int channels, uint32_t busHz) {
+  if (channels <= 0) {
+    return 0;
+  }
+  if (busHz == 0) {
+    busHz = 100000;
+  }
+  // address then cmd, hi, lo per channel, 9 clocks a byte and the START/STOP
+  uint32_t clocks = (1 + 3 * channels) * 9 + 2;
+  uint32_t us = (uint32_t)(((uint64_t)clocks * 1000000 + busHz - 1) / busHz);
+  return us + us / 4 + 5; // clock stretching, the handler getting there
+}
+
+const char *seqErrorText(int error) {
+  switch (error) {
+  case SEQ_OK:
+    return "ok";
+  case SEQ_EMPTY:
+    return "no events";
+  case SEQ_BAD_OUTPUT:
+    return "unknown output or value out of range";
+  case SEQ_PIN_CONFLICT:
+    return "pin used as GPIO and PWM, or as the trigger";
+  case SEQ_DAC_TOO_CLOSE:
+    return "DAC events closer together than the DAC can be loaded";
+  case SEQ_PERIOD_TOO_SHORT:
+    return "period doesn't fit the events";
+  case SEQ_NEEDS_TRIGGER:
+    return "more than one pass needs a period or a trigger";
+  case SEQ_BUS_BUSY:
+    return "the wavegen is using the DAC";
+  case SEQ_PWM_OFF:
+    return "PWM output isn't set up";
+  case SEQ_NO_TIMER:
+    return "no hardware alarm free";
+  case SEQ_NO_MEMORY:
+    return "out of memory";
+  }
+  return "unknown error";
+}
+
+// the first event that landed in step s on one of the outputs in [first, last]
+static int eventIn(const seqPlan *plan, const seqEvent *events, int count, int s, int first,
+                   int last) {
+  for (int i = 0; i < count; i++) {
+    if (plan->eventStep[i] == s && events[i].output >= first && events[i].output <= last) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static bool valid(const seqEvent *e) {
+  if (e->output < SEQ_GPIO1) {
+    return e->value <= 4095;
+  }
+  if (e->output < SEQ_PWM1) {
+    return e->value <= 1;
+  }
+  return e->output < SEQ_OUTPUTS;
+}
+
+int seqCompile(seqPlan *plan, const seqEvent *events, int count, uint32_t period, int loops,
+               uint32_t busHz, int triggerPin) {
+  plan->stepCount = 0;
+  plan->pwmCount = 0;
+  plan->period = period;
+  plan->gpioUsed = 0;
+  plan->pwmUsed = 0;
+  plan->dacUsed = 0;
+  plan->badEvent = -1;
+  if (count <= 0) {
+    return SEQ_EMPTY;
+  }
+  if (count > SEQ_MAX_EVENTS) {
+    return SEQ_NO_MEMORY;
+  }
+  if (period == 0 && triggerPin < 0 && loops != 1) {
+    // the second pass would wait for an edge that can't come
+    return SEQ_NEEDS_TRIGGER;
+  }
+
+  // stable insertion sort of the indices by time, they're mostly in order already
+  uint16_t order[SEQ_MAX_EVENTS];
+  for (int i = 0; i < count; i++) {
+    if (!valid(&events[i])) {
+      plan->badEvent = i;
+      return SEQ_BAD_OUTPUT;
+    }
+    int j = i;
+    while (j > 0 && events[order[j - 1]].at > events[i].at) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = (uint16_t)i;
+  }
+
+  seqStep *step = nullptr;
+  for (int k = 0; k < count; k++) {
+    const seqEvent *e = &events[order[k]];
+    if (step == nullptr || step->at != e->at) {
+      step = &plan->steps[plan->stepCount++];
+      memset(step, 0, sizeof(*step));
+      step->at = e->at;
+      step->pwmFirst = (uint16_t)plan->pwmCount;
+    }
+    plan->eventStep[order[k]] = (uint16_t)(plan->stepCount - 1);
+
+    if (e->output < SEQ_GPIO1) {
+      step->dacMask |= 1 << e->output;
+      step->dac[e->output] = e->value;
+      plan->dacUsed |= 1 << e->output;
+    } else if (e->output < SEQ_PWM1) {
+      uint8_t bit = 1 << (e->output - SEQ_GPIO1);
+      if (e->value) {
+        step->gpioSet |= bit;
+        step->gpioClear &= ~bit;
+      } else {
+        step->gpioClear |= bit;
+        step->gpioSet &= ~bit;
+      }
+      plan->gpioUsed |= bit;
+    } else {
+      uint8_t pin = e->output - SEQ_PWM1;
+      seqPwmOp *op = &plan->pwm[step->pwmFirst];
+      int n = 0;
+      while (n < step->pwmCount && op[n].pin != pin) {
+        n++;
+      }
+      if (n == step->pwmCount) {
+        step->pwmCount++;
+        plan->pwmCount++;
+      }
+      op[n].pin = pin;
+      op[n].value = e->value;
+      plan->pwmUsed |= 1 << pin;
+    }
+  }
+
+  if ((plan->gpioUsed & plan->pwmUsed) ||
+      (triggerPin >= 0 && ((plan->gpioUsed | plan->pwmUsed) & (1 << triggerPin)))) {
+    return SEQ_PIN_CONFLICT;
+  }
+  uint32_t last = plan->steps[plan->stepCount - 1].at;
+  if (period != 0 && period <= last) {
+    return SEQ_PERIOD_TOO_SHORT;
+  }
+
+  // each DAC step's codes go out after the DAC step before it fires
+  int first = -1;
+  int previous = -1;
+  for (int s = 0; s < plan->stepCount; s++) {
+    const seqStep *st = &plan->steps[s];
+    if (!st->dacMask) {
+      continue;
+    }
+    uint32_t need = seqPreloadUs(__builtin_popcount(st->dacMask), busHz);
+    if (previous >= 0 && st->at - plan->steps[previous].at < need) {
+      plan->badEvent = eventIn(plan, events, count, s, SEQ_DAC0, SEQ_BOTTOM_RAIL);
+      return SEQ_DAC_TOO_CLOSE;
+    }
+    if (first < 0) {
+      first = s;
+    }
+    previous = s;
+  }
+  if (first >= 0 && period != 0) {
+    // round to the first one on the next pass
+    const seqStep *st = &plan->steps[first];
+    uint32_t gap = period - plan->steps[previous].at + st->at;
+    if (gap < seqPreloadUs(__builtin_popcount(st->dacMask), busHz)) {
+      plan->badEvent = eventIn(plan, events, count, first, SEQ_DAC0, SEQ_BOTTOM_RAIL);
+      return SEQ_DAC_TOO_CLOSE;
+    }
+  }
+  return SEQ_OK;
+}
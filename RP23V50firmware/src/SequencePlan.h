@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: MIT
+#ifndef SEQUENCEPLAN_H
+#define SEQUENCEPLAN_H
+
+#include <stdint.h>
+
+// Timelines for the output sequencer (Sequencer.h)
+//
+// A timeline is a list of (time, output, value) events in any order.
+// seqCompile() sorts them, stably, so of two events on one output at the same
+// time the one added last wins. Everything due in the same microsecond is
+// merged into one step: GPIO levels become a set and a clear mask, DAC codes a
+// channel mask and four codes, PWM duties a short run of ops. Firing a step is
+// then a handful of register writes.
+//
+// The MCP4728 is on I2C, far too slow to write at the moment a step is due.
+// The codes for a DAC step are loaded into the chip's input registers ahead of
+// time with LDAC held high, and the step only pulses LDAC. So each DAC step
+// has to come at least seqPreloadUs() after the one before it, looping round
+// included, and seqCompile() checks that.
+//
+// Kept free of Arduino and SDK headers, scripts/sequence_plan_test.py builds it
+// on the host.
+
+#define SEQ_MAX_EVENTS 512
+
+// outputs
+#define SEQ_DAC0 0        // MCP4728 channels A-D, the value is a 12-bit code
+#define SEQ_DAC1 1
+#define SEQ_TOP_RAIL 2
+#define SEQ_BOTTOM_RAIL 3
+#define SEQ_GPIO1 4       // GPIO_1-8 at 4-11, 0 or 1
+#define SEQ_PWM1 12       // duty of the PWM on GPIO_1-8 at 12-19, 0-65535
+#define SEQ_OUTPUTS 20
+#define SEQ_PINS 8
+
+enum seqError {
+  SEQ_OK = 0,
+  SEQ_EMPTY,
+  SEQ_BAD_OUTPUT,     // no such output, or a value it can't take
+  SEQ_PIN_CONFLICT,   // one pin used as GPIO and PWM, or as the trigger
+  SEQ_DAC_TOO_CLOSE,  // a DAC step before the last one's preload is done
+  SEQ_PERIOD_TOO_SHORT,
+  SEQ_NEEDS_TRIGGER,  // more than one pass with no period and nothing to start the next
+  // sequencerStart()'s
+  SEQ_BUS_BUSY,       // the wavegen is streaming to the DAC
+  SEQ_PWM_OFF,        // a PWM output that hasn't been set up
+  SEQ_NO_TIMER,
+  SEQ_NO_MEMORY,
+};
+
+struct seqEvent {
+  uint32_t at; // us from the start of the pass
+  uint8_t output;
+  uint16_t value;
+};
+
+struct seqPwmOp {
+  uint8_t pin;    // 0-7 for GPIO_1-8
+  uint16_t value; // duty, pwmWriteDuty() takes it from there
+};
+
+struct seqStep {
+  uint32_t at;
+  uint8_t gpioSet;   // bit n is GPIO_(n+1)
+  uint8_t gpioClear;
+  uint8_t dacMask;   // channels LDAC latches
+  uint8_t pwmCount;
+  uint16_t pwmFirst; // into seqPlan::pwm
+  uint16_t dac[4];
+};
+
+// the arrays are the caller's, each at least as long as the event list
+struct seqPlan {
+  seqStep *steps;
+  int stepCount;
+  seqPwmOp *pwm;
+  int pwmCount;
+  uint16_t *eventStep; // the step each event fires in, in the order they were added
+  uint32_t period;     // us from one pass to the next, 0 to wait for a trigger
+  uint8_t gpioUsed;    // pins driven as GPIO
+  uint8_t pwmUsed;
+  uint8_t dacUsed;
+  int badEvent;        // what an error is about, -1 if nothing in particular
+};
+
+/// SEQ_OK or a seqError. loops is 0 for ever, triggerPin is 0-7, or -1 for none
+int seqCompile(seqPlan *plan, const seqEvent *events, int count, uint32_t period, int loops,
+               uint32_t busHz, int triggerPin);
+/// how long loading this many DAC channels takes at busHz, with some margin
+uint32_t seqPreloadUs(int channels, uint32_t busHz);
+const char *seqErrorText(int error);
+
+#endif
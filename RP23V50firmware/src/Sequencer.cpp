@@ -0,0 +1,442 @@
+// SPDX-License-Identifier: MIT
+#include "Sequencer.h"
+#include "JumperlessDefines.h"
+#include "MCP4728.h"
+#include "Peripherals.h"
+#include "WaveGen.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/timer.h"
+#include <new>
+#include <string.h>
+
+extern MCP4728 mcp;
+extern WaveGen wavegen;
+
+// GPIO_1-8 are GP20-27 (gpioDef), so a step's pin masks shift straight into SIO's
+#define SEQ_GPIO_SHIFT 20
+
+sequencerStatistics sequencerStats = {};
+
+static seqEvent events[SEQ_MAX_EVENTS];
+static int eventCount = 0;
+static int compiledCount = 0;
+static int badEvent = -1;
+
+static seqPlan plan = {};
+static int32_t *fired = nullptr;  // per step, us from the start of its pass
+static int16_t *nextDac = nullptr; // per DAC step, the DAC step loaded after it fires
+static int alarmNum = -1;
+
+static volatile bool running = false;
+static volatile bool waiting = false;
+static volatile bool ownsWire = false;
+static volatile int next = 0;
+static volatile uint64_t base = 0;     // timer us the pass started at
+static int loopsLeft = 0;              // 0 for ever
+static int triggerGpio = -1;
+static uint32_t triggerEdges = 0;
+static volatile int pendingDac = -1;   // the DAC step sitting in the input registers
+static uint16_t shown[4];              // what each DAC channel is putting out
+
+static i2c_inst_t *const bus = i2c0;
+
+static void release(void) {
+  delete[] plan.steps;
+  delete[] plan.pwm;
+  delete[] plan.eventStep;
+  delete[] fired;
+  delete[] nextDac;
+  plan.steps = nullptr;
+  plan.pwm = nullptr;
+  plan.eventStep = nullptr;
+  fired = nullptr;
+  nextDac = nullptr;
+  compiledCount = 0;
+}
+
+static bool allocate(int count) {
+  release();
+  plan.steps = new (std::nothrow) seqStep[count];
+  plan.pwm = new (std::nothrow) seqPwmOp[count];
+  plan.eventStep = new (std::nothrow) uint16_t[count];
+  fired = new (std::nothrow) int32_t[count];
+  nextDac = new (std::nothrow) int16_t[count];
+  if (!plan.steps || !plan.pwm || !plan.eventStep || !fired || !nextDac) {
+    release();
+    return false;
+  }
+  return true;
+}
+
+static uint16_t voltsToCode(int channel, float volts) {
+  int code = (int)(volts * 4095.0f / dacSpread[channel]) + dacZero[channel];
+  return (uint16_t)(code < 0 ? 0 : (code > 4095 ? 4095 : code));
+}
+
+// the codes into the MCP4728's input registers, LDAC moves them to the outputs
+static void __not_in_flash_func(load)(uint8_t mask, const uint16_t *codes) {
+  if (mask == 0) {
+    return;
+  }
+  int last = 31 - __builtin_clz(mask);
+  for (int ch = 0; ch <= last; ch++) {
+    if (!(mask & (1 << ch))) {
+      continue;
+    }
+    // multi-write with UDAC=1, VREF=VDD, PD normal, gain 1x like setChannelValue()
+    bus->hw->data_cmd = 0x40 | (ch << 1) | 1;
+    bus->hw->data_cmd = (codes[ch] >> 8) & 0x0F;
+    bus->hw->data_cmd = (codes[ch] & 0xFF) | (ch == last ? I2C_IC_DATA_CMD_STOP_BITS : 0);
+  }
+}
+
+static bool __not_in_flash_func(busIdle)(void) {
+  return bus->hw->txflr == 0 && !(bus->hw->status & I2C_IC_STATUS_ACTIVITY_BITS);
+}
+
+static void __not_in_flash_func(preload)(int step) {
+  pendingDac = step;
+  if (step >= 0) {
+    load(plan.steps[step].dacMask, plan.steps[step].dac);
+  }
+}
+
+static void __not_in_flash_func(latch)(int step) {
+  if (!busIdle()) {
+    // too close behind the last one, or the bus is being stretched
+    sequencerStats.dacLate++;
+    uint32_t start = time_us_32();
+    while (!busIdle() && time_us_32() - start < 500) {
+      tight_loop_contents();
+    }
+  }
+  if (bus->hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+    sequencerStats.busErrors++;
+    (void)bus->hw->clr_tx_abrt;
+  }
+  sio_hw->gpio_clr = 1u << LDAC;
+  busy_wait_us_32(1);
+  sio_hw->gpio_set = 1u << LDAC;
+
+  const seqStep *s = &plan.steps[step];
+  for (int ch = 0; ch < 4; ch++) {
+    if (s->dacMask & (1 << ch)) {
+      shown[ch] = s->dac[ch];
+    }
+  }
+  int following = nextDac[step];
+  if (following >= 0 && following <= step && loopsLeft == 1) {
+    following = -1; // the last pass, nothing to go round to
+  }
+  preload(following);
+}
+
+static void __not_in_flash_func(fire)(int step) {
+  const seqStep *s = &plan.steps[step];
+  uint64_t now = time_us_64();
+  if (s->gpioSet) {
+    sio_hw->gpio_set = (uint32_t)s->gpioSet << SEQ_GPIO_SHIFT;
+  }
+  if (s->gpioClear) {
+    sio_hw->gpio_clr = (uint32_t)s->gpioClear << SEQ_GPIO_SHIFT;
+  }
+  for (int n = 0; n < s->pwmCount; n++) {
+    const seqPwmOp *op = &plan.pwm[s->pwmFirst + n];
+    pwmWriteDuty(op->pin, op->value);
+  }
+  if (s->dacMask) {
+    latch(step);
+  }
+
+  int32_t at = (int32_t)(now - base);
+  fired[step] = at;
+  int32_t late = at - (int32_t)s->at;
+  if (late > sequencerStats.worstLateUs) {
+    sequencerStats.worstLateUs = late;
+  }
+  sequencerStats.steps++;
+}
+
+static void finish(void) {
+  running = false;
+  waiting = false;
+  if (triggerGpio >= 0) {
+    gpio_set_irq_enabled(triggerGpio, triggerEdges, false);
+  }
+  if (ownsWire) {
+    uint32_t start = time_us_32();
+    while (!busIdle() && time_us_32() - start < 2000) {
+      tight_loop_contents();
+    }
+    if (pendingDac >= 0) {
+      // codes for a step that never fired, put back what's showing first
+      load(plan.steps[pendingDac].dacMask, shown);
+      pendingDac = -1;
+      while (!busIdle() && time_us_32() - start < 2000) {
+        tight_loop_contents();
+      }
+    }
+    (void)bus->hw->clr_tx_abrt;
+    sio_hw->gpio_clr = 1u << LDAC; // where the rest of the firmware keeps it
+    ownsWire = false;
+  }
+}
+
+static void __not_in_flash_func(endPass)(void) {
+  sequencerStats.passes++;
+  next = 0;
+  if (loopsLeft > 0 && --loopsLeft == 0) {
+    finish();
+    return;
+  }
+  if (plan.period == 0) {
+    waiting = true; // the next edge starts the next one
+    return;
+  }
+  base = base + plan.period;
+}
+
+static void __not_in_flash_func(onAlarm)(uint alarm) {
+  (void)alarm;
+  uint32_t start = time_us_32();
+  while (running && !waiting) {
+    uint64_t due = base + plan.steps[next].at;
+    if ((int64_t)(due - time_us_64()) > SEQUENCER_LEAD_US) {
+      if (!hardware_alarm_set_target(alarmNum, from_us_since_boot(due - SEQUENCER_LEAD_US))) {
+        break;
+      }
+      continue; // went by while it was being set
+    }
+    while ((int64_t)(due - time_us_64()) > 0) {
+      tight_loop_contents();
+    }
+    fire(next);
+    next = next + 1;
+    if (next == plan.stepCount) {
+      endPass();
+    }
+  }
+  uint32_t us = time_us_32() - start;
+  if (us > sequencerStats.maxHandlerUs) {
+    sequencerStats.maxHandlerUs = us;
+  }
+}
+
+static void __not_in_flash_func(onTrigger)(void) {
+  if (triggerGpio < 0) {
+    return;
+  }
+  uint32_t edges = gpio_get_irq_event_mask(triggerGpio) & triggerEdges;
+  if (!edges) {
+    return;
+  }
+  gpio_acknowledge_irq(triggerGpio, edges);
+  if (!running) {
+    return;
+  }
+  if (!waiting) {
+    sequencerStats.missedTriggers++;
+    return;
+  }
+  base = time_us_64();
+  waiting = false;
+  sequencerStats.triggers++;
+  hardware_alarm_force_irq(alarmNum);
+}
+
+void sequencerClear(void) {
+  sequencerStop();
+  release();
+  eventCount = 0;
+  badEvent = -1;
+}
+
+bool sequencerAdd(uint32_t atUs, int output, uint16_t value) {
+  if (running || eventCount >= SEQ_MAX_EVENTS || output < 0 || output >= SEQ_OUTPUTS) {
+    return false;
+  }
+  events[eventCount].at = atUs;
+  events[eventCount].output = (uint8_t)output;
+  events[eventCount].value = value;
+  eventCount++;
+  return true;
+}
+
+bool sequencerAddVolts(uint32_t atUs, int output, float volts) {
+  if (output < SEQ_DAC0 || output > SEQ_BOTTOM_RAIL) {
+    return false;
+  }
+  return sequencerAdd(atUs, output, voltsToCode(output, volts));
+}
+
+int sequencerEvents(void) {
+  return eventCount;
+}
+
+int sequencerBadEvent(void) {
+  return badEvent;
+}
+
+int sequencerStart(int loops, uint32_t periodUs, int triggerPin, bool rising) {
+  sequencerStop();
+  badEvent = -1;
+  if (triggerPin < 0 || triggerPin > SEQ_PINS) {
+    return SEQ_BAD_OUTPUT;
+  }
+  if (eventCount == 0) {
+    return SEQ_EMPTY;
+  }
+  if (!allocate(eventCount)) {
+    return SEQ_NO_MEMORY;
+  }
+  int error = seqCompile(&plan, events, eventCount, periodUs, loops, mcp.getClockHz(),
+                         triggerPin - 1);
+  badEvent = plan.badEvent;
+  if (error != SEQ_OK) {
+    return error;
+  }
+  if (plan.dacUsed && (wavegen.isRunning() || waveGenOwnsWire())) {
+    return SEQ_BUS_BUSY;
+  }
+
+  for (int pin = 0; pin < SEQ_PINS; pin++) {
+    if ((plan.pwmUsed & (1 << pin)) && !gpioPWMEnabled[pin]) {
+      return SEQ_PWM_OFF;
+    }
+  }
+
+  if (alarmNum < 0) {
+    alarmNum = hardware_alarm_claim_unused(false);
+    if (alarmNum < 0) {
+      return SEQ_NO_TIMER;
+    }
+  }
+  // the IRQ goes to this core, core 0, ahead of everything else on it
+  hardware_alarm_set_callback(alarmNum, onAlarm);
+  irq_set_priority(hardware_alarm_get_irq_num(alarmNum), 0);
+
+  int first = -1;
+  int previous = -1;
+  for (int s = 0; s < plan.stepCount; s++) {
+    fired[s] = -1;
+    nextDac[s] = -1;
+    if (plan.steps[s].dacMask) {
+      if (previous >= 0) {
+        nextDac[previous] = (int16_t)s;
+      } else {
+        first = s;
+      }
+      previous = s;
+    }
+  }
+  if (previous >= 0 && loops != 1) {
+    nextDac[previous] = (int16_t)first; // round again
+  }
+  compiledCount = eventCount;
+
+  for (int pin = 0; pin < SEQ_PINS; pin++) {
+    if (plan.gpioUsed & (1 << pin)) {
+      gpio_set_function(SEQ_GPIO_SHIFT + pin, GPIO_FUNC_SIO);
+      gpio_set_dir(SEQ_GPIO_SHIFT + pin, true);
+    }
+  }
+
+  memset(&sequencerStats, 0, sizeof(sequencerStats));
+  next = 0;
+  loopsLeft = loops;
+
+  if (plan.dacUsed) {
+    shown[0] = voltsToCode(0, dacOutput[0]);
+    shown[1] = voltsToCode(1, dacOutput[1]);
+    shown[2] = voltsToCode(2, railVoltage[0]);
+    shown[3] = voltsToCode(3, railVoltage[1]);
+    // the address only changes with the controller off, as in WaveGen
+    bus->hw->enable = 0;
+    bus->hw->tar = mcp.getAddress();
+    bus->hw->enable = 1;
+    (void)bus->hw->clr_tx_abrt;
+    ownsWire = true;
+    sio_hw->gpio_set = 1u << LDAC;
+    preload(first);
+  }
+
+  running = true;
+  if (triggerPin) {
+    triggerGpio = SEQ_GPIO_SHIFT + triggerPin - 1;
+    triggerEdges = rising ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    gpio_set_function(triggerGpio, GPIO_FUNC_SIO);
+    gpio_set_dir(triggerGpio, false);
+    waiting = true;
+    gpio_add_raw_irq_handler(triggerGpio, onTrigger);
+    gpio_acknowledge_irq(triggerGpio, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL);
+    gpio_set_irq_enabled(triggerGpio, triggerEdges, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+  } else {
+    base = time_us_64() + SEQUENCER_START_US;
+    hardware_alarm_force_irq(alarmNum);
+  }
+  return SEQ_OK;
+}
+
+void sequencerStop(void) {
+  if (alarmNum >= 0) {
+    hardware_alarm_cancel(alarmNum);
+  }
+  uint32_t saved = save_and_disable_interrupts();
+  bool was = running;
+  running = false;
+  restore_interrupts(saved);
+  if (was || ownsWire) {
+    finish();
+  }
+  if (triggerGpio >= 0) {
+    gpio_remove_raw_irq_handler(triggerGpio, onTrigger);
+    triggerGpio = -1;
+  }
+}
+
+bool sequencerRunning(void) {
+  return running;
+}
+
+bool sequencerWaiting(void) {
+  return running && waiting;
+}
+
+int32_t sequencerFiredAt(int event) {
+  if (event < 0 || event >= compiledCount || fired == nullptr) {
+    return -1;
+  }
+  return fired[plan.eventStep[event]];
+}
+
+uint32_t sequencerScheduledAt(int event) {
+  if (event < 0 || event >= eventCount) {
+    return 0;
+  }
+  return events[event].at;
+}
+
+bool sequencerOwnsWire(void) {
+  return ownsWire;
+}
+
+void printSequencerStats(Stream *stream) {
+  stream->printf("sequencer: %s, %d events in %d steps",
+                 !running ? "stopped" : (waiting ? "waiting for trigger" : "running"),
+                 eventCount, compiledCount ? plan.stepCount : 0);
+  if (compiledCount && plan.period) {
+    stream->printf(", every %lu us", plan.period);
+  }
+  stream->printf("\n\r  %lu passes, %lu steps", sequencerStats.passes, sequencerStats.steps);
+  if (sequencerStats.steps) {
+    stream->printf(", worst %ld us late", (long)sequencerStats.worstLateUs);
+  }
+  stream->printf(", longest handler %lu us\n\r", sequencerStats.maxHandlerUs);
+  stream->printf("  %lu DAC steps waited on their preload, %lu bus errors, %lu triggers "
+                 "(%lu during a pass)\n\r",
+                 sequencerStats.dacLate, sequencerStats.busErrors, sequencerStats.triggers,
+                 sequencerStats.missedTriggers);
+}
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MIT
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <Arduino.h>
+#include "SequencePlan.h"
+
+// Timed stimulus on the DACs, rails, GPIO and PWM
+//
+// A script builds a timeline with sequencerAdd() and sequencerStart() compiles
+// it into steps (SequencePlan.h) and hands them to a hardware alarm on core 0.
+// The alarm goes off SEQUENCER_LEAD_US before a step is due and the handler,
+// at the highest IRQ priority, spins to the exact microsecond before it writes
+// the outputs, so steps land within a microsecond or so whatever MicroPython
+// or the main loop are doing. It records when each step actually fired, which
+// sequencerFiredAt() reads back.
+//
+// GPIO steps are one write each to the SIO set and clear registers. PWM steps
+// write the slice's compare level, or queue the PIO's next level for pins on
+// a PIO, which take it up at the end of the period they're in. DAC and rail steps pulse the MCP4728's LDAC
+// pin: the handler loads the next DAC step's codes into the chip's input
+// registers over I2C straight after the previous one fires, by dropping the
+// words into I2C0's TX FIFO, which sends them on its own. While a timeline
+// with DAC steps runs, the sequencer owns I2C0 the same way the wavegen does.
+// sequencerOwnsWire() says when, and the INA219 poller stays off the bus.
+//
+// A timeline can run once, a number of times or for ever, period us apart. It
+// can also wait for an edge on a GPIO pin to start, and with no period it
+// waits for another edge before every pass.
+
+#define SEQUENCER_LEAD_US 4     // the alarm's this early, the handler spins the rest
+#define SEQUENCER_START_US 200  // from sequencerStart() to the first pass
+
+struct sequencerStatistics {
+  uint32_t passes;
+  uint32_t steps;
+  int32_t worstLateUs;   // fired minus scheduled, over every step since the start
+  uint32_t maxHandlerUs; // longest the alarm handler ran
+  uint32_t dacLate;      // a DAC step's codes were still going out when it was due
+  uint32_t busErrors;    // the MCP4728 didn't ACK a preload
+  uint32_t triggers;
+  uint32_t missedTriggers; // an edge came in while a pass was still running
+};
+
+extern sequencerStatistics sequencerStats;
+
+void sequencerClear(void);
+/// output is one of SEQ_*, value as SequencePlan.h has it. False if the
+/// timeline's full or it's running
+bool sequencerAdd(uint32_t atUs, int output, uint16_t value);
+/// DAC0, DAC1 or a rail in volts, through the DAC calibration
+bool sequencerAddVolts(uint32_t atUs, int output, float volts);
+int sequencerEvents(void);
+
+/// compiles the timeline and starts it: loops passes (0 for ever) period us
+/// apart. triggerPin 1-8 waits for an edge on GPIO_n first, and before every
+/// pass if period is 0. Without a trigger, a period of 0 only goes with a
+/// single pass. SEQ_OK or a seqError, sequencerBadEvent() says which
+/// event it's about if it's any one in particular
+int sequencerStart(int loops, uint32_t periodUs, int triggerPin = 0, bool rising = true);
+int sequencerBadEvent(void);
+void sequencerStop(void);
+bool sequencerRunning(void);
+/// armed, waiting on the trigger
+bool sequencerWaiting(void);
+
+/// when event n (in the order added) last fired, us from the start of its
+/// pass, or -1 if it hasn't
+int32_t sequencerFiredAt(int event);
+uint32_t sequencerScheduledAt(int event);
+
+/// true while a timeline with DAC steps holds I2C0, Wire can't be used
+bool sequencerOwnsWire(void);
+void printSequencerStats(Stream *stream);
+
+#endif
@@ -0,0 +1,342 @@
+// SPDX-License-Identifier: MIT
+#include "Telemetry.h"
+#include "AdcSampler.h"
+#include "ArduinoStuff.h"
+#include "BinaryStream.h"
+#include "InaSampler.h"
+#include "Peripherals.h"
+#include "config.h"
+#include "pico/time.h"
+
+telemetryStatistics telemetryStats = {0, 0, 0, 0, 0};
+
+// single producer (the timer on core 0), single consumer (Python on core 0 or
+// the host service on core 1), head and tail only ever move forward
+static uint8_t ring[TELEMETRY_RING_SIZE];
+static volatile uint32_t ringHead = 0;
+static volatile uint32_t ringTail = 0;
+
+static repeating_timer_t timer;
+static volatile bool running = false;
+static uint32_t subscribed = 0;
+static int rate = 0;
+static int recordSize = 4;
+static telemetryOwner owner = TELEMETRY_OWNER_NONE;
+
+// last good values, the timer falls back on these while the ADC is busy
+static int16_t adcLast[ADC_SAMPLER_CHANNELS];
+
+static inline int16_t clamp16(float value) {
+  if (value > 32767.0f) {
+    return 32767;
+  }
+  if (value < -32768.0f) {
+    return -32768;
+  }
+  return (int16_t)lroundf(value);
+}
+
+static int16_t __not_in_flash_func(readAdcChannel)(int channel) {
+  // sequence 0 is right after a (re)start, latest would wait for the block
+  if (adcSamplerHas(channel) && adcSamplerSequence(channel) != 0) {
+    float volts = adcSamplerLatest(channel) * (adcSpread[channel] / 4095);
+    if (channel != 4 && channel != 5) {
+      volts -= adcZero[channel];
+    }
+    adcLast[channel] = clamp16(volts * 1000.0f);
+  }
+  return adcLast[channel];
+}
+
+static int16_t readInaChannel(int channel) {
+  int sensor = (channel - TELEMETRY_INA0_CURRENT) / 3;
+  int quantity = (channel - TELEMETRY_INA0_CURRENT) % 3;
+  float value = inaSamplerCached(sensor, quantity);
+  if (quantity == INA_CURRENT) {
+    return clamp16(value * 10.0f);
+  }
+  if (quantity == INA_BUS_VOLTAGE) {
+    return clamp16(value * 1000.0f);
+  }
+  return clamp16(value);
+}
+
+static int16_t __not_in_flash_func(readGpioLevels)(void) {
+  uint32_t levels = gpio_get_all();
+  int16_t bits = 0;
+  for (int i = 0; i < 10; i++) {
+    if ((levels >> gpioDef[i][0]) & 1) {
+      bits |= 1 << i;
+    }
+  }
+  return bits;
+}
+
+static bool __not_in_flash_func(tick)(repeating_timer_t *t) {
+  (void)t;
+  if (!running) {
+    return false;
+  }
+  uint32_t start = time_us_32();
+
+  uint32_t head = ringHead;
+  if (TELEMETRY_RING_SIZE - (head - ringTail) < (uint32_t)recordSize) {
+    telemetryStats.dropped++;
+    return true;
+  }
+
+  uint8_t record[TELEMETRY_RECORD_MAX];
+  record[0] = start & 0xff;
+  record[1] = (start >> 8) & 0xff;
+  record[2] = (start >> 16) & 0xff;
+  record[3] = start >> 24;
+  int length = 4;
+
+  uint32_t mask = subscribed;
+  while (mask != 0) {
+    int channel = __builtin_ctz(mask);
+    mask &= mask - 1;
+
+    int16_t value;
+    if (channel < TELEMETRY_INA0_CURRENT) {
+      value = readAdcChannel(channel);
+    } else if (channel < TELEMETRY_GPIO) {
+      value = readInaChannel(channel);
+    } else {
+      value = readGpioLevels();
+    }
+    record[length++] = value & 0xff;
+    record[length++] = (uint16_t)value >> 8;
+  }
+
+  for (int i = 0; i < length; i++) {
+    ring[(head + i) & (TELEMETRY_RING_SIZE - 1)] = record[i];
+  }
+  __dmb();
+  ringHead = head + length;
+  telemetryStats.records++;
+
+  telemetryStats.lastTickUs = time_us_32() - start;
+  if (telemetryStats.lastTickUs > telemetryStats.maxTickUs) {
+    telemetryStats.maxTickUs = telemetryStats.lastTickUs;
+  }
+  return true;
+}
+
+bool telemetryStart(uint32_t mask, int rateHz, telemetryOwner who) {
+  telemetryStop();
+  mask &= TELEMETRY_CHANNEL_MASK;
+  if (mask == 0 || rateHz < 1 || rateHz > TELEMETRY_MAX_RATE) {
+    return false;
+  }
+
+  subscribed = mask;
+  rate = rateHz;
+  recordSize = 4 + 2 * __builtin_popcount(mask);
+  owner = who;
+  ringTail = ringHead;
+  telemetryStats.records = 0;
+  telemetryStats.dropped = 0;
+  telemetryStats.maxTickUs = 0;
+
+  running = true;
+  // negative delay keeps the rate from drifting by however long a tick took
+  if (!add_repeating_timer_us(-(int64_t)(1000000 / rateHz), tick, nullptr,
+                              &timer)) {
+    running = false;
+    owner = TELEMETRY_OWNER_NONE;
+    return false;
+  }
+  return true;
+}
+
+void telemetryStop(void) {
+  if (!running) {
+    return;
+  }
+  running = false;
+  cancel_repeating_timer(&timer);
+  owner = TELEMETRY_OWNER_NONE;
+}
+
+bool telemetryRunning(void) { return running; }
+
+uint32_t telemetryMask(void) { return running ? subscribed : 0; }
+
+int telemetryRate(void) { return running ? rate : 0; }
+
+telemetryOwner telemetryOwnedBy(void) { return owner; }
+
+int telemetryRecordSize(void) { return recordSize; }
+
+int telemetryPending(void) { return ringHead - ringTail; }
+
+int telemetryRead(uint8_t *out, int maxBytes) {
+  uint32_t tail = ringTail;
+  int available = ringHead - tail;
+  __dmb();
+
+  int length = available < maxBytes ? available : maxBytes;
+  length -= length % recordSize;
+  for (int i = 0; i < length; i++) {
+    out[i] = ring[(tail + i) & (TELEMETRY_RING_SIZE - 1)];
+  }
+  __dmb();
+  ringTail = tail + length;
+  return length;
+}
+
+// host side
+
+static Adafruit_USBD_CDC *telemetryLastPort = nullptr;
+static unsigned long lastFrameTime = 0;
+static uint16_t frameSeq = 0;
+static uint8_t payload[TELEMETRY_FRAME_BYTES];
+
+// command parser state, 'S' takes 6 bytes of arguments
+static char pendingCommand = 0;
+static uint8_t pendingArgs[6];
+static int pendingArgCount = 0;
+
+static Adafruit_USBD_CDC *telemetryCdc(void) {
+  if (jumperlessConfig.serial_2.function == UART_FUNCTION_TELEMETRY) {
+    return &USBSer2;
+  }
+  if (jumperlessConfig.serial_1.function == UART_FUNCTION_TELEMETRY) {
+    return &USBSer1;
+  }
+  return nullptr;
+}
+
+Stream *telemetryPort(void) { return telemetryCdc(); }
+
+static inline void put16(uint8_t *out, uint16_t value) {
+  out[0] = value & 0xff;
+  out[1] = value >> 8;
+}
+
+static inline void put32(uint8_t *out, uint32_t value) {
+  out[0] = value & 0xff;
+  out[1] = (value >> 8) & 0xff;
+  out[2] = (value >> 16) & 0xff;
+  out[3] = value >> 24;
+}
+
+static void sendInfo(Stream *port) {
+  uint8_t info[20];
+  info[0] = TELEMETRY_VERSION;
+  info[1] = owner;
+  put32(info + 2, telemetryMask());
+  put16(info + 6, telemetryRate());
+  put16(info + 8, recordSize);
+  put32(info + 10, telemetryStats.records);
+  put32(info + 14, telemetryStats.dropped);
+  put16(info + 18, TELEMETRY_RING_SIZE / recordSize);
+  writeBinaryFrame(port, BINARY_STREAM_TELEMETRY, TELEMETRY_INFO, frameSeq++,
+                   info, sizeof(info));
+}
+
+static void runCommand(Stream *port, char command) {
+  switch (command) {
+  case 'S': {
+    uint32_t mask = pendingArgs[0] | (pendingArgs[1] << 8) |
+                    (pendingArgs[2] << 16) | ((uint32_t)pendingArgs[3] << 24);
+    int rateHz = pendingArgs[4] | (pendingArgs[5] << 8);
+    telemetryStart(mask, rateHz, TELEMETRY_OWNER_HOST);
+    sendInfo(port); // so the host knows the record layout, or that it failed
+    break;
+  }
+  case 'I':
+    sendInfo(port);
+    break;
+  case 'X':
+    if (owner == TELEMETRY_OWNER_HOST) {
+      telemetryStop();
+    }
+    break;
+  }
+}
+
+static void handleCommands(Stream *port) {
+  for (int i = 0; i < 16 && port->available() > 0; i++) {
+    uint8_t c = port->read();
+
+    if (pendingCommand != 0) {
+      pendingArgs[pendingArgCount++] = c;
+      if (pendingArgCount >= (int)sizeof(pendingArgs)) {
+        runCommand(port, pendingCommand);
+        pendingCommand = 0;
+      }
+      continue;
+    }
+
+    if (c == 'S') {
+      pendingCommand = c;
+      pendingArgCount = 0;
+    } else {
+      runCommand(port, c);
+    }
+  }
+}
+
+void telemetryService(void) {
+  Adafruit_USBD_CDC *port = telemetryCdc();
+
+  if (port != telemetryLastPort) {
+    if (owner == TELEMETRY_OWNER_HOST) {
+      telemetryStop();
+    }
+    pendingCommand = 0;
+    telemetryLastPort = port;
+  }
+  if (port == nullptr) {
+    return;
+  }
+  if (!port->dtr()) {
+    if (owner == TELEMETRY_OWNER_HOST) {
+      telemetryStop(); // nobody's listening, don't fill the ring for no one
+    }
+    pendingCommand = 0;
+    return;
+  }
+
+  handleCommands(port);
+
+  if (owner != TELEMETRY_OWNER_HOST) {
+    return;
+  }
+  int pending = telemetryPending();
+  if (pending == 0 || (pending < TELEMETRY_FRAME_BYTES &&
+                       millis() - lastFrameTime < TELEMETRY_FRAME_INTERVAL_MS)) {
+    return;
+  }
+  if (port->availableForWrite() < 64) {
+    return; // host isn't keeping up, records pile up in the ring instead
+  }
+  lastFrameTime = millis();
+
+  int length = telemetryRead(payload, TELEMETRY_FRAME_BYTES);
+  if (writeBinaryFrame(port, BINARY_STREAM_TELEMETRY, TELEMETRY_RECORDS,
+                       frameSeq++, payload, length)) {
+    telemetryStats.frames++;
+  } else {
+    // the host throws the partial frame away, the seq gap tells it why
+    telemetryStats.dropped += length / recordSize;
+  }
+}
+
+void printTelemetryStats(Stream *stream) {
+  if (!running) {
+    stream->printf("telemetry: stopped\n\r");
+    return;
+  }
+  static const char *owners[] = {"none", "python", "host"};
+  stream->printf("telemetry: mask 0x%04lX at %d Hz, %d byte records, read by %s\n\r",
+                 subscribed, rate, recordSize, owners[owner]);
+  stream->printf("records: %lu  dropped: %lu  frames: %lu\n\r",
+                 telemetryStats.records, telemetryStats.dropped,
+                 telemetryStats.frames);
+  stream->printf("tick: %lu us (max %lu us)  buffered: %d bytes\n\r",
+                 telemetryStats.lastTickUs, telemetryStats.maxTickUs,
+                 telemetryPending());
+}
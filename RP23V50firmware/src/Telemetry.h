@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MIT
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+// Timestamped measurement streaming
+//
+// A script or a host subscribes to a set of channels at a rate and a repeating
+// timer on core 0 writes one record per tick into a ring:
+//
+//   u32 time_us, then one i16 per subscribed channel, lowest channel first
+//
+// ADC channels come from the background sampler (AdcSampler), the INA219s
+// from InaSampler's cache and GPIO straight from SIO, so the timer never waits
+// on anything. INA values are the last conversion read, up to a conversion
+// time (~17 ms) older than the timestamp.
+//
+// MicroPython pulls whole records out with telemetry_read(). A host gets them
+// as BinaryStream frames (stream id 'T') on a CDC port set to "telemetry",
+// driven with single byte commands on the same port:
+//
+//   'S' mask(u32) rate(u16)   subscribe and stream
+//   'I'                       send an info frame
+//   'X'                       stop
+//
+// scripts/telemetry_stream.py is the reference decoder.
+
+// serial_x.function value for a CDC port that carries the stream
+#define UART_FUNCTION_TELEMETRY 7
+
+#define TELEMETRY_VERSION 1
+
+// channel numbers, bit n of a mask subscribes channel n
+#define TELEMETRY_ADC0 0          // ADC0-7 at 0-7, mV
+#define TELEMETRY_INA0_CURRENT 8  // 0.1 mA
+#define TELEMETRY_INA0_VOLTAGE 9  // bus voltage, mV
+#define TELEMETRY_INA0_POWER 10   // mW
+#define TELEMETRY_INA1_CURRENT 11
+#define TELEMETRY_INA1_VOLTAGE 12
+#define TELEMETRY_INA1_POWER 13
+#define TELEMETRY_GPIO 14         // bit n = GPIO n+1 (GPIO 9/10 are UART TX/RX)
+#define TELEMETRY_CHANNELS 15
+#define TELEMETRY_CHANNEL_MASK ((1UL << TELEMETRY_CHANNELS) - 1)
+
+#define TELEMETRY_MAX_RATE 5000   // Hz
+#define TELEMETRY_RING_SIZE 16384 // bytes, power of two
+#define TELEMETRY_RECORD_MAX (4 + 2 * TELEMETRY_CHANNELS)
+
+#define TELEMETRY_RECORDS 0 // whole records back to back
+#define TELEMETRY_INFO 1    // see sendInfo()
+
+// a frame goes out when this much is waiting, or after the interval
+#define TELEMETRY_FRAME_BYTES 512
+#define TELEMETRY_FRAME_INTERVAL_MS 20
+
+// who reads the ring, only one of them can without losing records
+enum telemetryOwner {
+  TELEMETRY_OWNER_NONE = 0,
+  TELEMETRY_OWNER_PYTHON,
+  TELEMETRY_OWNER_HOST,
+};
+
+struct telemetryStatistics {
+  uint32_t records;
+  uint32_t dropped;     // ring was full, the new record was thrown away
+  uint32_t frames;
+  uint32_t lastTickUs;  // time the last timer tick took
+  uint32_t maxTickUs;
+};
+
+extern telemetryStatistics telemetryStats;
+
+/// subscribes mask at rateHz (1 to TELEMETRY_MAX_RATE), dropping anything
+/// still buffered. False if the mask or rate is out of range or there's no
+/// timer to be had
+bool telemetryStart(uint32_t mask, int rateHz,
+                    telemetryOwner owner = TELEMETRY_OWNER_PYTHON);
+void telemetryStop(void);
+bool telemetryRunning(void);
+uint32_t telemetryMask(void);
+int telemetryRate(void);
+telemetryOwner telemetryOwnedBy(void);
+/// bytes in one record for the current mask
+int telemetryRecordSize(void);
+
+/// bytes waiting, always a whole number of records
+int telemetryPending(void);
+/// copies out as many whole records as fit in maxBytes, returns the bytes
+int telemetryRead(uint8_t *out, int maxBytes);
+
+Stream *telemetryPort(void);
+/// loop1() (core 1), runs host commands and sends frames
+void telemetryService(void);
+
+void printTelemetryStats(Stream *stream = &Serial);
+
+#endif
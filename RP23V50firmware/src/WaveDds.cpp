@@ -0,0 +1,319 @@
+// SPDX-License-Identifier: MIT
+#include "WaveDds.h"
+#include <math.h>
+#include <string.h>
+
+// one cycle plus the first point again, so interpolation never wraps
+static int16_t sineTable[DDS_TABLE_SIZE + 1];
+static bool sineBuilt = false;
+
+#define FRAC_BITS 15
+
+static void buildSine(void) {
+  for (int i = 0; i <= DDS_TABLE_SIZE; i++) {
+    double v = sin(2.0 * M_PI * i / DDS_TABLE_SIZE) * DDS_FULL_SCALE;
+    sineTable[i] = (int16_t)lround(v);
+  }
+  sineBuilt = true;
+}
+
+uint32_t ddsIncrement(float hz, float frameRate) {
+  if (frameRate <= 0.0f || hz <= 0.0f) {
+    return 0;
+  }
+  double step = (double)hz / (double)frameRate * 4294967296.0;
+  if (step >= 2147483647.0) {
+    return 0x7fffffff; // Nyquist, it's a square wave at best from here
+  }
+  uint32_t increment = (uint32_t)(step + 0.5);
+  return increment ? increment : 1;
+}
+
+float ddsFrequency(uint32_t increment, float frameRate) {
+  return (float)((double)increment * (double)frameRate / 4294967296.0);
+}
+
+void ddsInit(ddsState *dds, float frameRate) {
+  if (!sineBuilt) {
+    buildSine();
+  }
+  memset(dds, 0, sizeof(*dds));
+  ddsParams *p = &dds->staged;
+  p->frequency = 100.0f;
+  p->codeMax = 4095;
+  for (int i = 0; i < DDS_CHANNELS; i++) {
+    p->out[i].waveform = DDS_SINE;
+    p->out[i].harmonic = 1;
+  }
+  dds->active = *p;
+  dds->frameRate = frameRate;
+  dds->increment = ddsIncrement(p->frequency, frameRate);
+}
+
+ddsParams *ddsEdit(ddsState *dds) {
+  dds->sequence = dds->sequence + 1;
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  return &dds->staged;
+}
+
+void ddsCommit(ddsState *dds) {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  dds->sequence = dds->sequence + 1;
+}
+
+static uint64_t stepFor(float rate, float frameRate) {
+  if (rate <= 0.0f || frameRate <= 0.0f) {
+    return 0;
+  }
+  return (uint64_t)((double)rate / (double)frameRate * 4294967296.0 + 0.5);
+}
+
+static void sweepStart(ddsState *dds) {
+  const ddsParams *p = &dds->active;
+  dds->sweepId = p->sweepId;
+  dds->sweeping = true;
+  dds->sweepFrame = 0;
+  float frames = p->sweepSeconds * dds->frameRate;
+  dds->sweepFrames = frames < DDS_SWEEP_STEP ? DDS_SWEEP_STEP : (uint32_t)frames;
+  dds->sweepCountdown = DDS_SWEEP_STEP;
+  dds->increment = ddsIncrement(p->sweepStart, dds->frameRate);
+}
+
+static void sweepStep(ddsState *dds) {
+  const ddsParams *p = &dds->active;
+  dds->sweepCountdown = DDS_SWEEP_STEP;
+  dds->sweepFrame += DDS_SWEEP_STEP;
+  if (dds->sweepFrame >= dds->sweepFrames) {
+    if (!p->sweepRepeat) {
+      dds->sweeping = false;
+      dds->increment = ddsIncrement(p->sweepEnd, dds->frameRate);
+      return;
+    }
+    dds->sweepFrame = 0;
+  }
+  float t = (float)dds->sweepFrame / (float)dds->sweepFrames;
+  float hz;
+  if (p->sweepMode == DDS_SWEEP_LOG) {
+    hz = p->sweepStart * powf(p->sweepEnd / p->sweepStart, t);
+  } else {
+    hz = p->sweepStart + (p->sweepEnd - p->sweepStart) * t;
+  }
+  dds->increment = ddsIncrement(hz, dds->frameRate);
+}
+
+bool ddsApply(ddsState *dds) {
+  uint32_t seq = dds->sequence;
+  if (seq == dds->appliedSequence || (seq & 1)) {
+    return false;
+  }
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  ddsParams copy;
+  memcpy(&copy, (const void *)&dds->staged, sizeof(copy));
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (dds->sequence != seq) {
+    return false; // caught it mid-edit, next block
+  }
+  dds->appliedSequence = seq;
+
+  ddsParams *p = &dds->active;
+  *p = copy;
+  dds->count = 0;
+  for (int i = 0; i < DDS_CHANNELS; i++) {
+    if (p->out[i].harmonic == 0) {
+      p->out[i].harmonic = 1;
+    }
+    if (p->out[i].waveform == DDS_TABLE &&
+        (p->out[i].table == nullptr || p->out[i].tableLength == 0)) {
+      p->out[i].waveform = DDS_SINE;
+    }
+    if (p->enabled & (1 << i)) {
+      dds->order[dds->count++] = i;
+    }
+  }
+
+  const ddsPlayback *play = &p->play;
+  if (play->id != dds->playId) {
+    dds->playId = play->id;
+    dds->playPosition = 0;
+    dds->playStarved = 0;
+    dds->playValue = 0;
+    dds->playing = play->ring != nullptr || (play->data != nullptr && play->length > 0);
+  }
+  dds->playStep = stepFor(play->rate, dds->frameRate);
+
+  bool sweepable = p->sweepMode != DDS_SWEEP_OFF && p->sweepStart > 0.0f &&
+                   p->sweepEnd > 0.0f && p->sweepSeconds > 0.0f;
+  if (!sweepable) {
+    dds->sweeping = false;
+    dds->increment = ddsIncrement(p->frequency, dds->frameRate);
+  } else if (p->sweepId != dds->sweepId) {
+    sweepStart(dds);
+  } else if (!dds->sweeping) {
+    // a one-shot sweep that's finished holds its end frequency
+    dds->increment = ddsIncrement(p->sweepEnd, dds->frameRate);
+  }
+  return true;
+}
+
+void ddsSetFrameRate(ddsState *dds, float frameRate) {
+  if (frameRate <= 0.0f || frameRate == dds->frameRate) {
+    return;
+  }
+  float hz = ddsFrequency(dds->increment, dds->frameRate);
+  if (dds->sweeping && dds->frameRate > 0.0f) {
+    float scale = frameRate / dds->frameRate;
+    dds->sweepFrame = (uint32_t)(dds->sweepFrame * scale);
+    dds->sweepFrames = (uint32_t)(dds->sweepFrames * scale);
+    if (dds->sweepFrames < DDS_SWEEP_STEP) {
+      dds->sweepFrames = DDS_SWEEP_STEP;
+    }
+  }
+  dds->frameRate = frameRate;
+  dds->increment = ddsIncrement(hz, frameRate);
+  dds->playStep = stepFor(dds->active.play.rate, frameRate);
+}
+
+uint32_t ddsRingSpace(const ddsRing *ring) {
+  // one slot short of full, the renderer reads a sample past its position
+  return ring->size - 1 - (ring->written - ring->consumed);
+}
+
+uint32_t ddsRingPush(ddsRing *ring, const int16_t *samples, uint32_t count) {
+  uint32_t space = ddsRingSpace(ring);
+  if (count > space) {
+    count = space;
+  }
+  uint32_t written = ring->written;
+  for (uint32_t i = 0; i < count; i++) {
+    ring->samples[(written + i) & (ring->size - 1)] = samples[i];
+  }
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  ring->written = written + count;
+  return count;
+}
+
+static inline int32_t interpolate(const int16_t *table, uint32_t phase) {
+  uint32_t index = phase >> (32 - DDS_TABLE_BITS);
+  int32_t frac = (phase >> (32 - DDS_TABLE_BITS - FRAC_BITS)) & ((1 << FRAC_BITS) - 1);
+  int32_t a = table[index];
+  int32_t b = table[index + 1];
+  return a + (((b - a) * frac) >> FRAC_BITS);
+}
+
+static inline int32_t sampleAt(const void *data, uint8_t format, uint32_t index) {
+  if (format == DDS_SAMPLES_U12) {
+    // a byte at a time, bytes objects don't have to be aligned
+    const uint8_t *p = (const uint8_t *)data + 2 * index;
+    int32_t v = (((p[0] | (p[1] << 8)) & 0x0fff) - 2048) * 16;
+    return v < -DDS_FULL_SCALE ? -DDS_FULL_SCALE : v;
+  }
+  return ((const int16_t *)data)[index];
+}
+
+// any length, the phase scaled to it
+static int32_t tableShape(const ddsOutput *out, uint32_t phase) {
+  uint64_t position = (uint64_t)phase * out->tableLength;
+  uint32_t index = (uint32_t)(position >> 32);
+  int32_t frac = (int32_t)((position >> (32 - FRAC_BITS)) & ((1 << FRAC_BITS) - 1));
+  uint32_t next = index + 1 == out->tableLength ? 0 : index + 1;
+  int32_t a = sampleAt(out->table, out->tableFormat, index);
+  int32_t b = sampleAt(out->table, out->tableFormat, next);
+  return a + (((b - a) * frac) >> FRAC_BITS);
+}
+
+// the playback value for this frame, then on to the next one
+static void playStep(ddsState *dds) {
+  const ddsPlayback *play = &dds->active.play;
+  uint32_t index = (uint32_t)(dds->playPosition >> 32);
+  int32_t frac = (int32_t)((dds->playPosition >> (32 - FRAC_BITS)) & ((1 << FRAC_BITS) - 1));
+  int32_t a;
+  int32_t b;
+
+  if (play->ring != nullptr) {
+    ddsRing *ring = play->ring;
+    uint32_t available = ring->written - index;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (available < 2) {
+      if (!ring->finished) {
+        dds->playStarved++; // hold, the feeder's behind
+        return;
+      }
+      if (available == 1) {
+        dds->playValue = ring->samples[index & (ring->size - 1)];
+      }
+      dds->playing = false;
+      return;
+    }
+    a = ring->samples[index & (ring->size - 1)];
+    b = ring->samples[(index + 1) & (ring->size - 1)];
+    ring->consumed = index;
+  } else {
+    uint32_t length = play->length;
+    if (index >= length) {
+      if (!play->loop) {
+        dds->playing = false;
+        return;
+      }
+      index %= length;
+      dds->playPosition = ((uint64_t)index << 32) | (uint32_t)dds->playPosition;
+    }
+    uint32_t next = index + 1;
+    if (next == length) {
+      next = play->loop ? 0 : index;
+    }
+    a = sampleAt(play->data, play->format, index);
+    b = sampleAt(play->data, play->format, next);
+  }
+  dds->playValue = a + (((b - a) * frac) >> FRAC_BITS);
+  dds->playPosition += dds->playStep;
+}
+
+int32_t ddsShape(const ddsOutput *out, uint32_t phase) {
+  switch (out->waveform) {
+  case DDS_TRIANGLE: {
+    // -1 at 0, +1 half way, like the old table
+    uint32_t d = phase < 0x80000000u ? phase : 0u - phase;
+    int32_t v = (int32_t)(d >> 15) - 32768;
+    return v > DDS_FULL_SCALE ? DDS_FULL_SCALE : (v < -DDS_FULL_SCALE ? -DDS_FULL_SCALE : v);
+  }
+  case DDS_SAWTOOTH: {
+    // 0 at 0, up to +1, then from -1 back up to 0
+    int32_t v = (int32_t)phase >> 16;
+    return v < -DDS_FULL_SCALE ? -DDS_FULL_SCALE : v;
+  }
+  case DDS_SQUARE:
+    return phase < 0x80000000u ? DDS_FULL_SCALE : -DDS_FULL_SCALE;
+  case DDS_TABLE:
+    if (out->table != nullptr && out->tableLength > 0) {
+      return tableShape(out, phase);
+    }
+    return 0;
+  default:
+    return interpolate(sineTable, phase);
+  }
+}
+
+void ddsRender(ddsState *dds, uint16_t *codes, int frames) {
+  const ddsParams *p = &dds->active;
+  int count = dds->count;
+  int32_t codeMax = p->codeMax;
+  for (int f = 0; f < frames; f++) {
+    if (dds->sweeping && --dds->sweepCountdown == 0) {
+      sweepStep(dds);
+    }
+    if (dds->playing) {
+      playStep(dds);
+    }
+    uint32_t phase = dds->phase;
+    for (int i = 0; i < count; i++) {
+      const ddsOutput *out = &p->out[dds->order[i]];
+      int32_t shape = out->waveform == DDS_PLAYBACK
+                          ? dds->playValue
+                          : ddsShape(out, phase * out->harmonic + out->phase);
+      int32_t v = out->offset +
+                  (int32_t)(((int64_t)shape * out->gain + (1 << 14)) >> 15);
+      *codes++ = (uint16_t)(v < 0 ? 0 : (v > codeMax ? codeMax : v));
+    }
+    dds->phase = phase + dds->increment;
+  }
+}
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: MIT
+#ifndef WAVEDDS_H
+#define WAVEDDS_H
+
+#include <stdint.h>
+
+// Direct digital synthesis for the wavegen
+//
+// One 32-bit phase accumulator steps by a fixed increment every frame (one
+// sample on each enabled output), so any frequency up to half the frame rate
+// is frameRate * increment / 2^32, a resolution of a few microhertz. Shapes
+// come from the top bits of the phase: sine from a fixed DDS_TABLE_SIZE point
+// table with linear interpolation, the others worked out from the phase
+// directly, or a caller's own single-cycle table of any length, read in place.
+//
+// All four outputs run off the same accumulator. Each takes it times its
+// harmonic plus its phase offset, so quadrature or 3-phase outputs, or a
+// fundamental and its harmonics, stay locked to each other at any frequency
+// and through a sweep.
+//
+// Settings are edited in dds->staged between ddsEdit() and ddsCommit(), from
+// any core. The renderer picks up a committed edit with ddsApply() before its
+// next block, so frequency, amplitude and offset change between two samples
+// with the phase carrying on. Nothing is rebuilt when they change.
+//
+// Sweeps move the accumulator's increment every DDS_SWEEP_STEP frames, either
+// linearly in Hz or by a constant ratio (log), and either hold the end
+// frequency or start over.
+//
+// DDS_PLAYBACK outputs play a sequence instead, once or looped, recorded at
+// any rate: a second 32.32 accumulator steps through it at rate / frameRate
+// samples per frame and interpolates between neighbours. The samples are
+// either all in memory (read in place) or fed through a ddsRing by whoever
+// reads them off the filesystem. If the ring runs dry the output holds its
+// last value and the miss is counted, rather than playing stale samples.
+//
+// Kept free of Arduino and SDK headers, scripts/wave_dds_test.py builds it on
+// the host and checks the spectrum of what it renders.
+
+#define DDS_TABLE_BITS 10
+#define DDS_TABLE_SIZE (1 << DDS_TABLE_BITS)
+#define DDS_CHANNELS 4
+#define DDS_SWEEP_STEP 16 // frames between sweep increment updates
+#define DDS_FULL_SCALE 32767
+
+// same order as waveGen_waveform_t
+enum {
+  DDS_SINE = 0,
+  DDS_TRIANGLE,
+  DDS_SAWTOOTH,
+  DDS_SQUARE,
+  DDS_TABLE,    // ddsOutput::table
+  DDS_PLAYBACK, // ddsParams::play
+};
+
+// sample formats for tables and playback
+enum {
+  DDS_SAMPLES_S16 = 0, // int16, +-DDS_FULL_SCALE
+  DDS_SAMPLES_U12,     // little-endian 16-bit words of 12-bit codes, 2048 is 0
+};
+
+enum {
+  DDS_SWEEP_OFF = 0,
+  DDS_SWEEP_LINEAR,
+  DDS_SWEEP_LOG,
+};
+
+struct ddsOutput {
+  uint8_t waveform;
+  uint8_t harmonic;      // of the accumulator, 1 = the set frequency
+  uint32_t phase;        // added to accumulator * harmonic, 2^32 = 360 degrees
+  int32_t gain;          // output codes at a shape value of DDS_FULL_SCALE
+  int32_t offset;        // output code at a shape value of 0
+  const void *table;     // one cycle for DDS_TABLE
+  uint32_t tableLength;  // samples in it
+  uint8_t tableFormat;   // DDS_SAMPLES_*
+};
+
+// single producer (ddsRingPush), single consumer (the renderer)
+struct ddsRing {
+  int16_t *samples;
+  uint32_t size;               // a power of two
+  volatile uint32_t written;   // samples pushed so far
+  volatile uint32_t consumed;  // the renderer is done with everything before this
+  volatile bool finished;      // nothing more coming
+};
+
+struct ddsPlayback {
+  const void *data;  // the whole sequence, or nullptr to read from ring
+  uint32_t length;
+  uint8_t format;    // DDS_SAMPLES_*, the ring is always DDS_SAMPLES_S16
+  bool loop;         // memory only, a ring's feeder loops by pushing it again
+  ddsRing *ring;
+  float rate;        // samples per second of the sequence
+  uint32_t id;       // bump it to start from the top
+};
+
+struct ddsParams {
+  float frequency;  // Hz, harmonic 1
+  uint8_t enabled;  // bit n renders output n
+  ddsOutput out[DDS_CHANNELS];
+  uint16_t codeMax; // outputs are clamped to 0..codeMax
+  uint8_t sweepMode;
+  bool sweepRepeat;
+  float sweepStart; // Hz
+  float sweepEnd;
+  float sweepSeconds;
+  uint32_t sweepId; // bump it to (re)start the sweep from sweepStart
+  ddsPlayback play;
+};
+
+struct ddsState {
+  ddsParams staged;
+  volatile uint32_t sequence; // odd while an edit is in progress
+  uint32_t appliedSequence;
+  ddsParams active;
+
+  float frameRate;
+  uint32_t phase;
+  uint32_t increment;
+  uint8_t order[DDS_CHANNELS]; // enabled outputs, lowest first
+  int count;
+
+  bool sweeping;
+  uint32_t sweepFrame;
+  uint32_t sweepFrames;
+  uint32_t sweepId;
+  uint32_t sweepCountdown;
+
+  bool playing;
+  uint32_t playId;
+  uint64_t playPosition; // 32.32 samples into the sequence
+  uint64_t playStep;     // 32.32 samples per frame
+  int32_t playValue;     // the current playback shape
+  uint32_t playStarved;  // frames the ring was empty for
+};
+
+/// everything off, 12-bit outputs
+void ddsInit(ddsState *dds, float frameRate);
+
+/// staged settings to change, then ddsCommit()
+ddsParams *ddsEdit(ddsState *dds);
+void ddsCommit(ddsState *dds);
+
+/// renderer side: takes a committed edit, true if there was one
+bool ddsApply(ddsState *dds);
+/// renderer side: frames per second, keeps the frequency
+void ddsSetFrameRate(ddsState *dds, float frameRate);
+/// enabled outputs, the codes per frame ddsRender() writes
+static inline int ddsChannels(const ddsState *dds) { return dds->count; }
+/// the enabled output at position i of each frame
+static inline int ddsChannelAt(const ddsState *dds, int i) { return dds->order[i]; }
+
+/// frames * ddsChannels() codes, each frame's outputs lowest first
+void ddsRender(ddsState *dds, uint16_t *codes, int frames);
+
+/// the shape at a phase, +-DDS_FULL_SCALE
+int32_t ddsShape(const ddsOutput *out, uint32_t phase);
+
+/// room in the ring, and the samples that fit of count, returns how many went in
+uint32_t ddsRingSpace(const ddsRing *ring);
+uint32_t ddsRingPush(ddsRing *ring, const int16_t *samples, uint32_t count);
+/// true while a sequence is playing, false once it's run out
+static inline bool ddsPlaying(const ddsState *dds) { return dds->playing; }
+/// whole samples into the sequence
+static inline uint32_t ddsPlayPosition(const ddsState *dds) {
+  return (uint32_t)(dds->playPosition >> 32);
+}
+
+uint32_t ddsIncrement(float hz, float frameRate);
+float ddsFrequency(uint32_t increment, float frameRate);
+/// what the accumulator is doing now, sweep included
+static inline float ddsCurrentFrequency(const ddsState *dds) {
+  return ddsFrequency(dds->increment, dds->frameRate);
+}
+
+#endif
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: MIT
+#include "WaveFile.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static bool hasExtension(const char *path, const char *ext) {
+  size_t n = strlen(path);
+  size_t e = strlen(ext);
+  return n >= e && strcasecmp(path + n - e, ext) == 0;
+}
+
+// the next chunk of the file into the block, keeping what's left unread
+static bool refill(waveFileReader *reader) {
+  int left = reader->blockLength - reader->blockUsed;
+  if (left > 0 && reader->blockUsed > 0) {
+    memmove(reader->block, reader->block + reader->blockUsed, left);
+  }
+  reader->blockLength = left;
+  reader->blockUsed = 0;
+  int n = reader->file.read((uint8_t *)reader->block + left, WAVE_FILE_BLOCK - left);
+  if (n <= 0) {
+    return false;
+  }
+  reader->blockLength += n;
+  return true;
+}
+
+static bool parseLine(waveFileReader *reader, int16_t *sample) {
+  reader->line[reader->lineLength] = 0;
+  reader->lineLength = 0;
+  const char *p = reader->line;
+  while (*p == ' ' || *p == '\t') {
+    p++;
+  }
+  if (*p == 0 || *p == '#') {
+    return false;
+  }
+  char *end;
+  float v = strtof(p, &end);
+  if (end == p) {
+    return false; // a header without the #
+  }
+  v = v > 1.0f ? 1.0f : (v < -1.0f ? -1.0f : v);
+  *sample = (int16_t)lroundf(v * 32767.0f);
+  return true;
+}
+
+static int readCsv(waveFileReader *reader, int16_t *samples, int max) {
+  int count = 0;
+  while (count < max) {
+    if (reader->blockUsed == reader->blockLength && !refill(reader)) {
+      // a last line without a newline
+      if (reader->lineLength > 0 && parseLine(reader, &samples[count])) {
+        count++;
+      }
+      break;
+    }
+    char c = reader->block[reader->blockUsed++];
+    if (c == '\n' || c == '\r') {
+      if (parseLine(reader, &samples[count])) {
+        count++;
+      }
+    } else if (c == ',' || c == ';') {
+      reader->lineLength = WAVE_FILE_LINE; // only the first field counts
+    } else if (reader->lineLength < WAVE_FILE_LINE) {
+      reader->line[reader->lineLength++] = c;
+    }
+  }
+  return count;
+}
+
+static int readRaw(waveFileReader *reader, int16_t *samples, int max) {
+  int count = 0;
+  while (count < max) {
+    if (reader->blockLength - reader->blockUsed < 2 && !refill(reader)) {
+      break; // an odd byte at the end is dropped
+    }
+    if (reader->blockLength - reader->blockUsed < 2) {
+      continue;
+    }
+    const uint8_t *p = (const uint8_t *)reader->block + reader->blockUsed;
+    int32_t v = (((p[0] | (p[1] << 8)) & 0x0fff) - 2048) * 16;
+    samples[count++] = (int16_t)(v < -32767 ? -32767 : v);
+    reader->blockUsed += 2;
+  }
+  return count;
+}
+
+bool waveFileOpen(waveFileReader *reader, const char *path) {
+  reader->file = FatFS.open(path, "r");
+  if (!reader->file) {
+    return false;
+  }
+  reader->csv = hasExtension(path, ".csv") || hasExtension(path, ".txt");
+  reader->blockLength = 0;
+  reader->blockUsed = 0;
+  reader->lineLength = 0;
+  reader->samples = 0;
+  return true;
+}
+
+int waveFileRead(waveFileReader *reader, int16_t *samples, int max) {
+  if (!reader->file) {
+    return 0;
+  }
+  int count = reader->csv ? readCsv(reader, samples, max) : readRaw(reader, samples, max);
+  reader->samples += count;
+  return count;
+}
+
+bool waveFileRewind(waveFileReader *reader) {
+  reader->blockLength = 0;
+  reader->blockUsed = 0;
+  reader->lineLength = 0;
+  reader->samples = 0;
+  return reader->file && reader->file.seek(0);
+}
+
+void waveFileClose(waveFileReader *reader) {
+  if (reader->file) {
+    reader->file.close();
+  }
+}
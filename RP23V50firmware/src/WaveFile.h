@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MIT
+#ifndef WAVEFILE_H
+#define WAVEFILE_H
+
+#include <Arduino.h>
+#include <FatFS.h>
+
+// Waveform samples off the FatFS partition, for the wavegen's arbitrary
+// waveforms and file playback
+//
+// Two formats, picked by the file's extension:
+//   .csv / .txt  one sample per line, the first field, -1.0 to 1.0. Lines
+//                starting with # and blank lines are skipped, so a header or
+//                a time column after the value is fine.
+//   anything else  raw little-endian 16-bit words holding 12-bit DAC codes,
+//                2048 is 0 V before the amplitude and offset are applied.
+// Both come out as int16 at +-32767, what the DDS takes (WaveDds.h).
+//
+// The reader holds one small block of the file at a time, so a sequence
+// longer than RAM can be streamed through it a chunk at a time.
+
+#define WAVE_FILE_BLOCK 128 // bytes read from the file at a time
+#define WAVE_FILE_LINE 32   // CSV characters kept per line, the rest is ignored
+
+struct waveFileReader {
+  File file;
+  bool csv;
+  char block[WAVE_FILE_BLOCK];
+  int blockLength;
+  int blockUsed;
+  char line[WAVE_FILE_LINE + 1];
+  int lineLength;
+  uint32_t samples; // read since the open or the last rewind
+};
+
+/// false if it isn't there
+bool waveFileOpen(waveFileReader *reader, const char *path);
+/// up to max samples, 0 at the end of the file
+int waveFileRead(waveFileReader *reader, int16_t *samples, int max);
+/// back to the first sample
+bool waveFileRewind(waveFileReader *reader);
+void waveFileClose(waveFileReader *reader);
+
+#endif
@@ -1,6 +1,3 @@
-//
-// NOTE: This file is currently operating in synchronous fallback mode only.
-// Any previous experimental helper(s) should be removed to ensure a clean build.
 /*!
  *  @file waveGen.cpp
  *
@@ -8,64 +5,133 @@
  */
 
 #include "WaveGen.h"
+#include "Sequencer.h"
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "pico/critical_section.h"
 #include <math.h>
+#include <new>
 
 // Global pointer for static callback
 static WaveGen* g_current_wavegen = nullptr;
+static bool g_irq_installed = false;
+static volatile bool g_owns_wire = false;
+// held by the DMA IRQ and by whoever stops the stream from the other core
+static critical_section_t g_stream_lock;
+static WaveGen* g_feeding = nullptr; // playFile()'s, for waveGenFeed()
+
+// the blocking loop's bus use, setChannelValue() with a STOP each time
+#define B_PER_SAM 3.5f
+
+bool waveGenOwnsWire(void) {
+    return g_owns_wire;
+}
+
+bool waveGenPauseWire(void) {
+    WaveGen *wg = g_current_wavegen;
+    return wg != nullptr && wg->pauseStream();
+}
+
+void waveGenResumeWire(void) {
+    if (g_current_wavegen) {
+        g_current_wavegen->resumeStream();
+    }
+}
+
+void waveGenFeed(void) {
+    if (g_feeding) {
+        g_feeding->feed();
+    }
+}
+
+static int countOutputs(uint8_t mask) {
+    return __builtin_popcount(mask & 0x0F);
+}
 
 /*!
  *    @brief  Constructor
  */
 WaveGen::WaveGen() : 
     _channel(WAVEGEN_DAC0),
-    _waveform(WAVEGEN_SINE),
+    _channel_mask(1 << WAVEGEN_DAC0),
     _frequency_hz(1000.0f),
-    _amplitude_v(1.0f),
-    _offset_v(0.0f),
+    _sweep_start_hz(0.0f),
+    _sweep_end_hz(0.0f),
+    _sweep_seconds(0.0f),
+    _sweep_log(false),
+    _sweep_repeat(false),
+    _sweep_id(0),
     _running(false),
     _initialized(false),
-    _use_fallback(true), // Start in fallback mode for stability
-    _last_sample_time(0),
-    _sample_interval_us(0),
-    _sample_count(0),
-    _table_size(64),  // Start with small table
-    _table_index(0),
+    _use_fallback(false), // service() drops to the blocking loop if the DMA setup fails
+    _play_data(nullptr),
+    _play_length(0),
+    _play_format(DDS_SAMPLES_S16),
+    _play_loop(false),
+    _play_rate(0.0f),
+    _play_id(0),
+    _file_open(false),
+    _decimate(1),
+    _decimate_sum(0),
+    _decimate_count(0),
+    _i2c(i2c0),
+    _dma_data(-1),
+    _dma_control(-1),
+    _dma_timer(-1),
+    _timer_x(0),
+    _timer_y(1),
+    _sample_rate(0.0f),
+    _streaming(false),
+    _paused(false),
+    _next_fill(0),
     _successful_writes(0),
     _failed_writes(0),
-    _last_stats_time(0),
+    _underruns(0),
     _actual_frequency(0.0f),
-    _buffer_size(0),
-    _buffer_cycles(0),
-    _buffer_ready(false),
-    _transfer_in_progress(false),
-    _completion_pending(false),
-    _params_changed(false),
-    _last_samples_sent(0),
-    _last_transfer_us(0) {
-    _repeat_factor = 1;
-    _repeat_remaining = 1;
-    
-    // Initialize calibration arrays
+    _measured_rate(0.0f),
+    _max_refill_us(0),
+    _stats_window_start_us(0),
+    _samples_since_stats(0) {
     for (int i = 0; i < 4; i++) {
+        _outputs[i].waveform = WAVEGEN_SINE;
+        _outputs[i].amplitude_v = 1.0f;
+        _outputs[i].offset_v = 0.0f;
+        _outputs[i].phase_deg = 0.0f;
+        _outputs[i].harmonic = 1;
+        _outputs[i].table = nullptr;
+        _outputs[i].table_length = 0;
+        _outputs[i].table_format = DDS_SAMPLES_S16;
+        _outputs[i].owned_table = nullptr;
+        
+        // Initialize calibration arrays
         _calibration_offset[i] = 0.0f;
         _calibration_gain[i] = 1.0f;
     }
-    // Effective samples-per-second tracking
-    _effective_samples_per_sec = 0.0f;
-    _sps_calibrated = false;
+    _ring.samples = nullptr;
+    _ring.size = 0;
+    _ring.written = 0;
+    _ring.consumed = 0;
+    _ring.finished = false;
+    ddsInit(&_dds, WAVEGEN_MAX_SAMPLE_RATE);
 }
 
 /*!
  *    @brief  Initialize the waveform generator
  */
 bool WaveGen::begin(uint8_t i2c_address, TwoWire *wire) {
-    if (!_dac.begin(i2c_address, wire)) {
+    // the probe below is a Wire transaction, it can't go in the middle of the stream
+    stop();
+    if (sequencerOwnsWire() || !_dac.begin(i2c_address, wire)) {
         return false;
     }
+    _i2c = (wire == &Wire1) ? i2c1 : i2c0;
+    if (!critical_section_is_initialized(&g_stream_lock)) {
+        critical_section_init(&g_stream_lock);
+    }
     
     _initialized = true;
-    _buildWaveformTable();
-    _updateSampleInterval();
+    _planTimer();
+    _publish();
 
     return true;
 }
@@ -80,65 +146,352 @@ void WaveGen::end() {
 }
 
 /*!
- *    @brief  Set the active channel
+ *    @brief  Select the output the setters configure, and run only that one
  */
 void WaveGen::setChannel(waveGen_channel_t channel) {
     _channel = channel;
-    _params_changed = true;
-    if (_initialized) {
-        _buildWaveformTable();
+    _channel_mask = 1 << channel;
+    _publish();
+}
+
+/*!
+ *    @brief  Select another output and run it alongside the others
+ */
+void WaveGen::addChannel(waveGen_channel_t channel) {
+    _channel = channel;
+    _channel_mask |= 1 << channel;
+    _publish();
+}
+
+/*!
+ *    @brief  Stop one output, stopping the last one stops the generator
+ */
+void WaveGen::removeChannel(waveGen_channel_t channel) {
+    uint8_t mask = _channel_mask & ~(1 << channel);
+    if (mask == 0) {
+        stop();
+        return;
+    }
+    _channel_mask = mask;
+    if (_channel == channel) {
+        _channel = (waveGen_channel_t)__builtin_ctz(mask);
     }
+    _publish();
 }
 
 /*!
  *    @brief  Set the waveform type
  */
 void WaveGen::setWaveform(waveGen_waveform_t waveform) {
-    _waveform = waveform;
-    _params_changed = true;
-    if (_initialized) {
-        _buildWaveformTable();
-    }
+    _outputs[_channel].waveform = waveform;
+    _publish();
 }
 
 /*!
- *    @brief  Set the frequency
+ *    @brief  Set the frequency, ends a sweep
  */
 void WaveGen::setFrequency(float frequency_hz) {
     _frequency_hz = frequency_hz;
-    _params_changed = true;
-    if (_initialized) {
-        // Re-calibrate SPS if not calibrated yet
-
-        _updateTableSize();
-        _buildWaveformTable();
-        _updateSampleInterval();
-        
-        // Recalculate buffer for new frequency
-        _calculateOptimalBuffer();
-        _buildI2CBuffer();
-    }
+    _sweep_seconds = 0.0f;
+    _publish();
 }
 
 /*!
  *    @brief  Set the amplitude
  */
 void WaveGen::setAmplitude(float amplitude_v) {
-    _amplitude_v = amplitude_v;
-    _params_changed = true;
-    if (_initialized) {
-        _buildWaveformTable();
-    }
+    _outputs[_channel].amplitude_v = amplitude_v;
+    _publish();
 }
 
 /*!
  *    @brief  Set the offset
  */
 void WaveGen::setOffset(float offset_v) {
-    _offset_v = offset_v;
-    _params_changed = true;
-    if (_initialized) {
-        _buildWaveformTable();
+    _outputs[_channel].offset_v = offset_v;
+    _publish();
+}
+
+/*!
+ *    @brief  Set the phase, 90 puts it a quarter cycle ahead of one at 0
+ */
+void WaveGen::setPhase(float degrees) {
+    _outputs[_channel].phase_deg = degrees;
+    _publish();
+}
+
+/*!
+ *    @brief  Run the output at a multiple of the frequency
+ */
+void WaveGen::setHarmonic(uint8_t multiple) {
+    _outputs[_channel].harmonic = multiple ? multiple : 1;
+    _publish();
+}
+
+/*!
+ *    @brief  Sweep every output's frequency, from start_hz to end_hz
+ *
+ *    Linear in Hz or, with logarithmic, the same ratio every step. A one-shot
+ *    sweep stays at end_hz, repeat starts it over.
+ */
+void WaveGen::sweep(float start_hz, float end_hz, float seconds, bool logarithmic,
+                    bool repeat) {
+    if (seconds <= 0.0f || start_hz <= 0.0f || end_hz <= 0.0f) {
+        stopSweep();
+        return;
+    }
+    _sweep_start_hz = start_hz;
+    _sweep_end_hz = end_hz;
+    _sweep_seconds = seconds;
+    _sweep_log = logarithmic;
+    _sweep_repeat = repeat;
+    _sweep_id++;
+    _publish();
+}
+
+/*!
+ *    @brief  End a sweep, back to the set frequency
+ */
+void WaveGen::stopSweep() {
+    _sweep_seconds = 0.0f;
+    _publish();
+}
+
+/*!
+ *    @brief  Waits for the refill to take the last _publish(), so memory it
+ *            pointed at before can go
+ */
+void WaveGen::_waitApplied() {
+    // a refill is a few ms apart at worst, the blocking loop applies every frame
+    uint32_t start = millis();
+    while (_running && _dds.appliedSequence != _dds.sequence && millis() - start < 50) {
+        delayMicroseconds(100);
+    }
+}
+
+/*!
+ *    @brief  Points an output at a new cycle and frees loadCycle()'s old copy
+ */
+bool WaveGen::_setTable(waveGen_channel_t channel, const void *table, uint32_t length,
+                        uint8_t format, int16_t *owned) {
+    waveGen_output_t *o = &_outputs[channel];
+    int16_t *old = o->owned_table;
+    o->table = table;
+    o->table_length = table ? length : 0;
+    o->table_format = format;
+    o->owned_table = owned;
+    if (table) {
+        o->waveform = WAVEGEN_ARBITRARY;
+    } else if (o->waveform == WAVEGEN_ARBITRARY) {
+        o->waveform = WAVEGEN_SINE;
+    }
+    _publish();
+    // the old one, ours or not, can go once the refill's off it
+    _waitApplied();
+    delete[] old;
+    return table != nullptr;
+}
+
+/*!
+ *    @brief  Load one cycle from a file into the selected output
+ *
+ *    A .csv/.txt of -1.0 to 1.0 values or raw 12-bit codes, see WaveFile.h.
+ *    It plays at the set frequency, scaled by the amplitude and offset.
+ */
+bool WaveGen::loadCycle(const char *path) {
+    waveFileReader reader;
+    if (!waveFileOpen(&reader, path)) {
+        return false;
+    }
+    int16_t *cycle = new (std::nothrow) int16_t[WAVEGEN_CYCLE_MAX];
+    if (cycle == nullptr) {
+        waveFileClose(&reader);
+        return false;
+    }
+    int count = 0;
+    int n;
+    while (count < WAVEGEN_CYCLE_MAX &&
+           (n = waveFileRead(&reader, cycle + count, WAVEGEN_CYCLE_MAX - count)) > 0) {
+        count += n;
+    }
+    waveFileClose(&reader);
+    if (count < 2) {
+        delete[] cycle;
+        return false;
+    }
+    return _setTable(_channel, cycle, count, DDS_SAMPLES_S16, cycle);
+}
+
+/*!
+ *    @brief  Play one cycle from memory on the selected output, without copying
+ *
+ *    The samples have to stay put until another cycle replaces them,
+ *    dropExternal() or setCycle(nullptr, 0, 0).
+ */
+bool WaveGen::setCycle(const void *samples, uint32_t count, uint8_t format) {
+    if (samples == nullptr || count < 2) {
+        return _setTable(_channel, nullptr, 0, DDS_SAMPLES_S16, nullptr);
+    }
+    return _setTable(_channel, samples, count, format, nullptr);
+}
+
+/*!
+ *    @brief  Stop whatever's playing, the outputs hold their last value
+ */
+void WaveGen::stopPlayback() {
+    _play_data = nullptr;
+    _play_length = 0;
+    _play_rate = 0.0f;
+    _play_id++;
+    g_feeding = nullptr;
+    _publish();
+    if (_file_open) {
+        waveFileClose(&_file);
+        _file_open = false;
+    }
+    _waitApplied();
+    delete[] _ring.samples;
+    _ring.samples = nullptr;
+    _ring.size = 0;
+}
+
+/*!
+ *    @brief  Play a sequence from memory on the selected output, without copying
+ *
+ *    Resampled from sample_rate to the frame rate by interpolation. The
+ *    samples have to stay put until it's stopped or dropExternal().
+ */
+bool WaveGen::playBuffer(const void *samples, uint32_t count, uint8_t format,
+                         float sample_rate, bool loop) {
+    stopPlayback();
+    if (samples == nullptr || count == 0 || sample_rate <= 0.0f) {
+        return false;
+    }
+    _play_data = samples;
+    _play_length = count;
+    _play_format = format;
+    _play_loop = loop;
+    _play_rate = sample_rate;
+    _play_id++;
+    _outputs[_channel].waveform = WAVEGEN_PLAYBACK;
+    _publish();
+    return true;
+}
+
+/*!
+ *    @brief  Stream a sequence from a file on the selected output
+ *
+ *    Only WAVEGEN_RING_SAMPLES are in RAM at a time, feed() reads the rest as
+ *    it's needed. Recorded faster than the frame rate, it's averaged down by
+ *    a whole number of samples first, slower ones are interpolated up.
+ */
+bool WaveGen::playFile(const char *path, float sample_rate, bool loop) {
+    stopPlayback();
+    if (sample_rate <= 0.0f || !waveFileOpen(&_file, path)) {
+        return false;
+    }
+    _ring.samples = new (std::nothrow) int16_t[WAVEGEN_RING_SAMPLES];
+    if (_ring.samples == nullptr) {
+        waveFileClose(&_file);
+        return false;
+    }
+    _file_open = true;
+    _ring.size = WAVEGEN_RING_SAMPLES;
+    _ring.written = 0;
+    _ring.consumed = 0;
+    _ring.finished = false;
+    _play_loop = loop;
+
+    float frame_rate = getFrameRate();
+    _decimate = 1;
+    if (sample_rate > frame_rate) {
+        float k = ceilf(sample_rate / frame_rate);
+        _decimate = k < WAVEGEN_FEED_CHUNK ? (uint16_t)k : WAVEGEN_FEED_CHUNK;
+    }
+    _decimate_sum = 0;
+    _decimate_count = 0;
+    _play_rate = sample_rate / _decimate;
+    _play_id++;
+
+    // a full ring before the first sample goes out
+    g_feeding = this;
+    feed();
+    _outputs[_channel].waveform = WAVEGEN_PLAYBACK;
+    _publish();
+    return true;
+}
+
+/*!
+ *    @brief  Tops up playFile()'s ring, a chunk at a time while there's room
+ */
+void WaveGen::feed() {
+    if (!_file_open || _ring.samples == nullptr) {
+        return;
+    }
+    int16_t raw[WAVEGEN_FEED_CHUNK];
+    int16_t out[WAVEGEN_FEED_CHUNK];
+    // bounded, so a slow flash read doesn't hold up core 0 for long
+    for (int reads = 0; reads < 8; reads++) {
+        uint32_t room = ddsRingSpace(&_ring);
+        int want = WAVEGEN_FEED_CHUNK / _decimate;
+        if (want == 0) {
+            want = 1;
+        }
+        if (room < (uint32_t)want) {
+            return;
+        }
+        int n = waveFileRead(&_file, raw, want * _decimate);
+        if (n == 0) {
+            if (_play_loop && _file.samples > 0 && waveFileRewind(&_file)) {
+                continue;
+            }
+            _ring.finished = true;
+            waveFileClose(&_file);
+            _file_open = false;
+            return;
+        }
+        int produced = 0;
+        for (int i = 0; i < n; i++) {
+            _decimate_sum += raw[i];
+            if (++_decimate_count == _decimate) {
+                out[produced++] = (int16_t)(_decimate_sum / _decimate);
+                _decimate_sum = 0;
+                _decimate_count = 0;
+            }
+        }
+        ddsRingPush(&_ring, out, produced);
+    }
+}
+
+/*!
+ *    @brief  Playing, and not yet at the end of a one-shot sequence
+ */
+bool WaveGen::isPlaying() const {
+    return (_play_data != nullptr || _ring.samples != nullptr) && ddsPlaying(&_dds);
+}
+
+/*!
+ *    @brief  Samples into the sequence, counted in the file's own samples
+ */
+uint32_t WaveGen::getPlayPosition() const {
+    return ddsPlayPosition(&_dds) * (_ring.samples ? _decimate : 1);
+}
+
+/*!
+ *    @brief  Forgets every cycle and sequence read in place
+ *
+ *    For memory that's about to go, MicroPython's heap when it's torn down.
+ *    Outputs on a dropped cycle go back to sine.
+ */
+void WaveGen::dropExternal() {
+    for (int ch = 0; ch < 4; ch++) {
+        const waveGen_output_t *o = &_outputs[ch];
+        if (o->table != nullptr && o->owned_table == nullptr) {
+            _setTable((waveGen_channel_t)ch, nullptr, 0, DDS_SAMPLES_S16, nullptr);
+        }
+    }
+    if (_play_data != nullptr) {
+        stopPlayback();
     }
 }
 
@@ -146,31 +499,34 @@ void WaveGen::setOffset(float offset_v) {
  *    @brief  Start waveform generation
  */
 bool WaveGen::start() {
-    if (!_initialized) {
+    if (!_initialized || sequencerOwnsWire()) {
         return false;
     }
 
-    _running = true;
-    _last_sample_time = micros();
-    _sample_count = 0;
-    _table_index = 0;
-    // Use synchronous block streaming (no  Wire)
-    _use_fallback = false;
-    // Ensure SPS is calibrated right before streaming
-
-    _calculateOptimalBuffer();
-    _buildI2CBuffer();
-    _transfer_in_progress = false;
-    _completion_pending = false;
-    _params_changed = false;
-    _stats_window_start_us = micros();
+    if (_running) {
+        stop();
+    }
+    _successful_writes = 0;
+    _failed_writes = 0;
+    _underruns = 0;
+    _max_refill_us = 0;
+    _measured_rate = 0.0f;
+    _stats_window_start_us = time_us_32();
     _samples_since_stats = 0;
-    _indices_since_stats = 0;
-    // Initialize repeat logic based on computed table size and target frequency
-    _repeat_factor = 1;
-    _repeat_remaining = _repeat_factor;
 
-    
+    // the rate depends on which path service() takes
+    _planTimer();
+    _dds.phase = 0;
+    if (_sweep_seconds > 0.0f) {
+        _sweep_id++; // from the top
+    }
+    if (_play_data != nullptr) {
+        _play_id++; // a file carries on, what's in its ring can't be read again
+    }
+    _publish();
+
+    // service() sets up the DMA on its own core so the refill IRQ lands there
+    _running = true;
     return true;
 }
 
@@ -179,85 +535,101 @@ bool WaveGen::start() {
  */
 void WaveGen::stop() {
     _running = false;
-    // no  operations to abort in sync mode
+    if (_streaming) {
+        critical_section_enter_blocking(&g_stream_lock);
+        if (_streaming) {
+            _stopStream();
+        }
+        critical_section_exit(&g_stream_lock);
+    }
+}
+
+/*!
+ *    @brief  Ends the stream on a sample boundary so Wire can be used, from either core
+ */
+bool WaveGen::pauseStream() {
+    if (!_streaming) {
+        return false;
+    }
+    // the IRQ on the other core finishes its refill first
+    critical_section_enter_blocking(&g_stream_lock);
+    bool paused = _streaming;
+    if (paused) {
+        _paused = true;
+        _stopStream();
+    }
+    critical_section_exit(&g_stream_lock);
+    return paused;
+}
+
+/*!
+ *    @brief  Lets service() start the stream again, from the top of the ring
+ */
+void WaveGen::resumeStream() {
+    _paused = false;
 }
 
 /*!
  *    @brief  Service function - call frequently from main loop
+ *
+ *    Starts the DMA stream the first time round after start() and returns
+ *    straight away after that. In fallback mode it blocks until stopped.
  */
 void WaveGen::service() {
     if (!_running || !_initialized) {
-        // Serial.println("WaveGen: not running or initialized");
-        // Serial.flush();
-        
         return;
     }
-
-    // BLOCKING streaming loop for core2: keep the I2C transaction open and
-    // write samples continuously. Only exit when stopped or params change.
-
-    // If params changed, rebuild tables and restart streaming
-    if (_params_changed) {
-        _updateTableSize();
-        _buildWaveformTable();
-        _updateSampleInterval();
-        _calculateOptimalBuffer();
-        _buildI2CBuffer();
-        _params_changed = false;
+    if (_use_fallback) {
+        _serviceBlocking();
+        return;
     }
+    if (_streaming || _paused) {
+        return;
+    }
+    // a pause from the other core can't land between the check and the start
+    critical_section_enter_blocking(&g_stream_lock);
+    bool ok = _streaming || _paused || _startStream();
+    critical_section_exit(&g_stream_lock);
+    if (!ok) {
+        // no DMA channel or timer free, do it the slow way
+        _use_fallback = true;
+        _planTimer();
+    }
+}
 
-    uint32_t t0_overall = micros();
-    uint32_t samples_sent_this_call = 0;
-
-    // Per-sample repeated-START streaming to keep bus flow continuous and avoid
-    // long buffered drains. Each sample is its own short transaction.
-
-    while (_running && !_params_changed) {
-        // Synchronous per-sample write with STOP; simpler and accurate timing
-        bool ok = _dac.setChannelValue((MCP4728_channel_t)_channel,
-                                       _waveform_table[_table_index]);
-        if (!ok) {
-            _failed_writes++;
-            continue;
-        }
-        _successful_writes++;
-
-        // Advance to next table entry honoring repeat factor for very low frequencies
-        if (_repeat_remaining > 1) {
-            _repeat_remaining--;
-        } else {
-            _repeat_remaining = _repeat_factor;
-            _table_index = (_table_index + 1) % _table_size;
-            _indices_since_stats++;
+/*!
+ *    @brief  The blocking path, one setChannelValue() per output per frame
+ */
+void WaveGen::_serviceBlocking() {
+    // paced to _sample_rate so the DDS frequencies come out right
+    double due = (double)time_us_64();
+    while (_running) {
+        ddsApply(&_dds);
+        int outputs = ddsChannels(&_dds);
+        if (outputs == 0) {
+            break;
         }
-        samples_sent_this_call++;
-        _samples_since_stats++;
-        // Update rolling actual frequency every ~10ms for stability
-        uint32_t t_now = micros();
-        uint32_t dt = t_now - _stats_window_start_us;
-        if (dt >= 10000 && _table_size > 0) { // 10 ms window
-            // Effective samples-per-sec at table index rate (one index advance may have multiple repeats)
-            float indices_per_sec = ((float)_indices_since_stats) * (1000000.0f / (float)dt);
-            _actual_frequency = indices_per_sec / (float)_table_size;
-            _stats_window_start_us = t_now;
-            _samples_since_stats = 0;
-            _indices_since_stats = 0;
+        ddsSetFrameRate(&_dds, _sample_rate / outputs);
+        ddsRender(&_dds, _codes, 1);
+
+        uint32_t written = 0;
+        for (int i = 0; i < outputs; i++) {
+            if (_dac.setChannelValue((MCP4728_channel_t)ddsChannelAt(&_dds, i), _codes[i])) {
+                written++;
+            } else {
+                _failed_writes++;
+            }
         }
-        // Optional tiny escape hatch (disabled)
-    }
-
-    // No explicit STOP needed; each synchronous write ends with STOP
+        _countWrites(written);
 
-    // Stats
-    uint32_t t1_overall = micros();
-    _last_transfer_us = (t1_overall - t0_overall);
-    _last_samples_sent = samples_sent_this_call;
-
-    // Periodic frequency estimate
-    uint32_t now = t1_overall;
-    if (now - _last_stats_time >= 1000000) {
-        _updateStatistics();
-        _last_stats_time = now;
+        due += 1000000.0 * outputs / _sample_rate;
+        uint64_t now = time_us_64();
+        if ((double)now > due + 1000.0) {
+            due = (double)now; // fell behind, don't try to catch up in a burst
+        }
+        while ((double)time_us_64() < due) {
+            tight_loop_contents();
+        }
     }
 }
 
@@ -267,6 +639,7 @@ void WaveGen::service() {
 void WaveGen::setCalibrationOffset(waveGen_channel_t channel, float offset_v) {
     if ((int)channel < 4) {
         _calibration_offset[channel] = offset_v;
+        _publish();
     }
 }
 
@@ -276,179 +649,151 @@ void WaveGen::setCalibrationOffset(waveGen_channel_t channel, float offset_v) {
 void WaveGen::setCalibrationGain(waveGen_channel_t channel, float gain) {
     if ((int)channel < 4) {
         _calibration_gain[channel] = gain;
+        _publish();
     }
 }
 
+/*!
+ *    @brief  Fastest DAC write rate the stream (or blocking loop) can hold
+ */
+float WaveGen::_maxSampleRate() const {
+    float i2c_hz = (float)_dac.getClockHz();
+    if (i2c_hz > 1000000.0f) {
+        i2c_hz = 1000000.0f; // what the RP2350 actually does at "1.7 MHz"
+    }
+    float bytes = _use_fallback ? B_PER_SAM : WAVEGEN_WORDS_PER_SAMPLE;
+    float bus_limit = 0.8f * (i2c_hz / 9.0f) / bytes;
+    return bus_limit < WAVEGEN_MAX_SAMPLE_RATE ? bus_limit : WAVEGEN_MAX_SAMPLE_RATE;
+}
 
-//! !!!!!!!!!!!!!!!
-
-#define B_PER_SAM 3.5f
-
-//!!!!!!!!!!!!!
-
+// best x/y <= 1 with both in 16 bits, from the continued fraction of r
+static void bestFraction(double r, uint16_t *x, uint16_t *y) {
+    uint32_t p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    double v = r;
+    for (int i = 0; i < 32; i++) {
+        uint32_t a = (uint32_t)v;
+        uint64_t p2 = (uint64_t)a * p1 + p0;
+        uint64_t q2 = (uint64_t)a * q1 + q0;
+        if (p2 > 0xFFFF || q2 > 0xFFFF) {
+            break;
+        }
+        p0 = p1;
+        q0 = q1;
+        p1 = (uint32_t)p2;
+        q1 = (uint32_t)q2;
+        double frac = v - a;
+        if (frac < 1e-12) {
+            break;
+        }
+        v = 1.0 / frac;
+    }
+    if (p1 == 0 || q1 == 0) {
+        p1 = 1;
+        q1 = 0xFFFF;
+    }
+    *x = (uint16_t)p1;
+    *y = (uint16_t)q1;
+}
 
+/*!
+ *    @brief  DMA timer setting for _maxSampleRate(), and the rate it gives
+ */
+void WaveGen::_planTimer() {
+    float rate = _maxSampleRate();
+    if (_use_fallback) {
+        _sample_rate = rate;
+        return;
+    }
+    double clk = (double)clock_get_hz(clk_sys);
+    bestFraction(rate * WAVEGEN_WORDS_PER_SAMPLE / clk, &_timer_x, &_timer_y);
+    _sample_rate = (float)(clk * _timer_x / _timer_y / WAVEGEN_WORDS_PER_SAMPLE);
+}
 
+/*!
+ *    @brief  Frames per second on each output
+ */
+float WaveGen::getFrameRate() const {
+    float rate = _sample_rate > 0.0f ? _sample_rate : _maxSampleRate();
+    int outputs = countOutputs(_channel_mask);
+    return rate / (outputs ? outputs : 1);
+}
 
 /*!
  *    @brief  Get the actual achievable frequency for a desired frequency
  */
 float WaveGen::getAchievableFrequency(float desired_freq) const {
-    // Use synchronous-per-sample model: 3 bytes per write
-    TwoWire *wire = _dac.getWire();
-    float i2c_hz = 1000000.0f;
-    // if (wire) {
-    //     i2c_hz = (float)_dac.getClockHz();
-    // }
-    const float BYTES_PER_SAMPLE = B_PER_SAM;
-    float effective_samples_per_sec = (i2c_hz / 9.0f) / BYTES_PER_SAMPLE;
-    if (effective_samples_per_sec < 1.0f) effective_samples_per_sec = 1.0f;
-
-    // Calculate the table size needed for the desired frequency
-    float calculated_size = effective_samples_per_sec / desired_freq;
-    size_t table_size = (size_t)(calculated_size + 0.5f);
-    if (table_size < 2) {
-        table_size = 2;
-    } else if (table_size > MAX_WAVEFORM_TABLE_SIZE) {
-        table_size = MAX_WAVEFORM_TABLE_SIZE;
-    }
-
-    // Base achievable frequency without repeats
-    float achievable_no_repeat = effective_samples_per_sec / (float)table_size;
-
-    // If desired is lower, simulate repeat factor to predict achievable
-    if (desired_freq < achievable_no_repeat) {
-        float repeat = achievable_no_repeat / desired_freq;
-        if (repeat < 1.0f) repeat = 1.0f;
-        float predicted = achievable_no_repeat / (float)((uint32_t)(repeat + 0.5f));
-        return predicted;
-    }
-
-    return achievable_no_repeat;
+    float frame_rate = getFrameRate();
+    return ddsFrequency(ddsIncrement(desired_freq, frame_rate), frame_rate);
 }
 
 /*!
  *    @brief  Set frequency and return the actual achievable frequency
  */
 float WaveGen::setFrequencyAdjusted(float frequency_hz) {
-    // Set desired frequency
     setFrequency(frequency_hz);
+    return getAchievableFrequency(frequency_hz);
+}
 
-    // Predict actual based on current configuration (_table_size, _repeat_factor)
-    TwoWire *wire = _dac.getWire();
-    float i2c_hz = 1000000.0f;
-    // if (wire) {
-    //     i2c_hz = (float)_dac.getClockHz();
-    // }
-    const float BYTES_PER_SAMPLE = B_PER_SAM;
-    float effective_samples_per_sec = (i2c_hz / 9.0f) / BYTES_PER_SAMPLE;
-    if (effective_samples_per_sec < 1.0f) effective_samples_per_sec = 1.0f;
-    size_t ts = _table_size > 0 ? _table_size : 1;
-    uint32_t rf = _repeat_factor > 0 ? _repeat_factor : 1;
-    float predicted = effective_samples_per_sec / ((float)ts * (float)rf);
-    return predicted;
-}
-
-/*!
- *    @brief  Update table size based on frequency for accurate frequency generation
- */
-void WaveGen::_updateTableSize() {
-    // Effective sample rate based on I2C clock and 3-byte per sample
-    // Approximate bytes per sec = I2C_HZ / 9 bits per byte
-    TwoWire *wire = _dac.getWire();
-    float i2c_hz = 1000000.0f;
-    // if (wire) {
-    //     // If MCP4728 tracked clock, use it; otherwise keep default
-    //     i2c_hz = (float)_dac.getClockHz();
-    //     Serial.print("I2C Hz: ");
-    //     Serial.println(i2c_hz);
-    // }
-    const float BYTES_PER_SAMPLE = B_PER_SAM;
-    float effective_samples_per_sec = (i2c_hz / 9.0f) / BYTES_PER_SAMPLE;
-    if (effective_samples_per_sec < 1.0f) effective_samples_per_sec = 1.0f;
-
-    // Calculate table size to achieve the desired frequency
-    float calculated_size = effective_samples_per_sec / _frequency_hz;
-
-    // Round to nearest integer for exact frequency control
-    _table_size = (size_t)(calculated_size + 0.5f); // Round to nearest integer
-
-    // Ensure we stay within reasonable bounds
-    if (_table_size < 2) {
-        _table_size = 2; // Minimum for reasonable waveform quality
-    } else if (_table_size > MAX_WAVEFORM_TABLE_SIZE) {
-        _table_size = MAX_WAVEFORM_TABLE_SIZE; // Maximum table size
-    }
-
-    // Determine repeat factor for very low frequencies to extend effective period
-    // If desired frequency is below the minimum achievable for this table size,
-    // repeat each sample N times to reduce effective sample rate without changing I2C speed.
-    _repeat_factor = 1;
-    if (_table_size > 0) {
-        float achievable_freq = effective_samples_per_sec / (float)_table_size;
-        if (_frequency_hz < achievable_freq) {
-            float required_sps = _frequency_hz * (float)_table_size; // samples/sec needed
-            if (required_sps < 1.0f) required_sps = 1.0f;
-            float repeat = (effective_samples_per_sec / required_sps);
-            if (repeat < 1.0f) repeat = 1.0f;
-            if (repeat > 1.0f) {
-                // Clamp to a reasonable maximum to avoid overflow
-                if (repeat > 1000000.0f) repeat = 1000000.0f;
-                _repeat_factor = (uint32_t)(repeat + 0.5f);
-                if (_repeat_factor == 0) _repeat_factor = 1;
-            }
-        }
+/*!
+ *    @brief  The frequency the accumulator is at, partway through a sweep
+ */
+float WaveGen::getCurrentFrequency() const {
+    if (!_running) {
+        return _frequency_hz;
     }
-    _repeat_remaining = _repeat_factor;
+    return ddsCurrentFrequency(&_dds);
+}
 
-    // // Debug output (clean formatting)
-    // Serial.print("Table size calc: size=");
-    // Serial.print(calculated_size, 2);
-    // Serial.print(" -> ");
-    // Serial.print(_table_size);
-    // Serial.print(", est_no_repeat=");
-    // Serial.print(effective_samples_per_sec / (float)_table_size, 2);
-    // Serial.print(" Hz, repeat=");
-    // Serial.print((uint32_t)_repeat_factor);
-    // Serial.print(", est_with_repeat=");
-    // float denom = (float)_table_size * (float)(_repeat_factor > 0 ? _repeat_factor : 1);
-    // Serial.print(effective_samples_per_sec / denom, 2);
-    // Serial.println(" Hz");
-    // Serial.flush();
+/*!
+ *    @brief  Waveform cycles in one half of the ring
+ */
+size_t WaveGen::getBufferCycles() const {
+    int outputs = countOutputs(_channel_mask);
+    size_t frames = WAVEGEN_DMA_SAMPLES / (outputs ? outputs : 1);
+    return (size_t)(frames * getCurrentFrequency() / getFrameRate());
 }
 
 /*!
- *    @brief  Build the waveform lookup table
+ *    @brief  Hands the settings to the DDS, the next refill picks them up
  */
-void WaveGen::_buildWaveformTable() {
-    for (size_t i = 0; i < _table_size; i++) {
-        float t = (float)i / (float)_table_size; // 0..1
-        float value = 0.0f;
-        
-        switch (_waveform) {
-            case WAVEGEN_SINE: {
-                value = sinf(2.0f * M_PI * t);
-                break;
-            }
-            case WAVEGEN_TRIANGLE: {
-                value = 4.0f * fabsf(t - floorf(t + 0.5f)) - 1.0f; // -1..1
-                break;
-            }
-            case WAVEGEN_SAWTOOTH: {
-                value = 2.0f * (t - floorf(t + 0.5f)); // -1..1
-                break;
-            }
-            case WAVEGEN_SQUARE: {
-                value = (t < 0.5f) ? 1.0f : -1.0f;
-                break;
-            }
-        }
-        
-        // Apply amplitude and offset
-        float voltage = _offset_v + _amplitude_v * value;
-        
-        // Convert to DAC code
-        _waveform_table[i] = _voltsToCode(voltage, _channel);
+void WaveGen::_publish() {
+    extern float dacSpread[4];
+
+    ddsParams *p = ddsEdit(&_dds);
+    p->frequency = _frequency_hz;
+    p->enabled = _channel_mask;
+    p->codeMax = 4095;
+    for (int ch = 0; ch < 4; ch++) {
+        const waveGen_output_t *o = &_outputs[ch];
+        ddsOutput *out = &p->out[ch];
+        out->waveform = (uint8_t)o->waveform;
+        out->harmonic = o->harmonic;
+        float turns = o->phase_deg / 360.0f;
+        turns -= floorf(turns);
+        out->phase = (uint32_t)((double)turns * 4294967296.0);
+        // same scaling as _voltsToCode(), the offset takes the calibration offset
+        out->gain = (int32_t)lroundf(o->amplitude_v * _calibration_gain[ch] * 4095.0f /
+                                     dacSpread[ch]);
+        out->offset = _voltsToCode(o->offset_v, (waveGen_channel_t)ch);
+        out->table = o->table;
+        out->tableLength = o->table_length;
+        out->tableFormat = o->table_format;
     }
+    p->sweepMode = _sweep_seconds <= 0.0f ? DDS_SWEEP_OFF
+                   : (_sweep_log ? DDS_SWEEP_LOG : DDS_SWEEP_LINEAR);
+    p->sweepRepeat = _sweep_repeat;
+    p->sweepStart = _sweep_start_hz;
+    p->sweepEnd = _sweep_end_hz;
+    p->sweepSeconds = _sweep_seconds;
+    p->sweepId = _sweep_id;
+    p->play.data = _play_data;
+    p->play.length = _play_length;
+    p->play.format = _play_format;
+    p->play.loop = _play_loop;
+    p->play.ring = _ring.samples ? &_ring : nullptr;
+    p->play.rate = _play_rate;
+    p->play.id = _play_id;
+    ddsCommit(&_dds);
 }
 
 /*!
@@ -473,234 +818,258 @@ uint16_t WaveGen::_voltsToCode(float voltage, waveGen_channel_t channel) {
 }
 
 /*!
- *    @brief  Update the sample interval - fixed at 100us for 10kHz rate
+ *    @brief  Counts DAC writes and measures the rate they go out at
  */
-void WaveGen::_updateSampleInterval() {
-    // Fixed sample rate of 10000 Hz (100us intervals)
-    // This provides much higher frequency support while maintaining stability
-    _sample_interval_us = 1; // not used with per-sample streaming; maintained for compatibility
+void __not_in_flash_func(WaveGen::_countWrites)(uint32_t writes) {
+    _successful_writes += writes;
+    _samples_since_stats += writes;
+
+    uint32_t now = time_us_32();
+    uint32_t dt = now - _stats_window_start_us;
+    if (dt >= 250000) {
+        _measured_rate = (float)_samples_since_stats * 1000000.0f / (float)dt;
+        int outputs = ddsChannels(&_dds);
+        if (outputs > 0) {
+            _actual_frequency = ddsFrequency(_dds.increment, _measured_rate / outputs);
+        }
+        _stats_window_start_us = now;
+        _samples_since_stats = 0;
+    }
 }
 
 /*!
- *    @brief  Send the next sample to the DAC
+ *    @brief  Renders the next half's worth of frames into one half
  */
-void WaveGen::_sendNextSample() {
-    // Get the current sample value
-    uint16_t sample_value = _waveform_table[_table_index];
-    
-    // Prepare all 4 channel values (only active channel gets the signal)
-    uint16_t channel_values[4] = {0, 0, 0, 0};
-    channel_values[_channel] = sample_value;
-    
-    bool success = false;
-    
-   // if (_use_fallback) {
-        // Fallback mode: use synchronous writes for stability
-
-       // while (Serial.available() == 0) {
-        success = _dac.quickSetChannelValue((MCP4728_channel_t)_channel, sample_value, false, false);
-        //}
-    //} else {
-        // // Async mode: check if previous operation is complete
-        // if (!_dac.finishedAsync()) {
-        //     _failed_writes++;
-        //     return; // Skip this sample if previous one isn't done
-        // }
-        
-        // // Send async write with error checking
-        // noInterrupts(); // Disable interrupts during critical section
-        // success = _dac.fastWriteAsync(channel_values[0], channel_values[1], 
-        //                              channel_values[2], channel_values[3]);
-        // interrupts(); // Re-enable interrupts
-  //  }
-    
-    if (success) {
-        _successful_writes++;
-    } else {
-        _failed_writes++;
+void __not_in_flash_func(WaveGen::_fillHalf)(int half) {
+    ddsApply(&_dds);
+    int outputs = ddsChannels(&_dds);
+    if (outputs == 0) {
+        return; // can't happen, the mask is never empty; the half just plays again
+    }
+    ddsSetFrameRate(&_dds, _sample_rate / outputs);
+    int frames = WAVEGEN_DMA_SAMPLES / outputs;
+    ddsRender(&_dds, _codes, frames);
+
+    uint16_t *out = _i2c_buffer[half];
+    const uint16_t *code = _codes;
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < outputs; i++) {
+            // multi-write, UDAC=0 so the output moves on the last ACK
+            uint16_t value = *code++;
+            *out++ = 0x40 | (ddsChannelAt(&_dds, i) << 1);
+            *out++ = (value >> 8) & 0x0F; // VREF=VDD, PD normal, gain 1x like setChannelValue()
+            *out++ = value & 0xFF;
+        }
     }
-    
-    // Advance table index using dynamic table size
-    _table_index = (_table_index + 1) % _table_size;
 }
 
 /*!
- *    @brief  Update statistics
+ *    @brief  Claims the DMA, takes over the I2C block and starts the stream
  */
-void WaveGen::_updateStatistics() {
-    // Rolling window stats are updated in the streaming loop for accuracy
-    // Backstop: compute from index advances so repeats are accounted correctly
-    if (_table_size > 0) {
-        uint32_t dt = micros() - _stats_window_start_us;
-        if (dt > 0) {
-            float indices_per_sec = ((float)_indices_since_stats) * (1000000.0f / (float)dt);
-            _actual_frequency = indices_per_sec / (float)_table_size;
-        }
-        _stats_window_start_us = micros();
-        _samples_since_stats = 0;
-        _indices_since_stats = 0;
+bool WaveGen::_startStream() {
+    if (_dma_data < 0) {
+        _dma_data = dma_claim_unused_channel(false);
     }
-}
-
-//
-// Estimate effective samples-per-second from configured I2C clock
-// Fallback used before runtime calibration is available
-//
-float WaveGen::_estimateSamplesPerSec() const {
-    if (_sps_calibrated && _effective_samples_per_sec > 0.0f) {
-        return _effective_samples_per_sec;
+    if (_dma_control < 0) {
+        _dma_control = dma_claim_unused_channel(false);
+    }
+    if (_dma_timer < 0) {
+        _dma_timer = dma_claim_unused_timer(false);
+    }
+    if (_dma_data < 0 || _dma_control < 0 || _dma_timer < 0) {
+        return false;
     }
-    TwoWire *wire = _dac.getWire();
-    float i2c_hz = 1000000.0f;
-    // if (wire) {
-    //     i2c_hz = (float)_dac.getClockHz();
-    // }
-    const float BYTES_PER_SAMPLE = B_PER_SAM; // address + 3 data bytes per sample
-    float sps = (i2c_hz / 9.0f) / BYTES_PER_SAMPLE;
-    if (sps < 1.0f) sps = 1.0f;
-    return sps;
+    g_current_wavegen = this;
+    if (!g_irq_installed) {
+        irq_add_shared_handler(WAVEGEN_DMA_IRQ, _staticDmaIrq,
+                               PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        g_irq_installed = true;
+    }
+    // enables it in this core's NVIC, this is the core that does the refills
+    irq_set_enabled(WAVEGEN_DMA_IRQ, true);
+
+    // target address only changes with the controller off
+    _i2c->hw->enable = 0;
+    _i2c->hw->tar = _dac.getAddress();
+    _i2c->hw->enable = 1;
+    g_owns_wire = true;
+
+    _half_addr[0] = (uint32_t)_i2c_buffer[0];
+    _half_addr[1] = (uint32_t)_i2c_buffer[1];
+    _stats_window_start_us = time_us_32();
+    _samples_since_stats = 0;
+    _streaming = true;
+    _restartStream();
+    return true;
 }
 
-
 /*!
- *    @brief  Calculate optimal buffer size for seamless looping
+ *    @brief  (Re)starts both channels from half 0, also after a bus error
  */
-void WaveGen::_calculateOptimalBuffer() {
-    // I2C considerations:
-    // - 1MHz I2C speed
-    // - MCP4728 Multi-Write per-sample: 3 bytes (command + 2 data)
-    // - Pack many samples in a single transaction to eliminate per-transfer overhead
-    // - Target: ~10ms worth of samples to reduce CPU service load
-
-    const size_t BYTES_PER_SAMPLE = 4; // account for pacing/overhead per sample in repeated-START path
-    // Use maximum capacity with whole-wave alignment to minimize inter-burst gaps
-    size_t capacity_samples = (MAX_BUFFER_SIZE) / BYTES_PER_SAMPLE;
-    _buffer_samples = capacity_samples;
-
-    // Force an integer number of waveform cycles to minimize phase jitter and avoid mid-wave cutoffs
-    if (_table_size > 0) {
-        if (_buffer_samples < _table_size) {
-            _buffer_samples = _table_size;
-        } else {
-            _buffer_samples = (_buffer_samples / _table_size) * _table_size;
-        }
-        if (_buffer_samples > capacity_samples) {
-            _buffer_samples = (capacity_samples / _table_size) * _table_size;
-            if (_buffer_samples == 0) _buffer_samples = _table_size;
-        }
+void __not_in_flash_func(WaveGen::_restartStream)() {
+    uint32_t both = (1u << _dma_data) | (1u << _dma_control);
+    dma_irqn_set_channel_enabled(WAVEGEN_DMA_IRQ - DMA_IRQ_0, _dma_data, false);
+    dma_hw->abort = both;
+    while (dma_hw->abort & both) {
+        tight_loop_contents();
     }
-
-    _buffer_size = _buffer_samples * BYTES_PER_SAMPLE;
-    _buffer_cycles = (_table_size > 0) ? (_buffer_samples / _table_size) : 0;
-    _buffer_ready = false; // Need to rebuild buffer
+    // an abort flushes the FIFO and blocks it until cleared, the next word
+    // starts a fresh transaction with the address
+    (void)_i2c->hw->clr_tx_abrt;
+    (void)_i2c->hw->clr_tx_over;
+
+    _fillHalf(0);
+    _fillHalf(1);
+    _next_fill = 0;
+
+    dma_channel_config cfg = dma_channel_get_default_config(_dma_data);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, dma_get_timer_dreq(_dma_timer));
+    channel_config_set_chain_to(&cfg, _dma_control);
+    dma_channel_configure(_dma_data, &cfg, &_i2c->hw->data_cmd, _i2c_buffer[0],
+                          HALF_WORDS, false);
+
+    // one word per run: the next half's address into the data channel's
+    // read address trigger, wrapping over _half_addr
+    cfg = dma_channel_get_default_config(_dma_control);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_ring(&cfg, false, 3);
+    dma_channel_configure(_dma_control, &cfg,
+                          &dma_hw->ch[_dma_data].al3_read_addr_trig,
+                          _half_addr, 1, false);
+
+    dma_timer_set_fraction(_dma_timer, _timer_x, _timer_y);
+    dma_irqn_acknowledge_channel(WAVEGEN_DMA_IRQ - DMA_IRQ_0, _dma_data);
+    dma_irqn_set_channel_enabled(WAVEGEN_DMA_IRQ - DMA_IRQ_0, _dma_data, true);
+    dma_channel_start(_dma_control);
 }
 
 /*!
- *    @brief  Build the I2C buffer with multiple waveform cycles
+ *    @brief  Stops the DMA on a sample boundary and ends the transaction
  */
-void WaveGen::_buildI2CBuffer() {
-    if (_buffer_size == 0 || _table_size == 0) {
-        return;
+void WaveGen::_stopStream() {
+    _streaming = false;
+    dma_irqn_set_channel_enabled(WAVEGEN_DMA_IRQ - DMA_IRQ_0, _dma_data, false);
+
+    // stop the pacing so the read address holds still
+    dma_timer_set_fraction(_dma_timer, 0, 1);
+    delayMicroseconds(5);
+    uint32_t both = (1u << _dma_data) | (1u << _dma_control);
+    dma_hw->abort = both;
+    while (dma_hw->abort & both) {
+        tight_loop_contents();
     }
 
-    size_t buffer_pos = 0;
-    const uint8_t cmd = (uint8_t)(0x40 | (((uint8_t)_channel) << 1) | 0x00); // UDAC=0 immediate
-
-    for (size_t s = 0; s < _buffer_samples; s++) {
-        if (buffer_pos + 3 > MAX_BUFFER_SIZE) {
-            break;
-        }
-
-        size_t idx = (_table_index + s) % _table_size;
-        uint16_t value = _waveform_table[idx];
-        _i2c_buffer[buffer_pos++] = cmd;
-        _i2c_buffer[buffer_pos++] = (uint8_t)((value >> 8) & 0xFF);
-        _i2c_buffer[buffer_pos++] = (uint8_t)(value & 0xFF);
+    // finish the sample that's half out, or send the last one again, and STOP
+    const uint16_t *base = _i2c_buffer[0];
+    const uint16_t *next = (const uint16_t *)dma_hw->ch[_dma_data].read_addr;
+    size_t offset = next - base;
+    if (offset >= 2 * HALF_WORDS) {
+        offset = 0;
+        next = base;
     }
-
-    // Update actual size in case we broke early
-    _buffer_size = buffer_pos;
-    _buffer_ready = (_buffer_size > 1);
-
-    // Ensure buffer encodes whole cycles only (sanity assert-like guard)
-    if (_table_size > 0) {
-        size_t remainder = _buffer_samples % _table_size;
-        if (remainder != 0) {
-            size_t valid_samples = _buffer_samples - remainder;
-            _buffer_size = valid_samples * 3;
-            _buffer_samples = valid_samples;
+    size_t left = (WAVEGEN_WORDS_PER_SAMPLE - offset % WAVEGEN_WORDS_PER_SAMPLE) %
+                  WAVEGEN_WORDS_PER_SAMPLE;
+    if (left == 0) {
+        next = base + (offset >= WAVEGEN_WORDS_PER_SAMPLE ? offset - WAVEGEN_WORDS_PER_SAMPLE : 0);
+        left = WAVEGEN_WORDS_PER_SAMPLE;
+    }
+    uint32_t start = micros();
+    for (size_t i = 0; i < left; i++) {
+        while (!(_i2c->hw->status & I2C_IC_STATUS_TFNF_BITS) && micros() - start < 2000) {
+            tight_loop_contents();
+        }
+        uint32_t word = next[i];
+        if (i == left - 1) {
+            word |= I2C_IC_DATA_CMD_STOP_BITS;
         }
+        _i2c->hw->data_cmd = word;
     }
+    while ((_i2c->hw->status & I2C_IC_STATUS_ACTIVITY_BITS) && micros() - start < 2000) {
+        tight_loop_contents();
+    }
+    (void)_i2c->hw->clr_tx_abrt;
+    g_owns_wire = false;
 }
 
 /*!
- *    @brief  Start async transfer (simplified)
+ *    @brief  Shared DMA IRQ handler
  */
-void WaveGen::_startBufferTransfer() {
-    if (!_running) {
-        return;
+void __not_in_flash_func(WaveGen::_staticDmaIrq)() {
+    WaveGen *wg = g_current_wavegen;
+    if (wg && wg->_dma_data >= 0 &&
+        dma_irqn_get_channel_status(WAVEGEN_DMA_IRQ - DMA_IRQ_0, wg->_dma_data)) {
+        dma_irqn_acknowledge_channel(WAVEGEN_DMA_IRQ - DMA_IRQ_0, wg->_dma_data);
+        critical_section_enter_blocking(&g_stream_lock);
+        wg->_onDmaIrq();
+        critical_section_exit(&g_stream_lock);
     }
+}
 
-    // Safety check: ensure we have valid data
-    if (_table_size == 0 || _table_index >= _table_size) {
+/*!
+ *    @brief  A half went out, refill it while the other one plays
+ */
+void __not_in_flash_func(WaveGen::_onDmaIrq)() {
+    if (!_streaming) {
         return;
     }
+    uint32_t t0 = time_us_32();
 
-    if (!_buffer_ready) {
+    // a NACK or an overfull FIFO loses bytes, so the DAC would be out of step
+    // with cmd/hi/lo from here on. Start over from a sample boundary.
+    if (_i2c->hw->raw_intr_stat &
+        (I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS | I2C_IC_RAW_INTR_STAT_TX_OVER_BITS)) {
+        _failed_writes++;
+        _restartStream();
         return;
     }
 
-    // Per-sample synchronous streaming to avoid chunk boundaries completely
-    size_t total_samples_sent = 0;
-    uint32_t t0 = micros();
-    while (_running && total_samples_sent < _table_size) {
-        uint16_t sample_value = _waveform_table[_table_index];
-        bool ok = _dac.setChannelValue((MCP4728_channel_t)_channel, sample_value);
-        if (!ok) {
-            _failed_writes++;
-            break;
-        }
-        _successful_writes++;
-        _table_index = (_table_index + 1) % _table_size;
-        total_samples_sent++;
+    // the half the data channel is in now isn't ours to touch. If it's the
+    // one we were about to refill, we're a whole half late and it went out twice.
+    uintptr_t reading = dma_hw->ch[_dma_data].read_addr;
+    int playing = (reading >= (uintptr_t)_i2c_buffer[1]) ? 1 : 0;
+    int half = _next_fill;
+    if (playing == half) {
+        _underruns++;
+        half ^= 1;
     }
-    uint32_t t1 = micros();
-    _last_transfer_us = (t1 - t0);
-    _last_samples_sent = total_samples_sent;
-    // Build buffer for next call (not used in per-sample mode but keeps state consistent)
-    _buildI2CBuffer();
-}
+    _fillHalf(half);
+    _next_fill = half ^ 1;
+    _countWrites(WAVEGEN_DMA_SAMPLES);
 
-/*!
- *    @brief  Static callback for  completion
- */
-void WaveGen::_staticTransferComplete() {
-    // IRQ context: set flag only, no Serial or heavy work
-    if (g_current_wavegen) {
-        g_current_wavegen->_completion_pending = true;
+    uint32_t took = time_us_32() - t0;
+    if (took > _max_refill_us) {
+        _max_refill_us = took;
     }
 }
 
 /*!
- *    @brief  Called when buffer transfer completes
+ *    @brief  Prints rates and error counts
  */
-void WaveGen::_onTransferComplete() {
-    if (!_running) {
-        return; // Safety check
-    }
-    
-    _transfer_in_progress = false;
-    
-    // Advance to next buffer window
-    if (_table_size > 0 && _buffer_samples > 0) {
-        _table_index = (_table_index + _buffer_samples) % _table_size;
+void WaveGen::printStats(Stream *stream) {
+    stream->printf("wavegen: %s, outputs 0x%x, %.4f Hz", 
+                   !_running ? "stopped" : (_streaming ? "DMA stream" : "blocking"),
+                   _channel_mask, getCurrentFrequency());
+    if (_sweep_seconds > 0.0f) {
+        stream->printf(" (sweeping %.1f-%.1f Hz %s)", _sweep_start_hz, _sweep_end_hz,
+                       _sweep_log ? "log" : "linear");
     }
-
-    // Refill buffer for next window
-    _buildI2CBuffer();
-
-    // Immediately start next transfer for continuous streaming
-    if (_running) {
-        _startBufferTransfer();
+    stream->printf("\n\r  %.0f DAC writes/s programmed, %.0f measured, %.0f frames/s per output\n\r",
+                   _sample_rate, _measured_rate, getFrameRate());
+    stream->printf("  %lu writes, %lu bus errors, %lu underruns, slowest refill %lu us\n\r",
+                   (uint32_t)_successful_writes, (uint32_t)_failed_writes,
+                   (uint32_t)_underruns, (uint32_t)_max_refill_us);
+    if (_play_data != nullptr || _ring.samples != nullptr) {
+        stream->printf("  playback: %s, sample %lu, %.0f samples/s", 
+                       ddsPlaying(&_dds) ? "playing" : "ended", getPlayPosition(), _play_rate);
+        if (_ring.samples != nullptr) {
+            stream->printf(" (file, 1/%u), %lu frames starved", _decimate,
+                           getPlayStarved());
+        }
+        stream->printf("\n\r");
     }
 }
@@ -10,6 +10,54 @@
 
 #include "Arduino.h"
 #include "MCP4728.h"
+#include "WaveDds.h"
+#include "WaveFile.h"
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+
+// Streaming: the samples go out as one endless MCP4728 multi-write on I2C0
+// (cmd, hi, lo per sample, the DAC updates on the last ACK). A DMA channel
+// feeds those bytes from a two half ring into the I2C TX FIFO, paced by a DMA
+// timer at 3x the sample rate, and a second channel re-arms it with the other
+// half's address so it never waits on the CPU. The DMA IRQ refills the half
+// that just went out; it's installed on whichever core calls service() first
+// after start() (core 1, from loop1()), and that's all the time it takes.
+//
+// While streaming the transaction never ends, so nothing else can use Wire.
+// waveGenOwnsWire() says when; InaSampler checks it and serves cached values.
+// The MCP4728 setters in Peripherals.cpp can't wait, so they waveGenPauseWire()
+// (the stream stops on a sample boundary under the lock the DMA IRQ takes),
+// write, and waveGenResumeWire(); service() starts it up again after that.
+//
+// If there's no DMA channel or timer to be had, or setFallbackMode(true),
+// service() blocks in a paced per-sample setChannelValue() loop instead.
+//
+// Samples come from the DDS in WaveDds.h: a fixed 1024 point table and a 32-bit
+// phase accumulator, so the frequency resolution is microhertz and changing
+// frequency, amplitude or offset rebuilds nothing. The refill picks up a change
+// on its next half, between two samples, with the phase carrying on. Any of
+// the four MCP4728 channels can run at once off the same accumulator, each
+// with its own waveform, level, phase and harmonic, and the DAC writes are
+// shared between them (frame rate = sample rate / outputs). setChannel() picks
+// the one output the setters configure and makes it the only one running,
+// addChannel() adds another.
+//
+// WAVEGEN_ARBITRARY plays a single cycle of the user's own at the set
+// frequency: loadCycle() copies one in from a file (see WaveFile.h), setCycle()
+// reads one in place wherever it already is. WAVEGEN_PLAYBACK plays a whole
+// sequence at its own sample rate instead, resampled to the frame rate by the
+// DDS. playBuffer() reads it in place; playFile() streams it through a ring
+// that feed() (waveGenFeed(), from core 0's loop and MicroPython's delays)
+// keeps topped up from flash, so it can be longer than RAM. Files recorded
+// faster than the frame rate are box averaged down on the way in.
+
+#define WAVEGEN_DMA_SAMPLES 120      // DAC writes per half, whole frames for 1-4 outputs
+#define WAVEGEN_WORDS_PER_SAMPLE 3   // I2C data_cmd words: cmd, hi, lo
+#define WAVEGEN_MAX_SAMPLE_RATE 30000.0f // ~80% of a 1 MHz bus
+#define WAVEGEN_DMA_IRQ DMA_IRQ_0    // DMA_IRQ_1 is the ADC sampler's, on core 0
+#define WAVEGEN_CYCLE_MAX 4096       // samples loadCycle() takes from a file
+#define WAVEGEN_RING_SAMPLES 4096    // playFile() read-ahead, ~0.3 s at the top rate
+#define WAVEGEN_FEED_CHUNK 256       // samples feed() reads from the file at a time
 
 // Waveform types
 typedef enum {
@@ -17,6 +65,8 @@ typedef enum {
     WAVEGEN_TRIANGLE,
     WAVEGEN_SAWTOOTH,
     WAVEGEN_SQUARE,
+    WAVEGEN_ARBITRARY, // setCycle() / loadCycle()
+    WAVEGEN_PLAYBACK,  // playFile() / playBuffer()
 } waveGen_waveform_t;
 
 // Channel selection
@@ -38,18 +88,50 @@ public:
     bool begin(uint8_t i2c_address = MCP4728_I2CADDR_DEFAULT, TwoWire *wire = &Wire);
     void end();
     
-    // Waveform configuration
+    // Waveform configuration, of the selected output
     void setChannel(waveGen_channel_t channel);
     void setWaveform(waveGen_waveform_t waveform);
     void setFrequency(float frequency_hz);
     void setAmplitude(float amplitude_v);
     void setOffset(float offset_v);
+    void setPhase(float degrees);       // against the accumulator
+    void setHarmonic(uint8_t multiple); // of the frequency, 1-255
     // Query current configuration
     waveGen_channel_t getChannel() const { return _channel; }
-    waveGen_waveform_t getWaveform() const { return _waveform; }
+    waveGen_waveform_t getWaveform() const { return _outputs[_channel].waveform; }
     float getFrequency() const { return _frequency_hz; }
-    float getAmplitude() const { return _amplitude_v; }
-    float getOffset() const { return _offset_v; }
+    float getAmplitude() const { return _outputs[_channel].amplitude_v; }
+    float getOffset() const { return _outputs[_channel].offset_v; }
+    float getPhase() const { return _outputs[_channel].phase_deg; }
+    uint8_t getHarmonic() const { return _outputs[_channel].harmonic; }
+
+    // More than one output: select and enable another, or stop one
+    void addChannel(waveGen_channel_t channel);
+    void removeChannel(waveGen_channel_t channel);
+    uint8_t getChannelMask() const { return _channel_mask; }
+
+    // Sweeps from start_hz to end_hz, phase continuous; setFrequency() ends it
+    void sweep(float start_hz, float end_hz, float seconds, bool logarithmic = false,
+               bool repeat = false);
+    void stopSweep();
+    bool isSweeping() const { return _sweep_seconds > 0.0f; }
+    float getCurrentFrequency() const; // where the sweep is now
+
+    // Arbitrary waveforms, one cycle for WAVEGEN_ARBITRARY on the selected output
+    bool loadCycle(const char *path);   // copied in, up to WAVEGEN_CYCLE_MAX samples
+    bool setCycle(const void *samples, uint32_t count, uint8_t format); // read in place
+    uint32_t getCycleLength() const { return _outputs[_channel].table_length; }
+
+    // Sequences, played once or looped on the selected output at sample_rate
+    bool playFile(const char *path, float sample_rate, bool loop = false);
+    bool playBuffer(const void *samples, uint32_t count, uint8_t format, float sample_rate,
+                    bool loop = false);
+    void stopPlayback();
+    bool isPlaying() const;
+    uint32_t getPlayPosition() const;   // samples in
+    uint32_t getPlayStarved() const { return _dds.playStarved; } // frames the ring ran dry
+    void feed();                        // reads ahead for playFile()
+    void dropExternal();                // forget setCycle()/playBuffer() memory
     
     // Control
     bool start();
@@ -60,10 +142,19 @@ public:
     void service();
     
     // Statistics
-    uint32_t getSuccessfulWrites() const { return _successful_writes; }
-    uint32_t getFailedWrites() const { return _failed_writes; }
+    uint32_t getSuccessfulWrites() const { return _successful_writes; } // samples sent
+    uint32_t getFailedWrites() const { return _failed_writes; }         // bus aborts/overruns
+    uint32_t getUnderruns() const { return _underruns; } // a half went out twice, refill was late
     float getActualFrequency() const { return _actual_frequency; }
-    size_t getTableSize() const { return _table_size; }
+    float getSampleRate() const { return _sample_rate; }                // programmed
+    float getMeasuredSampleRate() const { return _measured_rate; }      // counted in the IRQ
+    uint32_t getMaxRefillUs() const { return _max_refill_us; }
+    bool isStreaming() const { return _streaming; }
+    bool pauseStream();                 // false if there was no stream to pause
+    void resumeStream();
+    size_t getTableSize() const { return DDS_TABLE_SIZE; }
+    float getFrameRate() const;
+    void printStats(Stream *stream);
     
     // Frequency management
     float getAchievableFrequency(float desired_freq) const;
@@ -73,92 +164,123 @@ public:
     void setFallbackMode(bool use_fallback) { _use_fallback = use_fallback; }
     bool isFallbackMode() const { return _use_fallback; }
     
-    // Buffer mode information
-    size_t getBufferSize() const { return _buffer_size; }
-    size_t getBufferCycles() const { return _buffer_cycles; }
+    // Buffer mode information (one half of the ring)
+    size_t getBufferSize() const { return HALF_WORDS; }
+    size_t getBufferCycles() const; // waveform cycles per half at the moment
     
     // Calibration (if needed)
     void setCalibrationOffset(waveGen_channel_t channel, float offset_v);
     void setCalibrationGain(waveGen_channel_t channel, float gain);
 
 private:
+    struct waveGen_output_t {
+        waveGen_waveform_t waveform;
+        float amplitude_v;
+        float offset_v;
+        float phase_deg;
+        uint8_t harmonic;
+        const void *table;      // WAVEGEN_ARBITRARY's cycle
+        uint32_t table_length;
+        uint8_t table_format;   // DDS_SAMPLES_*
+        int16_t *owned_table;   // loadCycle()'s copy, freed with the next one
+    };
+
     // Configuration
     MCP4728 _dac;
-    volatile waveGen_channel_t _channel;
-    volatile waveGen_waveform_t _waveform;
-    volatile float _frequency_hz;
-    volatile float _amplitude_v;
-    volatile float _offset_v;
+    waveGen_channel_t _channel;     // the one the setters change
+    uint8_t _channel_mask;          // outputs running
+    waveGen_output_t _outputs[4];
+    float _frequency_hz;
+    float _sweep_start_hz;
+    float _sweep_end_hz;
+    float _sweep_seconds;           // 0 = not sweeping
+    bool _sweep_log;
+    bool _sweep_repeat;
+    uint32_t _sweep_id;
     
     // State
     volatile bool _running;
     volatile bool _initialized;
     bool _use_fallback;
     
-    // Timing
-    uint32_t _last_sample_time;
-    uint32_t _sample_interval_us;
-    uint32_t _sample_count;
-    
-    // Waveform data
-    static const size_t MAX_WAVEFORM_TABLE_SIZE = 8192;
-    volatile uint16_t _waveform_table[MAX_WAVEFORM_TABLE_SIZE];
-    volatile size_t _table_size;        // Current table size (dynamic)
-    volatile size_t _table_index;
-    // Sample repeat control for very low frequencies
-    volatile uint32_t _repeat_factor;     // number of times to resend each sample
-    volatile uint32_t _repeat_remaining;  // countdown for repeats before advancing index
-    
-    // Buffer management for efficient I2C transfers
-    static const size_t MAX_BUFFER_SIZE = 8192; // 4KB buffer
-    alignas(4) uint8_t _i2c_buffer[MAX_BUFFER_SIZE];
-    size_t _buffer_size; // Actual buffer size for current frequency
-    size_t _buffer_cycles; // Number of waveform cycles in buffer (legacy; used for stats only)
-    size_t _buffer_samples; // Number of samples packed in current buffer
-    bool _buffer_ready;
-    bool _transfer_in_progress;
-    volatile bool _completion_pending;
-    volatile bool _params_changed;
+    // Samples
+    ddsState _dds;                  // settings staged here, the refill applies them
+    uint16_t _codes[WAVEGEN_DMA_SAMPLES];
+
+    // Playback
+    const void *_play_data;         // playBuffer()'s, or nullptr for the file
+    uint32_t _play_length;
+    uint8_t _play_format;
+    bool _play_loop;
+    float _play_rate;               // after decimating
+    uint32_t _play_id;
+    waveFileReader _file;
+    bool _file_open;
+    uint16_t _decimate;             // file samples averaged per ring sample
+    int32_t _decimate_sum;
+    uint16_t _decimate_count;
+    ddsRing _ring;
     
+    // DMA ring, two halves of data_cmd words back to back
+    static const size_t HALF_WORDS = WAVEGEN_DMA_SAMPLES * WAVEGEN_WORDS_PER_SAMPLE;
+    alignas(4) uint16_t _i2c_buffer[2][HALF_WORDS];
+    alignas(8) uint32_t _half_addr[2];  // the control channel's ring
+
+    // DMA streaming
+    i2c_inst_t *_i2c;
+    int _dma_data;          // table -> I2C TX FIFO, timer paced
+    int _dma_control;       // points _dma_data at the next half
+    int _dma_timer;
+    uint16_t _timer_x;      // timer rate = clk_sys * x / y words per second
+    uint16_t _timer_y;
+    float _sample_rate;     // DAC writes per second, shared by the outputs
+    volatile bool _streaming;
+    volatile bool _paused;  // a Wire user has the bus, service() doesn't restart
+    volatile int _next_fill; // half the next IRQ refills
+
     // Statistics
-    uint32_t _successful_writes;
-    uint32_t _failed_writes;
-    uint32_t _last_stats_time;
-    float _actual_frequency;
-    // Live stats window for accurate frequency reporting during continuous streaming
+    volatile uint32_t _successful_writes;
+    volatile uint32_t _failed_writes;
+    volatile uint32_t _underruns;
+    volatile float _actual_frequency;
+    volatile float _measured_rate;
+    volatile uint32_t _max_refill_us;
     volatile uint32_t _stats_window_start_us;
     volatile uint32_t _samples_since_stats;
-    volatile uint32_t _indices_since_stats;
-    // Measured transfer stats (sync mode)
-    size_t _last_samples_sent;
-    uint32_t _last_transfer_us;
     
     // Calibration
     float _calibration_offset[4];
     float _calibration_gain[4];
     
     // Internal functions
-    // Effective samples-per-second management
-    float _effective_samples_per_sec;
-    bool _sps_calibrated;
-    float _estimateSamplesPerSec() const;
-
-
-    void _buildWaveformTable();
+    float _maxSampleRate() const;
+    void _planTimer();
+    void _publish();
+    void _waitApplied();
+    bool _setTable(waveGen_channel_t channel, const void *table, uint32_t length,
+                   uint8_t format, int16_t *owned);
     uint16_t _voltsToCode(float voltage, waveGen_channel_t channel);
-    void _updateTableSize();
-    void _updateSampleInterval();
-    void _updateStatistics();
-    void _sendNextSample();
+    void _countWrites(uint32_t writes);
+    void _serviceBlocking();
     
     // Buffer management functions
-    void _calculateOptimalBuffer();
-    void _buildI2CBuffer();
-    void _startBufferTransfer();
-    void _onTransferComplete();
+    void _fillHalf(int half);
+    bool _startStream();
+    void _restartStream();
+    void _stopStream();
+    void _onDmaIrq();
     
-    // Static callback for  completion
-    static void _staticTransferComplete();
+    // Shared DMA IRQ handler
+    static void _staticDmaIrq();
 };
 
+/// true while the wavegen's DMA stream holds I2C0, Wire can't be used
+bool waveGenOwnsWire(void);
+/// stops the stream so Wire is free, true if it did (call waveGenResumeWire() after)
+bool waveGenPauseWire(void);
+/// lets service() start the stream that waveGenPauseWire() stopped
+void waveGenResumeWire(void);
+/// tops up a playFile() ring, call it often from core 0
+void waveGenFeed(void);
+
 #endif
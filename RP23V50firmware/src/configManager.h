@@ -119,6 +119,7 @@ const StringIntEntry uartFunctionTable[] = {
     {"led", 5},
     {"oled_leds", 6},
     {"leds_oled", 6},
+    {"telemetry", 7},
 };
 const int uartFunctionTableSize = sizeof(uartFunctionTable) / sizeof(uartFunctionTable[0]);
 
@@ -176,7 +177,9 @@ const StringIntEntry dumpFormatTable[] = {
     {"terminal", 0},
     {"rgb", 1},
     {"raw", 2},
-    {"uint32", 2}
+    {"uint32", 2},
+    {"binary", 3},
+    {"stream", 3}
 };
 const int dumpFormatTableSize = sizeof(dumpFormatTable) / sizeof(dumpFormatTable[0]);
 
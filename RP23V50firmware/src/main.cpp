@@ -27,6 +27,7 @@ KevinC@ppucc.io
 #include <SPI.h>
 #include <Wire.h>
 #include "ArduinoStuff.h"
+#include "Animations.h"
 #include "CH446Q.h"
 #include "Commands.h"
 
@@ -40,6 +41,10 @@ KevinC@ppucc.io
 #include "Highlighting.h"
 #include "JulseView.h"
 #include "JumperlessDefines.h"
+#include "LEDStream.h"
+#include "Telemetry.h"
+#include "InaSampler.h"
+#include "ScriptCache.h"
 #include "LEDs.h"
 #include "LogicAnalyzer.h"
 #include "MatrixState.h"
@@ -105,7 +110,7 @@ unsigned long startupTimers[ 12 ];
 
 volatile int dumpLED = 0;
 unsigned long dumpLEDTimer = 0;
-unsigned long dumpLEDrate = 50;
+unsigned long dumpLEDrate = 20;
 
 
 const char firmwareVersion[] = "5.3.2.4"; //! remember to update this
@@ -802,6 +807,9 @@ busyPrintTime = millis( );
             // chooseShownReadings();
             showMeasurements( 16, 0, 0 );
         }
+        inaSamplerService( );
+        waveGenFeed( );
+        scriptCacheService( );
 
         busyTimers[ 8 ] = micros( );
         if ( mscModeEnabled == true ) {
@@ -1034,11 +1042,6 @@ float wavegen_frequency = 1000.0f;
                 Serial.print("Fallback mode: ");
                 Serial.println(wavegen.isFallbackMode() ? "ON" : "OFF");
                 
-                // Keep synchronous mode (no Wire.writeAsync)
-                wavegen.setFallbackMode(true);
-                Serial.println("Staying in synchronous fallback mode (no writeAsync)");
-                Serial.flush();
-                
                 // Configure wavegen for ±8V range
                 wavegen.setChannel(WAVEGEN_DAC1);
                 wavegen.setWaveform(WAVEGEN_SINE);
@@ -1125,6 +1128,7 @@ float wavegen_frequency = 1000.0f;
                             Serial.print(wavegen.getSuccessfulWrites());
                             Serial.print(", Failed: ");
                             Serial.println(wavegen.getFailedWrites());
+                            wavegen.printStats(&Serial);
                             break;
                         }
                     }
@@ -1396,6 +1400,7 @@ float wavegen_frequency = 1000.0f;
         // for (int i = 0; i < 10; i++) {
         if ( dumpLED == 1 ) {
             dumpLED = 0;
+            printLEDDumpStats( );
         } else {
             dumpLED = 1;
         }
@@ -1925,22 +1930,22 @@ float wavegen_frequency = 1000.0f;
                 if ( Serial.available( ) > 0 ) {
                     char c = Serial.read( );
                     if ( c == '1' ) {
-                        float iSense = INA1.getCurrent_mA( );
+                        float iSense = inaSamplerLatest( 1, INA_CURRENT );
                         Serial.print( "ina1 = " );
                         Serial.print( iSense );
                         Serial.println( "mA" );
                     }
                 } else {
-                    float iSense = INA0.getCurrent_mA( );
+                    float iSense = inaSamplerLatest( 0, INA_CURRENT );
                     Serial.print( "ina0 = " );
                     Serial.print( iSense );
                     Serial.print( "mA \t" );
 
-                    iSense = INA0.getBusVoltage( );
+                    iSense = inaSamplerLatest( 0, INA_BUS_VOLTAGE );
                     Serial.print( iSense );
                     Serial.print( "V \t" );
 
-                    iSense = INA0.getPower_mW( );
+                    iSense = inaSamplerLatest( 0, INA_POWER );
                     Serial.print( iSense );
                     Serial.println( "mW" );
                 }
@@ -2316,7 +2321,13 @@ void loop1( ) {
 
     replyWithSerialInfo( );
 
-    if ( dumpLED == 1 ) {
+    if ( telemetryPort( ) != nullptr ) {
+        telemetryService( );
+    }
+
+    if ( dumpLED == 1 && ledStreamPort( ) != nullptr ) {
+        ledStreamService( );
+    } else if ( dumpLED == 1 ) {
 
         if ( millis( ) - dumpLEDTimer > dumpLEDrate ) {
             if ( core1busy == false ) {
@@ -2415,6 +2426,8 @@ void core2stuff( ) // core 2 handles the LEDs and the CH446Q8
 
                     showAllRowAnimations( );
 
+                    animationScheduler( );
+
                     core2busy = false;
                     netUpdateRefreshCount = 0;
                 }